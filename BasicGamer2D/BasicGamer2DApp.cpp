@@ -1,11 +1,18 @@
 #include "BasicGamer2DApp.h"
+#include "GamerBenchmark.h"
+#include "GamerCpu.h"
+#include <algorithm>
+#include <chrono>
+
+BasicGamer2DApp::BasicGamer2DApp(bool benchmark) : mBenchmark(benchmark) {}
 
 void BasicGamer2DApp::OnInit() {
   ComputeApp::OnInit();
 
-  mRow = mCol = 4;
+  SetGridSize(kDemoRow, kDemoCol);
   mNumPins = 3;
-  mMaxTurns = 4;
+  mMaxTurns = kDemoMaxTurns;
+  mInfinity = kDemoInfinity;
 
   CreateBuffer();
   CreateRootSignature();
@@ -13,63 +20,37 @@ void BasicGamer2DApp::OnInit() {
   CreatePipelineState();
 }
 
+void BasicGamer2DApp::SetGridSize(UINT row, UINT col) {
+  mRow = row;
+  mCol = col;
+  mSweepBlock = 2;
+  while (mSweepBlock < std::max<UINT>(mRow, mCol) && mSweepBlock < 1024)
+    mSweepBlock *= 2;
+  mSweepBlocksHorizontal = (mRow + mSweepBlock - 1) / mSweepBlock;
+  mSweepBlocksVertical = (mCol + mSweepBlock - 1) / mSweepBlock;
+}
+
 void BasicGamer2DApp::OnCompute() {
   ComputeApp::OnCompute();
+  if (mBenchmark) {
+    BenchmarkGpuSweeps();
+    return;
+  }
 
-  std::vector<float> costHorizontal(mRow * mCol);
-  costHorizontal[0 + 0 * mRow] = 0;
-  costHorizontal[1 + 0 * mRow] = 1;
-  costHorizontal[2 + 0 * mRow] = 3;
-  costHorizontal[3 + 0 * mRow] = 1000;
-  costHorizontal[0 + 1 * mRow] = 0;
-  costHorizontal[1 + 1 * mRow] = 2;
-  costHorizontal[2 + 1 * mRow] = 7;
-  costHorizontal[3 + 1 * mRow] = 1000;
-  costHorizontal[0 + 2 * mRow] = 0;
-  costHorizontal[1 + 2 * mRow] = 5;
-  costHorizontal[2 + 2 * mRow] = 4;
-  costHorizontal[3 + 2 * mRow] = 1000;
-  std::vector<float> costVertical(mRow * mCol);
-  costVertical[0 + 0 * mRow] = 0;
-  costVertical[0 + 1 * mRow] = 9;
-  costVertical[0 + 2 * mRow] = 3;
-  costVertical[0 + 3 * mRow] = 1000;
-  costVertical[1 + 0 * mRow] = 0;
-  costVertical[1 + 1 * mRow] = 5;
-  costVertical[1 + 2 * mRow] = 7;
-  costVertical[1 + 3 * mRow] = 1000;
-  costVertical[2 + 0 * mRow] = 0;
-  costVertical[2 + 1 * mRow] = 1;
-  costVertical[2 + 2 * mRow] = 2;
-  costVertical[2 + 3 * mRow] = 1000;
+  std::vector<float> costHorizontal, costVertical;
+  std::vector<int> pins;
+  DemoRouteInput(costHorizontal, costVertical, pins);
   std::vector<UINT> mark(mRow * mCol, 0);
-  std::vector<UINT> pinIndices = {0 * mRow + 0, 1 * mRow + 2, 2 * mRow + 0};
+  std::vector<UINT> pinIndices(pins.begin(), pins.end());
 
   // copy to gpu
-  {
-    void *mappedData = nullptr;
-    ThrowIfFailed(mCostHorizontalUploadBuffer->Map(0, nullptr, &mappedData));
-    memcpy(mappedData, costHorizontal.data(), mRow * mCol * sizeof(float));
-    mCostHorizontalUploadBuffer->Unmap(0, nullptr);
-  }
-  {
-    void *mappedData = nullptr;
-    ThrowIfFailed(mCostVerticalUploadBuffer->Map(0, nullptr, &mappedData));
-    memcpy(mappedData, costVertical.data(), mRow * mCol * sizeof(float));
-    mCostVerticalUploadBuffer->Unmap(0, nullptr);
-  }
-  {
-    void *mappedData = nullptr;
-    ThrowIfFailed(mMarkUploadBuffer->Map(0, nullptr, &mappedData));
-    memcpy(mappedData, mark.data(), mRow * mCol * sizeof(float));
-    mMarkUploadBuffer->Unmap(0, nullptr);
-  }
-  {
-    void *mappedData = nullptr;
-    ThrowIfFailed(mPinIndicesUploadBuffer->Map(0, nullptr, &mappedData));
-    memcpy(mappedData, pinIndices.data(), pinIndices.size() * sizeof(UINT));
-    mPinIndicesUploadBuffer->Unmap(0, nullptr);
-  }
+  Upload(mCostHorizontalUploadBuffer.Get(), costHorizontal.data(),
+         costHorizontal.size() * sizeof(float));
+  Upload(mCostVerticalUploadBuffer.Get(), costVertical.data(),
+         costVertical.size() * sizeof(float));
+  Upload(mMarkUploadBuffer.Get(), mark.data(), mark.size() * sizeof(UINT));
+  Upload(mPinIndicesUploadBuffer.Get(), pinIndices.data(),
+         pinIndices.size() * sizeof(UINT));
 
   // Reset cmdList
   ThrowIfFailed(mCmdAlloc->Reset());
@@ -77,42 +58,7 @@ void BasicGamer2DApp::OnCompute() {
 
   std::vector<CD3DX12_RESOURCE_BARRIER> barriers;
 
-  // upload
-  barriers.clear();
-  barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
-      mCostHorizontalBuffer.Get(), D3D12_RESOURCE_STATE_COMMON,
-      D3D12_RESOURCE_STATE_COPY_DEST));
-  barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
-      mCostVerticalBuffer.Get(), D3D12_RESOURCE_STATE_COMMON,
-      D3D12_RESOURCE_STATE_COPY_DEST));
-  barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
-      mMarkBuffer.Get(), D3D12_RESOURCE_STATE_COMMON,
-      D3D12_RESOURCE_STATE_COPY_DEST));
-  barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
-      mPinIndicesBuffer.Get(), D3D12_RESOURCE_STATE_COMMON,
-      D3D12_RESOURCE_STATE_COPY_DEST));
-  mCmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
-  mCmdList->CopyResource(mCostHorizontalBuffer.Get(),
-                         mCostHorizontalUploadBuffer.Get());
-  mCmdList->CopyResource(mCostVerticalBuffer.Get(),
-                         mCostVerticalUploadBuffer.Get());
-  mCmdList->CopyResource(mMarkBuffer.Get(), mMarkUploadBuffer.Get());
-  mCmdList->CopyResource(mPinIndicesBuffer.Get(),
-                         mPinIndicesUploadBuffer.Get());
-  barriers.clear();
-  barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
-      mCostHorizontalBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST,
-      D3D12_RESOURCE_STATE_COMMON));
-  barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
-      mCostVerticalBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST,
-      D3D12_RESOURCE_STATE_COMMON));
-  barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
-      mMarkBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST,
-      D3D12_RESOURCE_STATE_COMMON));
-  barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
-      mPinIndicesBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST,
-      D3D12_RESOURCE_STATE_COMMON));
-  mCmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+  RecordUpload();
 
   // SetRootPin
   mCmdList->SetPipelineState(mSetRootPinPSO.Get());
@@ -126,7 +72,7 @@ void BasicGamer2DApp::OnCompute() {
       3, mIsRoutedPinBuffer->GetGPUVirtualAddress());
   mCmdList->SetComputeRootUnorderedAccessView(
       4, mRoutesBuffer->GetGPUVirtualAddress());
-  mCmdList->Dispatch(1, 1, 1);
+  mCmdList->Dispatch((mNumPins + 255) / 256, 1, 1);
 
   // gamer process
   for (UINT i = 1; i < pinIndices.size(); i++) {
@@ -135,43 +81,13 @@ void BasicGamer2DApp::OnCompute() {
     barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mMarkBuffer.Get()));
     barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mDistBuffer.Get()));
     mCmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
-    mCmdList->SetPipelineState(mCleanDistPSO.Get());
-    mCmdList->SetComputeRootSignature(mCleanDistRootSignature.Get());
-    mCmdList->SetComputeRootUnorderedAccessView(
-        0, mMarkBuffer->GetGPUVirtualAddress());
-    mCmdList->SetComputeRootUnorderedAccessView(
-        1, mDistBuffer->GetGPUVirtualAddress());
-    mCmdList->Dispatch(mCol, 1, 1);
+    RecordCleanDist();
     for (UINT turn = 0; turn < mMaxTurns; turn++) {
       barriers.clear();
       barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mDistBuffer.Get()));
       barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mAllPrevBuffer.Get()));
       mCmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
-      if ((turn & 1)) {
-        // SweepVertical
-        mCmdList->SetPipelineState(mSweepVerticalPSO.Get());
-        mCmdList->SetComputeRootSignature(mSweepVerticalRootSignature.Get());
-        mCmdList->SetComputeRoot32BitConstant(0, turn, 0);
-        mCmdList->SetComputeRootUnorderedAccessView(
-            1, mCostVerticalBuffer->GetGPUVirtualAddress());
-        mCmdList->SetComputeRootUnorderedAccessView(
-            2, mDistBuffer->GetGPUVirtualAddress());
-        mCmdList->SetComputeRootUnorderedAccessView(
-            3, mAllPrevBuffer->GetGPUVirtualAddress());
-        mCmdList->Dispatch(mRow, 1, 1);
-      } else {
-        // SweepHorizontal
-        mCmdList->SetPipelineState(mSweepHorizontalPSO.Get());
-        mCmdList->SetComputeRootSignature(mSweepHorizontalRootSignature.Get());
-        mCmdList->SetComputeRoot32BitConstant(0, turn, 0);
-        mCmdList->SetComputeRootUnorderedAccessView(
-            1, mCostHorizontalBuffer->GetGPUVirtualAddress());
-        mCmdList->SetComputeRootUnorderedAccessView(
-            2, mDistBuffer->GetGPUVirtualAddress());
-        mCmdList->SetComputeRootUnorderedAccessView(
-            3, mAllPrevBuffer->GetGPUVirtualAddress());
-        mCmdList->Dispatch(mCol, 1, 1);
-      }
+      RecordSweep(turn);
     }
     // TracePath
     barriers.clear();
@@ -182,23 +98,7 @@ void BasicGamer2DApp::OnCompute() {
     barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mIsRoutedPinBuffer.Get()));
     barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mRoutesBuffer.Get()));
     mCmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
-    mCmdList->SetPipelineState(mTracePathPSO.Get());
-    mCmdList->SetComputeRootSignature(mTracePathRootSignature.Get());
-    mCmdList->SetComputeRoot32BitConstant(0, mNumPins, 0);
-    mCmdList->SetComputeRoot32BitConstant(0, mMaxTurns, 1);
-    mCmdList->SetComputeRootUnorderedAccessView(
-        1, mDistBuffer->GetGPUVirtualAddress());
-    mCmdList->SetComputeRootUnorderedAccessView(
-        2, mAllPrevBuffer->GetGPUVirtualAddress());
-    mCmdList->SetComputeRootUnorderedAccessView(
-        3, mPinIndicesBuffer->GetGPUVirtualAddress());
-    mCmdList->SetComputeRootUnorderedAccessView(
-        4, mMarkBuffer->GetGPUVirtualAddress());
-    mCmdList->SetComputeRootUnorderedAccessView(
-        5, mIsRoutedPinBuffer->GetGPUVirtualAddress());
-    mCmdList->SetComputeRootUnorderedAccessView(
-        6, mRoutesBuffer->GetGPUVirtualAddress());
-    mCmdList->Dispatch(1, 1, 1);
+    RecordTracePath();
   }
 
   // download
@@ -231,30 +131,12 @@ void BasicGamer2DApp::OnCompute() {
   std::vector<int> routes(2 * mNumPins * mMaxTurns);
   std::vector<float> dist(mRow * mCol);
   std::vector<int> allPrev(mMaxTurns * mRow * mCol);
-  {
-    void *mappedData = nullptr;
-    ThrowIfFailed(mRoutesReadbackBuffer->Map(0, nullptr, &mappedData));
-    memcpy(routes.data(), mappedData, routes.size() * sizeof(int));
-    mRoutesReadbackBuffer->Unmap(0, nullptr);
-  }
-  {
-    void *mappedData = nullptr;
-    ThrowIfFailed(mDistReadbackBuffer->Map(0, nullptr, &mappedData));
-    memcpy(dist.data(), mappedData, dist.size() * sizeof(float));
-    mDistReadbackBuffer->Unmap(0, nullptr);
-  }
-  {
-    void *mappedData = nullptr;
-    ThrowIfFailed(mAllPrevReadbackBuffer->Map(0, nullptr, &mappedData));
-    memcpy(allPrev.data(), mappedData, allPrev.size() * sizeof(int));
-    mAllPrevReadbackBuffer->Unmap(0, nullptr);
-  }
-  {
-    void *mappedData = nullptr;
-    ThrowIfFailed(mMarkReadbackBuffer->Map(0, nullptr, &mappedData));
-    memcpy(mark.data(), mappedData, mark.size() * sizeof(int));
-    mMarkReadbackBuffer->Unmap(0, nullptr);
-  }
+  Readback(mRoutesReadbackBuffer.Get(), routes.data(),
+           routes.size() * sizeof(int));
+  Readback(mDistReadbackBuffer.Get(), dist.data(), dist.size() * sizeof(float));
+  Readback(mAllPrevReadbackBuffer.Get(), allPrev.data(),
+           allPrev.size() * sizeof(int));
+  Readback(mMarkReadbackBuffer.Get(), mark.data(), mark.size() * sizeof(int));
   for (UINT rowId = 0; rowId < mCol; rowId++) {
     for (UINT colId = 0; colId < mRow; colId++) {
       std::printf("%.2f ", dist[rowId * mRow + colId]);
@@ -273,6 +155,243 @@ void BasicGamer2DApp::OnCompute() {
   }
 }
 
+void BasicGamer2DApp::Upload(ID3D12Resource *uploadBuffer, const void *data,
+                             size_t bytes) {
+  void *mappedData = nullptr;
+  ThrowIfFailed(uploadBuffer->Map(0, nullptr, &mappedData));
+  memcpy(mappedData, data, bytes);
+  uploadBuffer->Unmap(0, nullptr);
+}
+
+void BasicGamer2DApp::Readback(ID3D12Resource *readbackBuffer, void *data,
+                               size_t bytes) {
+  void *mappedData = nullptr;
+  ThrowIfFailed(readbackBuffer->Map(0, nullptr, &mappedData));
+  memcpy(data, mappedData, bytes);
+  readbackBuffer->Unmap(0, nullptr);
+}
+
+void BasicGamer2DApp::RecordUpload() {
+  std::vector<CD3DX12_RESOURCE_BARRIER> barriers;
+  barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+      mCostHorizontalBuffer.Get(), D3D12_RESOURCE_STATE_COMMON,
+      D3D12_RESOURCE_STATE_COPY_DEST));
+  barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+      mCostVerticalBuffer.Get(), D3D12_RESOURCE_STATE_COMMON,
+      D3D12_RESOURCE_STATE_COPY_DEST));
+  barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+      mMarkBuffer.Get(), D3D12_RESOURCE_STATE_COMMON,
+      D3D12_RESOURCE_STATE_COPY_DEST));
+  barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+      mPinIndicesBuffer.Get(), D3D12_RESOURCE_STATE_COMMON,
+      D3D12_RESOURCE_STATE_COPY_DEST));
+  mCmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+  mCmdList->CopyResource(mCostHorizontalBuffer.Get(),
+                         mCostHorizontalUploadBuffer.Get());
+  mCmdList->CopyResource(mCostVerticalBuffer.Get(),
+                         mCostVerticalUploadBuffer.Get());
+  mCmdList->CopyResource(mMarkBuffer.Get(), mMarkUploadBuffer.Get());
+  mCmdList->CopyResource(mPinIndicesBuffer.Get(),
+                         mPinIndicesUploadBuffer.Get());
+  barriers.clear();
+  barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+      mCostHorizontalBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST,
+      D3D12_RESOURCE_STATE_COMMON));
+  barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+      mCostVerticalBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST,
+      D3D12_RESOURCE_STATE_COMMON));
+  barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+      mMarkBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST,
+      D3D12_RESOURCE_STATE_COMMON));
+  barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+      mPinIndicesBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST,
+      D3D12_RESOURCE_STATE_COMMON));
+  mCmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+}
+
+void BasicGamer2DApp::RecordCleanDist() {
+  mCmdList->SetPipelineState(mCleanDistPSO.Get());
+  mCmdList->SetComputeRootSignature(mCleanDistRootSignature.Get());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      0, mMarkBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      1, mDistBuffer->GetGPUVirtualAddress());
+  mCmdList->Dispatch((mRow + 255) / 256, mCol, 1);
+}
+
+void BasicGamer2DApp::RecordSweep(UINT turn) {
+  // Even turns sweep the mCol rows, odd turns the mRow columns; lines longer
+  // than one block go through ReduceBlocks and PropagateCarry first.
+  bool vertical = (turn & 1) != 0;
+  UINT lines = vertical ? mRow : mCol;
+  UINT blocks = vertical ? mSweepBlocksVertical : mSweepBlocksHorizontal;
+  ID3D12Resource *cost =
+      vertical ? mCostVerticalBuffer.Get() : mCostHorizontalBuffer.Get();
+
+  mCmdList->SetComputeRootSignature(vertical
+                                        ? mSweepVerticalRootSignature.Get()
+                                        : mSweepHorizontalRootSignature.Get());
+  mCmdList->SetComputeRoot32BitConstant(0, turn, 0);
+  mCmdList->SetComputeRootUnorderedAccessView(1, cost->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      2, mDistBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      3, mAllPrevBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      4, mSweepCarryBuffer->GetGPUVirtualAddress());
+  if (blocks > 1) {
+    CD3DX12_RESOURCE_BARRIER barrier =
+        CD3DX12_RESOURCE_BARRIER::UAV(mSweepCarryBuffer.Get());
+    mCmdList->SetPipelineState(vertical ? mSweepVerticalReducePSO.Get()
+                                        : mSweepHorizontalReducePSO.Get());
+    mCmdList->Dispatch(blocks, lines, 1);
+    mCmdList->ResourceBarrier(1, &barrier);
+    mCmdList->SetPipelineState(vertical ? mSweepVerticalCarryPSO.Get()
+                                        : mSweepHorizontalCarryPSO.Get());
+    mCmdList->Dispatch((lines + 63) / 64, 1, 1);
+    mCmdList->ResourceBarrier(1, &barrier);
+  }
+  mCmdList->SetPipelineState(vertical ? mSweepVerticalPSO.Get()
+                                      : mSweepHorizontalPSO.Get());
+  mCmdList->Dispatch(blocks, lines, 1);
+}
+
+void BasicGamer2DApp::RecordTracePath() {
+  // SelectPin and MarkSegments spread the pins and the cells over threads;
+  // only the backtrace, one step per turn, runs on a single thread.
+  CD3DX12_RESOURCE_BARRIER barrier =
+      CD3DX12_RESOURCE_BARRIER::UAV(mTraceBuffer.Get());
+  mCmdList->SetComputeRootSignature(mTracePathRootSignature.Get());
+  mCmdList->SetComputeRoot32BitConstant(0, mNumPins, 0);
+  mCmdList->SetComputeRoot32BitConstant(0, mMaxTurns, 1);
+  mCmdList->SetComputeRootUnorderedAccessView(
+      1, mDistBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      2, mAllPrevBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      3, mPinIndicesBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      4, mMarkBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      5, mIsRoutedPinBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      6, mRoutesBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      7, mTraceBuffer->GetGPUVirtualAddress());
+  mCmdList->SetPipelineState(mSelectPinPSO.Get());
+  mCmdList->Dispatch(1, 1, 1);
+  mCmdList->ResourceBarrier(1, &barrier);
+  mCmdList->SetPipelineState(mTracePathPSO.Get());
+  mCmdList->Dispatch(1, 1, 1);
+  mCmdList->ResourceBarrier(1, &barrier);
+  mCmdList->SetPipelineState(mMarkSegmentsPSO.Get());
+  mCmdList->Dispatch((std::max<UINT>(mRow, mCol) + 255) / 256, mMaxTurns, 1);
+}
+
+void BasicGamer2DApp::BenchmarkGpuSweeps() {
+  const UINT grids[][2] = {{1000, 1000}, {4096, 1024}, {1024, 4096},
+                           {4000, 4000}};
+  const UINT iterations = 50;
+  mNumPins = 1;
+  mMaxTurns = 2;
+  mInfinity = 1e9f;
+
+  std::printf("\nGPU sweeps, checked against GamerCpu over two turns\n");
+  std::printf("%11s %6s %14s %10s %12s\n", "grid", "blocks", "sweeps/s",
+              "Mcells/s", "mismatches");
+  for (const auto &grid : grids) {
+    SetGridSize(grid[0], grid[1]);
+    CreateBuffer();
+    CreateComputeShader();
+    CreatePipelineState();
+
+    size_t cells = (size_t)mRow * mCol;
+    std::vector<float> costHorizontal, costVertical;
+    std::vector<int> mark;
+    RandomSweepInput(mRow, mCol, mInfinity, 1, costHorizontal, costVertical,
+                     mark);
+    std::vector<UINT> pinIndices(mNumPins, 0);
+    Upload(mCostHorizontalUploadBuffer.Get(), costHorizontal.data(),
+           cells * sizeof(float));
+    Upload(mCostVerticalUploadBuffer.Get(), costVertical.data(),
+           cells * sizeof(float));
+    Upload(mMarkUploadBuffer.Get(), mark.data(), cells * sizeof(int));
+    Upload(mPinIndicesUploadBuffer.Get(), pinIndices.data(),
+           pinIndices.size() * sizeof(UINT));
+
+    // Two turns from the marked cells, read back and compared.
+    std::vector<CD3DX12_RESOURCE_BARRIER> barriers;
+    ThrowIfFailed(mCmdAlloc->Reset());
+    ThrowIfFailed(mCmdList->Reset(mCmdAlloc.Get(), nullptr));
+    RecordUpload();
+    RecordCleanDist();
+    for (UINT turn = 0; turn < mMaxTurns; turn++) {
+      barriers.clear();
+      barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mDistBuffer.Get()));
+      barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mAllPrevBuffer.Get()));
+      mCmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+      RecordSweep(turn);
+    }
+    barriers.clear();
+    barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+        mDistBuffer.Get(), D3D12_RESOURCE_STATE_COMMON,
+        D3D12_RESOURCE_STATE_COPY_SOURCE));
+    barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+        mAllPrevBuffer.Get(), D3D12_RESOURCE_STATE_COMMON,
+        D3D12_RESOURCE_STATE_COPY_SOURCE));
+    mCmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+    mCmdList->CopyResource(mDistReadbackBuffer.Get(), mDistBuffer.Get());
+    mCmdList->CopyResource(mAllPrevReadbackBuffer.Get(), mAllPrevBuffer.Get());
+    ThrowIfFailed(mCmdList->Close());
+    ID3D12CommandList *cmdLists[] = {mCmdList.Get()};
+    mCmdQueue->ExecuteCommandLists(_countof(cmdLists), cmdLists);
+    FlushCommandQueue();
+
+    std::vector<float> dist(cells);
+    std::vector<int> allPrev(mMaxTurns * cells);
+    Readback(mDistReadbackBuffer.Get(), dist.data(), dist.size() * sizeof(float));
+    Readback(mAllPrevReadbackBuffer.Get(), allPrev.data(),
+             allPrev.size() * sizeof(int));
+
+    GamerCpu gamer(mRow, mCol, mInfinity);
+    std::vector<float> expected(cells);
+    std::vector<int> expectedPrev(mMaxTurns * cells);
+    for (size_t i = 0; i < cells; i++)
+      expected[i] = mark[i] ? 0.f : mInfinity;
+    gamer.SweepHorizontal(costHorizontal.data(), expected.data(),
+                          expectedPrev.data());
+    gamer.SweepVertical(costVertical.data(), expected.data(),
+                        expectedPrev.data() + cells);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < cells; i++)
+      mismatches += dist[i] != expected[i];
+    for (size_t i = 0; i < allPrev.size(); i++)
+      mismatches += allPrev[i] != expectedPrev[i];
+
+    // Timed: turns back to back, as in the router.
+    ThrowIfFailed(mCmdAlloc->Reset());
+    ThrowIfFailed(mCmdList->Reset(mCmdAlloc.Get(), nullptr));
+    for (UINT i = 0; i < iterations; i++) {
+      barriers.clear();
+      barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mDistBuffer.Get()));
+      barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mAllPrevBuffer.Get()));
+      mCmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+      RecordSweep(i % mMaxTurns);
+    }
+    ThrowIfFailed(mCmdList->Close());
+    auto start = std::chrono::high_resolution_clock::now();
+    mCmdQueue->ExecuteCommandLists(_countof(cmdLists), cmdLists);
+    FlushCommandQueue();
+    auto stop = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+
+    std::printf("%5ux%-5u %3ux%-2u %14.1f %10.1f %12zu%s\n", mRow, mCol,
+                mSweepBlocksHorizontal, mSweepBlocksVertical,
+                iterations / seconds, iterations * cells / seconds / 1e6,
+                mismatches, mismatches ? "  MISMATCH" : "");
+  }
+}
+
 void BasicGamer2DApp::CreateBuffer() {
   // Create DefaultBuffer
   ThrowIfFailed(mDevice->CreateCommittedResource(
@@ -331,6 +450,24 @@ void BasicGamer2DApp::CreateBuffer() {
           mNumPins * sizeof(UINT), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
       D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&mPinIndicesBuffer)));
   d3dSetDebugName(mPinIndicesBuffer.Get(), "PinIndices");
+  // Pin picked, segment count and (start, step, length) per turn.
+  ThrowIfFailed(mDevice->CreateCommittedResource(
+      &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
+      &CD3DX12_RESOURCE_DESC::Buffer(
+          (2 + 3 * mMaxTurns) * sizeof(int),
+          D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+      D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&mTraceBuffer)));
+  d3dSetDebugName(mTraceBuffer.Get(), "Trace");
+  // SweepCarry of GamerSweep.hlsli is ten 32-bit values, one per block.
+  UINT carries = std::max<UINT>(mCol * mSweepBlocksHorizontal,
+                                mRow * mSweepBlocksVertical);
+  ThrowIfFailed(mDevice->CreateCommittedResource(
+      &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
+      &CD3DX12_RESOURCE_DESC::Buffer(
+          carries * 10 * sizeof(UINT),
+          D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+      D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&mSweepCarryBuffer)));
+  d3dSetDebugName(mSweepCarryBuffer.Get(), "SweepCarry");
 
   // Create UploadBuffer
   ThrowIfFailed(mDevice->CreateCommittedResource(
@@ -381,20 +518,22 @@ void BasicGamer2DApp::CreateRootSignature() {
   std::vector<CD3DX12_ROOT_PARAMETER> rootParams;
 
   // Create RootSignature for SweepHorizontal
-  rootParams.resize(4);
+  rootParams.resize(5);
   rootParams[0].InitAsConstants(1, 0);
   rootParams[1].InitAsUnorderedAccessView(0);
   rootParams[2].InitAsUnorderedAccessView(1);
   rootParams[3].InitAsUnorderedAccessView(2);
+  rootParams[4].InitAsUnorderedAccessView(3);
   mSweepHorizontalRootSignature = d3dUtil::CreateRootSignature(
       mDevice.Get(), (UINT)rootParams.size(), rootParams.data());
 
   // Create RootSignature for SweepVertical
-  rootParams.resize(4);
+  rootParams.resize(5);
   rootParams[0].InitAsConstants(1, 0);
   rootParams[1].InitAsUnorderedAccessView(0);
   rootParams[2].InitAsUnorderedAccessView(1);
   rootParams[3].InitAsUnorderedAccessView(2);
+  rootParams[4].InitAsUnorderedAccessView(3);
   mSweepVerticalRootSignature = d3dUtil::CreateRootSignature(
       mDevice.Get(), (UINT)rootParams.size(), rootParams.data());
 
@@ -416,7 +555,7 @@ void BasicGamer2DApp::CreateRootSignature() {
       mDevice.Get(), (UINT)rootParams.size(), rootParams.data());
 
   // Create RootSignature for TracePath
-  rootParams.resize(7);
+  rootParams.resize(8);
   rootParams[0].InitAsConstants(2, 0);
   rootParams[1].InitAsUnorderedAccessView(0);
   rootParams[2].InitAsUnorderedAccessView(1);
@@ -424,22 +563,36 @@ void BasicGamer2DApp::CreateRootSignature() {
   rootParams[4].InitAsUnorderedAccessView(3);
   rootParams[5].InitAsUnorderedAccessView(4);
   rootParams[6].InitAsUnorderedAccessView(5);
+  rootParams[7].InitAsUnorderedAccessView(6);
   mTracePathRootSignature = d3dUtil::CreateRootSignature(
       mDevice.Get(), (UINT)rootParams.size(), rootParams.data());
 }
 
 void BasicGamer2DApp::CreateComputeShader() {
-  char rowBuf[16], colBuf[16];
+  char rowBuf[16], colBuf[16], blockBuf[16], infinityBuf[32];
   std::snprintf(rowBuf, 16, "%u", mRow);
   std::snprintf(colBuf, 16, "%u", mCol);
-  D3D_SHADER_MACRO macros[] = {
-      {"ROW", rowBuf}, {"COL", colBuf}, {nullptr, nullptr}};
+  std::snprintf(blockBuf, 16, "%u", mSweepBlock);
+  std::snprintf(infinityBuf, 32, "%.1f", mInfinity);
+  D3D_SHADER_MACRO macros[] = {{"ROW", rowBuf},
+                               {"COL", colBuf},
+                               {"SWEEP_BLOCK", blockBuf},
+                               {"INFINITY_DISTANCE", infinityBuf},
+                               {nullptr, nullptr}};
 
   // Create Shader for sweep
   mSweepHorizontalCS =
       d3dUtil::CompileShader(L"SweepHorizontal.hlsl", macros, "main", "cs_5_0");
+  mSweepHorizontalReduceCS = d3dUtil::CompileShader(
+      L"SweepHorizontal.hlsl", macros, "ReduceBlocks", "cs_5_0");
+  mSweepHorizontalCarryCS = d3dUtil::CompileShader(
+      L"SweepHorizontal.hlsl", macros, "PropagateCarry", "cs_5_0");
   mSweepVerticalCS =
       d3dUtil::CompileShader(L"SweepVertical.hlsl", macros, "main", "cs_5_0");
+  mSweepVerticalReduceCS = d3dUtil::CompileShader(
+      L"SweepVertical.hlsl", macros, "ReduceBlocks", "cs_5_0");
+  mSweepVerticalCarryCS = d3dUtil::CompileShader(
+      L"SweepVertical.hlsl", macros, "PropagateCarry", "cs_5_0");
 
   // Create Shader for CleanDist
   mCleanDistCS =
@@ -452,6 +605,10 @@ void BasicGamer2DApp::CreateComputeShader() {
   // Create Shader for TracePath
   mTracePathCS =
       d3dUtil::CompileShader(L"TracePath.hlsl", macros, "main", "cs_5_0");
+  mSelectPinCS =
+      d3dUtil::CompileShader(L"TracePath.hlsl", macros, "SelectPin", "cs_5_0");
+  mMarkSegmentsCS = d3dUtil::CompileShader(L"TracePath.hlsl", macros,
+                                           "MarkSegments", "cs_5_0");
 }
 
 void BasicGamer2DApp::CreatePipelineState() {
@@ -465,12 +622,33 @@ void BasicGamer2DApp::CreatePipelineState() {
   ThrowIfFailed(mDevice->CreateComputePipelineState(
       &psoDesc, IID_PPV_ARGS(&mSweepHorizontalPSO)));
 
-  // Create PipelineState for SweepHorizontal
+  psoDesc.CS = {
+      reinterpret_cast<BYTE *>(mSweepHorizontalReduceCS->GetBufferPointer()),
+      mSweepHorizontalReduceCS->GetBufferSize()};
+  ThrowIfFailed(mDevice->CreateComputePipelineState(
+      &psoDesc, IID_PPV_ARGS(&mSweepHorizontalReducePSO)));
+  psoDesc.CS = {
+      reinterpret_cast<BYTE *>(mSweepHorizontalCarryCS->GetBufferPointer()),
+      mSweepHorizontalCarryCS->GetBufferSize()};
+  ThrowIfFailed(mDevice->CreateComputePipelineState(
+      &psoDesc, IID_PPV_ARGS(&mSweepHorizontalCarryPSO)));
+
+  // Create PipelineState for SweepVertical
   psoDesc.pRootSignature = mSweepVerticalRootSignature.Get();
   psoDesc.CS = {reinterpret_cast<BYTE *>(mSweepVerticalCS->GetBufferPointer()),
                 mSweepVerticalCS->GetBufferSize()};
   ThrowIfFailed(mDevice->CreateComputePipelineState(
       &psoDesc, IID_PPV_ARGS(&mSweepVerticalPSO)));
+  psoDesc.CS = {
+      reinterpret_cast<BYTE *>(mSweepVerticalReduceCS->GetBufferPointer()),
+      mSweepVerticalReduceCS->GetBufferSize()};
+  ThrowIfFailed(mDevice->CreateComputePipelineState(
+      &psoDesc, IID_PPV_ARGS(&mSweepVerticalReducePSO)));
+  psoDesc.CS = {
+      reinterpret_cast<BYTE *>(mSweepVerticalCarryCS->GetBufferPointer()),
+      mSweepVerticalCarryCS->GetBufferSize()};
+  ThrowIfFailed(mDevice->CreateComputePipelineState(
+      &psoDesc, IID_PPV_ARGS(&mSweepVerticalCarryPSO)));
 
   // Create PipelineState for CleanDist
   psoDesc.pRootSignature = mCleanDistRootSignature.Get();
@@ -492,4 +670,12 @@ void BasicGamer2DApp::CreatePipelineState() {
                 mTracePathCS->GetBufferSize()};
   ThrowIfFailed(mDevice->CreateComputePipelineState(
       &psoDesc, IID_PPV_ARGS(&mTracePathPSO)));
+  psoDesc.CS = {reinterpret_cast<BYTE *>(mSelectPinCS->GetBufferPointer()),
+                mSelectPinCS->GetBufferSize()};
+  ThrowIfFailed(mDevice->CreateComputePipelineState(
+      &psoDesc, IID_PPV_ARGS(&mSelectPinPSO)));
+  psoDesc.CS = {reinterpret_cast<BYTE *>(mMarkSegmentsCS->GetBufferPointer()),
+                mMarkSegmentsCS->GetBufferSize()};
+  ThrowIfFailed(mDevice->CreateComputePipelineState(
+      &psoDesc, IID_PPV_ARGS(&mMarkSegmentsPSO)));
 }
@@ -3,18 +3,40 @@
 
 class BasicGamer2DApp : public ComputeApp {
 public:
+  // benchmark runs BenchmarkGpuSweeps instead of routing the demo grid.
+  explicit BasicGamer2DApp(bool benchmark = false);
+
   void OnInit() override;
   void OnCompute() override;
 
 private:
+  void SetGridSize(UINT row, UINT col);
   void CreateBuffer();
   void CreateRootSignature();
   void CreateComputeShader();
   void CreatePipelineState();
 
+  void Upload(ID3D12Resource *uploadBuffer, const void *data, size_t bytes);
+  void Readback(ID3D12Resource *readbackBuffer, void *data, size_t bytes);
+  void RecordUpload();
+  void RecordCleanDist();
+  void RecordSweep(UINT turn);
+  // Routes the closest unrouted pin: SelectPin, TracePath, MarkSegments.
+  void RecordTracePath();
+
+  // Full-grid sweeps per second on large square and non-square grids, after
+  // checking two turns against GamerCpu.
+  void BenchmarkGpuSweeps();
+
+  bool mBenchmark = false;
   UINT mRow, mCol;
   UINT mMaxTurns;
   UINT mNumPins;
+  float mInfinity;
+
+  // Cells per sweep thread group, and groups per row and per column.
+  UINT mSweepBlock;
+  UINT mSweepBlocksHorizontal, mSweepBlocksVertical;
 
   ComPtr<ID3D12Resource> mCostHorizontalBuffer;
   ComPtr<ID3D12Resource> mCostVerticalBuffer;
@@ -24,6 +46,8 @@ private:
   ComPtr<ID3D12Resource> mRoutesBuffer;
   ComPtr<ID3D12Resource> mIsRoutedPinBuffer;
   ComPtr<ID3D12Resource> mPinIndicesBuffer;
+  ComPtr<ID3D12Resource> mSweepCarryBuffer;
+  ComPtr<ID3D12Resource> mTraceBuffer;
 
   // UploadBuffer for CostHorizontal, CostVertical, Mark, PinIndices
   ComPtr<ID3D12Resource> mCostHorizontalUploadBuffer;
@@ -44,6 +68,15 @@ private:
   ComPtr<ID3DBlob> mSweepVerticalCS;
   ComPtr<ID3D12PipelineState> mSweepHorizontalPSO;
   ComPtr<ID3D12PipelineState> mSweepVerticalPSO;
+  // Extra passes for lines longer than one block
+  ComPtr<ID3DBlob> mSweepHorizontalReduceCS;
+  ComPtr<ID3DBlob> mSweepHorizontalCarryCS;
+  ComPtr<ID3DBlob> mSweepVerticalReduceCS;
+  ComPtr<ID3DBlob> mSweepVerticalCarryCS;
+  ComPtr<ID3D12PipelineState> mSweepHorizontalReducePSO;
+  ComPtr<ID3D12PipelineState> mSweepHorizontalCarryPSO;
+  ComPtr<ID3D12PipelineState> mSweepVerticalReducePSO;
+  ComPtr<ID3D12PipelineState> mSweepVerticalCarryPSO;
 
   // CleanDist
   ComPtr<ID3D12RootSignature> mCleanDistRootSignature;
@@ -59,4 +92,9 @@ private:
   ComPtr<ID3D12RootSignature> mTracePathRootSignature;
   ComPtr<ID3DBlob> mTracePathCS;
   ComPtr<ID3D12PipelineState> mTracePathPSO;
+  // Argmin over the pins and marking of the traced segments
+  ComPtr<ID3DBlob> mSelectPinCS;
+  ComPtr<ID3DBlob> mMarkSegmentsCS;
+  ComPtr<ID3D12PipelineState> mSelectPinPSO;
+  ComPtr<ID3D12PipelineState> mMarkSegmentsPSO;
 };
@@ -3,8 +3,11 @@
 RWStructuredBuffer<int> mark : register(u0);
 RWStructuredBuffer<float> dist : register(u1);
 
-[numthreads(ROW / 2, 1, 1)]
-void main(uint3 threadIdx : SV_GroupThreadID, uint3 blockIdx : SV_GroupID) {
-  dist[blockIdx.x * ROW + threadIdx.x] = mark[blockIdx.x * ROW + threadIdx.x] ? 0.f : INFINITY_DISTANCE;
-  dist[blockIdx.x * ROW + threadIdx.x + ROW / 2] = mark[blockIdx.x * ROW + threadIdx.x + ROW / 2] ? 0.f : INFINITY_DISTANCE;
+// One group per 256 cells of a grid row, one grid row per group row.
+[numthreads(256, 1, 1)]
+void main(uint3 dispatchIdx : SV_DispatchThreadID) {
+  if (dispatchIdx.x >= ROW)
+    return;
+  uint idx = dispatchIdx.y * ROW + dispatchIdx.x;
+  dist[idx] = mark[idx] ? 0.f : INFINITY_DISTANCE;
 }
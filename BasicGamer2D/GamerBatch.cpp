@@ -0,0 +1,318 @@
+#include "GamerBatch.h"
+#include <Common/ParallelFor.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Least a window's margin grows by when it held no route.
+#define GAMER_BATCH_WINDOW_GROWTH 8
+
+namespace {
+double SecondsSince(std::chrono::high_resolution_clock::time_point start) {
+  return std::chrono::duration<double>(
+             std::chrono::high_resolution_clock::now() - start)
+      .count();
+}
+
+// The box of pins grown by margin on every side, within a row x col grid;
+// the whole grid for a negative margin or no pins.
+GamerBox NetWindow(const std::vector<int> &pins, int row, int col,
+                   int margin) {
+  if (margin < 0 || pins.empty())
+    return {0, 0, row, col};
+  GamerBox box = {row, col, 0, 0};
+  for (int pin : pins) {
+    int x = pin % row, y = pin / row;
+    box = {std::min(box.x0, x), std::min(box.y0, y), std::max(box.x1, x + 1),
+           std::max(box.y1, y + 1)};
+  }
+  return {std::max(0, box.x0 - margin), std::max(0, box.y0 - margin),
+          std::min(row, box.x1 + margin), std::min(col, box.y1 + margin)};
+}
+
+// The cells of box out of a grid of row cells per grid row, row by row.
+void CopyWindow(const float *cost, int row, const GamerBox &box,
+                std::vector<float> &out) {
+  int width = box.x1 - box.x0;
+  out.resize((size_t)width * (box.y1 - box.y0));
+  for (int y = box.y0; y < box.y1; y++)
+    std::copy(cost + (size_t)y * row + box.x0,
+              cost + (size_t)y * row + box.x1,
+              out.begin() + (size_t)(y - box.y0) * width);
+}
+} // namespace
+
+GamerBatchRouter::GamerBatchRouter(int row, int col, float infinity)
+    : mRow(row), mCol(col), mInfinity(infinity) {}
+
+GamerBatchStats GamerBatchRouter::Route(const float *costHorizontal,
+                                        const float *costVertical,
+                                        const std::vector<GamerNet> &nets,
+                                        std::vector<GamerNetRoute> &routes,
+                                        const GamerBatchOptions &options,
+                                        int threadCount) {
+  GamerBatchStats stats;
+  size_t cells = (size_t)mRow * mCol;
+  routes.assign(nets.size(), GamerNetRoute());
+  if (threadCount <= 0)
+    threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+
+  std::vector<int> todo(nets.size());
+  for (size_t i = 0; i < nets.size(); i++)
+    todo[i] = (int)i;
+
+  // Nets over each cell and its congestion history. The pass costs are the
+  // given costs raised by the cell's penalty, kept current on the cells whose
+  // penalty changes: those of the nets routed or ripped up, and with
+  // negotiation those at capacity, whose present factor grows every pass.
+  std::vector<int> usage(cells, 0);
+  std::vector<float> history(cells, 0.f);
+  std::vector<float> raisedHorizontal, raisedVertical;
+  // Cells whose usage changed since the costs were raised, with repeats;
+  // cells overused after the pass; cells at capacity when the costs were
+  // last raised; cells to raise.
+  std::vector<int> changed, overused, full, touched;
+  // seen[cell] == epoch marks the cells of the list being built.
+  std::vector<int> seen(cells, -1);
+  int epoch = 0;
+  std::vector<int> group;
+  std::vector<char> ripUp(nets.size());
+  float present = options.presentCost;
+  const float maxRaised =
+      mInfinity / ((float)options.maxTurns * std::max(mRow, mCol));
+
+  // Raises the pass costs of the cells of touched.
+  auto raise = [&]() {
+    if (raisedHorizontal.empty()) {
+      raisedHorizontal.assign(costHorizontal, costHorizontal + cells);
+      raisedVertical.assign(costVertical, costVertical + cells);
+    }
+    ParallelFor(0, (int)touched.size(), threadCount, [&](int k) {
+      int cell = touched[k];
+      if (options.negotiated) {
+        float factor =
+            1.f + present * std::max(0, usage[cell] + 1 - options.capacity);
+        auto negotiate = [&](float cost) {
+          return cost >= mInfinity
+                     ? cost
+                     : std::min(maxRaised, (cost + history[cell]) * factor);
+        };
+        raisedHorizontal[cell] = negotiate(costHorizontal[cell]);
+        raisedVertical[cell] = negotiate(costVertical[cell]);
+      } else {
+        float penalty = history[cell] + options.congestionCost * usage[cell];
+        raisedHorizontal[cell] = costHorizontal[cell] + penalty;
+        raisedVertical[cell] = costVertical[cell] + penalty;
+      }
+    });
+  };
+  // Adds the cells of [first, last) to touched once each, in one epoch.
+  auto touch = [&](const int *first, const int *last) {
+    for (const int *cell = first; cell != last; cell++) {
+      if (seen[*cell] != epoch) {
+        seen[*cell] = epoch;
+        touched.push_back(*cell);
+      }
+    }
+  };
+
+  while (!todo.empty() && stats.iterations < options.maxIterations) {
+    const size_t groupSize =
+        options.groupNets > 0 ? options.groupNets : todo.size();
+    double routeSeconds = 0.0;
+    auto passStart = std::chrono::high_resolution_clock::now();
+    for (size_t first = 0; first < todo.size(); first += groupSize) {
+      group.assign(todo.begin() + first,
+                   todo.begin() + std::min(first + groupSize, todo.size()));
+      const float *passHorizontal = costHorizontal;
+      const float *passVertical = costVertical;
+      if (!raisedHorizontal.empty()) {
+        passHorizontal = raisedHorizontal.data();
+        passVertical = raisedVertical.data();
+      }
+
+      auto routeStart = std::chrono::high_resolution_clock::now();
+      RoutePass(passHorizontal, passVertical, nets, group, routes, options,
+                threadCount);
+      routeSeconds += SecondsSince(routeStart);
+
+      AddUsage(routes, group, 1, usage, threadCount);
+      size_t groupStart = changed.size();
+      for (int n : group)
+        changed.insert(changed.end(), routes[n].cells.begin(),
+                       routes[n].cells.end());
+      if (first + groupSize < todo.size()) {
+        touched.clear();
+        epoch++;
+        touch(changed.data() + groupStart, changed.data() + changed.size());
+        raise();
+      }
+    }
+    stats.passSeconds.push_back(routeSeconds);
+    stats.passNets.push_back((int)todo.size());
+    stats.iterations++;
+    stats.routedNets += (int)todo.size();
+
+    // Every net over an overused cell was ripped up, so only the cells of
+    // the nets just routed can be overused now.
+    overused.clear();
+    epoch++;
+    for (int n : todo) {
+      for (int cell : routes[n].cells) {
+        if (usage[cell] > options.capacity && seen[cell] != epoch) {
+          seen[cell] = epoch;
+          overused.push_back(cell);
+        }
+      }
+    }
+    stats.overusedCells = (int)overused.size();
+    stats.passOverused.push_back(stats.overusedCells);
+    if (overused.empty()) {
+      stats.updateSeconds.push_back(SecondsSince(passStart) - routeSeconds);
+      break;
+    }
+
+    // Rip up every net over an overused cell.
+    ParallelFor(0, (int)overused.size(), threadCount, [&](int k) {
+      int cell = overused[k];
+      history[cell] += options.negotiated
+                           ? options.historyCost *
+                                 (usage[cell] - options.capacity)
+                           : options.congestionCost;
+    });
+    ParallelFor(0, (int)routes.size(), threadCount, [&](int n) {
+      const std::vector<int> &netCells = routes[n].cells;
+      ripUp[n] = std::any_of(netCells.begin(), netCells.end(),
+                             [&](int cell) { return seen[cell] == epoch; });
+    });
+    todo.clear();
+    for (size_t n = 0; n < routes.size(); n++)
+      if (ripUp[n])
+        todo.push_back((int)n);
+    AddUsage(routes, todo, -1, usage, threadCount);
+    for (int n : todo)
+      changed.insert(changed.end(), routes[n].cells.begin(),
+                     routes[n].cells.end());
+
+    touched.clear();
+    epoch++;
+    touch(changed.data(), changed.data() + changed.size());
+    touch(full.data(), full.data() + full.size());
+    changed.clear();
+    if (options.negotiated) {
+      full.clear();
+      for (int cell : touched)
+        if (usage[cell] >= options.capacity)
+          full.push_back(cell);
+    }
+    raise();
+    present *= options.presentGrowth;
+    stats.updateSeconds.push_back(SecondsSince(passStart) - routeSeconds);
+  }
+  return stats;
+}
+
+void GamerBatchRouter::Usage(const std::vector<GamerNetRoute> &routes,
+                             std::vector<int> &usage) const {
+  usage.assign((size_t)mRow * mCol, 0);
+  for (const GamerNetRoute &route : routes)
+    for (int cell : route.cells)
+      usage[cell]++;
+}
+
+void GamerBatchRouter::AddUsage(const std::vector<GamerNetRoute> &routes,
+                                const std::vector<int> &nets, int delta,
+                                std::vector<int> &usage,
+                                int threadCount) const {
+  // Net cells are ascending, so each range starts with a binary search.
+  if (threadCount <= 0)
+    threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+  int cells = mRow * mCol;
+  int width = (cells + threadCount - 1) / threadCount;
+  ParallelFor(0, threadCount, threadCount, [&](int range) {
+    int c0 = range * width;
+    int c1 = std::min(c0 + width, cells);
+    for (int n : nets) {
+      const std::vector<int> &netCells = routes[n].cells;
+      for (auto it = std::lower_bound(netCells.begin(), netCells.end(), c0);
+           it != netCells.end() && *it < c1; ++it)
+        usage[*it] += delta;
+    }
+  });
+}
+
+void GamerBatchRouter::RoutePass(const float *costHorizontal,
+                                 const float *costVertical,
+                                 const std::vector<GamerNet> &nets,
+                                 const std::vector<int> &todo,
+                                 std::vector<GamerNetRoute> &routes,
+                                 const GamerBatchOptions &options,
+                                 int threadCount) {
+  // Nets differ a lot in cost, so workers take the next net as they finish
+  // rather than a fixed share.
+  if (threadCount <= 0)
+    threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+  int workers = std::min(threadCount, (int)todo.size());
+  std::atomic<int> next(0);
+  ParallelFor(0, workers, workers, [&](int) {
+    // Many small windows go through one router and one set of buffers.
+    GamerCpu gamer(0, 0, mInfinity);
+    GamerRoute route;
+    route.adaptiveTurns = options.adaptiveTurns;
+    std::vector<float> windowHorizontal, windowVertical;
+    std::vector<int> windowPins;
+    for (int i = next++; i < (int)todo.size(); i = next++) {
+      const GamerNet &net = nets[todo[i]];
+      GamerNetRoute &out = routes[todo[i]];
+      out.sweeps = 0;
+      out.windows = 0;
+      out.sweptCells = 0;
+      int margin = options.windowMargin;
+      for (;;) {
+        GamerBox box = NetWindow(net.pinIndices, mRow, mCol, margin);
+        bool whole = box.x0 == 0 && box.y0 == 0 && box.x1 == mRow &&
+                     box.y1 == mCol;
+        int width = box.x1 - box.x0, height = box.y1 - box.y0;
+        gamer.Resize(width, height);
+        if (whole) {
+          gamer.Route(costHorizontal, costVertical, net.pinIndices,
+                      options.maxTurns, route, options.path, 1);
+        } else {
+          CopyWindow(costHorizontal, mRow, box, windowHorizontal);
+          CopyWindow(costVertical, mRow, box, windowVertical);
+          windowPins.clear();
+          for (int pin : net.pinIndices)
+            windowPins.push_back((pin / mRow - box.y0) * width + pin % mRow -
+                                 box.x0);
+          gamer.Route(windowHorizontal.data(), windowVertical.data(),
+                      windowPins, options.maxTurns, route, options.path, 1);
+        }
+        out.window = box;
+        out.windows++;
+        out.sweeps += route.sweeps;
+        out.sweptCells += (long long)route.sweeps * width * height;
+        out.complete = std::all_of(route.isRoutedPin.begin(),
+                                   route.isRoutedPin.end(),
+                                   [](int routed) { return routed != 0; });
+        if (out.complete || whole)
+          break;
+        margin = std::max(2 * margin, margin + GAMER_BATCH_WINDOW_GROWTH);
+      }
+
+      // Back to cells of the grid; the mapping keeps them ascending.
+      const GamerBox &box = out.window;
+      int width = box.x1 - box.x0;
+      auto toGrid = [&](int cell) {
+        return (box.y0 + cell / width) * mRow + box.x0 + cell % width;
+      };
+      out.segments.resize(route.routes.size() - 1);
+      std::transform(route.routes.begin() + 1, route.routes.end(),
+                     out.segments.begin(), toGrid);
+      out.cells.clear();
+      for (size_t c = 0; c < route.mark.size(); c++)
+        if (route.mark[c])
+          out.cells.push_back(toGrid((int)c));
+    }
+  });
+}
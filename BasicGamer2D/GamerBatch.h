@@ -0,0 +1,125 @@
+#pragma once
+#include "GamerCpu.h"
+#include <vector>
+
+// One net of a batch: cell indices of its pins, routed from the first.
+struct GamerNet {
+  std::vector<int> pinIndices;
+};
+
+// A routed net.
+struct GamerNetRoute {
+  // Start and end cell of every segment, smaller index first, as in
+  // GamerRoute::routes without the count.
+  std::vector<int> segments;
+  // Every cell of the net (pins and segments), ascending.
+  std::vector<int> cells;
+  // Every pin was reached within the turns allowed.
+  bool complete = false;
+  // Sweeps its last routing ran.
+  int sweeps = 0;
+  // The window it was last routed in, how many windows its last routing
+  // tried, and the cells swept over all of them.
+  GamerBox window;
+  int windows = 0;
+  long long sweptCells = 0;
+};
+
+struct GamerBatchOptions {
+  int maxTurns = 4;
+  // Routing passes: the first routes every net, each later one rips up and
+  // reroutes the nets over overused cells.
+  int maxIterations = 8;
+  // Nets a cell can hold before it is overused. Two nets that cross on the
+  // one-layer grid share the crossing cell, so below two they cannot cross.
+  int capacity = 2;
+  // Added to the cost of entering a cell for every pass that ends with the
+  // cell overused, and for every net that keeps its route over the cell
+  // while the others are rerouted.
+  float congestionCost = 8.f;
+  // Negotiated congestion as in PathFinder instead: entering a cell costs
+  // (edge + history) * (1 + present * (nets over capacity if one more net
+  // took the cell)), at most infinity / (maxTurns * max(row, col)) so that
+  // no route becomes unreachable. history grows by historyCost times the
+  // overuse of every pass that ends with the cell overused, and present
+  // starts at presentCost and grows by presentGrowth every pass, so nets
+  // that can go around a congested cell end up doing so. Blocked edges stay
+  // blocked. Dense designs want more passes than maxIterations defaults to,
+  // and a groupNets of a few nets per thread.
+  bool negotiated = false;
+  float presentCost = 0.5f;
+  float presentGrowth = 1.5f;
+  float historyCost = 1.f;
+  // A pass routes its nets in groups of this many (0 = all at once), each
+  // against costs raised by the usage of the groups before it, so that nets
+  // rerouted in the same pass do not all take the same free cells.
+  int groupNets = 0;
+  // Routes each net on a window of the grid: the box of its pins grown by
+  // this many cells on every side (negative = the whole grid). Only when
+  // some pin cannot be reached inside the window is it routed again on one
+  // with the margin doubled, by at least GAMER_BATCH_WINDOW_GROWTH, up to
+  // the whole grid. Each window's costs are copied out and swept as a grid
+  // of its own.
+  int windowMargin = -1;
+  GamerCpuPath path = GamerCpuPath::Avx2;
+  // GamerRoute::adaptiveTurns for every net.
+  bool adaptiveTurns = false;
+};
+
+struct GamerBatchStats {
+  int iterations = 0;
+  // Nets routed over all passes, the first pass included.
+  int routedNets = 0;
+  // Cells still overused after the last pass.
+  int overusedCells = 0;
+  // Seconds spent routing in each pass.
+  std::vector<double> passSeconds;
+  // For each pass: the nets it routed, the cells overused after it, and the
+  // seconds spent updating usage and costs and ripping up nets after it.
+  std::vector<int> passNets;
+  std::vector<int> passOverused;
+  std::vector<double> updateSeconds;
+};
+
+// Routes many independent nets over one pair of cost arrays on the CPU. Every
+// pass is one task per net, handed out to threadCount workers (0 = all
+// hardware threads) that each own a GamerCpu and buffers for the largest
+// window they have routed. A pass routes all of its nets against the same
+// costs, so the routes do not depend on the number of threads. After every
+// pass and group, usage and the raised costs are updated in place, in
+// parallel, on only the cells whose usage or penalty changed.
+class GamerBatchRouter {
+public:
+  GamerBatchRouter(int row, int col, float infinity = 1000.f);
+
+  GamerBatchRouter(const GamerBatchRouter &rhs) = delete;
+  GamerBatchRouter &operator=(const GamerBatchRouter &rhs) = delete;
+  ~GamerBatchRouter() = default;
+
+  GamerBatchStats Route(const float *costHorizontal, const float *costVertical,
+                        const std::vector<GamerNet> &nets,
+                        std::vector<GamerNetRoute> &routes,
+                        const GamerBatchOptions &options = GamerBatchOptions(),
+                        int threadCount = 0);
+
+  // Nets per cell for the given routes.
+  void Usage(const std::vector<GamerNetRoute> &routes,
+             std::vector<int> &usage) const;
+
+private:
+  // Adds delta to usage on every cell of the given nets, one range of cells
+  // per thread.
+  void AddUsage(const std::vector<GamerNetRoute> &routes,
+                const std::vector<int> &nets, int delta,
+                std::vector<int> &usage, int threadCount) const;
+
+  void RoutePass(const float *costHorizontal, const float *costVertical,
+                 const std::vector<GamerNet> &nets,
+                 const std::vector<int> &todo,
+                 std::vector<GamerNetRoute> &routes,
+                 const GamerBatchOptions &options, int threadCount);
+
+  int mRow = 0;
+  int mCol = 0;
+  float mInfinity = 1000.f;
+};
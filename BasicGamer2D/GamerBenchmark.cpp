@@ -0,0 +1,1067 @@
+#include "GamerBenchmark.h"
+#include "GamerCpu.h"
+#include "GamerLayerCpu.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace {
+// Infinity for the benchmark grids: far above any path cost they contain.
+const float kInfinity = 1e9f;
+
+struct Config {
+  const char *name;
+  GamerCpuPath path;
+  int threads;
+};
+
+std::vector<Config> Configs() {
+  const int hwThreads =
+      (int)std::max(1u, std::thread::hardware_concurrency());
+  return {{"scalar x1", GamerCpuPath::Scalar, 1},
+          {"avx2 x1", GamerCpuPath::Avx2, 1},
+          {"scalar xN", GamerCpuPath::Scalar, hwThreads},
+          {"avx2 xN", GamerCpuPath::Avx2, hwThreads}};
+}
+
+// One turn over a line of n cells: c[i] is the cost of the edge from cell
+// i - 1 to cell i. Tries every start for every cell, nearest start first on
+// ties, and combines the two directions in the order the shaders do.
+void ReferenceSweepLine(int n, const float *c, float *d, int *prev) {
+  std::vector<float> out(d, d + n);
+  for (int i = 0; i < n; i++) {
+    float bestL = d[i], bestR = d[i];
+    int fromL = i, fromR = i;
+    float sum = 0.f;
+    for (int j = i - 1; j >= 0; j--) {
+      sum += c[j + 1];
+      if (d[j] + sum < bestL) {
+        bestL = d[j] + sum;
+        fromL = j;
+      }
+    }
+    sum = 0.f;
+    for (int j = i + 1; j < n; j++) {
+      sum += c[j];
+      if (d[j] + sum < bestR) {
+        bestR = d[j] + sum;
+        fromR = j;
+      }
+    }
+    prev[i] = i;
+    if (bestL < out[i]) {
+      out[i] = bestL;
+      prev[i] = fromL;
+    }
+    if (bestR < out[i]) {
+      out[i] = bestR;
+      prev[i] = fromR;
+    }
+  }
+  std::copy(out.begin(), out.end(), d);
+}
+
+void ReferenceSweep(int row, int col, bool vertical, const float *cost,
+                    float *dist, int *prev) {
+  int lines = vertical ? row : col;
+  int n = vertical ? col : row;
+  std::vector<float> c(n), d(n);
+  std::vector<int> p(n);
+  for (int line = 0; line < lines; line++) {
+    auto cell = [&](int pos) {
+      return vertical ? pos * row + line : line * row + pos;
+    };
+    for (int pos = 0; pos < n; pos++) {
+      c[pos] = cost[cell(pos)];
+      d[pos] = dist[cell(pos)];
+    }
+    ReferenceSweepLine(n, c.data(), d.data(), p.data());
+    for (int pos = 0; pos < n; pos++) {
+      dist[cell(pos)] = d[pos];
+      prev[cell(pos)] = cell(p[pos]);
+    }
+  }
+}
+
+// Three turns, horizontal first, on grids down to a single cell and up to
+// several strips of GamerCpu::SweepVertical and several groups of eight rows
+// of the AVX2 path; false on the first difference.
+bool ValidateSweeps(GamerCpuPath path, int threadCount) {
+  const int shapes[][2] = {{1, 1},  {1, 7},  {7, 1},   {2, 2},  {5, 3},
+                           {37, 23}, {64, 5}, {5, 64}, {130, 70}, {70, 130}};
+  for (const auto &shape : shapes) {
+    int row = shape[0], col = shape[1];
+    std::vector<float> costHorizontal, costVertical;
+    std::vector<int> mark;
+    RandomSweepInput(row, col, kInfinity, row * 131 + col, costHorizontal,
+                     costVertical, mark);
+
+    size_t cells = (size_t)row * col;
+    std::vector<float> dist(cells), expected(cells);
+    std::vector<int> prev(cells), expectedPrev(cells);
+    for (size_t i = 0; i < cells; i++)
+      dist[i] = expected[i] = mark[i] ? 0.f : kInfinity;
+
+    GamerCpu gamer(row, col, kInfinity);
+    for (int turn = 0; turn < 3; turn++) {
+      bool vertical = (turn & 1) != 0;
+      const float *cost = vertical ? costVertical.data() : costHorizontal.data();
+      if (vertical)
+        gamer.SweepVertical(cost, dist.data(), prev.data(), path, threadCount);
+      else
+        gamer.SweepHorizontal(cost, dist.data(), prev.data(), path,
+                              threadCount);
+      ReferenceSweep(row, col, vertical, cost, expected.data(),
+                     expectedPrev.data());
+
+      for (size_t i = 0; i < cells; i++) {
+        if (dist[i] != expected[i] || prev[i] != expectedPrev[i]) {
+          printf("MISMATCH %dx%d turn %d cell (%d, %d): dist %g prev %d, "
+                 "expected %g prev %d\n",
+                 row, col, turn, (int)(i % row), (int)(i / row), dist[i],
+                 prev[i], expected[i], expectedPrev[i]);
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// GamerSweepRowsAvx2 on every whole group of eight rows against
+// GamerSweepRows, three turns' worth on the same distances, since
+// SweepHorizontal may not take it; true without AVX2.
+bool ValidateRowKernel() {
+  if (!GamerCpu::Avx2Supported())
+    return true;
+  const int shapes[][2] = {{1, 8}, {7, 9}, {37, 23}, {130, 70}};
+  for (const auto &shape : shapes) {
+    int row = shape[0], col = shape[1];
+    std::vector<float> costHorizontal, costVertical;
+    std::vector<int> mark;
+    RandomSweepInput(row, col, kInfinity, row * 17 + col, costHorizontal,
+                     costVertical, mark);
+    size_t cells = (size_t)row * col;
+    std::vector<float> dist(cells), expected(cells), best(cells);
+    std::vector<int> prev(cells), expectedPrev(cells), bestPrev(cells);
+    for (size_t i = 0; i < cells; i++)
+      dist[i] = expected[i] = mark[i] ? 0.f : kInfinity;
+    GamerSweepArgs args = {row,         col,        costHorizontal.data(),
+                           dist.data(), prev.data(), best.data(),
+                           bestPrev.data()};
+    GamerSweepArgs reference = args;
+    reference.dist = expected.data();
+    reference.prev = expectedPrev.data();
+
+    for (int turn = 0; turn < 3; turn++) {
+      for (int y0 = 0; y0 + 8 <= col; y0 += 8) {
+        GamerSweepRowsAvx2(args, y0);
+        GamerSweepRows(reference, y0, y0 + 8);
+      }
+      for (size_t i = 0; i < (size_t)(col / 8 * 8) * row; i++) {
+        if (dist[i] != expected[i] || prev[i] != expectedPrev[i]) {
+          printf("MISMATCH GamerSweepRowsAvx2 %dx%d turn %d cell (%d, %d): "
+                 "dist %g prev %d, expected %g prev %d\n",
+                 row, col, turn, (int)(i % row), (int)(i / row), dist[i],
+                 prev[i], expected[i], expectedPrev[i]);
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// Prints the first difference between a buffer of a routed net and the
+// values expected for it.
+template <typename T>
+bool Compare(const char *config, const char *name, const std::vector<T> &got,
+             const std::vector<T> &expected) {
+  for (size_t i = 0; i < std::max(got.size(), expected.size()); i++) {
+    if (i >= got.size() || i >= expected.size() || got[i] != expected[i]) {
+      printf("MISMATCH %s %s[%zu]: %g, expected %g\n", config, name, i,
+             i < got.size() ? (double)got[i] : 0.0,
+             i < expected.size() ? (double)expected[i] : 0.0);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SameRoute(const char *config, const GamerRoute &got,
+               const GamerRoute &expected) {
+  return Compare(config, "dist", got.dist, expected.dist) &&
+         Compare(config, "allPrev", got.allPrev, expected.allPrev) &&
+         Compare(config, "mark", got.mark, expected.mark) &&
+         Compare(config, "routes", got.routes, expected.routes);
+}
+
+// A net of eight pins on a random grid; every configuration must route it
+// exactly as the scalar path on one thread does.
+bool ValidateRoutes() {
+  const int row = 130, col = 70;
+  std::vector<float> costHorizontal, costVertical;
+  std::vector<int> mark;
+  RandomSweepInput(row, col, kInfinity, 7, costHorizontal, costVertical, mark);
+  std::vector<int> pinIndices;
+  for (int i = 0; i < 8; i++)
+    pinIndices.push_back((i * 37 % col) * row + i * 53 % row);
+
+  GamerCpu gamer(row, col, kInfinity);
+  GamerRoute expected, route;
+  gamer.Route(costHorizontal.data(), costVertical.data(), pinIndices, 4,
+              expected, GamerCpuPath::Scalar, 1);
+  for (const Config &config : Configs()) {
+    gamer.Route(costHorizontal.data(), costVertical.data(), pinIndices, 4,
+                route, config.path, config.threads);
+    if (!SameRoute(config.name, route, expected))
+      return false;
+  }
+  return true;
+}
+
+// GamerPrevStore against allPrev for four and eight turns on odd grids, as
+// the sweeps leave it and with every 29th predecessor moved off its line so
+// that the exception list is used, then the net of ValidateRoutes routed with compactPrev against
+// the same net with allPrev; false on the first difference.
+bool ValidatePrev() {
+  const int shapes[][2] = {{37, 23}, {130, 70}, {257, 131}};
+  for (const auto &shape : shapes) {
+    int row = shape[0], col = shape[1];
+    std::vector<float> costHorizontal, costVertical;
+    std::vector<int> mark;
+    RandomSweepInput(row, col, kInfinity, row + col, costHorizontal,
+                     costVertical, mark);
+    size_t cells = (size_t)row * col;
+    GamerCpu gamer(row, col, kInfinity);
+    std::vector<float> dist(cells);
+
+    for (bool scramble : {false, true}) {
+      for (int turns : {4, 8}) {
+        std::vector<int> allPrev(turns * cells);
+        GamerPrevStore store;
+        store.Reset(row, col, turns);
+        gamer.CleanDist(mark.data(), dist.data());
+        for (int turn = 0; turn < turns; turn++) {
+          int *prev = allPrev.data() + turn * cells;
+          if (turn & 1)
+            gamer.SweepVertical(costVertical.data(), dist.data(), prev);
+          else
+            gamer.SweepHorizontal(costHorizontal.data(), dist.data(), prev);
+          for (size_t i = turn; scramble && i < cells; i += 29)
+            prev[i] = (int)((i * 7919 + 1) % cells);
+          store.Store(turn, prev);
+        }
+        for (int turn = 0; turn < turns; turn++) {
+          for (size_t i = 0; i < cells; i++) {
+            int got = store.Prev(turn, (int)i);
+            if (got != allPrev[turn * cells + i]) {
+              printf("MISMATCH prev store %dx%d%s turn %d/%d cell %d: %d, "
+                     "expected %d\n",
+                     row, col, scramble ? " scrambled" : "", turn, turns,
+                     (int)i, got, allPrev[turn * cells + i]);
+              return false;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  const int row = 130, col = 70;
+  std::vector<float> costHorizontal, costVertical;
+  std::vector<int> mark;
+  RandomSweepInput(row, col, kInfinity, 7, costHorizontal, costVertical, mark);
+  std::vector<int> pinIndices;
+  for (int i = 0; i < 8; i++)
+    pinIndices.push_back((i * 37 % col) * row + i * 53 % row);
+
+  // The compact predecessors are expanded back for comparison.
+  GamerCpu gamer(row, col, kInfinity);
+  GamerRoute expected, route;
+  gamer.Route(costHorizontal.data(), costVertical.data(), pinIndices, 4,
+              expected, GamerCpuPath::Scalar, 1);
+  route.compactPrev = true;
+  gamer.Route(costHorizontal.data(), costVertical.data(), pinIndices, 4,
+              route, GamerCpuPath::Avx2, 0);
+  size_t cells = (size_t)row * col;
+  route.allPrev.resize(4 * cells);
+  for (int turn = 0; turn < 4; turn++)
+    for (size_t i = 0; i < cells; i++)
+      route.allPrev[turn * cells + i] = route.prevStore.Prev(turn, (int)i);
+  return SameRoute("compact", route, expected);
+}
+
+// Random nets routed with and without GamerRoute::adaptiveTurns for four to
+// sixteen turns, on random costs with blocked edges and on the same grid at
+// a uniform cost, where every net ends after a couple of turns; the routes
+// and marks must be the same. False on the first difference.
+bool ValidateTurns() {
+  const int row = 96, col = 80;
+  std::vector<float> costHorizontal, costVertical;
+  std::vector<int> mark;
+  RandomSweepInput(row, col, kInfinity, 37, costHorizontal, costVertical,
+                   mark);
+  std::vector<GamerNet> nets;
+  RandomNets(row, col, 20, 41, nets);
+  GamerCpu gamer(row, col, kInfinity);
+
+  for (bool uniform : {false, true}) {
+    std::vector<float> h = costHorizontal, v = costVertical;
+    if (uniform) {
+      std::fill(h.begin(), h.end(), 1.f);
+      std::fill(v.begin(), v.end(), 1.f);
+    }
+    for (int turns : {4, 8, 16}) {
+      GamerRoute full, adaptive;
+      adaptive.adaptiveTurns = true;
+      for (size_t n = 0; n < nets.size(); n++) {
+        gamer.Route(h.data(), v.data(), nets[n].pinIndices, turns, full);
+        gamer.Route(h.data(), v.data(), nets[n].pinIndices, turns, adaptive);
+        if (full.routes != adaptive.routes || full.mark != adaptive.mark) {
+          printf("MISMATCH adaptive turns %s, %d turns, net %zu\n",
+                 uniform ? "uniform" : "random", turns, n);
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// ReferenceSweepLine over the given cells of a layered grid, in order.
+void ReferenceSweepCells(const std::vector<int> &line, const float *cost,
+                         float *dist, int *prev) {
+  int n = (int)line.size();
+  std::vector<float> c(n), d(n);
+  std::vector<int> p(n);
+  for (int pos = 0; pos < n; pos++) {
+    c[pos] = cost[line[pos]];
+    d[pos] = dist[line[pos]];
+  }
+  ReferenceSweepLine(n, c.data(), d.data(), p.data());
+  for (int pos = 0; pos < n; pos++) {
+    dist[line[pos]] = d[pos];
+    prev[line[pos]] = line[p[pos]];
+  }
+}
+
+// Two rounds of GamerLayerCpu on layer stacks of one to five layers and grids
+// of odd shapes, against ReferenceSweepLine over every wire line and via
+// stack, and a stack of 33 layers refused; false on the first difference.
+bool ValidateLayers(int threadCount) {
+  using Dir = GamerLayerDir;
+  const std::vector<Dir> stacks[] = {
+      {Dir::Horizontal},
+      {Dir::Vertical},
+      {Dir::Horizontal, Dir::Vertical},
+      {Dir::Vertical, Dir::Horizontal, Dir::Vertical},
+      {Dir::Horizontal, Dir::Vertical, Dir::Horizontal, Dir::Vertical,
+       Dir::Horizontal}};
+  const int shapes[][2] = {{1, 1}, {7, 1}, {1, 7}, {5, 3}, {37, 23}, {40, 70}};
+  for (const auto &dirs : stacks) {
+    for (const auto &shape : shapes) {
+      int row = shape[0], col = shape[1], layers = (int)dirs.size();
+      GamerLayerCpu gamer(row, col, dirs, kInfinity);
+      std::vector<float> cost, via;
+      std::vector<int> mark;
+      RandomLayerInput(row, col, layers, kInfinity, row * 131 + col + layers,
+                       cost, via, mark);
+      size_t cells = gamer.Cells();
+      std::vector<float> dist(cells), expected(cells);
+      std::vector<int> prev(cells), expectedPrev(cells);
+      gamer.CleanDist(mark.data(), dist.data(), threadCount);
+      expected = dist;
+
+      for (int step = 0; step < 4; step++) {
+        std::vector<int> line;
+        if (step & 1) {
+          gamer.RelaxVias(via.data(), dist.data(), prev.data(), threadCount);
+          for (int y = 0; y < col; y++) {
+            for (int x = 0; x < row; x++) {
+              line.clear();
+              for (int layer = 0; layer < layers; layer++)
+                line.push_back(gamer.Index(x, y, layer));
+              ReferenceSweepCells(line, via.data(), expected.data(),
+                                  expectedPrev.data());
+            }
+          }
+        } else {
+          gamer.SweepLayers(cost.data(), dist.data(), prev.data(),
+                            threadCount);
+          for (int layer = 0; layer < layers; layer++) {
+            bool vertical = dirs[layer] == Dir::Vertical;
+            for (int k = 0; k < (vertical ? row : col); k++) {
+              line.clear();
+              for (int pos = 0; pos < (vertical ? col : row); pos++)
+                line.push_back(vertical ? gamer.Index(k, pos, layer)
+                                        : gamer.Index(pos, k, layer));
+              ReferenceSweepCells(line, cost.data(), expected.data(),
+                                  expectedPrev.data());
+            }
+          }
+        }
+
+        for (size_t i = 0; i < cells; i++) {
+          if (dist[i] != expected[i] || prev[i] != expectedPrev[i]) {
+            printf("MISMATCH %dx%dx%d step %d cell %d: dist %g prev %d, "
+                   "expected %g prev %d\n",
+                   row, col, layers, step, (int)i, dist[i], prev[i],
+                   expected[i], expectedPrev[i]);
+            return false;
+          }
+        }
+      }
+    }
+  }
+  // More layers than the sweeps hold are refused, not overrun.
+  try {
+    GamerLayerCpu gamer(4, 4, std::vector<Dir>(33, Dir::Horizontal));
+    printf("MISMATCH 33 layers were accepted\n");
+    return false;
+  } catch (const std::runtime_error &) {
+  }
+  return true;
+}
+} // namespace
+
+void RandomSweepInput(int row, int col, float infinity, unsigned int seed,
+                      std::vector<float> &costHorizontal,
+                      std::vector<float> &costVertical,
+                      std::vector<int> &mark) {
+  size_t cells = (size_t)row * col;
+  std::mt19937 rng(seed);
+  auto edgeCost = [&]() {
+    unsigned int r = rng();
+    return r % 20 == 0 ? infinity : (float)(1 + (r >> 8) % 9);
+  };
+  costHorizontal.resize(cells);
+  costVertical.resize(cells);
+  mark.resize(cells);
+  for (size_t i = 0; i < cells; i++) {
+    costHorizontal[i] = edgeCost();
+    costVertical[i] = edgeCost();
+    mark[i] = rng() % 50 == 0;
+  }
+}
+
+void RandomLayerInput(int row, int col, int layers, float infinity,
+                      unsigned int seed, std::vector<float> &cost,
+                      std::vector<float> &via, std::vector<int> &mark) {
+  size_t cells = (size_t)row * col * layers;
+  std::mt19937 rng(seed);
+  cost.resize(cells);
+  via.resize(cells);
+  mark.resize(cells);
+  for (size_t i = 0; i < cells; i++) {
+    unsigned int r = rng();
+    cost[i] = r % 20 == 0 ? infinity : (float)(1 + (r >> 8) % 9);
+    via[i] = (float)(4 + (r >> 16) % 5);
+    mark[i] = rng() % 50 == 0;
+  }
+}
+
+void RandomNets(int row, int col, int count, unsigned int seed,
+                std::vector<GamerNet> &nets) {
+  const int window = 24;
+  std::mt19937 rng(seed);
+  std::vector<char> taken((size_t)row * col, 0);
+  nets.assign(count, GamerNet());
+  for (GamerNet &net : nets) {
+    int x0 = (int)(rng() % std::max(1, row - window));
+    int y0 = (int)(rng() % std::max(1, col - window));
+    int pins = 2 + (int)(rng() % 4);
+    // Gives up on a pin after a few tries in a crowded window.
+    for (int tries = 0; (int)net.pinIndices.size() < pins && tries < 64;
+         tries++) {
+      int x = std::min(row - 1, x0 + (int)(rng() % window));
+      int y = std::min(col - 1, y0 + (int)(rng() % window));
+      int cell = y * row + x;
+      if (!taken[cell]) {
+        taken[cell] = 1;
+        net.pinIndices.push_back(cell);
+      }
+    }
+  }
+}
+
+void RandomSpreadNets(int row, int col, int count, unsigned int seed,
+                      std::vector<GamerNet> &nets) {
+  std::mt19937 rng(seed);
+  std::vector<char> taken((size_t)row * col, 0);
+  nets.assign(count, GamerNet());
+  for (GamerNet &net : nets) {
+    int level = 0;
+    while ((8 << level) < std::max(row, col) && rng() % 2)
+      level++;
+    int window = 8 << level;
+    int width = std::min(row, window), height = std::min(col, window);
+    int x0 = (int)(rng() % (row - width + 1));
+    int y0 = (int)(rng() % (col - height + 1));
+    int pins = std::min(8, 2 + level / 2 + (int)(rng() % 3));
+    for (int tries = 0; (int)net.pinIndices.size() < pins && tries < 64;
+         tries++) {
+      int cell = (y0 + (int)(rng() % height)) * row + x0 +
+                 (int)(rng() % width);
+      if (!taken[cell]) {
+        taken[cell] = 1;
+        net.pinIndices.push_back(cell);
+      }
+    }
+  }
+}
+
+void DemoRouteInput(std::vector<float> &costHorizontal,
+                    std::vector<float> &costVertical,
+                    std::vector<int> &pinIndices) {
+  const int row = kDemoRow;
+  costHorizontal.assign(kDemoRow * kDemoCol, 0.f);
+  costHorizontal[0 + 0 * row] = 0;
+  costHorizontal[1 + 0 * row] = 1;
+  costHorizontal[2 + 0 * row] = 3;
+  costHorizontal[3 + 0 * row] = 1000;
+  costHorizontal[0 + 1 * row] = 0;
+  costHorizontal[1 + 1 * row] = 2;
+  costHorizontal[2 + 1 * row] = 7;
+  costHorizontal[3 + 1 * row] = 1000;
+  costHorizontal[0 + 2 * row] = 0;
+  costHorizontal[1 + 2 * row] = 5;
+  costHorizontal[2 + 2 * row] = 4;
+  costHorizontal[3 + 2 * row] = 1000;
+  costVertical.assign(kDemoRow * kDemoCol, 0.f);
+  costVertical[0 + 0 * row] = 0;
+  costVertical[0 + 1 * row] = 9;
+  costVertical[0 + 2 * row] = 3;
+  costVertical[0 + 3 * row] = 1000;
+  costVertical[1 + 0 * row] = 0;
+  costVertical[1 + 1 * row] = 5;
+  costVertical[1 + 2 * row] = 7;
+  costVertical[1 + 3 * row] = 1000;
+  costVertical[2 + 0 * row] = 0;
+  costVertical[2 + 1 * row] = 1;
+  costVertical[2 + 2 * row] = 2;
+  costVertical[2 + 3 * row] = 1000;
+  pinIndices = {0 * row + 0, 1 * row + 2, 2 * row + 0};
+}
+
+bool RunGoldenCheck() {
+  // What the shaders leave in the buffers after routing the demo net.
+  GamerRoute golden;
+  golden.dist = {0,  0,  0,    1000, 7,    5,    0,    1000,
+                 10, 6,  2,    1000, 1000, 1000, 1000, 1000};
+  golden.allPrev = {0, 1, 2,  3,  6,  6,  6,  7,  8,  9,  10, 11, 12,
+                    13, 14, 15, 0,  1,  2,  3,  4,  1,  6,  7,  4,  1,
+                    6,  11, 12, 13, 14, 15, 0,  1,  2,  3,  5,  5,  6,
+                    7,  10, 10, 10, 11, 12, 13, 14, 15, 0,  1,  2,  3,
+                    4,  5,  6,  7,  4,  9,  10, 11, 12, 13, 14, 15};
+  golden.mark = {1, 1, 1, 0, 1, 1, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0};
+  // (2, 0) - (2, 1) and (0, 0) - (2, 0) for pin (2, 1), then (0, 1) - (0, 2),
+  // (0, 1) - (1, 1) and (1, 0) - (1, 1) for pin (0, 2).
+  golden.routes = {10, 2, 6, 0, 2, 4, 8, 4, 5, 1, 5};
+
+  std::vector<float> costHorizontal, costVertical;
+  std::vector<int> pinIndices;
+  DemoRouteInput(costHorizontal, costVertical, pinIndices);
+  GamerCpu gamer(kDemoRow, kDemoCol, kDemoInfinity);
+  GamerRoute route;
+  bool valid = true;
+  for (const Config &config : Configs()) {
+    gamer.Route(costHorizontal.data(), costVertical.data(), pinIndices,
+                kDemoMaxTurns, route, config.path, config.threads);
+    valid = SameRoute(config.name, route, golden) && valid;
+  }
+  printf("demo net %s the shader results\n",
+         valid ? "matches" : "DOES NOT match");
+  return valid;
+}
+
+bool RunValidation() {
+  bool sweeps = true;
+  for (const Config &config : Configs())
+    sweeps = ValidateSweeps(config.path, config.threads) && sweeps;
+  sweeps = ValidateSweeps(GamerCpuPath::Avx2, 3) && sweeps;
+  sweeps = ValidateRowKernel() && sweeps;
+  bool routes = ValidateRoutes();
+  printf("sweeps %s the brute-force reference, routes %s on every path\n",
+         sweeps ? "match" : "DO NOT match", routes ? "agree" : "DO NOT agree");
+  bool prev = ValidatePrev();
+  printf("compact predecessors %s allPrev\n", prev ? "match" : "DO NOT match");
+  bool turns = ValidateTurns();
+  printf("adaptive turns %s\n",
+         turns ? "route as every turn does" : "CHANGE the routes");
+  bool layers = ValidateLayers(1) && ValidateLayers(3);
+  printf("layered grids: sweeps and vias %s the brute-force reference\n",
+         layers ? "match" : "DO NOT match");
+  bool golden = RunGoldenCheck();
+  return sweeps && routes && prev && turns && layers && golden;
+}
+
+void RunSweepBenchmark(int iterations) {
+  const int hwThreads =
+      (int)std::max(1u, std::thread::hardware_concurrency());
+  RunValidation();
+  printf("AVX2 %s, %d hardware threads\n",
+         GamerCpu::Avx2Supported() ? "enabled" : "unavailable", hwThreads);
+  printf("%11s %10s %14s %14s %10s %10s\n", "grid", "path", "horizontal/s",
+         "vertical/s", "Mcells/s", "route ms");
+
+  const int grids[][2] = {
+      {1000, 1000}, {4096, 1024}, {1024, 4096}, {4000, 4000}};
+  for (const auto &grid : grids) {
+    int row = grid[0], col = grid[1];
+    std::vector<float> costHorizontal, costVertical;
+    std::vector<int> mark;
+    RandomSweepInput(row, col, kInfinity, 1, costHorizontal, costVertical,
+                     mark);
+    size_t cells = (size_t)row * col;
+    std::vector<float> dist(cells);
+    std::vector<int> prev(cells);
+    GamerCpu gamer(row, col, kInfinity);
+    // A net of eight pins spread over the grid, routed with four turns.
+    std::vector<int> pinIndices;
+    for (int i = 0; i < 8; i++)
+      pinIndices.push_back((int)((size_t)(i * 37 % 64) * col / 64 * row +
+                                 (size_t)(i * 53 % 64) * row / 64));
+    GamerRoute route;
+
+    for (const Config &config : Configs()) {
+      for (size_t i = 0; i < cells; i++)
+        dist[i] = mark[i] ? 0.f : kInfinity;
+      gamer.SweepHorizontal(costHorizontal.data(), dist.data(), prev.data(),
+                            config.path, config.threads);
+
+      auto start = std::chrono::high_resolution_clock::now();
+      for (int i = 0; i < iterations; i++)
+        gamer.SweepHorizontal(costHorizontal.data(), dist.data(), prev.data(),
+                              config.path, config.threads);
+      auto mid = std::chrono::high_resolution_clock::now();
+      for (int i = 0; i < iterations; i++)
+        gamer.SweepVertical(costVertical.data(), dist.data(), prev.data(),
+                            config.path, config.threads);
+      auto stop = std::chrono::high_resolution_clock::now();
+      gamer.Route(costHorizontal.data(), costVertical.data(), pinIndices, 4,
+                  route, config.path, config.threads);
+      auto routed = std::chrono::high_resolution_clock::now();
+
+      double horizontal = std::chrono::duration<double>(mid - start).count();
+      double vertical = std::chrono::duration<double>(stop - mid).count();
+      double routeMs = std::chrono::duration<double, std::milli>(routed - stop)
+                           .count();
+      printf("%5dx%-5d %10s %14.1f %14.1f %10.1f %10.1f\n", row, col,
+             config.name, iterations / horizontal, iterations / vertical,
+             2.0 * iterations * cells / (horizontal + vertical) / 1e6, routeMs);
+    }
+  }
+
+  RunPrevBenchmark();
+  RunPinBenchmark();
+  RunTurnBenchmark();
+  RunLayerBenchmark();
+  RunBatchBenchmark();
+  RunCongestionBenchmark();
+  RunWindowBenchmark();
+}
+
+void RunBatchBenchmark(int netCount) {
+  const int row = 256, col = 256;
+  const int hwThreads =
+      (int)std::max(1u, std::thread::hardware_concurrency());
+  std::vector<float> costHorizontal, costVertical;
+  std::vector<int> mark;
+  RandomSweepInput(row, col, kInfinity, 3, costHorizontal, costVertical, mark);
+  std::vector<GamerNet> nets;
+  RandomNets(row, col, netCount, 5, nets);
+
+  std::vector<int> threadCounts;
+  for (int threads = 1; threads < hwThreads; threads *= 2)
+    threadCounts.push_back(threads);
+  threadCounts.push_back(hwThreads);
+
+  printf("\n%d nets on %dx%d, rip-up-and-reroute\n", netCount, row, col);
+  printf("%8s %7s %8s %12s %12s %9s %9s %8s\n", "threads", "passes",
+         "routed", "pass 1 n/s", "total n/s", "overused", "open", "speedup");
+  GamerBatchRouter router(row, col, kInfinity);
+  GamerBatchOptions options;
+  std::vector<GamerNetRoute> expected, routes;
+  double baseline = 0.0;
+  for (int threads : threadCounts) {
+    GamerBatchStats stats =
+        router.Route(costHorizontal.data(), costVertical.data(), nets,
+                     routes, options, threads);
+    double seconds = 0.0;
+    for (double pass : stats.passSeconds)
+      seconds += pass;
+    int open = 0;
+    for (const GamerNetRoute &route : routes)
+      open += !route.complete;
+    bool same = true;
+    if (expected.empty())
+      expected = routes;
+    for (size_t n = 0; n < routes.size(); n++)
+      same = same && routes[n].segments == expected[n].segments;
+    if (baseline == 0.0)
+      baseline = seconds;
+
+    printf("%8d %7d %8d %12.1f %12.1f %9d %9d %7.2fx%s\n", threads,
+           stats.iterations, stats.routedNets,
+           netCount / stats.passSeconds[0], stats.routedNets / seconds,
+           stats.overusedCells, open, baseline / seconds,
+           same ? "" : "  MISMATCH");
+  }
+}
+
+void RunPrevBenchmark(int traces) {
+  printf("\n%11s %5s %12s %12s %10s %11s %11s %10s\n", "grid", "turns",
+         "allPrev MB", "compact MB", "exceptions", "int ns", "compact ns",
+         "encode ms");
+  const int grids[][2] = {{1000, 1000}, {2048, 2048}};
+  for (const auto &grid : grids) {
+    int row = grid[0], col = grid[1];
+    std::vector<float> costHorizontal, costVertical;
+    std::vector<int> mark;
+    RandomSweepInput(row, col, kInfinity, 11, costHorizontal, costVertical,
+                     mark);
+    size_t cells = (size_t)row * col;
+    GamerCpu gamer(row, col, kInfinity);
+    std::vector<float> dist(cells);
+    std::mt19937 rng(13);
+    std::vector<int> targets(traces);
+    for (int &target : targets)
+      target = (int)(rng() % cells);
+
+    for (int turns : {4, 8}) {
+      std::vector<int> allPrev(turns * cells);
+      GamerPrevStore store;
+      store.Reset(row, col, turns);
+      double encodeSeconds = 0.0;
+      gamer.CleanDist(mark.data(), dist.data());
+      for (int turn = 0; turn < turns; turn++) {
+        int *prev = allPrev.data() + turn * cells;
+        if (turn & 1)
+          gamer.SweepVertical(costVertical.data(), dist.data(), prev);
+        else
+          gamer.SweepHorizontal(costHorizontal.data(), dist.data(), prev);
+        auto start = std::chrono::high_resolution_clock::now();
+        store.Store(turn, prev);
+        auto stop = std::chrono::high_resolution_clock::now();
+        encodeSeconds += std::chrono::duration<double>(stop - start).count();
+      }
+
+      bool same = true;
+      for (int turn = 0; turn < turns && same; turn++)
+        for (size_t i = 0; i < cells && same; i++)
+          same = store.Prev(turn, (int)i) == allPrev[turn * cells + i];
+
+      // Walk back from every target through all turns, as TracePath does.
+      long long sumInt = 0, sumCompact = 0;
+      auto start = std::chrono::high_resolution_clock::now();
+      for (int target : targets) {
+        int idx = target;
+        for (int t = turns - 1; t >= 0; t--)
+          idx = allPrev[t * cells + idx];
+        sumInt += idx;
+      }
+      auto mid = std::chrono::high_resolution_clock::now();
+      for (int target : targets) {
+        int idx = target;
+        for (int t = turns - 1; t >= 0; t--)
+          idx = store.Prev(t, idx);
+        sumCompact += idx;
+      }
+      auto stop = std::chrono::high_resolution_clock::now();
+
+      double intNs =
+          std::chrono::duration<double, std::nano>(mid - start).count();
+      double compactNs =
+          std::chrono::duration<double, std::nano>(stop - mid).count();
+      printf("%5dx%-5d %5d %12.1f %12.1f %10zu %11.1f %11.1f %10.1f%s\n", row,
+             col, turns, allPrev.size() * sizeof(int) / 1e6,
+             store.Bytes() / 1e6, store.Exceptions(), intNs / traces,
+             compactNs / traces, encodeSeconds * 1e3,
+             same && sumInt == sumCompact ? "" : "  MISMATCH");
+    }
+  }
+}
+
+void RunPinBenchmark() {
+  const int row = 512, col = 512, turns = 4;
+  const int hwThreads =
+      (int)std::max(1u, std::thread::hardware_concurrency());
+  size_t cells = (size_t)row * col;
+  std::vector<float> costHorizontal, costVertical;
+  std::vector<int> mark;
+  RandomSweepInput(row, col, kInfinity, 17, costHorizontal, costVertical,
+                   mark);
+  GamerCpu gamer(row, col, kInfinity);
+  std::vector<int> shuffled(cells);
+  for (size_t i = 0; i < cells; i++)
+    shuffled[i] = (int)i;
+  std::mt19937 rng(19);
+  std::shuffle(shuffled.begin(), shuffled.end(), rng);
+  std::vector<int> threadCounts = {1};
+  if (hwThreads > 1)
+    threadCounts.push_back(hwThreads);
+
+  printf("\npin selection and tracing on %dx%d, %d turns\n", row, col, turns);
+  printf("%6s %8s %8s %12s %12s %8s\n", "pins", "threads", "traced",
+         "pins/s", "sweeps us", "trace %");
+  for (int pins : {64, 1024, 8192}) {
+    std::vector<int> pinIndices(shuffled.begin(), shuffled.begin() + pins);
+    // One round of sweeps, as Route does for every pin, from a tree that
+    // covers the sources of the grid and the first pin.
+    GamerRoute swept;
+    swept.dist.assign(cells, 0.f);
+    swept.allPrev.assign(turns * cells, 0);
+    swept.mark = mark;
+    swept.mark[pinIndices[0]] = 1;
+    swept.isRoutedPin.assign(pins, 0);
+    swept.isRoutedPin[0] = 1;
+    swept.routes.assign(1, 0);
+    auto start = std::chrono::high_resolution_clock::now();
+    gamer.CleanDist(swept.mark.data(), swept.dist.data());
+    for (int turn = 0; turn < turns; turn++) {
+      int *prev = swept.allPrev.data() + turn * cells;
+      if (turn & 1)
+        gamer.SweepVertical(costVertical.data(), swept.dist.data(), prev);
+      else
+        gamer.SweepHorizontal(costHorizontal.data(), swept.dist.data(), prev);
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
+    double sweepSeconds = std::chrono::duration<double>(stop - start).count();
+
+    // Trace every pin the sweeps reached against the same distances, which
+    // leaves only the work of TracePath.
+    std::vector<int> expected;
+    for (int threads : threadCounts) {
+      GamerRoute route = swept;
+      int traced = 0;
+      start = std::chrono::high_resolution_clock::now();
+      while (gamer.TracePath(pinIndices, turns, route, threads))
+        traced++;
+      stop = std::chrono::high_resolution_clock::now();
+      double seconds = std::chrono::duration<double>(stop - start).count();
+      if (expected.empty())
+        expected = route.routes;
+      printf("%6d %8d %8d %12.0f %12.1f %7.1f%%%s\n", pins, threads, traced,
+             traced / seconds, sweepSeconds * 1e6,
+             100.0 * seconds / traced / (seconds / traced + sweepSeconds),
+             route.routes == expected ? "" : "  MISMATCH");
+    }
+  }
+}
+
+void RunTurnBenchmark(int netCount) {
+  printf("\nadaptive turns, %d nets\n", netCount);
+  printf("%11s %5s %12s %12s %7s %10s %10s\n", "grid", "turns",
+         "full sweeps", "adaptive", "saved", "full ms", "adaptive ms");
+  const int grids[][2] = {{256, 256}, {512, 512}};
+  for (const auto &grid : grids) {
+    int row = grid[0], col = grid[1];
+    std::vector<float> costHorizontal, costVertical;
+    std::vector<int> mark;
+    RandomSweepInput(row, col, kInfinity, 23, costHorizontal, costVertical,
+                     mark);
+    std::vector<GamerNet> nets;
+    RandomNets(row, col, netCount, 29, nets);
+    GamerCpu gamer(row, col, kInfinity);
+
+    for (int turns : {4, 8, 16}) {
+      long long sweeps[2] = {0, 0};
+      double seconds[2] = {0.0, 0.0};
+      bool same = true;
+      GamerRoute full, adaptive;
+      adaptive.adaptiveTurns = true;
+      for (const GamerNet &net : nets) {
+        GamerRoute *routes[2] = {&full, &adaptive};
+        for (int k = 0; k < 2; k++) {
+          auto start = std::chrono::high_resolution_clock::now();
+          gamer.Route(costHorizontal.data(), costVertical.data(),
+                      net.pinIndices, turns, *routes[k]);
+          auto stop = std::chrono::high_resolution_clock::now();
+          seconds[k] += std::chrono::duration<double>(stop - start).count();
+          sweeps[k] += routes[k]->sweeps;
+        }
+        same = same && full.routes == adaptive.routes &&
+               full.mark == adaptive.mark;
+      }
+      printf("%5dx%-5d %5d %12lld %12lld %6.1f%% %10.1f %10.1f%s\n", row, col,
+             turns, sweeps[0], sweeps[1],
+             100.0 * (sweeps[0] - sweeps[1]) / sweeps[0], seconds[0] * 1e3,
+             seconds[1] * 1e3, same ? "" : "  MISMATCH");
+    }
+  }
+}
+
+void RunLayerBenchmark(int iterations) {
+  using Dir = GamerLayerDir;
+  const int hwThreads =
+      (int)std::max(1u, std::thread::hardware_concurrency());
+  printf("\n%11s %6s %8s %10s %10s %10s %10s\n", "grid", "layers", "threads",
+         "layers/s", "vias/s", "Mcells/s", "route ms");
+
+  struct Grid {
+    int row, col;
+    std::vector<Dir> dirs;
+  };
+  const Grid grids[] = {
+      {512, 512, {Dir::Horizontal, Dir::Vertical}},
+      {512, 512,
+       {Dir::Horizontal, Dir::Vertical, Dir::Horizontal, Dir::Vertical,
+        Dir::Horizontal, Dir::Vertical}},
+      {1000, 1000,
+       {Dir::Horizontal, Dir::Vertical, Dir::Horizontal, Dir::Vertical}}};
+  std::vector<int> threadCounts = {1};
+  if (hwThreads > 1)
+    threadCounts.push_back(hwThreads);
+  for (const Grid &grid : grids) {
+    int layers = (int)grid.dirs.size();
+    GamerLayerCpu gamer(grid.row, grid.col, grid.dirs, kInfinity);
+    std::vector<float> cost, via;
+    std::vector<int> mark;
+    RandomLayerInput(grid.row, grid.col, layers, kInfinity, 31, cost, via,
+                     mark);
+    size_t cells = gamer.Cells();
+    std::vector<float> dist(cells);
+    std::vector<int> prev(cells);
+    // A net of eight pins spread over the grid and its layers, routed with
+    // three rounds.
+    std::vector<int> pinIndices;
+    for (int i = 0; i < 8; i++)
+      pinIndices.push_back(gamer.Index(i * 53 % 64 * grid.row / 64,
+                                       i * 37 % 64 * grid.col / 64,
+                                       i % layers));
+    GamerLayerRoute route;
+
+    for (int threads : threadCounts) {
+      gamer.CleanDist(mark.data(), dist.data(), threads);
+      auto start = std::chrono::high_resolution_clock::now();
+      for (int i = 0; i < iterations; i++)
+        gamer.SweepLayers(cost.data(), dist.data(), prev.data(), threads);
+      auto mid = std::chrono::high_resolution_clock::now();
+      for (int i = 0; i < iterations; i++)
+        gamer.RelaxVias(via.data(), dist.data(), prev.data(), threads);
+      auto stop = std::chrono::high_resolution_clock::now();
+      gamer.Route(cost.data(), via.data(), pinIndices, 3, route, threads);
+      auto routed = std::chrono::high_resolution_clock::now();
+
+      double sweeps = std::chrono::duration<double>(mid - start).count();
+      double vias = std::chrono::duration<double>(stop - mid).count();
+      double routeMs = std::chrono::duration<double, std::milli>(routed - stop)
+                           .count();
+      printf("%5dx%-5d %6d %8d %10.1f %10.1f %10.1f %10.1f\n", grid.row,
+             grid.col, layers, threads, iterations / sweeps,
+             iterations / vias, 2.0 * iterations * cells / (sweeps + vias) / 1e6,
+             routeMs);
+    }
+  }
+}
+
+void RunCongestionBenchmark(int netCount, int maxIterations) {
+  const int row = 128, col = 128;
+  std::vector<float> costHorizontal, costVertical;
+  std::vector<int> mark;
+  RandomSweepInput(row, col, kInfinity, 3, costHorizontal, costVertical, mark);
+  std::vector<GamerNet> nets;
+  RandomNets(row, col, netCount, 4, nets);
+
+  struct Mode {
+    const char *name;
+    bool negotiated;
+    int groupNets;
+  };
+  const Mode modes[] = {{"additive", false, 0},
+                        {"negotiated", true, 0},
+                        {"negotiated", true, 64},
+                        {"negotiated", true, 16}};
+
+  printf("\n%d nets on %dx%d, up to %d passes\n", netCount, row, col,
+         maxIterations);
+  printf("%-11s %6s %7s %8s %9s %6s %9s %9s %9s\n", "costs", "group",
+         "passes", "routed", "overused", "open", "wire", "route s",
+         "update s");
+  GamerBatchRouter router(row, col, kInfinity);
+  std::vector<GamerNetRoute> routes;
+  for (const Mode &mode : modes) {
+    GamerBatchOptions options;
+    options.maxIterations = maxIterations;
+    options.negotiated = mode.negotiated;
+    options.groupNets = mode.groupNets;
+    GamerBatchStats stats = router.Route(costHorizontal.data(),
+                                         costVertical.data(), nets, routes,
+                                         options);
+    double routeSeconds = 0.0, updateSeconds = 0.0;
+    for (int p = 0; p < stats.iterations; p++) {
+      routeSeconds += stats.passSeconds[p];
+      updateSeconds += stats.updateSeconds[p];
+    }
+    int open = 0;
+    long long wire = 0;
+    for (const GamerNetRoute &route : routes) {
+      open += !route.complete;
+      for (size_t s = 0; s < route.segments.size(); s += 2) {
+        int a = route.segments[s], b = route.segments[s + 1];
+        wire += a / row == b / row ? b - a : (b - a) / row;
+      }
+    }
+    printf("%-11s %6d %7d %8d %9d %6d %9lld %9.3f %9.4f\n", mode.name,
+           mode.groupNets, stats.iterations, stats.routedNets,
+           stats.overusedCells, open, wire, routeSeconds, updateSeconds);
+  }
+}
+
+void RunWindowBenchmark(int netCount) {
+  const int sizes[] = {256, 1024};
+  const int margins[] = {-1, 0, 4, 16};
+  printf("\n%d spread nets, one pass, windows of the pins' box plus margin\n",
+         netCount);
+  printf("%9s %7s %14s %10s %8s %6s %10s %10s\n", "grid", "margin",
+         "Mcells/net", "reduction", "widened", "open", "wire", "nets/s");
+  for (int size : sizes) {
+    std::vector<float> costHorizontal, costVertical;
+    std::vector<int> mark;
+    RandomSweepInput(size, size, kInfinity, 31, costHorizontal, costVertical,
+                     mark);
+    std::vector<GamerNet> nets;
+    RandomSpreadNets(size, size, netCount, 37, nets);
+
+    GamerBatchRouter router(size, size, kInfinity);
+    std::vector<GamerNetRoute> routes;
+    double wholeCells = 0.0;
+    long long wholeWire = 0;
+    for (int margin : margins) {
+      GamerBatchOptions options;
+      options.maxIterations = 1;
+      options.windowMargin = margin;
+      GamerBatchStats stats = router.Route(costHorizontal.data(),
+                                           costVertical.data(), nets, routes,
+                                           options);
+      double swept = 0.0;
+      long long wire = 0;
+      int widened = 0, open = 0;
+      for (const GamerNetRoute &route : routes) {
+        swept += (double)route.sweptCells;
+        widened += route.windows > 1;
+        open += !route.complete;
+        for (size_t s = 0; s < route.segments.size(); s += 2) {
+          int a = route.segments[s], b = route.segments[s + 1];
+          wire += a / size == b / size ? b - a : (b - a) / size;
+        }
+      }
+      if (margin < 0) {
+        wholeCells = swept;
+        wholeWire = wire;
+      }
+      char grid[32];
+      snprintf(grid, sizeof(grid), "%dx%d", size, size);
+      printf("%9s %7s %14.3f %9.1fx %8d %6d %+9.2f%% %10.1f\n", grid,
+             margin < 0 ? "whole" : std::to_string(margin).c_str(),
+             swept / netCount / 1e6, wholeCells / swept, widened, open,
+             100.0 * (wire - wholeWire) / wholeWire,
+             netCount / stats.passSeconds[0]);
+    }
+  }
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "GamerBatch.h"
+#include <vector>
+
+// The grid and net of the BasicGamer2DApp demo.
+const int kDemoRow = 4;
+const int kDemoCol = 4;
+const int kDemoMaxTurns = 4;
+const float kDemoInfinity = 1000.f;
+
+// Random sweep input for a row x col grid: integer edge costs 1..9 with about
+// one edge in twenty blocked (cost infinity), and about one cell in fifty
+// marked as a source. The same seed gives the same grid everywhere.
+void RandomSweepInput(int row, int col, float infinity, unsigned int seed,
+                      std::vector<float> &costHorizontal,
+                      std::vector<float> &costVertical,
+                      std::vector<int> &mark);
+
+// The same for a grid of layers, laid out as in GamerLayerCpu: wire costs as
+// above and via costs 4..8.
+void RandomLayerInput(int row, int col, int layers, float infinity,
+                      unsigned int seed, std::vector<float> &cost,
+                      std::vector<float> &via, std::vector<int> &mark);
+
+// count nets of two to five pins on distinct cells, each within a 24x24
+// window of a random row x col grid, as local nets of a placed design are.
+void RandomNets(int row, int col, int count, unsigned int seed,
+                std::vector<GamerNet> &nets);
+
+// count nets of two to eight pins on distinct cells, with the heavy tail of
+// net sizes of placed designs: a net spans a window 8 cells across with
+// probability one half, 16 with one quarter and so on up to the whole
+// row x col grid, and wider nets have more pins.
+void RandomSpreadNets(int row, int col, int count, unsigned int seed,
+                      std::vector<GamerNet> &nets);
+
+// The demo's hand-set edge costs, with the last column and row blocked, and
+// its three pins.
+void DemoRouteInput(std::vector<float> &costHorizontal,
+                    std::vector<float> &costVertical,
+                    std::vector<int> &pinIndices);
+
+// Routes the demo net with GamerCpu on every path, on one and on all hardware
+// threads, and compares dist, allPrev, mark and routes with the results of
+// the shaders. Prints the first difference; true when all match.
+bool RunGoldenCheck();
+
+// The checks of RunSweepBenchmark without the timing: the sweeps of every
+// path against a brute-force scan of every line on small grids of odd shapes
+// (eight rows and more, so that the AVX2 path takes whole groups), the paths
+// against each other on a whole net, GamerPrevStore and compactPrev routing
+// against allPrev, adaptiveTurns routing against every turn, GamerLayerCpu
+// sweeps and vias against the same scan, and the demo net against the golden
+// results. Prints every mismatch; true when there is none.
+bool RunValidation();
+
+// Full-grid sweeps per second of GamerCpu for square and non-square grids
+// from 1000x1000 up, scalar and AVX2 on one and on all hardware threads, and
+// the time to route a net of eight pins. Runs RunValidation first; a
+// mismatch is printed and the timing still runs. Ends with
+// RunPrevBenchmark, RunPinBenchmark, RunTurnBenchmark, RunLayerBenchmark,
+// RunBatchBenchmark, RunCongestionBenchmark and RunWindowBenchmark.
+void RunSweepBenchmark(int iterations = 10);
+
+// Memory of allPrev against GamerPrevStore for four and eight turns on
+// 1000x1000 and 2048x2048 grids, the time to walk traces paths back through
+// every turn in each, and the time to encode the turns. Every predecessor is
+// checked against allPrev.
+void RunPrevBenchmark(int traces = 100000);
+
+// Pins per second of GamerCpu::TracePath, closest-pin search and backtrace,
+// for nets of 64 to 8192 pins on a 512x512 grid on one and on all hardware
+// threads, beside the time of one round of sweeps and the share of a pin's
+// time the trace takes.
+void RunPinBenchmark();
+
+// Sweeps run by GamerCpu::Route for netCount random nets on random cost
+// grids of 256x256 and 512x512 with four to sixteen turns allowed, with and
+// without GamerRoute::adaptiveTurns, the sweeps saved and the time of each;
+// the routes and marks of the two are checked to be the same.
+void RunTurnBenchmark(int netCount = 100);
+
+// Layer sweeps and via relaxations per second of GamerLayerCpu on grids of
+// two to six layers with alternating directions, on one and on all hardware
+// threads, and the time to route a net of eight pins over three rounds.
+void RunLayerBenchmark(int iterations = 5);
+
+// Nets per second of GamerBatchRouter on a 256x256 grid for doubling thread
+// counts up to all hardware threads, with rip-up-and-reroute passes; the
+// routes of every thread count are checked against those of one thread.
+void RunBatchBenchmark(int netCount = 400);
+
+// Rip-up-and-reroute of netCount nets crowded onto a 128x128 grid with the
+// additive congestion costs and with negotiated costs in groups of all, 64
+// and 16 nets: passes until no cell is overused (at most maxIterations), the
+// cells still overused, open nets, wire length, and the seconds spent routing
+// and updating usage and costs.
+void RunCongestionBenchmark(int netCount = 300, int maxIterations = 150);
+
+// GamerBatchRouter on RandomSpreadNets nets of 256x256 and 1024x1024 grids,
+// on the whole grid and on windows of margins 0 to 16: cells swept per net,
+// the reduction from the whole grid, nets that needed a wider window, open
+// nets, wire length against the whole grid and nets per second.
+void RunWindowBenchmark(int netCount = 400);
@@ -8,3 +8,9 @@
 #ifndef INFINITY_DISTANCE
 #define INFINITY_DISTANCE 1000
 #endif
+
+// Cells of a row or column scanned by one thread group in a sweep, a power of
+// two. Longer lines are split into several blocks (see GamerSweep.hlsli).
+#ifndef SWEEP_BLOCK
+#define SWEEP_BLOCK 1024
+#endif
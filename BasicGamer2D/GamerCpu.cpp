@@ -0,0 +1,384 @@
+#include "GamerCpu.h"
+#include <Common/CpuFeatures.h>
+#include <Common/ParallelFor.h>
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+// Vertical strips are a multiple of this many columns wide, so that threads
+// never share a cache line of a row.
+#define GAMER_CPU_STRIP_ALIGN 16
+// Pins per task of the closest-pin search, and segment cells per task of the
+// marking in TracePath; anything shorter runs on the calling thread.
+#define GAMER_CPU_SELECT_CHUNK 4096
+#define GAMER_CPU_MARK_CHUNK 4096
+// GamerSweepRowsAvx2 gathers eight rows a column at a time and is slower than
+// the scalar scan of one row after another (61.5 against 103.9 sweeps/s at
+// 1000x1000, 17.5 against 22.8 at 4096x1024), so SweepHorizontal keeps to the
+// scalar kernel on the AVX2 path until it is faster. -validate checks it
+// either way.
+#define GAMER_CPU_AVX2_ROWS 0
+
+GamerCpu::GamerCpu(int row, int col, float infinity)
+    : mRow(row), mCol(col), mInfinity(infinity),
+      mBest((size_t)row * col), mBestPrev((size_t)row * col) {}
+
+void GamerCpu::Resize(int row, int col) {
+  mRow = row;
+  mCol = col;
+  mBest.resize((size_t)row * col);
+  mBestPrev.resize((size_t)row * col);
+}
+
+void GamerCpu::Route(const float *costHorizontal, const float *costVertical,
+                     const std::vector<int> &pinIndices, int maxTurns,
+                     GamerRoute &route, GamerCpuPath path, int threadCount) {
+  size_t cells = (size_t)mRow * mCol;
+  route.dist.assign(cells, 0.f);
+  if (route.compactPrev) {
+    route.allPrev.clear();
+    route.prevStore.Reset(mRow, mCol, maxTurns);
+    mTurnPrev.resize(cells);
+  } else {
+    route.allPrev.assign(maxTurns * cells, 0);
+  }
+  route.mark.assign(cells, 0);
+  route.isRoutedPin.assign(pinIndices.size(), 0);
+  route.routes.assign(1, 0);
+  route.sweeps = 0;
+  if (pinIndices.empty())
+    return;
+
+  // SetRootPin
+  route.isRoutedPin[0] = 1;
+  route.mark[pinIndices[0]] = 1;
+
+  float minCost = route.adaptiveTurns
+                      ? MinCost(costHorizontal, costVertical, threadCount)
+                      : 0.f;
+  for (size_t i = 1; i < pinIndices.size(); i++) {
+    CleanDist(route.mark.data(), route.dist.data(), threadCount);
+    GamerBox box = {mRow, mCol, 0, 0};
+    for (size_t p = 0; p < pinIndices.size(); p++) {
+      if (!route.isRoutedPin[p]) {
+        int x = pinIndices[p] % mRow, y = pinIndices[p] / mRow;
+        box = {std::min(box.x0, x), std::min(box.y0, y),
+               std::max(box.x1, x + 1), std::max(box.y1, y + 1)};
+      }
+    }
+    int turns = maxTurns;
+    for (int turn = 0; turn < maxTurns; turn++) {
+      int *prev = route.compactPrev ? mTurnPrev.data()
+                                    : route.allPrev.data() + turn * cells;
+      if (turn & 1)
+        SweepVertical(costVertical, route.dist.data(), prev, path, threadCount);
+      else
+        SweepHorizontal(costHorizontal, route.dist.data(), prev, path,
+                        threadCount);
+      if (route.compactPrev)
+        route.prevStore.Store(turn, prev, threadCount);
+      route.sweeps++;
+
+      // A turn can only lower cells through those the turn before lowered:
+      // the others were already swept in its direction two turns ago. So
+      // every later path into the box of the unrouted pins starts at a cell
+      // this turn lowered, and once the closest pin is closer than all of
+      // them, no later turn changes which pin is picked or how it is
+      // reached. Until a pin is reached there is nothing to compare with.
+      if (route.adaptiveTurns && turn >= 1 && turn + 1 < maxTurns) {
+        int pinId = ClosestPin(pinIndices, route, threadCount);
+        if (pinId != -1 &&
+            route.dist[pinIndices[pinId]] <
+                ChangedMin(route.dist.data(), prev, box, minCost, path,
+                           threadCount)) {
+          turns = turn + 1;
+          break;
+        }
+      }
+    }
+    TracePath(pinIndices, turns, route, threadCount);
+  }
+}
+
+void GamerCpu::CleanDist(const int *mark, float *dist, int threadCount) {
+  ParallelFor(0, mCol, threadCount, [&](int rowId) {
+    size_t base = (size_t)rowId * mRow;
+    for (size_t i = base; i < base + mRow; i++)
+      dist[i] = mark[i] ? 0.f : mInfinity;
+  });
+}
+
+void GamerCpu::SweepHorizontal(const float *costHorizontal, float *dist,
+                               int *prev, GamerCpuPath path, int threadCount) {
+  const bool avx2 =
+      GAMER_CPU_AVX2_ROWS && path == GamerCpuPath::Avx2 && Avx2Supported();
+  GamerSweepArgs args = {mRow, mCol, costHorizontal, dist,
+                         prev, mBest.data(), mBestPrev.data()};
+  ParallelFor(0, (mCol + 7) / 8, threadCount, [&](int group) {
+    int y0 = group * 8;
+    int y1 = std::min(y0 + 8, mCol);
+    if (avx2 && y1 - y0 == 8)
+      GamerSweepRowsAvx2(args, y0);
+    else
+      GamerSweepRows(args, y0, y1);
+  });
+}
+
+void GamerCpu::SweepVertical(const float *costVertical, float *dist, int *prev,
+                             GamerCpuPath path, int threadCount) {
+  // One strip of whole rows per thread, so that each step down the grid
+  // reads long runs of memory.
+  if (threadCount <= 0)
+    threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+  int width = (mRow + threadCount - 1) / threadCount;
+  width = (width + GAMER_CPU_STRIP_ALIGN - 1) / GAMER_CPU_STRIP_ALIGN *
+          GAMER_CPU_STRIP_ALIGN;
+  int strips = (mRow + width - 1) / width;
+
+  const bool avx2 = path == GamerCpuPath::Avx2 && Avx2Supported();
+  GamerSweepArgs args = {mRow, mCol, costVertical, dist,
+                         prev, mBest.data(), mBestPrev.data()};
+  ParallelFor(0, strips, threadCount, [&](int strip) {
+    int x0 = strip * width;
+    int x1 = std::min(x0 + width, mRow);
+    if (avx2)
+      GamerSweepColumnsAvx2(args, x0, x1);
+    else
+      GamerSweepColumns(args, x0, x1);
+  });
+}
+
+bool GamerCpu::TracePath(const std::vector<int> &pinIndices, int numTurns,
+                         GamerRoute &route, int threadCount) {
+  int pinId = ClosestPin(pinIndices, route, threadCount);
+  if (pinId == -1)
+    return false;
+  route.isRoutedPin[pinId] = 1;
+
+  // backtracing, one step per turn; the segments are marked afterwards
+  struct Segment {
+    int start, step, length;
+  };
+  std::vector<Segment> segments;
+  size_t cells = (size_t)mRow * mCol;
+  int idx = pinIndices[pinId];
+  for (int t = numTurns - 1; t >= 0; t--) {
+    int prevIdx = route.compactPrev ? route.prevStore.Prev(t, idx)
+                                    : route.allPrev[t * cells + idx];
+    if (prevIdx == idx)
+      continue;
+    int startIdx = std::min(idx, prevIdx);
+    int endIdx = std::max(idx, prevIdx);
+    route.routes.push_back(startIdx);
+    route.routes.push_back(endIdx);
+    route.routes[0] += 2;
+    int step = idx / mRow == prevIdx / mRow ? 1 : mRow;
+    segments.push_back({startIdx, step, (endIdx - startIdx) / step + 1});
+    idx = prevIdx;
+  }
+
+  // MarkSegments: (segment, first cell) per task, and a thread for every
+  // GAMER_CPU_MARK_CHUNK cells at most
+  std::vector<std::pair<int, int>> tasks;
+  int segmentCells = 0;
+  for (int s = 0; s < (int)segments.size(); s++) {
+    for (int k = 0; k < segments[s].length; k += GAMER_CPU_MARK_CHUNK)
+      tasks.push_back({s, k});
+    segmentCells += segments[s].length;
+  }
+  if (threadCount <= 0)
+    threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+  threadCount = std::min(threadCount, segmentCells / GAMER_CPU_MARK_CHUNK + 1);
+  ParallelFor(0, (int)tasks.size(), threadCount, [&](int task) {
+    const Segment &segment = segments[tasks[task].first];
+    int first = tasks[task].second;
+    int last = std::min(segment.length, first + GAMER_CPU_MARK_CHUNK);
+    for (int k = first; k < last; k++)
+      route.mark[segment.start + k * segment.step] = 1;
+  });
+  return true;
+}
+
+float GamerCpu::ChangedMin(const float *dist, const int *prev,
+                           const GamerBox &box, float minCost,
+                           GamerCpuPath path, int threadCount) {
+  const bool avx2 = path == GamerCpuPath::Avx2 && Avx2Supported();
+  mRowMin.resize(mCol);
+  ParallelFor(0, mCol, threadCount, [&](int rowId) {
+    mRowMin[rowId] =
+        avx2 ? GamerChangedMinRowAvx2(dist, prev, mRow, rowId, box, minCost)
+             : GamerChangedMinRow(dist, prev, mRow, rowId, box, minCost);
+  });
+  return *std::min_element(mRowMin.begin(), mRowMin.end());
+}
+
+float GamerCpu::MinCost(const float *costHorizontal,
+                        const float *costVertical, int threadCount) {
+  mRowMin.resize(mCol);
+  ParallelFor(0, mCol, threadCount, [&](int rowId) {
+    size_t base = (size_t)rowId * mRow;
+    float minCost = std::numeric_limits<float>::infinity();
+    for (size_t i = base + 1; i < base + mRow; i++)
+      minCost = std::min(minCost, costHorizontal[i]);
+    for (size_t i = base; rowId > 0 && i < base + mRow; i++)
+      minCost = std::min(minCost, costVertical[i]);
+    mRowMin[rowId] = minCost;
+  });
+  float minCost = *std::min_element(mRowMin.begin(), mRowMin.end());
+  return minCost == std::numeric_limits<float>::infinity()
+             ? 0.f
+             : std::max(0.f, minCost);
+}
+
+int GamerCpu::ClosestPin(const std::vector<int> &pinIndices,
+                         const GamerRoute &route, int threadCount) {
+  // find the closest un-routed pin: the first closest of every chunk, then
+  // the first of those, which is the pin a single scan would find
+  int pins = (int)pinIndices.size();
+  int chunks = (pins + GAMER_CPU_SELECT_CHUNK - 1) / GAMER_CPU_SELECT_CHUNK;
+  std::vector<std::pair<float, int>> chunkBest(chunks);
+  ParallelFor(0, chunks, threadCount, [&](int chunk) {
+    float minDist = mInfinity;
+    int pinId = -1;
+    int last = std::min(pins, (chunk + 1) * GAMER_CPU_SELECT_CHUNK);
+    for (int i = chunk * GAMER_CPU_SELECT_CHUNK; i < last; i++) {
+      if (!route.isRoutedPin[i]) {
+        float d = route.dist[pinIndices[i]];
+        if (d < minDist) {
+          minDist = d;
+          pinId = i;
+        }
+      }
+    }
+    chunkBest[chunk] = {minDist, pinId};
+  });
+  float minDist = mInfinity;
+  int pinId = -1;
+  for (const auto &best : chunkBest) {
+    if (best.second != -1 && best.first < minDist) {
+      minDist = best.first;
+      pinId = best.second;
+    }
+  }
+  return pinId;
+}
+
+bool GamerCpu::Avx2Supported() {
+  if (!GamerAvx2Compiled())
+    return false;
+  return CpuSupportsAvx2();
+}
+
+void GamerSweepRows(const GamerSweepArgs &args, int y0, int y1) {
+  const int row = args.row;
+  for (int y = y0; y < y1; y++) {
+    size_t base = (size_t)y * row;
+    const float *c = args.cost + base;
+    float *d = args.dist + base;
+    float *bestL = args.best + base;
+    int *prevL = args.bestPrev + base;
+
+    bestL[0] = d[0];
+    prevL[0] = 0;
+    for (int x = 1; x < row; x++) {
+      float through = bestL[x - 1] + c[x];
+      if (d[x] > through) {
+        bestL[x] = through;
+        prevL[x] = prevL[x - 1];
+      } else {
+        bestL[x] = d[x];
+        prevL[x] = x;
+      }
+    }
+
+    float bestR = 0.f;
+    int prevR = 0;
+    for (int x = row - 1; x >= 0; x--) {
+      if (x == row - 1 || d[x] <= bestR + c[x + 1]) {
+        bestR = d[x];
+        prevR = x;
+      } else {
+        bestR += c[x + 1];
+      }
+
+      int from = x;
+      if (bestL[x] < d[x]) {
+        d[x] = bestL[x];
+        from = prevL[x];
+      }
+      if (bestR < d[x]) {
+        d[x] = bestR;
+        from = prevR;
+      }
+      args.prev[base + x] = (int)base + from;
+    }
+  }
+}
+
+void GamerSweepColumns(const GamerSweepArgs &args, int x0, int x1) {
+  const int row = args.row, col = args.col, n = x1 - x0;
+  const float *cost = args.cost;
+  float *dist = args.dist;
+  float *bestL = args.best;
+  int *prevL = args.bestPrev;
+
+  for (int x = x0; x < x1; x++) {
+    bestL[x] = dist[x];
+    prevL[x] = 0;
+  }
+  for (int y = 1; y < col; y++) {
+    size_t i0 = (size_t)y * row + x0;
+    for (size_t i = i0; i < i0 + n; i++) {
+      float through = bestL[i - row] + cost[i];
+      bool take = dist[i] > through;
+      bestL[i] = take ? through : dist[i];
+      prevL[i] = take ? prevL[i - row] : y;
+    }
+  }
+
+  std::vector<float> bestR(n);
+  std::vector<int> prevR(n);
+  for (int y = col - 1; y >= 0; y--) {
+    size_t i0 = (size_t)y * row + x0;
+    for (int x = 0; x < n; x++) {
+      size_t i = i0 + x;
+      if (y == col - 1) {
+        bestR[x] = dist[i];
+        prevR[x] = y;
+      } else {
+        float through = bestR[x] + cost[i + row];
+        bool take = dist[i] > through;
+        bestR[x] = take ? through : dist[i];
+        prevR[x] = take ? prevR[x] : y;
+      }
+
+      float best = dist[i];
+      int from = y;
+      if (bestL[i] < best) {
+        best = bestL[i];
+        from = prevL[i];
+      }
+      if (bestR[x] < best) {
+        best = bestR[x];
+        from = prevR[x];
+      }
+      dist[i] = best;
+      args.prev[i] = from * row + x0 + x;
+    }
+  }
+}
+
+float GamerChangedMinRow(const float *dist, const int *prev, int row, int y,
+                         const GamerBox &box, float minCost) {
+  int dy = std::max(0, std::max(box.y0 - y, y - (box.y1 - 1)));
+  int base = y * row;
+  float minDist = std::numeric_limits<float>::infinity();
+  for (int x = 0; x < row; x++) {
+    int i = base + x;
+    if (prev[i] != i) {
+      int dx = std::max(0, std::max(box.x0 - x, x - (box.x1 - 1)));
+      minDist = std::min(minDist, dist[i] + minCost * (float)(dx + dy));
+    }
+  }
+  return minDist;
+}
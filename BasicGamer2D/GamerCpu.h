@@ -0,0 +1,153 @@
+#pragma once
+#include "GamerPrev.h"
+#include <vector>
+
+enum class GamerCpuPath { Scalar, Avx2 };
+
+// Cells x0 <= x < x1, y0 <= y < y1 of a grid.
+struct GamerBox {
+  int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+};
+
+// Buffers of the router after routing a net, laid out as on the GPU.
+struct GamerRoute {
+  std::vector<float> dist;
+  // maxTurns slices of row * col, or empty with compactPrev.
+  std::vector<int> allPrev;
+  // Set before routing to keep the predecessors in prevStore instead of
+  // allPrev, for grids where maxTurns ints per cell do not fit.
+  bool compactPrev = false;
+  GamerPrevStore prevStore;
+  // Set before routing to end the turns of a pin once more turns cannot
+  // change its route: once a pin is reached and no path from a cell the
+  // last turn lowered, if any, can reach an unrouted pin as cheaply as the
+  // closest one already is. Only the first turns of allPrev are then
+  // written for each pin; the routes are the same. Each check costs about a
+  // third of a sweep, so it pays when many turns are allowed.
+  bool adaptiveTurns = false;
+  // Sweeps run by the last Route.
+  int sweeps = 0;
+  std::vector<int> mark;
+  std::vector<int> isRoutedPin;
+  // routes[0] is the number of entries that follow: the start and end cell
+  // of every segment, smaller index first.
+  std::vector<int> routes;
+};
+
+// CPU version of the GAMER router, for routing and checking the shaders on
+// grids of any size and shape without a device. Cells are indexed y * row + x
+// as in the shaders: row is the length of a grid row (ROW) and col the number
+// of rows (COL). costHorizontal[i] is the cost of the edge from cell i - 1 to
+// cell i and costVertical[i] the cost of the edge from cell i - row to cell i.
+// Every kernel gives exactly the results of its shader while every sum of
+// costs is exact in float, e.g. for integer costs.
+class GamerCpu {
+public:
+  GamerCpu(int row, int col, float infinity = 1000.f);
+
+  GamerCpu(const GamerCpu &rhs) = delete;
+  GamerCpu &operator=(const GamerCpu &rhs) = delete;
+  ~GamerCpu() = default;
+
+  // The whole of BasicGamer2DApp::OnCompute: SetRootPin, then for every
+  // other pin CleanDist, maxTurns sweeps starting horizontal, and TracePath.
+  void Route(const float *costHorizontal, const float *costVertical,
+             const std::vector<int> &pinIndices, int maxTurns,
+             GamerRoute &route, GamerCpuPath path = GamerCpuPath::Avx2,
+             int threadCount = 0);
+
+  // CleanDist.hlsl: zero on marked cells, infinity elsewhere.
+  void CleanDist(const int *mark, float *dist, int threadCount = 0);
+
+  // One turn of the router, like SweepHorizontal.hlsl/SweepVertical.hlsl:
+  // every row (column) is scanned from both ends and dist lowered to the
+  // cheapest straight segment from any cell of the line. prev is the row * col
+  // slice of allPrev for the turn and receives the cell each segment starts
+  // at, or the cell itself. Ties go to the nearer start as in the shaders.
+  // Rows (strips of columns) are split across threadCount threads (0 = all
+  // hardware threads). The AVX2 path scans eight columns at once, one per
+  // lane, and falls back to scalar when the CPU or build lacks support; rows
+  // take the scalar kernel on either path (see GAMER_CPU_AVX2_ROWS).
+  void SweepHorizontal(const float *costHorizontal, float *dist, int *prev,
+                       GamerCpuPath path = GamerCpuPath::Avx2,
+                       int threadCount = 0);
+  void SweepVertical(const float *costVertical, float *dist, int *prev,
+                     GamerCpuPath path = GamerCpuPath::Avx2,
+                     int threadCount = 0);
+
+  // Over the cells a sweep lowered, those whose prev is not the cell itself,
+  // the smallest dist plus minCost per step to the nearest cell of box: no
+  // path from them into box costs less when every edge costs minCost or
+  // more. Float infinity when the sweep lowered no cell. Rows are split
+  // across threadCount threads.
+  float ChangedMin(const float *dist, const int *prev, const GamerBox &box,
+                   float minCost, GamerCpuPath path = GamerCpuPath::Avx2,
+                   int threadCount = 0);
+
+  // TracePath.hlsl: routes the closest unrouted pin back along allPrev (or
+  // prevStore), marking its cells and appending its segments to
+  // route.routes. False when no unrouted pin is closer than infinity. The
+  // pin search and the marking are split across threadCount threads once
+  // there are enough pins (cells) to pay for them.
+  bool TracePath(const std::vector<int> &pinIndices, int numTurns,
+                 GamerRoute &route, int threadCount = 0);
+
+  // Reshapes the grid to row x col, keeping the memory of the scratch
+  // buffers, so that one router can take windows of many sizes.
+  void Resize(int row, int col);
+
+  int Row() const { return mRow; }
+  int Col() const { return mCol; }
+  float Infinity() const { return mInfinity; }
+
+  static bool Avx2Supported();
+
+private:
+  // The unrouted pin TracePath takes next, or -1 when none is closer than
+  // infinity.
+  int ClosestPin(const std::vector<int> &pinIndices, const GamerRoute &route,
+                 int threadCount);
+  // Cheapest edge of the grid, leaving out the unused first column
+  // (row) of costHorizontal (costVertical).
+  float MinCost(const float *costHorizontal, const float *costVertical,
+                int threadCount);
+
+  int mRow = 0;
+  int mCol = 0;
+  float mInfinity = 1000.f;
+
+  // Scan from the left (top) of every line, row * col.
+  std::vector<float> mBest;
+  std::vector<int> mBestPrev;
+  // The turn being swept when routing with compactPrev.
+  std::vector<int> mTurnPrev;
+  // Per-row minima of ChangedMin and MinCost.
+  std::vector<float> mRowMin;
+};
+
+// Sweep kernels shared by the scalar and AVX2 translation units. Rows
+// [y0, y1) or columns [x0, x1) of one turn; best and bestPrev are row * col
+// scratch, of which the kernels use the part under their rows (columns).
+struct GamerSweepArgs {
+  int row;
+  int col;
+  const float *cost;
+  float *dist;
+  int *prev;
+  float *best;
+  int *bestPrev;
+};
+
+void GamerSweepRows(const GamerSweepArgs &args, int y0, int y1);
+void GamerSweepColumns(const GamerSweepArgs &args, int x0, int x1);
+
+// Eight rows from y0, one per lane.
+void GamerSweepRowsAvx2(const GamerSweepArgs &args, int y0);
+void GamerSweepColumnsAvx2(const GamerSweepArgs &args, int x0, int x1);
+
+// GamerCpu::ChangedMin of row y alone.
+float GamerChangedMinRow(const float *dist, const int *prev, int row, int y,
+                         const GamerBox &box, float minCost);
+float GamerChangedMinRowAvx2(const float *dist, const int *prev, int row,
+                             int y, const GamerBox &box, float minCost);
+bool GamerAvx2Compiled();
@@ -0,0 +1,288 @@
+// Compiled with AVX2 enabled (see BasicGamer2D.vcxproj); only called after
+// GamerCpu::Avx2Supported() has checked the CPU.
+#include "GamerCpu.h"
+
+#if defined(__AVX2__)
+
+#include <algorithm>
+#include <immintrin.h>
+#include <limits>
+
+bool GamerAvx2Compiled() { return true; }
+
+namespace {
+void Transpose8(__m256 r[8]) {
+  __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]);
+  __m256 t1 = _mm256_unpackhi_ps(r[0], r[1]);
+  __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]);
+  __m256 t3 = _mm256_unpackhi_ps(r[2], r[3]);
+  __m256 t4 = _mm256_unpacklo_ps(r[4], r[5]);
+  __m256 t5 = _mm256_unpackhi_ps(r[4], r[5]);
+  __m256 t6 = _mm256_unpacklo_ps(r[6], r[7]);
+  __m256 t7 = _mm256_unpackhi_ps(r[6], r[7]);
+  __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+  r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+  r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+  r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+  r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+  r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+  r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+  r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+  r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+// Columns [x, x + n) of eight rows from p, one vector per column with row k
+// in lane k; offsets holds k * stride. Whole tiles are transposed, shorter
+// ones gathered, and columns past n are zero. Only moves bits, so T may be
+// float or int.
+template <typename T>
+void LoadColumns(const T *p, size_t stride, __m256i offsets, int x, int n,
+                 __m256 cols[8]) {
+  if (n == 8) {
+    for (int k = 0; k < 8; k++)
+      cols[k] = _mm256_loadu_ps((const float *)(p + k * stride + x));
+    Transpose8(cols);
+    return;
+  }
+  for (int j = 0; j < 8; j++)
+    cols[j] = j < n ? _mm256_i32gather_ps((const float *)(p + x + j), offsets,
+                                          4)
+                    : _mm256_setzero_ps();
+}
+
+template <typename T>
+void StoreColumns(T *p, size_t stride, int x, int n, __m256 cols[8]) {
+  if (n == 8) {
+    Transpose8(cols);
+    for (int k = 0; k < 8; k++)
+      _mm256_storeu_ps((float *)(p + k * stride + x), cols[k]);
+    return;
+  }
+  alignas(32) T lanes[8];
+  for (int j = 0; j < n; j++) {
+    _mm256_store_ps((float *)lanes, cols[j]);
+    for (int k = 0; k < 8; k++)
+      p[k * stride + x + j] = lanes[k];
+  }
+}
+
+inline __m256i Select(__m256i a, __m256i b, __m256 mask) {
+  return _mm256_castps_si256(_mm256_blendv_ps(
+      _mm256_castsi256_ps(a), _mm256_castsi256_ps(b), mask));
+}
+} // namespace
+
+void GamerSweepRowsAvx2(const GamerSweepArgs &args, int y0) {
+  // The scan runs down all eight rows at once. Starting from infinity rather
+  // than the first cell keeps the first step like every other: infinity plus
+  // any cost never beats a cell's own distance. min(through, d) is d on ties
+  // like the comparison, and keeps the select off the chain from column to
+  // column.
+  const int row = args.row;
+  const size_t stride = row;
+  const size_t base = (size_t)y0 * row;
+  const float *c = args.cost + base;
+  float *d = args.dist + base;
+  int *prev = args.prev + base;
+  // The left scan of column x is stored as one vector at [x * 8].
+  float *bestL = args.best + base;
+  int *prevL = args.bestPrev + base;
+
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i offsets = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(row));
+  const __m256i rowBase = _mm256_add_epi32(offsets, _mm256_set1_epi32((int)base));
+  const __m256 infinity =
+      _mm256_set1_ps(std::numeric_limits<float>::infinity());
+  __m256 dv[8], cv[8], outDist[8], outPrev[8];
+
+  __m256 best = infinity;
+  __m256i from = _mm256_setzero_si256();
+  for (int x = 0; x < row; x += 8) {
+    int n = std::min(8, row - x);
+    LoadColumns(d, stride, offsets, x, n, dv);
+    LoadColumns(c, stride, offsets, x, n, cv);
+    for (int j = 0; j < n; j++) {
+      __m256 through = _mm256_add_ps(best, cv[j]);
+      __m256 take = _mm256_cmp_ps(dv[j], through, _CMP_GT_OQ);
+      best = _mm256_min_ps(through, dv[j]);
+      from = Select(_mm256_set1_epi32(x + j), from, take);
+      _mm256_storeu_ps(bestL + (size_t)(x + j) * 8, best);
+      _mm256_storeu_si256((__m256i *)(prevL + (size_t)(x + j) * 8), from);
+    }
+  }
+
+  best = infinity;
+  from = _mm256_setzero_si256();
+  for (int x = (row - 1) / 8 * 8; x >= 0; x -= 8) {
+    int n = std::min(8, row - x);
+    LoadColumns(d, stride, offsets, x, n, dv);
+    // Cost of the edge right of each column; there is none right of the last.
+    LoadColumns(c, stride, offsets, x + 1, std::min(8, row - 1 - x), cv);
+    for (int j = n - 1; j >= 0; j--) {
+      __m256i here = _mm256_set1_epi32(x + j);
+      __m256 through = _mm256_add_ps(best, cv[j]);
+      __m256 take = _mm256_cmp_ps(dv[j], through, _CMP_GT_OQ);
+      best = _mm256_min_ps(through, dv[j]);
+      from = Select(here, from, take);
+
+      __m256 left = _mm256_loadu_ps(bestL + (size_t)(x + j) * 8);
+      __m256i leftFrom =
+          _mm256_loadu_si256((const __m256i *)(prevL + (size_t)(x + j) * 8));
+      __m256 out = dv[j];
+      __m256i outFrom = here;
+      __m256 better = _mm256_cmp_ps(left, out, _CMP_LT_OQ);
+      out = _mm256_blendv_ps(out, left, better);
+      outFrom = Select(outFrom, leftFrom, better);
+      better = _mm256_cmp_ps(best, out, _CMP_LT_OQ);
+      out = _mm256_blendv_ps(out, best, better);
+      outFrom = Select(outFrom, from, better);
+      outDist[j] = out;
+      outPrev[j] = _mm256_castsi256_ps(_mm256_add_epi32(outFrom, rowBase));
+    }
+    StoreColumns(d, stride, x, n, outDist);
+    StoreColumns(prev, stride, x, n, outPrev);
+  }
+}
+
+void GamerSweepColumnsAvx2(const GamerSweepArgs &args, int x0, int x1) {
+  // Eight columns per vector, whole rows of the strip per step; the last
+  // x1 - x0 mod 8 columns go to the scalar kernel.
+  const int row = args.row, col = args.col;
+  const int xv = x0 + (x1 - x0) / 8 * 8;
+  const float *cost = args.cost;
+  float *dist = args.dist;
+  float *bestL = args.best;
+  int *prevL = args.bestPrev;
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i stride = _mm256_set1_epi32(row);
+
+  for (int x = x0; x < xv; x++) {
+    bestL[x] = dist[x];
+    prevL[x] = 0;
+  }
+  for (int y = 1; y < col; y++) {
+    __m256i here = _mm256_set1_epi32(y);
+    for (size_t i = (size_t)y * row + x0; i < (size_t)y * row + xv; i += 8) {
+      __m256 d = _mm256_loadu_ps(dist + i);
+      __m256 through = _mm256_add_ps(_mm256_loadu_ps(bestL + i - row),
+                                     _mm256_loadu_ps(cost + i));
+      __m256 take = _mm256_cmp_ps(d, through, _CMP_GT_OQ);
+      __m256i above = _mm256_loadu_si256((const __m256i *)(prevL + i - row));
+      _mm256_storeu_ps(bestL + i, _mm256_blendv_ps(d, through, take));
+      _mm256_storeu_si256((__m256i *)(prevL + i), Select(here, above, take));
+    }
+  }
+
+  std::vector<float> bestR(xv - x0);
+  std::vector<int> prevR(xv - x0);
+  for (int y = col - 1; y >= 0; y--) {
+    __m256i here = _mm256_set1_epi32(y);
+    size_t i0 = (size_t)y * row;
+    for (int x = x0; x < xv; x += 8) {
+      size_t i = i0 + x;
+      float *r = bestR.data() + (x - x0);
+      int *rFrom = prevR.data() + (x - x0);
+      __m256 d = _mm256_loadu_ps(dist + i);
+      __m256 below = d;
+      __m256i belowFrom = here;
+      if (y < col - 1) {
+        __m256 through =
+            _mm256_add_ps(_mm256_loadu_ps(r), _mm256_loadu_ps(cost + i + row));
+        __m256 take = _mm256_cmp_ps(d, through, _CMP_GT_OQ);
+        below = _mm256_blendv_ps(d, through, take);
+        belowFrom = Select(here, _mm256_loadu_si256((const __m256i *)rFrom),
+                           take);
+      }
+      _mm256_storeu_ps(r, below);
+      _mm256_storeu_si256((__m256i *)rFrom, belowFrom);
+
+      __m256 above = _mm256_loadu_ps(bestL + i);
+      __m256 out = d;
+      __m256i outFrom = here;
+      __m256 better = _mm256_cmp_ps(above, out, _CMP_LT_OQ);
+      out = _mm256_blendv_ps(out, above, better);
+      outFrom = Select(outFrom,
+                       _mm256_loadu_si256((const __m256i *)(prevL + i)), better);
+      better = _mm256_cmp_ps(below, out, _CMP_LT_OQ);
+      out = _mm256_blendv_ps(out, below, better);
+      outFrom = Select(outFrom, belowFrom, better);
+
+      __m256i column = _mm256_add_epi32(lanes, _mm256_set1_epi32(x));
+      _mm256_storeu_ps(dist + i, out);
+      _mm256_storeu_si256(
+          (__m256i *)(args.prev + i),
+          _mm256_add_epi32(_mm256_mullo_epi32(outFrom, stride), column));
+    }
+  }
+
+  if (xv < x1)
+    GamerSweepColumns(args, xv, x1);
+}
+
+float GamerChangedMinRowAvx2(const float *dist, const int *prev, int row,
+                             int y, const GamerBox &box, float minCost) {
+  // Eight cells per step; the last row mod 8 go to the scalar loop.
+  const int dy = std::max(0, std::max(box.y0 - y, y - (box.y1 - 1)));
+  const int base = y * row;
+  const int xv = row / 8 * 8;
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i boxX0 = _mm256_set1_epi32(box.x0);
+  const __m256i boxX1 = _mm256_set1_epi32(box.x1 - 1);
+  const __m256i dyv = _mm256_set1_epi32(dy);
+  const __m256 cost = _mm256_set1_ps(minCost);
+  const __m256 infinity =
+      _mm256_set1_ps(std::numeric_limits<float>::infinity());
+  __m256 minDist = infinity;
+  for (int x = 0; x < xv; x += 8) {
+    __m256i xs = _mm256_add_epi32(lanes, _mm256_set1_epi32(x));
+    __m256i idx = _mm256_add_epi32(xs, _mm256_set1_epi32(base));
+    __m256i same = _mm256_cmpeq_epi32(
+        _mm256_loadu_si256((const __m256i *)(prev + base + x)), idx);
+    __m256i dx = _mm256_max_epi32(
+        zero, _mm256_max_epi32(_mm256_sub_epi32(boxX0, xs),
+                               _mm256_sub_epi32(xs, boxX1)));
+    __m256 bound = _mm256_add_ps(
+        _mm256_loadu_ps(dist + base + x),
+        _mm256_mul_ps(cost, _mm256_cvtepi32_ps(_mm256_add_epi32(dx, dyv))));
+    minDist = _mm256_min_ps(
+        minDist, _mm256_blendv_ps(bound, infinity, _mm256_castsi256_ps(same)));
+  }
+  alignas(32) float lanesMin[8];
+  _mm256_store_ps(lanesMin, minDist);
+  float result = *std::min_element(lanesMin, lanesMin + 8);
+  for (int x = xv; x < row; x++) {
+    int i = base + x;
+    if (prev[i] != i) {
+      int dx = std::max(0, std::max(box.x0 - x, x - (box.x1 - 1)));
+      result = std::min(result, dist[i] + minCost * (float)(dx + dy));
+    }
+  }
+  return result;
+}
+
+#else
+
+bool GamerAvx2Compiled() { return false; }
+
+void GamerSweepRowsAvx2(const GamerSweepArgs &args, int y0) {
+  GamerSweepRows(args, y0, y0 + 8);
+}
+
+void GamerSweepColumnsAvx2(const GamerSweepArgs &args, int x0, int x1) {
+  GamerSweepColumns(args, x0, x1);
+}
+
+float GamerChangedMinRowAvx2(const float *dist, const int *prev, int row,
+                             int y, const GamerBox &box, float minCost) {
+  return GamerChangedMinRow(dist, prev, row, y, box, minCost);
+}
+
+#endif
@@ -0,0 +1,237 @@
+#include "GamerDriver.h"
+#include "GamerBenchmark.h"
+#include "GamerFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace {
+// Infinity of generated instances, as in the benchmarks.
+const float kInfinity = 1e9f;
+
+double Seconds(std::chrono::high_resolution_clock::time_point start) {
+  return std::chrono::duration<double>(
+             std::chrono::high_resolution_clock::now() - start)
+      .count();
+}
+
+int ParseInt(const char *s, const char *name) {
+  char *end;
+  long value = strtol(s, &end, 10);
+  if (end == s || *end != '\0' || value < 0 || value > INT32_MAX)
+    throw std::runtime_error(std::string("bad ") + name + ": " + s);
+  return (int)value;
+}
+
+// What is known about one routed net.
+struct NetStats {
+  int pins = 0;
+  int segments = 0;
+  int wireLength = 0;
+  int sweeps = 0;
+  int windows = 0;
+  long long sweptCells = 0;
+  bool complete = false;
+  int overused = 0;
+};
+
+// Edges along the segments of route, on a grid of row cells per grid row.
+int WireLength(const GamerNetRoute &route, int row) {
+  int length = 0;
+  for (size_t s = 0; s < route.segments.size(); s += 2) {
+    int a = route.segments[s], b = route.segments[s + 1];
+    length += a / row == b / row ? b - a : (b - a) / row;
+  }
+  return length;
+}
+
+// Min, mean and max of field over nets.
+template <typename F>
+void PrintSpread(const char *name, const std::vector<NetStats> &nets,
+                 F field) {
+  if (nets.empty())
+    return;
+  int lo = field(nets[0]), hi = lo;
+  double sum = 0.0;
+  for (const NetStats &net : nets) {
+    lo = std::min(lo, field(net));
+    hi = std::max(hi, field(net));
+    sum += field(net);
+  }
+  printf("%-12s %8d %10.2f %8d %12.0f\n", name, lo, sum / nets.size(), hi,
+         sum);
+}
+
+int MakeInstance(int argc, char **argv, int i) {
+  if (argc - i < 5)
+    throw std::runtime_error("-make-instance needs OUT ROW COL NETS [SEED]");
+  std::string path = argv[i + 1];
+  GamerInstance instance;
+  instance.row = ParseInt(argv[i + 2], "ROW");
+  instance.col = ParseInt(argv[i + 3], "COL");
+  int netCount = ParseInt(argv[i + 4], "NETS");
+  unsigned int seed = argc - i > 5 ? ParseInt(argv[i + 5], "SEED") : 1;
+  if (instance.row == 0 || instance.col == 0)
+    throw std::runtime_error("the grid is empty");
+  instance.infinity = kInfinity;
+
+  std::vector<int> mark;
+  RandomSweepInput(instance.row, instance.col, instance.infinity, seed,
+                   instance.costHorizontal, instance.costVertical, mark);
+  RandomNets(instance.row, instance.col, netCount, seed + 1, instance.nets);
+  SaveGamerInstance(path, instance);
+  printf("wrote %dx%d with %d nets to %s\n", instance.row, instance.col,
+         netCount, path.c_str());
+  return 0;
+}
+
+int RouteInstance(int argc, char **argv, int i) {
+  if (argc - i < 2)
+    throw std::runtime_error("-route needs an instance");
+  std::string path = argv[i + 1];
+  std::string outPath, statsPath;
+  GamerBatchOptions options;
+  int threadCount = 0;
+  for (int k = i + 2; k < argc; k++) {
+    bool hasValue = k + 1 < argc;
+    if (strcmp(argv[k], "-adaptive") == 0)
+      options.adaptiveTurns = true;
+    else if (strcmp(argv[k], "-negotiated") == 0)
+      options.negotiated = true;
+    else if (!hasValue)
+      throw std::runtime_error(std::string("bad option ") + argv[k]);
+    else if (strcmp(argv[k], "-out") == 0)
+      outPath = argv[++k];
+    else if (strcmp(argv[k], "-stats") == 0)
+      statsPath = argv[++k];
+    else if (strcmp(argv[k], "-turns") == 0)
+      options.maxTurns = std::max(1, ParseInt(argv[++k], "-turns"));
+    else if (strcmp(argv[k], "-iterations") == 0)
+      options.maxIterations = std::max(1, ParseInt(argv[++k], "-iterations"));
+    else if (strcmp(argv[k], "-capacity") == 0)
+      options.capacity = ParseInt(argv[++k], "-capacity");
+    else if (strcmp(argv[k], "-window") == 0)
+      options.windowMargin = ParseInt(argv[++k], "-window");
+    else if (strcmp(argv[k], "-group") == 0)
+      options.groupNets = ParseInt(argv[++k], "-group");
+    else if (strcmp(argv[k], "-threads") == 0)
+      threadCount = ParseInt(argv[++k], "-threads");
+    else
+      throw std::runtime_error(std::string("bad option ") + argv[k]);
+  }
+
+  auto start = std::chrono::high_resolution_clock::now();
+  GamerInstance instance;
+  LoadGamerInstance(path, instance);
+  double loadSeconds = Seconds(start);
+  size_t pinCount = 0;
+  for (const GamerNet &net : instance.nets)
+    pinCount += net.pinIndices.size();
+  double bytes = 2.0 * instance.costHorizontal.size() * sizeof(float) +
+                 pinCount * sizeof(int) +
+                 (instance.nets.size() + 1) * sizeof(uint64_t);
+  printf("%s: %dx%d, %zu nets, %zu pins\n", path.c_str(), instance.row,
+         instance.col, instance.nets.size(), pinCount);
+  printf("loaded in %.3f s (%.1f MB/s)\n", loadSeconds,
+         bytes / loadSeconds / 1e6);
+
+  GamerBatchRouter router(instance.row, instance.col, instance.infinity);
+  std::vector<GamerNetRoute> routes;
+  GamerBatchStats stats =
+      router.Route(instance.costHorizontal.data(),
+                   instance.costVertical.data(), instance.nets, routes,
+                   options, threadCount);
+  double routeSeconds = 0.0, updateSeconds = 0.0;
+  printf("%6s %8s %9s %10s %10s\n", "pass", "nets", "overused", "route s",
+         "update s");
+  for (size_t p = 0; p < stats.passSeconds.size(); p++) {
+    printf("%6zu %8d %9d %10.3f %10.4f\n", p + 1, stats.passNets[p],
+           stats.passOverused[p], stats.passSeconds[p],
+           stats.updateSeconds[p]);
+    routeSeconds += stats.passSeconds[p];
+    updateSeconds += stats.updateSeconds[p];
+  }
+  printf("%d routings of %zu nets in %d passes, %.3f s (%.1f routings/s), "
+         "updates %.3f s\n",
+         stats.routedNets, instance.nets.size(), stats.iterations,
+         routeSeconds, stats.routedNets / std::max(routeSeconds, 1e-9),
+         updateSeconds);
+
+  std::vector<int> usage;
+  router.Usage(routes, usage);
+  std::vector<NetStats> nets(routes.size());
+  int open = 0;
+  for (size_t n = 0; n < routes.size(); n++) {
+    NetStats &net = nets[n];
+    net.pins = (int)instance.nets[n].pinIndices.size();
+    net.segments = (int)routes[n].segments.size() / 2;
+    net.wireLength = WireLength(routes[n], instance.row);
+    net.sweeps = routes[n].sweeps;
+    net.windows = routes[n].windows;
+    net.sweptCells = routes[n].sweptCells;
+    net.complete = routes[n].complete;
+    for (int cell : routes[n].cells)
+      net.overused += usage[cell] > options.capacity;
+    open += !net.complete;
+  }
+  double swept = 0.0;
+  int widened = 0;
+  for (const NetStats &net : nets) {
+    swept += (double)net.sweptCells;
+    widened += net.windows > 1;
+  }
+  printf("%d open nets, %d overused cells\n", open, stats.overusedCells);
+  printf("last routings swept %.1f Mcells, %d nets needed a wider window\n",
+         swept / 1e6, widened);
+  printf("%-12s %8s %10s %8s %12s\n", "per net", "min", "mean", "max",
+         "total");
+  PrintSpread("pins", nets, [](const NetStats &n) { return n.pins; });
+  PrintSpread("segments", nets, [](const NetStats &n) { return n.segments; });
+  PrintSpread("wire length", nets,
+              [](const NetStats &n) { return n.wireLength; });
+  PrintSpread("sweeps", nets, [](const NetStats &n) { return n.sweeps; });
+  PrintSpread("overused", nets, [](const NetStats &n) { return n.overused; });
+
+  if (!statsPath.empty()) {
+    std::unique_ptr<FILE, int (*)(FILE *)> f(fopen(statsPath.c_str(), "w"),
+                                             fclose);
+    if (!f)
+      throw std::runtime_error("cannot open " + statsPath);
+    fprintf(f.get(), "net pins segments wirelength sweeps windows "
+                     "sweptcells complete overused\n");
+    for (size_t n = 0; n < nets.size(); n++)
+      fprintf(f.get(), "%zu %d %d %d %d %d %lld %d %d\n", n, nets[n].pins,
+              nets[n].segments, nets[n].wireLength, nets[n].sweeps,
+              nets[n].windows, nets[n].sweptCells, (int)nets[n].complete,
+              nets[n].overused);
+    if (ferror(f.get()) || fclose(f.release()) != 0)
+      throw std::runtime_error("cannot write " + statsPath);
+  }
+  if (!outPath.empty()) {
+    start = std::chrono::high_resolution_clock::now();
+    SaveGamerRoutes(outPath, instance.row, routes);
+    printf("wrote routes in %.3f s\n", Seconds(start));
+  }
+  return 0;
+}
+} // namespace
+
+int RunRouteDriver(int argc, char **argv) {
+  try {
+    for (int i = 1; i < argc; i++) {
+      if (strcmp(argv[i], "-make-instance") == 0)
+        return MakeInstance(argc, argv, i);
+      if (strcmp(argv[i], "-route") == 0)
+        return RouteInstance(argc, argv, i);
+    }
+    throw std::runtime_error("expected -route or -make-instance");
+  } catch (std::runtime_error &e) {
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+}
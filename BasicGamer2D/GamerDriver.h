@@ -0,0 +1,22 @@
+#pragma once
+
+// Headless routing of GamerFile instances with GamerBatchRouter, for running
+// large instances repeatably without a device. Uses only the CPU router and
+// the standard library, so it builds anywhere the CPU sources do.
+//
+//   -route IN [-out PATH] [-stats PATH] [-turns N] [-iterations N]
+//          [-capacity N] [-group N] [-window N] [-threads N] [-adaptive]
+//          [-negotiated]
+//     Loads IN, routes every net and prints the load and write times, the
+//     nets, overused cells and times of every pass and a summary of the
+//     nets. -out writes the routes as in SaveGamerRoutes; -stats writes a
+//     line per net: id, pins, segments, wire length, the sweeps, windows and
+//     swept cells of its last routing, whether it is complete, and its cells
+//     that are overused. The other options set GamerBatchOptions and the
+//     thread count (0 = all hardware threads).
+//   -make-instance OUT ROW COL NETS [SEED]
+//     Writes a RandomSweepInput grid with RandomNets nets to OUT; the same
+//     seed (default 1) gives the same file everywhere.
+//
+// argv is the whole command line; returns the process exit code.
+int RunRouteDriver(int argc, char **argv);
@@ -0,0 +1,158 @@
+#include "GamerFile.h"
+#include <Common/MappedFile.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+// Output buffer of SaveGamerRoutes.
+#define GAMER_ROUTES_BUFFER_BYTES (1u << 20)
+
+namespace {
+// True when count elements of size bytes at offset lie within the file.
+bool Fits(uint64_t offset, uint64_t count, uint64_t size, uint64_t fileSize) {
+  return offset <= fileSize && count <= (fileSize - offset) / size;
+}
+
+uint64_t AlignUp(uint64_t v, uint64_t a) { return (v + a - 1) / a * a; }
+
+struct FileCloser {
+  void operator()(FILE *f) const { fclose(f); }
+};
+
+void Write(FILE *f, const void *data, size_t size, const std::string &path) {
+  if (fwrite(data, 1, size, f) != size)
+    throw std::runtime_error("cannot write " + path);
+}
+
+// Zeros from at up to offset, which is less than 256 bytes on.
+void Pad(FILE *f, uint64_t &at, uint64_t offset, const std::string &path) {
+  static const uint8_t zeros[256] = {};
+  Write(f, zeros, (size_t)(offset - at), path);
+  at = offset;
+}
+} // namespace
+
+void LoadGamerInstance(const std::string &path, GamerInstance &instance) {
+  MappedFile file(path);
+  GamerFileHeader header;
+  memcpy(&header, file.Map(0, sizeof(header)), sizeof(header));
+  if (memcmp(header.magic, GAMER_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != GAMER_FILE_VERSION ||
+      header.headerSize != sizeof(GamerFileHeader))
+    throw std::runtime_error(path + " is not a version " +
+                             std::to_string(GAMER_FILE_VERSION) +
+                             " routing instance");
+  if (header.row <= 0 || header.col <= 0 ||
+      (uint64_t)header.row * (uint64_t)header.col > INT32_MAX)
+    throw std::runtime_error(path + " has a grid of bad size");
+  const uint64_t cells = (uint64_t)header.row * header.col;
+  const uint64_t size = file.Size();
+  if (header.netCount >= size / sizeof(uint64_t) ||
+      !Fits(header.costHorizontalOffset, cells, sizeof(float), size) ||
+      !Fits(header.costVerticalOffset, cells, sizeof(float), size) ||
+      !Fits(header.netStartsOffset, header.netCount + 1, sizeof(uint64_t),
+            size) ||
+      !Fits(header.pinsOffset, header.pinCount, sizeof(int32_t), size))
+    throw std::runtime_error(path + " is truncated");
+
+  instance.row = header.row;
+  instance.col = header.col;
+  instance.infinity = header.infinity;
+  instance.costHorizontal.resize((size_t)cells);
+  instance.costVertical.resize((size_t)cells);
+  CopySection(file, header.costHorizontalOffset, cells,
+              instance.costHorizontal.data(), GAMER_FILE_CHUNK_BYTES);
+  CopySection(file, header.costVerticalOffset, cells,
+              instance.costVertical.data(), GAMER_FILE_CHUNK_BYTES);
+
+  std::vector<uint64_t> netStarts((size_t)header.netCount + 1);
+  std::vector<int32_t> pins((size_t)header.pinCount);
+  CopySection(file, header.netStartsOffset, header.netCount + 1,
+              netStarts.data(), GAMER_FILE_CHUNK_BYTES);
+  CopySection(file, header.pinsOffset, header.pinCount, pins.data(),
+              GAMER_FILE_CHUNK_BYTES);
+  if (netStarts[0] != 0 || netStarts.back() != header.pinCount ||
+      !std::is_sorted(netStarts.begin(), netStarts.end()))
+    throw std::runtime_error(path + " has bad net starts");
+  for (int32_t pin : pins) {
+    if (pin < 0 || (uint64_t)pin >= cells)
+      throw std::runtime_error(path + " has a pin off the grid");
+  }
+
+  instance.nets.assign((size_t)header.netCount, GamerNet());
+  for (size_t n = 0; n < instance.nets.size(); n++)
+    instance.nets[n].pinIndices.assign(pins.begin() + netStarts[n],
+                                       pins.begin() + netStarts[n + 1]);
+}
+
+void SaveGamerInstance(const std::string &path, const GamerInstance &instance) {
+  const uint64_t cells = (uint64_t)instance.row * instance.col;
+  if (instance.costHorizontal.size() != cells ||
+      instance.costVertical.size() != cells)
+    throw std::runtime_error("cost arrays do not match the grid of " + path);
+  std::vector<uint64_t> netStarts(1, 0);
+  for (const GamerNet &net : instance.nets)
+    netStarts.push_back(netStarts.back() + net.pinIndices.size());
+
+  std::unique_ptr<FILE, FileCloser> f(fopen(path.c_str(), "wb"));
+  if (!f)
+    throw std::runtime_error("cannot open " + path);
+
+  GamerFileHeader header = {};
+  memcpy(header.magic, GAMER_FILE_MAGIC, sizeof(header.magic));
+  header.version = GAMER_FILE_VERSION;
+  header.headerSize = sizeof(GamerFileHeader);
+  header.row = instance.row;
+  header.col = instance.col;
+  header.infinity = instance.infinity;
+  header.netCount = instance.nets.size();
+  header.pinCount = netStarts.back();
+  header.costHorizontalOffset = AlignUp(sizeof(GamerFileHeader), 256);
+  header.costVerticalOffset =
+      AlignUp(header.costHorizontalOffset + cells * sizeof(float), 256);
+  header.netStartsOffset =
+      AlignUp(header.costVerticalOffset + cells * sizeof(float), 256);
+  header.pinsOffset = AlignUp(
+      header.netStartsOffset + netStarts.size() * sizeof(uint64_t), 256);
+
+  uint64_t at = sizeof(header);
+  Write(f.get(), &header, sizeof(header), path);
+  Pad(f.get(), at, header.costHorizontalOffset, path);
+  Write(f.get(), instance.costHorizontal.data(), cells * sizeof(float), path);
+  at += cells * sizeof(float);
+  Pad(f.get(), at, header.costVerticalOffset, path);
+  Write(f.get(), instance.costVertical.data(), cells * sizeof(float), path);
+  at += cells * sizeof(float);
+  Pad(f.get(), at, header.netStartsOffset, path);
+  Write(f.get(), netStarts.data(), netStarts.size() * sizeof(uint64_t), path);
+  at += netStarts.size() * sizeof(uint64_t);
+  Pad(f.get(), at, header.pinsOffset, path);
+  for (const GamerNet &net : instance.nets)
+    Write(f.get(), net.pinIndices.data(),
+          net.pinIndices.size() * sizeof(int32_t), path);
+  if (fclose(f.release()) != 0)
+    throw std::runtime_error("cannot write " + path);
+}
+
+void SaveGamerRoutes(const std::string &path, int row,
+                     const std::vector<GamerNetRoute> &routes) {
+  std::unique_ptr<FILE, FileCloser> f(fopen(path.c_str(), "wb"));
+  if (!f)
+    throw std::runtime_error("cannot open " + path);
+  setvbuf(f.get(), nullptr, _IOFBF, GAMER_ROUTES_BUFFER_BYTES);
+
+  for (size_t n = 0; n < routes.size(); n++) {
+    const std::vector<int> &segments = routes[n].segments;
+    fprintf(f.get(), "net%zu %zu %zu\n", n, n, segments.size() / 2);
+    for (size_t s = 0; s < segments.size(); s += 2) {
+      int a = segments[s], b = segments[s + 1];
+      fprintf(f.get(), "(%d,%d,1)-(%d,%d,1)\n", a % row, a / row, b % row,
+              b / row);
+    }
+    fputs("!\n", f.get());
+  }
+  if (ferror(f.get()) || fclose(f.release()) != 0)
+    throw std::runtime_error("cannot write " + path);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "GamerBatch.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Routing instances. The binary format is a GamerFileHeader followed by the
+// two cost arrays in the layout GamerCpu takes them, the start of every net
+// in the pin array (netCount + 1 entries, the last one pinCount) and the pin
+// array itself, each section 256-byte aligned and little-endian. Loading maps
+// the file GAMER_FILE_CHUNK_BYTES at a time and copies the sections out with
+// nothing to parse, so grids of millions of cells load at disk speed.
+//
+// Routes are written as text, one block per net in the style of the ISPD
+// global routing contests, with every segment on the one layer:
+//   net<id> <id> <segment count>
+//   (x0,y0,1)-(x1,y1,1)
+//   ...
+//   !
+
+#define GAMER_FILE_MAGIC "GAMER2D"
+#define GAMER_FILE_VERSION 1
+#define GAMER_FILE_CHUNK_BYTES (64u << 20)
+
+struct GamerFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t headerSize;
+  // Cells per grid row and grid rows, as GamerCpu's row and col.
+  int32_t row;
+  int32_t col;
+  float infinity;
+  uint32_t reserved;
+  uint64_t netCount;
+  uint64_t pinCount;
+  // Byte offsets of row * col floats each, netCount + 1 uint64_t net starts
+  // and pinCount int32_t cell indices.
+  uint64_t costHorizontalOffset;
+  uint64_t costVerticalOffset;
+  uint64_t netStartsOffset;
+  uint64_t pinsOffset;
+};
+
+// A grid and its nets, as GamerBatchRouter::Route takes them.
+struct GamerInstance {
+  int row = 0;
+  int col = 0;
+  float infinity = 1000.f;
+  std::vector<float> costHorizontal;
+  std::vector<float> costVertical;
+  std::vector<GamerNet> nets;
+};
+
+// Throw std::runtime_error on an unreadable or malformed file, including
+// pins off the grid.
+void LoadGamerInstance(const std::string &path, GamerInstance &instance);
+void SaveGamerInstance(const std::string &path, const GamerInstance &instance);
+
+// The segments of routes[n] as net n, on a grid of row cells per grid row.
+void SaveGamerRoutes(const std::string &path, int row,
+                     const std::vector<GamerNetRoute> &routes);
@@ -0,0 +1,318 @@
+#include "GamerLayerCpu.h"
+#include <Common/ParallelFor.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+// Vertical strips are a multiple of this many columns wide, so that threads
+// never share a cache line of a row.
+#define GAMER_LAYER_STRIP_ALIGN 16
+// Most layers a grid can have.
+#define GAMER_LAYER_MAX 32
+
+namespace {
+// GamerSweepRows on one line of n cells, cell k at offset k * stride of cost,
+// dist and prev, and cell index first + k * stride. bestL and prevL are n
+// entries of scratch.
+void SweepLine(int n, size_t stride, const float *c, float *d, int *prev,
+               int first, float *bestL, int *prevL) {
+  bestL[0] = d[0];
+  prevL[0] = 0;
+  for (int k = 1; k < n; k++) {
+    float through = bestL[k - 1] + c[k * stride];
+    if (d[k * stride] > through) {
+      bestL[k] = through;
+      prevL[k] = prevL[k - 1];
+    } else {
+      bestL[k] = d[k * stride];
+      prevL[k] = k;
+    }
+  }
+
+  float bestR = 0.f;
+  int prevR = 0;
+  for (int k = n - 1; k >= 0; k--) {
+    float here = d[k * stride];
+    if (k == n - 1 || here <= bestR + c[(k + 1) * stride]) {
+      bestR = here;
+      prevR = k;
+    } else {
+      bestR += c[(k + 1) * stride];
+    }
+
+    int from = k;
+    if (bestL[k] < here) {
+      here = bestL[k];
+      from = prevL[k];
+    }
+    if (bestR < here) {
+      here = bestR;
+      from = prevR;
+    }
+    d[k * stride] = here;
+    prev[k * stride] = first + from * (int)stride;
+  }
+}
+} // namespace
+
+GamerLayerCpu::GamerLayerCpu(int row, int col,
+                             const std::vector<GamerLayerDir> &dirs,
+                             float infinity)
+    : mRow(row), mCol(col), mLayers((int)dirs.size()), mInfinity(infinity),
+      mBest((size_t)row * col * dirs.size()),
+      mBestPrev((size_t)row * col * dirs.size()) {
+  // SweepRow and SweepColumns keep the layers of each direction on the stack.
+  if (dirs.empty() || dirs.size() > GAMER_LAYER_MAX)
+    throw std::runtime_error("a grid has 1 to " +
+                             std::to_string(GAMER_LAYER_MAX) + " layers");
+  for (int layer = 0; layer < mLayers; layer++) {
+    if (dirs[layer] == GamerLayerDir::Horizontal)
+      mHorizontal.push_back(layer);
+    else
+      mVertical.push_back(layer);
+  }
+}
+
+void GamerLayerCpu::Route(const float *cost, const float *via,
+                          const std::vector<int> &pinIndices, int maxRounds,
+                          GamerLayerRoute &route, int threadCount) {
+  size_t cells = Cells();
+  route.dist.assign(cells, 0.f);
+  route.allPrev.assign(2 * maxRounds * cells, 0);
+  route.mark.assign(cells, 0);
+  route.isRoutedPin.assign(pinIndices.size(), 0);
+  route.routes.assign(1, 0);
+  if (pinIndices.empty())
+    return;
+
+  // SetRootPin
+  route.isRoutedPin[0] = 1;
+  route.mark[pinIndices[0]] = 1;
+
+  for (size_t i = 1; i < pinIndices.size(); i++) {
+    CleanDist(route.mark.data(), route.dist.data(), threadCount);
+    for (int round = 0; round < maxRounds; round++) {
+      int *prev = route.allPrev.data() + 2 * round * cells;
+      SweepLayers(cost, route.dist.data(), prev, threadCount);
+      RelaxVias(via, route.dist.data(), prev + cells, threadCount);
+    }
+    TracePath(pinIndices, maxRounds, route);
+  }
+}
+
+void GamerLayerCpu::CleanDist(const int *mark, float *dist, int threadCount) {
+  const size_t rowCells = (size_t)mRow * mLayers;
+  ParallelFor(0, mCol, threadCount, [&](int rowId) {
+    size_t base = rowId * rowCells;
+    for (size_t i = base; i < base + rowCells; i++)
+      dist[i] = mark[i] ? 0.f : mInfinity;
+  });
+}
+
+void GamerLayerCpu::SweepLayers(const float *cost, float *dist, int *prev,
+                                int threadCount) {
+  // One task per grid row, all horizontal layers in the same pass so that
+  // the row block is read once, front to back.
+  if (!mHorizontal.empty()) {
+    ParallelFor(0, mCol, threadCount,
+                [&](int rowId) { SweepRow(cost, dist, prev, rowId); });
+  }
+
+  // One strip of whole rows per thread, as in GamerCpu::SweepVertical.
+  if (mVertical.empty())
+    return;
+  if (threadCount <= 0)
+    threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+  int width = (mRow + threadCount - 1) / threadCount;
+  width = (width + GAMER_LAYER_STRIP_ALIGN - 1) / GAMER_LAYER_STRIP_ALIGN *
+          GAMER_LAYER_STRIP_ALIGN;
+  int strips = (mRow + width - 1) / width;
+  ParallelFor(0, strips, threadCount, [&](int strip) {
+    int x0 = strip * width;
+    SweepColumns(cost, dist, prev, x0, std::min(x0 + width, mRow));
+  });
+}
+
+void GamerLayerCpu::RelaxVias(const float *via, float *dist, int *prev,
+                              int threadCount) {
+  // A stack is the layers of one cell, contiguous; its scratch is its own
+  // cells of mBest.
+  ParallelFor(0, mCol, threadCount, [&](int rowId) {
+    for (int x = 0; x < mRow; x++) {
+      int first = Index(x, rowId, 0);
+      SweepLine(mLayers, 1, via + first, dist + first, prev + first, first,
+                mBest.data() + first, mBestPrev.data() + first);
+    }
+  });
+}
+
+bool GamerLayerCpu::TracePath(const std::vector<int> &pinIndices,
+                              int numRounds, GamerLayerRoute &route) {
+  float minDist = mInfinity;
+  int pinId = -1;
+  for (int i = 0; i < (int)pinIndices.size(); i++) {
+    if (!route.isRoutedPin[i]) {
+      float d = route.dist[pinIndices[i]];
+      if (d < minDist) {
+        minDist = d;
+        pinId = i;
+      }
+    }
+  }
+  if (pinId == -1)
+    return false;
+  route.isRoutedPin[pinId] = 1;
+
+  // backtracing through the vias, then the wires, of every round
+  size_t cells = Cells();
+  const int rowCells = mRow * mLayers;
+  int idx = pinIndices[pinId];
+  for (int s = 2 * numRounds - 1; s >= 0; s--) {
+    int prevIdx = route.allPrev[s * cells + idx];
+    if (prevIdx == idx)
+      continue;
+    int startIdx = std::min(idx, prevIdx);
+    int endIdx = std::max(idx, prevIdx);
+    route.routes.push_back(startIdx);
+    route.routes.push_back(endIdx);
+    route.routes[0] += 2;
+    int step = idx / mLayers == prevIdx / mLayers ? 1 // via
+               : idx / rowCells == prevIdx / rowCells ? mLayers
+                                                      : rowCells;
+    for (int tmpIdx = startIdx; tmpIdx <= endIdx; tmpIdx += step)
+      route.mark[tmpIdx] = 1;
+    idx = prevIdx;
+  }
+  return true;
+}
+
+void GamerLayerCpu::SweepRow(const float *cost, float *dist, int *prev,
+                             int y) {
+  // GamerSweepRows for every horizontal layer of the row at once. The layer
+  // list is copied to the stack: the int stores below could alias it.
+  const int stride = mLayers;
+  const int count = (int)mHorizontal.size();
+  int layers[GAMER_LAYER_MAX];
+  std::copy(mHorizontal.begin(), mHorizontal.end(), layers);
+  const size_t base = (size_t)Index(0, y, 0);
+  const float *c = cost + base;
+  float *d = dist + base;
+  int *p = prev + base;
+  float *bestL = mBest.data() + base;
+  int *prevL = mBestPrev.data() + base;
+
+  for (int k = 0; k < count; k++) {
+    bestL[layers[k]] = d[layers[k]];
+    prevL[layers[k]] = layers[k];
+  }
+  for (int x = 1; x < mRow; x++) {
+    for (int k = 0; k < count; k++) {
+      int i = x * stride + layers[k];
+      float through = bestL[i - stride] + c[i];
+      bool take = d[i] > through;
+      bestL[i] = take ? through : d[i];
+      prevL[i] = take ? prevL[i - stride] : i;
+    }
+  }
+
+  float bestR[GAMER_LAYER_MAX];
+  int prevR[GAMER_LAYER_MAX];
+  for (int k = 0; k < count; k++) {
+    int i = (mRow - 1) * stride + layers[k];
+    bestR[k] = d[i];
+    prevR[k] = i;
+  }
+  for (int x = mRow - 1; x >= 0; x--) {
+    for (int k = 0; k < count; k++) {
+      int i = x * stride + layers[k];
+      if (x < mRow - 1) {
+        float through = bestR[k] + c[i + stride];
+        bool take = d[i] > through;
+        bestR[k] = take ? through : d[i];
+        prevR[k] = take ? prevR[k] : i;
+      }
+
+      float best = d[i];
+      int from = i;
+      if (bestL[i] < best) {
+        best = bestL[i];
+        from = prevL[i];
+      }
+      if (bestR[k] < best) {
+        best = bestR[k];
+        from = prevR[k];
+      }
+      d[i] = best;
+      p[i] = (int)base + from;
+    }
+  }
+}
+
+void GamerLayerCpu::SweepColumns(const float *cost, float *dist, int *prev,
+                                 int x0, int x1) {
+  // GamerSweepColumns for every vertical layer of the strip at once, a row
+  // of the strip at a time. Scratch entries hold cell indices; as in
+  // SweepRow the layer list is copied to the stack.
+  const int rowCells = mRow * mLayers;
+  const int count = (int)mVertical.size();
+  int layers[GAMER_LAYER_MAX];
+  std::copy(mVertical.begin(), mVertical.end(), layers);
+  const int stripCells = (x1 - x0) * mLayers;
+  float *bestL = mBest.data();
+  int *prevL = mBestPrev.data();
+
+  for (int j = 0; j < stripCells; j += mLayers) {
+    for (int k = 0; k < count; k++) {
+      int i = Index(x0, 0, 0) + j + layers[k];
+      bestL[i] = dist[i];
+      prevL[i] = i;
+    }
+  }
+  for (int y = 1; y < mCol; y++) {
+    int i0 = Index(x0, y, 0);
+    for (int j = 0; j < stripCells; j += mLayers) {
+      for (int k = 0; k < count; k++) {
+        int i = i0 + j + layers[k];
+        float through = bestL[i - rowCells] + cost[i];
+        bool take = dist[i] > through;
+        bestL[i] = take ? through : dist[i];
+        prevL[i] = take ? prevL[i - rowCells] : i;
+      }
+    }
+  }
+
+  std::vector<float> bestR(stripCells);
+  std::vector<int> prevR(stripCells);
+  for (int y = mCol - 1; y >= 0; y--) {
+    int i0 = Index(x0, y, 0);
+    for (int j = 0; j < stripCells; j += mLayers) {
+      for (int k = 0; k < count; k++) {
+        int r = j + layers[k];
+        int i = i0 + r;
+        if (y == mCol - 1) {
+          bestR[r] = dist[i];
+          prevR[r] = i;
+        } else {
+          float through = bestR[r] + cost[i + rowCells];
+          bool take = dist[i] > through;
+          bestR[r] = take ? through : dist[i];
+          prevR[r] = take ? prevR[r] : i;
+        }
+
+        float best = dist[i];
+        int from = i;
+        if (bestL[i] < best) {
+          best = bestL[i];
+          from = prevL[i];
+        }
+        if (bestR[r] < best) {
+          best = bestR[r];
+          from = prevR[r];
+        }
+        dist[i] = best;
+        prev[i] = from;
+      }
+    }
+  }
+}
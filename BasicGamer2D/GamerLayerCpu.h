@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Preferred direction of a routing layer: wires on it run only this way.
+enum class GamerLayerDir { Horizontal, Vertical };
+
+// Buffers of GamerLayerCpu after routing a net, cells layer-interleaved.
+struct GamerLayerRoute {
+  std::vector<float> dist;
+  // Two slices of row * col * layers per round: the layer sweeps, then the
+  // vias.
+  std::vector<int> allPrev;
+  std::vector<int> mark;
+  std::vector<int> isRoutedPin;
+  // routes[0] is the number of entries that follow: the start and end cell
+  // of every wire and via segment, smaller index first.
+  std::vector<int> routes;
+};
+
+// GAMER on a stack of routing layers, on the CPU. Every layer has a preferred
+// direction, and vias join a cell to the same cell on the layers above and
+// below. Cell (x, y, layer) is at (y * row + x) * layers + layer: the layers
+// of a cell are adjacent, so a via stack is a few floats of one cache line
+// and every grid row is one contiguous block for the wire sweeps.
+// cost[i] is the cost of the wire into cell i from the cell before it along
+// its layer (x - 1 or y - 1), via[i] the cost of the via into cell i from
+// the layer below; via is unused on layer 0. A round sweeps every layer along
+// its direction, then relaxes every via stack the same way, so a route of r
+// rounds has up to r wire and r via segments. Ties go to the nearer start as
+// in GamerCpu.
+class GamerLayerCpu {
+public:
+  // dirs has one entry per layer, from the bottom; throws std::runtime_error
+  // for no layers or more than 32.
+  GamerLayerCpu(int row, int col, const std::vector<GamerLayerDir> &dirs,
+                float infinity = 1000.f);
+
+  GamerLayerCpu(const GamerLayerCpu &rhs) = delete;
+  GamerLayerCpu &operator=(const GamerLayerCpu &rhs) = delete;
+  ~GamerLayerCpu() = default;
+
+  // GamerCpu::Route on the layers: pinIndices are cell indices with their
+  // layer, and every pin after the first takes maxRounds rounds.
+  void Route(const float *cost, const float *via,
+             const std::vector<int> &pinIndices, int maxRounds,
+             GamerLayerRoute &route, int threadCount = 0);
+
+  // Zero on marked cells, infinity elsewhere.
+  void CleanDist(const int *mark, float *dist, int threadCount = 0);
+
+  // Sweeps every layer along its direction. Rows and strips of columns, each
+  // with all of its layers, are the tasks split across threadCount threads
+  // (0 = all hardware threads). prev receives the
+  // cell each segment starts at, or the cell itself.
+  void SweepLayers(const float *cost, float *dist, int *prev,
+                   int threadCount = 0);
+
+  // Sweeps every via stack, one task per grid row.
+  void RelaxVias(const float *via, float *dist, int *prev,
+                 int threadCount = 0);
+
+  // Routes the closest unrouted pin back through the 2 * numRounds slices
+  // of allPrev, marking its cells and appending its segments to
+  // route.routes. False when no unrouted pin is closer than infinity.
+  bool TracePath(const std::vector<int> &pinIndices, int numRounds,
+                 GamerLayerRoute &route);
+
+  int Index(int x, int y, int layer) const {
+    return (y * mRow + x) * mLayers + layer;
+  }
+  int Row() const { return mRow; }
+  int Col() const { return mCol; }
+  int Layers() const { return mLayers; }
+  size_t Cells() const { return (size_t)mRow * mCol * mLayers; }
+  float Infinity() const { return mInfinity; }
+
+private:
+  // Row y of every horizontal layer, and columns [x0, x1) of every vertical
+  // layer.
+  void SweepRow(const float *cost, float *dist, int *prev, int y);
+  void SweepColumns(const float *cost, float *dist, int *prev, int x0,
+                    int x1);
+
+  int mRow = 0;
+  int mCol = 0;
+  int mLayers = 0;
+  float mInfinity = 1000.f;
+  std::vector<int> mHorizontal;
+  std::vector<int> mVertical;
+
+  // Scan from the left (top, bottom layer) of every line, one per cell.
+  std::vector<float> mBest;
+  std::vector<int> mBestPrev;
+};
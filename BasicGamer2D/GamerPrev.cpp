@@ -0,0 +1,150 @@
+#include "GamerPrev.h"
+#include <Common/ParallelFor.h>
+#include <algorithm>
+
+// Columns per task when encoding a vertical turn, and bytes per task when
+// packing; both keep tasks to whole cache lines.
+#define GAMER_PREV_STRIP 64
+#define GAMER_PREV_PACK_BLOCK 4096
+
+void GamerPrevStore::Reset(int row, int col, int maxTurns) {
+  mRow = row;
+  mCol = col;
+  mTurnBytes = ((size_t)row * col + 3) / 4;
+  mCodes.assign(maxTurns * mTurnBytes, 0);
+  mExceptions.assign(maxTurns, {});
+}
+
+void GamerPrevStore::Store(int turn, const int *prev, int threadCount) {
+  size_t cells = (size_t)mRow * mCol;
+  mCellCodes.resize(cells);
+  if (turn & 1) {
+    int strips = (mRow + GAMER_PREV_STRIP - 1) / GAMER_PREV_STRIP;
+    ParallelFor(0, strips, threadCount, [&](int strip) {
+      int x0 = strip * GAMER_PREV_STRIP;
+      EncodeColumns(prev, x0, std::min(x0 + GAMER_PREV_STRIP, mRow));
+    });
+  } else {
+    ParallelFor(0, mCol, threadCount,
+                [&](int y) { EncodeRow(prev, y); });
+  }
+
+  // Pack four codes to a byte and pick out the exceptions, in cell order.
+  int blocks = (int)((mTurnBytes + GAMER_PREV_PACK_BLOCK - 1) /
+                     GAMER_PREV_PACK_BLOCK);
+  std::vector<std::vector<std::pair<int, int>>> blockExceptions(blocks);
+  uint8_t *codes = mCodes.data() + turn * mTurnBytes;
+  ParallelFor(0, blocks, threadCount, [&](int block) {
+    size_t b0 = (size_t)block * GAMER_PREV_PACK_BLOCK;
+    size_t b1 = std::min(b0 + GAMER_PREV_PACK_BLOCK, mTurnBytes);
+    for (size_t b = b0; b < b1; b++) {
+      uint8_t byte = 0;
+      for (size_t i = 4 * b; i < std::min(4 * b + 4, cells); i++) {
+        byte |= mCellCodes[i] << (i % 4 * 2);
+        if (mCellCodes[i] == Exception)
+          blockExceptions[block].push_back({(int)i, prev[i]});
+      }
+      codes[b] = byte;
+    }
+  });
+
+  std::vector<std::pair<int, int>> &exceptions = mExceptions[turn];
+  exceptions.clear();
+  for (const auto &e : blockExceptions)
+    exceptions.insert(exceptions.end(), e.begin(), e.end());
+}
+
+int GamerPrevStore::Prev(int turn, int idx) const {
+  Code code = Get(turn, idx);
+  if (code == Self)
+    return idx;
+  if (code == Exception) {
+    const std::vector<std::pair<int, int>> &exceptions = mExceptions[turn];
+    auto it = std::lower_bound(exceptions.begin(), exceptions.end(),
+                               std::make_pair(idx, 0));
+    return it->second;
+  }
+
+  // The first cell of the line, or the last, is never coded to point past it.
+  int step = (turn & 1) ? mRow : 1;
+  if (code == Lower)
+    step = -step;
+  do
+    idx += step;
+  while (Get(turn, idx) == code);
+  return idx;
+}
+
+size_t GamerPrevStore::Bytes() const {
+  size_t bytes = mCodes.size();
+  for (const auto &exceptions : mExceptions)
+    bytes += exceptions.size() * sizeof(exceptions[0]);
+  return bytes;
+}
+
+size_t GamerPrevStore::Exceptions() const {
+  size_t count = 0;
+  for (const auto &exceptions : mExceptions)
+    count += exceptions.size();
+  return count;
+}
+
+void GamerPrevStore::EncodeRow(const int *prev, int y) {
+  const int base = y * mRow;
+  uint8_t *codes = mCellCodes.data();
+  // A cell can point down the line when its start is the last cell below it
+  // that does not, and that start is its own.
+  int last = -1;
+  for (int i = base; i < base + mRow; i++) {
+    if (prev[i] == i)
+      codes[i] = Self;
+    else if (prev[i] == last && codes[last] == Self)
+      codes[i] = Lower;
+    else
+      codes[i] = Exception;
+    if (codes[i] != Lower)
+      last = i;
+  }
+  last = -1;
+  for (int i = base + mRow - 1; i >= base; i--) {
+    if (codes[i] == Exception && prev[i] == last && codes[last] == Self)
+      codes[i] = Upper;
+    if (codes[i] != Upper)
+      last = i;
+  }
+}
+
+void GamerPrevStore::EncodeColumns(const int *prev, int x0, int x1) {
+  // As EncodeRow, a whole row of the strip at a time.
+  uint8_t *codes = mCellCodes.data();
+  std::vector<int> last(x1 - x0, -1);
+  for (int y = 0; y < mCol; y++) {
+    int i = y * mRow + x0;
+    for (int k = 0; k < x1 - x0; k++, i++) {
+      if (prev[i] == i)
+        codes[i] = Self;
+      else if (prev[i] == last[k] && codes[last[k]] == Self)
+        codes[i] = Lower;
+      else
+        codes[i] = Exception;
+      if (codes[i] != Lower)
+        last[k] = i;
+    }
+  }
+  std::fill(last.begin(), last.end(), -1);
+  for (int y = mCol - 1; y >= 0; y--) {
+    int i = y * mRow + x0;
+    for (int k = 0; k < x1 - x0; k++, i++) {
+      if (codes[i] == Exception && prev[i] == last[k] &&
+          codes[last[k]] == Self)
+        codes[i] = Upper;
+      if (codes[i] != Upper)
+        last[k] = i;
+    }
+  }
+}
+
+GamerPrevStore::Code GamerPrevStore::Get(int turn, int idx) const {
+  uint8_t byte = mCodes[turn * mTurnBytes + idx / 4];
+  return (Code)((byte >> (idx % 4 * 2)) & 3);
+}
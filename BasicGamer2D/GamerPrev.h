@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Predecessors of every turn at two bits per cell instead of an int. A turn
+// moves along rows (even turns) or columns (odd turns), so every predecessor
+// is on the cell's own line, and with non-negative costs the cells between a
+// cell and the start of its segment all come from the same start, which
+// comes from itself. Each cell stores only which way its start lies: the
+// start is the first cell that way not pointing the same way. Cells where
+// that does not hold, e.g. after rounding in float sums, are kept exactly in
+// a sorted exception list, so Prev() always returns what the sweep wrote.
+class GamerPrevStore {
+public:
+  void Reset(int row, int col, int maxTurns);
+
+  // Encodes the row * col slice of allPrev for one turn, splitting lines
+  // across threadCount threads (0 = all hardware threads).
+  void Store(int turn, const int *prev, int threadCount = 0);
+
+  // allPrev[turn * row * col + idx].
+  int Prev(int turn, int idx) const;
+
+  size_t Bytes() const;
+  size_t Exceptions() const;
+
+private:
+  enum Code : uint8_t { Self = 0, Lower = 1, Upper = 2, Exception = 3 };
+
+  // Codes of one row (column strip) into mCellCodes.
+  void EncodeRow(const int *prev, int y);
+  void EncodeColumns(const int *prev, int x0, int x1);
+  Code Get(int turn, int idx) const;
+
+  int mRow = 0;
+  int mCol = 0;
+  // Four cells per byte in cell order, (row * col + 3) / 4 bytes per turn.
+  size_t mTurnBytes = 0;
+  std::vector<uint8_t> mCodes;
+  // (idx, prev) pairs of every turn, sorted by idx.
+  std::vector<std::vector<std::pair<int, int>>> mExceptions;
+  // One byte per cell of the turn being stored, before packing.
+  std::vector<uint8_t> mCellCodes;
+};
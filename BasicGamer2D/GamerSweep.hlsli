@@ -0,0 +1,195 @@
+// One turn of the router: every line of the grid is min-plus scanned in both
+// directions and dist lowered to the cheapest straight segment from any cell
+// of the line. The including file defines LINE_LENGTH, NUM_LINES and
+// CellIndex(line, pos), where cost[CellIndex(line, pos)] is the cost of the
+// edge from pos - 1 to pos.
+//
+// A line is cut into SWEEP_BLOCKS blocks of SWEEP_BLOCK cells, one thread
+// group each, dispatched as (SWEEP_BLOCKS, NUM_LINES). A line of one block is
+// swept by main alone. Longer lines take three passes: ReduceBlocks scans
+// every block on its own and keeps what leaves it at either end,
+// PropagateCarry walks those along the line to find what enters every block,
+// and main scans the blocks again with that folded in.
+
+#define SWEEP_BLOCKS ((LINE_LENGTH + SWEEP_BLOCK - 1) / SWEEP_BLOCK)
+
+struct SweepCarry {
+  // Block scanned on its own, left to right: total cost from its first to its
+  // last cell, and the best distance at the last cell with where it starts.
+  float costL;
+  float distL;
+  int prevL;
+  // The same right to left, ending at the first cell.
+  float costR;
+  float distR;
+  int prevR;
+  // Best distance arriving at the first (last) cell from the blocks left
+  // (right) of this one, edge onto the cell included, and where it starts.
+  float inDistL;
+  int inPrevL;
+  float inDistR;
+  int inPrevR;
+};
+
+cbuffer CB : register(b0) {
+  int turn;
+};
+RWStructuredBuffer<float> cost : register(u0);
+RWStructuredBuffer<float> dist : register(u1);
+RWStructuredBuffer<int> allPrev : register(u2);
+RWStructuredBuffer<SweepCarry> carry : register(u3);
+
+groupshared float cL[SWEEP_BLOCK];
+groupshared float cR[SWEEP_BLOCK];
+groupshared float dL[SWEEP_BLOCK];
+groupshared float dR[SWEEP_BLOCK];
+groupshared int pL[SWEEP_BLOCK];
+groupshared int pR[SWEEP_BLOCK];
+
+uint BlockFirst(uint blockId) { return blockId * SWEEP_BLOCK; }
+uint BlockLast(uint blockId) {
+  return min(BlockFirst(blockId) + SWEEP_BLOCK, LINE_LENGTH) - 1;
+}
+
+// Scans block blockId of line lineId from the left into cL/dL/pL and from the
+// right into cR/dR/pR, where index cur is the cur-th cell from that end.
+// Slots past the end of a short block are unreachable and free to cross.
+void ScanBlock(uint threadId, uint lineId, uint blockId) {
+  uint first = BlockFirst(blockId);
+  uint last = BlockLast(blockId);
+  for (uint cur = threadId; cur < SWEEP_BLOCK; cur += SWEEP_BLOCK / 2) {
+    if (cur <= last - first) {
+      cL[cur] = cur == 0 ? 0.f : cost[CellIndex(lineId, first + cur)];
+      cR[cur] = cur == 0 ? 0.f : cost[CellIndex(lineId, last - cur + 1)];
+      dL[cur] = dist[CellIndex(lineId, first + cur)];
+      dR[cur] = dist[CellIndex(lineId, last - cur)];
+      pL[cur] = first + cur;
+      pR[cur] = last - cur;
+    } else {
+      cL[cur] = cR[cur] = 0.f;
+      dL[cur] = dR[cur] = INFINITY_DISTANCE;
+      pL[cur] = pR[cur] = -1;
+    }
+  }
+  GroupMemoryBarrierWithGroupSync();
+
+  for (uint d = 0; (1 << d) < SWEEP_BLOCK; d++) {
+    uint dst = (threadId >> d << (d + 1) | (1 << d)) | (threadId & ((1 << d) - 1));
+    uint src = (dst >> d << d) - 1;
+    if (dL[dst] > dL[src] + cL[dst]) {
+      dL[dst] = dL[src] + cL[dst];
+      pL[dst] = pL[src];
+    }
+    if (dR[dst] > dR[src] + cR[dst]) {
+      dR[dst] = dR[src] + cR[dst];
+      pR[dst] = pR[src];
+    }
+    cL[dst] += cL[src];
+    cR[dst] += cR[src];
+    GroupMemoryBarrierWithGroupSync();
+  }
+}
+
+[numthreads(SWEEP_BLOCK / 2, 1, 1)]
+void ReduceBlocks(uint3 threadIdx : SV_GroupThreadID, uint3 blockIdx : SV_GroupID) {
+  uint lineId = blockIdx.y;
+  uint blockId = blockIdx.x;
+  ScanBlock(threadIdx.x, lineId, blockId);
+  if (threadIdx.x == 0) {
+    uint n = BlockLast(blockId) - BlockFirst(blockId);
+    uint i = lineId * SWEEP_BLOCKS + blockId;
+    carry[i].costL = cL[n];
+    carry[i].distL = dL[n];
+    carry[i].prevL = pL[n];
+    carry[i].costR = cR[n];
+    carry[i].distR = dR[n];
+    carry[i].prevR = pR[n];
+  }
+}
+
+// One thread per line, serial over its blocks.
+[numthreads(64, 1, 1)]
+void PropagateCarry(uint3 dispatchIdx : SV_DispatchThreadID) {
+  uint lineId = dispatchIdx.x;
+  if (lineId >= NUM_LINES)
+    return;
+  uint base = lineId * SWEEP_BLOCKS;
+
+  // Best distance at the last cell of the blocks so far, and its start.
+  float best = INFINITY_DISTANCE;
+  int prev = -1;
+  for (uint b = 0; b < SWEEP_BLOCKS; b++) {
+    float arrive = b == 0 ? INFINITY_DISTANCE
+                          : best + cost[CellIndex(lineId, BlockFirst(b))];
+    carry[base + b].inDistL = arrive;
+    carry[base + b].inPrevL = prev;
+    if (arrive + carry[base + b].costL < carry[base + b].distL) {
+      best = arrive + carry[base + b].costL;
+    } else {
+      best = carry[base + b].distL;
+      prev = carry[base + b].prevL;
+    }
+  }
+
+  best = INFINITY_DISTANCE;
+  prev = -1;
+  for (int b = (int)SWEEP_BLOCKS - 1; b >= 0; b--) {
+    float arrive = b == (int)SWEEP_BLOCKS - 1
+                   ? INFINITY_DISTANCE
+                   : best + cost[CellIndex(lineId, BlockLast(b) + 1)];
+    carry[base + b].inDistR = arrive;
+    carry[base + b].inPrevR = prev;
+    if (arrive + carry[base + b].costR < carry[base + b].distR) {
+      best = arrive + carry[base + b].costR;
+    } else {
+      best = carry[base + b].distR;
+      prev = carry[base + b].prevR;
+    }
+  }
+}
+
+[numthreads(SWEEP_BLOCK / 2, 1, 1)]
+void main(uint3 threadIdx : SV_GroupThreadID, uint3 blockIdx : SV_GroupID) {
+  uint lineId = blockIdx.y;
+  uint blockId = blockIdx.x;
+  ScanBlock(threadIdx.x, lineId, blockId);
+
+  float inL = INFINITY_DISTANCE, inR = INFINITY_DISTANCE;
+  int inPrevL = -1, inPrevR = -1;
+#if SWEEP_BLOCKS > 1
+  SweepCarry c = carry[lineId * SWEEP_BLOCKS + blockId];
+  inL = c.inDistL;
+  inPrevL = c.inPrevL;
+  inR = c.inDistR;
+  inPrevR = c.inPrevR;
+#endif
+
+  uint first = BlockFirst(blockId);
+  uint last = BlockLast(blockId);
+  for (uint cur = threadIdx.x; cur <= last - first; cur += SWEEP_BLOCK / 2) {
+    uint idx = CellIndex(lineId, first + cur);
+    uint rev = last - first - cur;
+    float bestL = dL[cur];
+    int prevL = pL[cur];
+    if (inL + cL[cur] < bestL) {
+      bestL = inL + cL[cur];
+      prevL = inPrevL;
+    }
+    float bestR = dR[rev];
+    int prevR = pR[rev];
+    if (inR + cR[rev] < bestR) {
+      bestR = inR + cR[rev];
+      prevR = inPrevR;
+    }
+
+    allPrev[turn * ROW * COL + idx] = idx;
+    if (bestL < dist[idx]) {
+      dist[idx] = bestL;
+      allPrev[turn * ROW * COL + idx] = CellIndex(lineId, prevL);
+    }
+    if (bestR < dist[idx]) {
+      dist[idx] = bestR;
+      allPrev[turn * ROW * COL + idx] = CellIndex(lineId, prevR);
+    }
+  }
+}
@@ -8,11 +8,15 @@ RWStructuredBuffer<int> mark : register(u1);
 RWStructuredBuffer<int> isRoutedPin : register(u2);
 RWStructuredBuffer<int> routes : register(u3);
 
-[numthreads(1, 1, 1)]
-void main() {
-  for (int i = 0; i < numPins; i++)
-    isRoutedPin[i] = 0;
-  isRoutedPin[0] = 1;
-  mark[pinIndices[0]] = 1;
-  routes[0] = 0;
-}
\ No newline at end of file
+// One thread per pin, dispatched as ((numPins + 255) / 256, 1, 1).
+[numthreads(256, 1, 1)]
+void main(uint3 dispatchIdx : SV_DispatchThreadID) {
+  int i = dispatchIdx.x;
+  if (i >= numPins)
+    return;
+  isRoutedPin[i] = i == 0;
+  if (i == 0) {
+    mark[pinIndices[0]] = 1;
+    routes[0] = 0;
+  }
+}
@@ -1,5 +1,14 @@
 #include "GamerCommon.hlsli"
 
+// Routes the closest unrouted pin back to the routed tree in three passes:
+// SelectPin picks the pin with an argmin over all pins in one thread group,
+// main walks allPrev back through the turns and lists the segments, and
+// MarkSegments marks their cells, one thread per cell. trace holds the pin
+// picked, then the number of segments and (start, step, length) of each.
+
+#define SELECT_THREADS 256
+#define MARK_THREADS 256
+
 cbuffer CB : register(b0) {
   int numPins;
   int numTurns;
@@ -10,28 +19,62 @@ RWStructuredBuffer<int> pinIndices : register(u2);
 RWStructuredBuffer<int> mark : register(u3);
 RWStructuredBuffer<int> isRoutedPin : register(u4);
 RWStructuredBuffer<int> routes : register(u5);
+RWStructuredBuffer<int> trace : register(u6);
 
-[numthreads(1, 1, 1)]
-void main() {
-  float minDist = INFINITY_DISTANCE;
-  int pinId = -1, idx = -1;
+groupshared float bestDist[SELECT_THREADS];
+groupshared int bestPin[SELECT_THREADS];
 
-  // fine the closest un-routed pin
-  for (int i = 0; i < numPins; i++) {
+// One group. Every thread keeps the first closest pin of its stride, then the
+// tree keeps the closer of two, the lower pin on ties, so the pin picked is
+// the one the serial loop would pick.
+[numthreads(SELECT_THREADS, 1, 1)]
+void SelectPin(uint threadId : SV_GroupIndex) {
+  float minDist = INFINITY_DISTANCE;
+  int pinId = 0x7fffffff;
+  for (int i = threadId; i < numPins; i += SELECT_THREADS) {
     if (!isRoutedPin[i]) {
-      int p = pinIndices[i];
-      if (dist[p] < minDist) {
-        minDist = dist[p];
-        idx = p;
+      float d = dist[pinIndices[i]];
+      if (d < minDist) {
+        minDist = d;
         pinId = i;
       }
     }
   }
+  bestDist[threadId] = minDist;
+  bestPin[threadId] = pinId;
+  GroupMemoryBarrierWithGroupSync();
+
+  for (uint stride = SELECT_THREADS / 2; stride > 0; stride >>= 1) {
+    if (threadId < stride) {
+      float d = bestDist[threadId + stride];
+      int p = bestPin[threadId + stride];
+      if (d < bestDist[threadId] ||
+          (d == bestDist[threadId] && p < bestPin[threadId])) {
+        bestDist[threadId] = d;
+        bestPin[threadId] = p;
+      }
+    }
+    GroupMemoryBarrierWithGroupSync();
+  }
+
+  if (threadId == 0) {
+    pinId = bestPin[0] == 0x7fffffff ? -1 : bestPin[0];
+    trace[0] = pinId;
+    trace[1] = 0;
+    if (pinId != -1)
+      isRoutedPin[pinId] = 1;
+  }
+}
+
+// backtracing
+[numthreads(1, 1, 1)]
+void main() {
+  int pinId = trace[0];
   if (pinId == -1)
     return;
-  isRoutedPin[pinId] = 1;
 
-  // backtracing
+  int idx = pinIndices[pinId];
+  int segments = 0;
   for (int t = numTurns - 1; t >= 0; t--) {
     int prevIdx = allPrev[t * ROW * COL + idx];
     if (prevIdx == idx)
@@ -40,13 +83,22 @@ void main() {
     int endIdx = max(idx, prevIdx);
     routes[++routes[0]] = startIdx;
     routes[++routes[0]] = endIdx;
-    if ((uint) idx / ROW == (uint) prevIdx / ROW) { // horizontal
-      for (int tmpIdx = startIdx; tmpIdx <= endIdx; tmpIdx++)
-        mark[tmpIdx] = 1;
-    } else { // vertical
-      for (int tmpIdx = startIdx; tmpIdx <= endIdx; tmpIdx += ROW)
-        mark[tmpIdx] = 1;
-    }
+    int step = (uint)idx / ROW == (uint)prevIdx / ROW ? 1 : ROW; // horizontal
+    trace[2 + 3 * segments] = startIdx;
+    trace[3 + 3 * segments] = step;
+    trace[4 + 3 * segments] = (endIdx - startIdx) / step + 1;
+    segments++;
     idx = prevIdx;
   }
-}
\ No newline at end of file
+  trace[1] = segments;
+}
+
+// Dispatched as ((max(ROW, COL) + MARK_THREADS - 1) / MARK_THREADS,
+// numTurns): group row s marks segment s.
+[numthreads(MARK_THREADS, 1, 1)]
+void MarkSegments(uint3 dispatchIdx : SV_DispatchThreadID) {
+  int s = dispatchIdx.y;
+  if (s >= trace[1] || (int)dispatchIdx.x >= trace[4 + 3 * s])
+    return;
+  mark[trace[2 + 3 * s] + dispatchIdx.x * trace[3 + 3 * s]] = 1;
+}
@@ -1,16 +1,50 @@
+#include "GamerBenchmark.h"
+#include "GamerDriver.h"
+#include <cstdio>
+#include <cstring>
+#ifdef _WIN32
 #include "BasicGamer2DApp.h"
+#endif
 
-int main(void) {
+int main(int argc, char **argv) {
   // Enable run-time memory check for debug builds.
-#if defined(DEBUG) | defined(_DEBUG)
+#if defined(_WIN32) && (defined(DEBUG) | defined(_DEBUG))
   _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
 
+  // -bench: time the CPU sweeps and batch routing, then the GPU sweeps checked
+  // against them (on builds without D3D12, only the CPU part).
+  // -golden: route the demo net on the CPU and check it, without a device.
+  // -validate: every check of -bench without the timing; non-zero on any
+  // mismatch.
+  // -route, -make-instance: run the headless driver, see GamerDriver.h.
+  bool benchmark = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-golden") == 0)
+      return RunGoldenCheck() ? 0 : 1;
+    if (strcmp(argv[i], "-validate") == 0)
+      return RunValidation() ? 0 : 1;
+    if (strcmp(argv[i], "-route") == 0 ||
+        strcmp(argv[i], "-make-instance") == 0)
+      return RunRouteDriver(argc, argv);
+    benchmark = benchmark || strcmp(argv[i], "-bench") == 0;
+  }
+  if (benchmark)
+    RunSweepBenchmark();
+
+#ifdef _WIN32
   try {
-    BasicGamer2DApp{}.Run();
+    BasicGamer2DApp{benchmark}.Run();
   } catch (DxException &e) {
     setlocale(LC_ALL, "");
     fwprintf(stderr, L"HR Failed: %ls", e.ToString().c_str());
     return 0;
   }
-}
\ No newline at end of file
+#else
+  if (!benchmark) {
+    fprintf(stderr, "this build has no D3D12; use -golden, -validate, -bench, "
+                    "-route or -make-instance\n");
+    return 1;
+  }
+#endif
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// True when the CPU has AVX and the OS saves the YMM registers.
+inline bool CpuSupportsAvx()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+	return __builtin_cpu_supports("avx");
+#endif
+}
+
+// CpuSupportsAvx, and the CPU has AVX2.
+inline bool CpuSupportsAvx2()
+{
+#if defined(_MSC_VER)
+	if (!CpuSupportsAvx())
+		return false;
+
+	int info[4];
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "d3dUtil.h"
+
+// RenderTargetPool allocator creating committed 2D textures on the default heap.
+struct D3D12RenderTargetAllocator
+{
+	struct Desc
+	{
+		DXGI_FORMAT Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		D3D12_RESOURCE_FLAGS Flags = D3D12_RESOURCE_FLAG_NONE;
+		D3D12_RESOURCE_STATES InitialState = D3D12_RESOURCE_STATE_GENERIC_READ;
+
+		bool operator==(const Desc& rhs) const
+		{
+			return Format == rhs.Format && Flags == rhs.Flags && InitialState == rhs.InitialState;
+		}
+	};
+
+	typedef Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+
+	explicit D3D12RenderTargetAllocator(ID3D12Device* device) : Device(device) {}
+
+	Resource Allocate(const Desc& desc, unsigned int width, unsigned int height)
+	{
+		D3D12_RESOURCE_DESC texDesc;
+		ZeroMemory(&texDesc, sizeof(D3D12_RESOURCE_DESC));
+		texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		texDesc.Alignment = 0;
+		texDesc.Width = width;
+		texDesc.Height = height;
+		texDesc.DepthOrArraySize = 1;
+		texDesc.MipLevels = 1;
+		texDesc.Format = desc.Format;
+		texDesc.SampleDesc.Count = 1;
+		texDesc.SampleDesc.Quality = 0;
+		texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+		texDesc.Flags = desc.Flags;
+
+		Resource resource;
+		ThrowIfFailed(Device->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+			D3D12_HEAP_FLAG_NONE,
+			&texDesc,
+			desc.InitialState,
+			nullptr,
+			IID_PPV_ARGS(&resource)));
+		return resource;
+	}
+
+	void Release(Resource& resource)
+	{
+		resource.Reset();
+	}
+
+	ID3D12Device* Device = nullptr;
+};
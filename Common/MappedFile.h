@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only file with one mapped view at a time. Throws std::runtime_error
+// when the file cannot be opened or mapped, or a view runs past its end.
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::string& path) : mPath(path)
+	{
+#ifdef _WIN32
+		mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		LARGE_INTEGER size;
+		if (mFile == INVALID_HANDLE_VALUE || !GetFileSizeEx(mFile, &size))
+			throw std::runtime_error("cannot open " + path);
+		mSize = (uint64_t)size.QuadPart;
+		mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mMapping)
+			throw std::runtime_error("cannot map " + path);
+#else
+		mFd = open(path.c_str(), O_RDONLY);
+		struct stat st;
+		if (mFd < 0 || fstat(mFd, &st) != 0)
+			throw std::runtime_error("cannot open " + path);
+		mSize = (uint64_t)st.st_size;
+#endif
+	}
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile()
+	{
+		Unmap();
+#ifdef _WIN32
+		if (mMapping)
+			CloseHandle(mMapping);
+		if (mFile != INVALID_HANDLE_VALUE)
+			CloseHandle(mFile);
+#else
+		if (mFd >= 0)
+			close(mFd);
+#endif
+	}
+
+	uint64_t Size() const { return mSize; }
+
+	// Maps [offset, offset + size) in place of the previous view and returns
+	// a pointer to offset. Views start on the 64 KB allocation granularity of
+	// Windows, which is a multiple of the page size everywhere else.
+	const uint8_t* Map(uint64_t offset, size_t size)
+	{
+		if (offset + size > mSize)
+			throw std::runtime_error(mPath + " is truncated");
+		Unmap();
+		uint64_t start = offset & ~uint64_t(0xffff);
+		mViewSize = size_t(offset + size - start);
+#ifdef _WIN32
+		mView = MapViewOfFile(mMapping, FILE_MAP_READ, DWORD(start >> 32),
+			DWORD(start), mViewSize);
+		if (!mView)
+			throw std::runtime_error("cannot map " + mPath);
+#else
+		mView = mmap(nullptr, mViewSize, PROT_READ, MAP_PRIVATE, mFd, (off_t)start);
+		if (mView == MAP_FAILED)
+		{
+			mView = nullptr;
+			throw std::runtime_error("cannot map " + mPath);
+		}
+		madvise(mView, mViewSize, MADV_SEQUENTIAL);
+#endif
+		return static_cast<const uint8_t*>(mView) + (offset - start);
+	}
+
+private:
+	void Unmap()
+	{
+		if (!mView)
+			return;
+#ifdef _WIN32
+		UnmapViewOfFile(mView);
+#else
+		munmap(mView, mViewSize);
+#endif
+		mView = nullptr;
+	}
+
+	std::string mPath;
+#ifdef _WIN32
+	HANDLE mFile = INVALID_HANDLE_VALUE;
+	HANDLE mMapping = nullptr;
+#else
+	int mFd = -1;
+#endif
+	void* mView = nullptr;
+	size_t mViewSize = 0;
+	uint64_t mSize = 0;
+};
+
+// Copies count elements at offset out of file, mapping at most chunkBytes at
+// a time.
+template<typename T>
+void CopySection(MappedFile& file, uint64_t offset, uint64_t count, T* out, uint64_t chunkBytes)
+{
+	const uint64_t perChunk = std::max<uint64_t>(1, chunkBytes / sizeof(T));
+	for (uint64_t first = 0; first < count; first += perChunk)
+	{
+		size_t n = (size_t)std::min(perChunk, count - first);
+		const uint8_t* data = file.Map(offset + first * sizeof(T), n * sizeof(T));
+		memcpy(out + first, data, n * sizeof(T));
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// Splits [begin, end) into contiguous chunks and runs body(i) for every index,
+// one chunk per thread. threadCount <= 0 uses every hardware thread. The calling
+// thread takes the first chunk itself, so threadCount == 1 spawns nothing.
+template<typename Body>
+void ParallelFor(int begin, int end, int threadCount, Body&& body)
+{
+	if (end <= begin)
+		return;
+
+	if (threadCount <= 0)
+		threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+	threadCount = std::min(threadCount, end - begin);
+
+	int chunk = (end - begin + threadCount - 1) / threadCount;
+
+	std::vector<std::thread> workers;
+	workers.reserve(threadCount - 1);
+	for (int t = 1; t < threadCount; ++t)
+	{
+		int first = begin + t * chunk;
+		int last = std::min(first + chunk, end);
+		if (first >= last)
+			break;
+		workers.emplace_back([first, last, &body]()
+		{
+			for (int i = first; i < last; ++i)
+				body(i);
+		});
+	}
+
+	for (int i = begin, last = std::min(begin + chunk, end); i < last; ++i)
+		body(i);
+
+	for (auto& w : workers)
+		w.join();
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+///<summary>
+/// Keeps size-dependent textures (edge maps, copies of the back buffer, ...)
+/// alive across window resizes. Each named target is backed by a texture whose
+/// dimensions are rounded up to geometric buckets, so a drag only allocates when
+/// it crosses a bucket; shrinking reuses the bigger texture. Replaced textures
+/// are released releaseDelay frames later, once the GPU can no longer read them.
+///
+/// Allocator must provide:
+///   typedef ... Resource;   // default constructible, movable
+///   typedef ... Desc;       // compared with ==
+///   Resource Allocate(const Desc& desc, unsigned int width, unsigned int height);
+///   void Release(Resource& resource);
+///</summary>
+template<typename Allocator>
+class RenderTargetPool
+{
+public:
+	typedef typename Allocator::Resource Resource;
+	typedef typename Allocator::Desc Desc;
+
+	struct Target
+	{
+		Resource Res = Resource();
+		Desc ResDesc = Desc();
+
+		// Size of the texture actually allocated.
+		unsigned int Width = 0;
+		unsigned int Height = 0;
+
+		// Size the caller asked for; the valid region starts at (0, 0).
+		unsigned int ViewWidth = 0;
+		unsigned int ViewHeight = 0;
+
+		// Bumped whenever Res changes, so views onto it know to be rebuilt.
+		unsigned int Generation = 0;
+	};
+
+	RenderTargetPool(Allocator allocator, unsigned int releaseDelay) :
+		mAllocator(std::move(allocator)), mReleaseDelay(releaseDelay)
+	{
+	}
+
+	RenderTargetPool(const RenderTargetPool& rhs) = delete;
+	RenderTargetPool& operator=(const RenderTargetPool& rhs) = delete;
+
+	~RenderTargetPool()
+	{
+		for (auto& retired : mRetired)
+			mAllocator.Release(retired.Res);
+		for (auto& t : mTargets)
+			mAllocator.Release(t.second.Res);
+	}
+
+	const Target& Acquire(const std::string& name, const Desc& desc, unsigned int width, unsigned int height)
+	{
+		Target& t = mTargets[name];
+		t.ViewWidth = width;
+		t.ViewHeight = height;
+
+		unsigned int bucketWidth = BucketSize(width);
+		unsigned int bucketHeight = BucketSize(height);
+
+		bool fits = t.Generation != 0 && t.ResDesc == desc && width <= t.Width && height <= t.Height;
+
+		// Reuse on shrink, unless the texture has become far too big for the request.
+		bool wasteful = (std::uint64_t)bucketWidth * bucketHeight * kShrinkFactor < (std::uint64_t)t.Width * t.Height;
+		if (fits && !wasteful)
+			return t;
+
+		if (t.Generation != 0)
+			mRetired.push_back({ std::move(t.Res), mFrame });
+
+		t.Res = mAllocator.Allocate(desc, bucketWidth, bucketHeight);
+		t.ResDesc = desc;
+		t.Width = bucketWidth;
+		t.Height = bucketHeight;
+		t.Generation++;
+		mAllocationCount++;
+		return t;
+	}
+
+	// Call once per frame after the frame's commands have been submitted.
+	void EndFrame()
+	{
+		mFrame++;
+
+		std::size_t kept = 0;
+		for (std::size_t i = 0; i < mRetired.size(); ++i)
+		{
+			if (mFrame - mRetired[i].Frame >= mReleaseDelay)
+			{
+				mAllocator.Release(mRetired[i].Res);
+				mReleaseCount++;
+			}
+			else
+			{
+				mRetired[kept++] = std::move(mRetired[i]);
+			}
+		}
+		mRetired.resize(kept);
+	}
+
+	static unsigned int BucketSize(unsigned int size)
+	{
+		// 64, 80, 112, 144, ... (x1.25, rounded up to multiples of 16).
+		unsigned int bucket = kMinBucket;
+		while (bucket < size)
+			bucket = (bucket + bucket / 4 + 15) & ~15u;
+		return bucket;
+	}
+
+	Allocator& GetAllocator() { return mAllocator; }
+
+	int AllocationCount() const { return mAllocationCount; }
+	int ReleaseCount() const { return mReleaseCount; }
+	std::size_t PendingReleaseCount() const { return mRetired.size(); }
+
+private:
+	static const unsigned int kMinBucket = 64;
+	static const unsigned int kShrinkFactor = 4;
+
+	struct Retired
+	{
+		Resource Res;
+		std::uint64_t Frame;
+	};
+
+	Allocator mAllocator;
+	unsigned int mReleaseDelay = 0;
+
+	std::unordered_map<std::string, Target> mTargets;
+	std::vector<Retired> mRetired;
+
+	std::uint64_t mFrame = 0;
+	int mAllocationCount = 0;
+	int mReleaseCount = 0;
+};
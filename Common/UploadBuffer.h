@@ -55,6 +55,15 @@ public:
         memcpy(&mMappedData[elementIndex*mElementByteSize], &data, sizeof(T));
     }
 
+    // Direct access to the persistently mapped memory, for producers that want to
+    // write elements in place instead of going through CopyData. Only valid for
+    // tightly packed (non-constant) buffers.
+    T* MappedData()
+    {
+        assert(!mIsConstantBuffer);
+        return reinterpret_cast<T*>(mMappedData);
+    }
+
 private:
     Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
     BYTE* mMappedData = nullptr;
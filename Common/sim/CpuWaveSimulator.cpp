@@ -0,0 +1,164 @@
+#include "CpuWaveSimulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+	inline void ShadeRow(const float* h, WaveSample* out, int i, int numRows, int numCols, float spatialStep)
+	{
+		const float* row = h + i * numCols;
+		const float* up = h + std::max(i - 1, 0) * numCols;
+		const float* down = h + std::min(i + 1, numRows - 1) * numCols;
+		WaveSample* dst = out + i * numCols;
+		const float twoDx = 2.0f * spatialStep;
+
+		for (int j = 0; j < numCols; ++j)
+		{
+			float l = row[std::max(j - 1, 0)];
+			float r = row[std::min(j + 1, numCols - 1)];
+			float t = up[j];
+			float b = down[j];
+
+			// Same finite difference as the DISPLACEMENT_MAP path in Lit.hlsl.
+			float nx = l - r;
+			float ny = twoDx;
+			float nz = b - t;
+			float invLen = 1.0f / std::sqrt(nx * nx + ny * ny + nz * nz);
+
+			WaveSample s;
+			s.Height = row[j];
+			s.Normal[0] = nx * invLen;
+			s.Normal[1] = ny * invLen;
+			s.Normal[2] = nz * invLen;
+			dst[j] = s;
+		}
+	}
+
+	inline void StepRow(float* prev, const float* curr, int i, int numCols, float k1, float k2, float k3)
+	{
+		float* p = prev + i * numCols;
+		const float* c = curr + i * numCols;
+		const float* cu = c - numCols;
+		const float* cd = c + numCols;
+
+		// Boundary columns stay fixed at zero.
+		for (int j = 1; j < numCols - 1; ++j)
+			p[j] = k1 * p[j] + k2 * c[j] + k3 * (cd[j] + cu[j] + c[j + 1] + c[j - 1]);
+	}
+}
+
+void WaveStep(float* prev, const float* curr, int numRows, int numCols, float k1, float k2, float k3)
+{
+	for (int i = 1; i < numRows - 1; ++i)
+		StepRow(prev, curr, i, numCols, k1, k2, k3);
+}
+
+void WaveStepAndShade(float* prev, const float* curr, WaveSample* out,
+	int numRows, int numCols, float k1, float k2, float k3, float spatialStep)
+{
+	// Row i-1 can be shaded as soon as row i of the next solution exists, so the
+	// shading pass trails the stencil update by one row and stays in cache.
+	for (int i = 0; i < numRows; ++i)
+	{
+		if (i > 0 && i < numRows - 1)
+			StepRow(prev, curr, i, numCols, k1, k2, k3);
+		if (i > 0)
+			ShadeRow(prev, out, i - 1, numRows, numCols, spatialStep);
+	}
+	ShadeRow(prev, out, numRows - 1, numRows, numCols, spatialStep);
+}
+
+void WaveShade(const float* heights, WaveSample* out, int numRows, int numCols, float spatialStep)
+{
+	for (int i = 0; i < numRows; ++i)
+		ShadeRow(heights, out, i, numRows, numCols, spatialStep);
+}
+
+void WaveNormalsAndTangents(const float* heights, float* normals, float* tangents,
+	int numRows, int numCols, float spatialStep)
+{
+	const float twoDx = 2.0f * spatialStep;
+	for (int i = 0; i < numRows; ++i)
+	{
+		const float* row = heights + i * numCols;
+		const float* up = heights + std::max(i - 1, 0) * numCols;
+		const float* down = heights + std::min(i + 1, numRows - 1) * numCols;
+		for (int j = 0; j < numCols; ++j)
+		{
+			float l = row[std::max(j - 1, 0)];
+			float r = row[std::min(j + 1, numCols - 1)];
+			float t = up[j];
+			float b = down[j];
+
+			float* n = normals + 3 * (i * numCols + j);
+			float nx = l - r, ny = twoDx, nz = b - t;
+			float invN = 1.0f / std::sqrt(nx * nx + ny * ny + nz * nz);
+			n[0] = nx * invN;
+			n[1] = ny * invN;
+			n[2] = nz * invN;
+
+			// Tangent follows +x (the u direction of the grid).
+			float* tu = tangents + 3 * (i * numCols + j);
+			float tx = twoDx, ty = r - l;
+			float invT = 1.0f / std::sqrt(tx * tx + ty * ty);
+			tu[0] = tx * invT;
+			tu[1] = ty * invT;
+			tu[2] = 0.0f;
+		}
+	}
+}
+
+CpuWaveSimulator::CpuWaveSimulator(int m, int n, float dx, float dt, float speed, float damping)
+	: WaveBackend(m, n, dx, dt, speed, damping)
+{
+	mPrevSln.assign(m * n, 0.0f);
+	mCurrSln.assign(m * n, 0.0f);
+
+	// Same initial impulse as the GPU simulator.
+	mPrevSln[m * n / 2] = 1.0f;
+	mCurrSln[m * n / 2] = 1.0f;
+}
+
+bool CpuWaveSimulator::Update(float dt, WaveSample* out)
+{
+	mShadeTarget = out;
+	bool stepped = WaveBackend::Update(dt);
+	mShadeTarget = nullptr;
+	return stepped;
+}
+
+void CpuWaveSimulator::Step()
+{
+	if (mShadeTarget)
+		WaveStepAndShade(mPrevSln.data(), mCurrSln.data(), mShadeTarget,
+			mNumRows, mNumCols, mK1, mK2, mK3, mSpatialStep);
+	else
+		WaveStep(mPrevSln.data(), mCurrSln.data(), mNumRows, mNumCols, mK1, mK2, mK3);
+
+	// prev now holds the next solution: prev -> curr -> next
+	std::swap(mPrevSln, mCurrSln);
+	++mVersion;
+}
+
+void CpuWaveSimulator::Shade(WaveSample* out) const
+{
+	WaveShade(mCurrSln.data(), out, mNumRows, mNumCols, mSpatialStep);
+}
+
+void CpuWaveSimulator::Disturb(int i, int j, float magnitude)
+{
+	// Don't disturb boundaries.
+	if (i <= 1 || i >= mNumRows - 2 || j <= 1 || j >= mNumCols - 2)
+		return;
+
+	float halfMag = 0.5f * magnitude;
+	float* c = mCurrSln.data();
+	c[i * mNumCols + j] += magnitude;
+	c[i * mNumCols + j + 1] += halfMag;
+	c[i * mNumCols + j - 1] += halfMag;
+	c[(i + 1) * mNumCols + j] += halfMag;
+	c[(i - 1) * mNumCols + j] += halfMag;
+	++mVersion;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+#include "WaveBackend.h"
+
+// Per-vertex data streamed to the GPU when the waves are simulated on the CPU.
+// Binds to input slot 1 next to the static grid vertices (see Lit.hlsl, HEIGHT_STREAM).
+struct WaveSample
+{
+    float Height;
+    float Normal[3];
+};
+
+// One finite-difference step: writes the next solution into prev in place.
+void WaveStep(float* prev, const float* curr, int numRows, int numCols, float k1, float k2, float k3);
+
+// Fused finite-difference step: writes the next solution into prev in place and
+// emits height + normal for every vertex into out. Every cell is read and written
+// exactly once, so out can point straight at write-combined upload memory.
+void WaveStepAndShade(float* prev, const float* curr, WaveSample* out,
+    int numRows, int numCols, float k1, float k2, float k3, float spatialStep);
+
+// Emits height + normal for an existing solution without advancing it.
+void WaveShade(const float* heights, WaveSample* out, int numRows, int numCols, float spatialStep);
+
+// Normals and tangents (along +x) for normal mapping / offline consumers.
+void WaveNormalsAndTangents(const float* heights, float* normals, float* tangents,
+    int numRows, int numCols, float spatialStep);
+
+class CpuWaveSimulator : public WaveBackend
+{
+public:
+    CpuWaveSimulator(int m, int n, float dx, float dt, float speed, float damping);
+    ~CpuWaveSimulator() override = default;
+
+    // Bumped every time the solution changes; lets callers skip re-streaming.
+    unsigned long long Version() const { return mVersion; }
+
+    const float* CurrentSolution() const { return mCurrSln.data(); }
+
+    using WaveBackend::Update;
+
+    // As Update(dt), but a step that is due runs fused with shading into out.
+    bool Update(float dt, WaveSample* out);
+    void Shade(WaveSample* out) const;
+    void Disturb(int i, int j, float magnitude) override;
+
+protected:
+    void Step() override;
+
+private:
+    // Where Step shades the next solution, or null to only step.
+    WaveSample* mShadeTarget = nullptr;
+
+    unsigned long long mVersion = 0;
+
+    std::vector<float> mPrevSln;
+    std::vector<float> mCurrSln;
+};
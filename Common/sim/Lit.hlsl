@@ -14,7 +14,7 @@
 #endif
 
 // Include structures and functions for lighting.
-#include "../Shaders/LightingUtil.hlsl"
+#include "../../Shaders/LightingUtil.hlsl"
 
 // Samplers
 SamplerState gsamLinearWrap        : register(s0);
@@ -73,6 +73,11 @@ struct VertexIn
 	float3 PosL    : POSITION;
 	float3 NormalL : NORMAL;
 	float2 TexC    : TEXCOORD;
+#ifdef HEIGHT_STREAM
+	// Streamed from the CPU simulator in input slot 1.
+	float  HeightL       : HEIGHT;
+	float3 StreamNormalL : NORMAL1;
+#endif
 };
 
 struct VertexOut
@@ -101,6 +106,12 @@ VertexOut VS(VertexIn vin)
 	vin.NormalL = normalize(float3(-r + l, 2.0f * gGridSpatialStep, b - t));
 #endif
 
+#ifdef HEIGHT_STREAM
+	// Heights and normals were produced in the same pass as the simulation step.
+	vin.PosL.y += vin.HeightL;
+	vin.NormalL = vin.StreamNormalL;
+#endif
+
 	// Transform to world space.
 	float4 posW = mul(float4(vin.PosL, 1.0f), gWorld);
 	vout.PosW = posW.xyz;
@@ -0,0 +1,26 @@
+#include "WaveBackend.h"
+
+WaveBackend::WaveBackend(int m, int n, float dx, float dt, float speed, float damping)
+{
+	mNumRows = m;
+	mNumCols = n;
+
+	mTimeStep = dt;
+	mSpatialStep = dx;
+
+	WaveCoefficients k = ComputeWaveCoefficients(dx, dt, speed, damping);
+	mK1 = k.K1;
+	mK2 = k.K2;
+	mK3 = k.K3;
+}
+
+bool WaveBackend::Update(float dt)
+{
+	mAccumulated += dt;
+	if (mAccumulated < mTimeStep)
+		return false;
+	mAccumulated -= mTimeStep;
+
+	Step();
+	return true;
+}
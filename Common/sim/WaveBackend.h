@@ -0,0 +1,50 @@
+#pragma once
+
+#include "WaveCoefficients.h"
+
+// What every wave simulator backend shares: the grid, the finite-difference
+// constants and a fixed time step. Update accumulates frame time and calls
+// Step once a simulation step is due, so the CPU and D3D12 backends advance
+// the same solution at the same rate and can be swapped behind this class.
+// Nothing here depends on Windows headers.
+class WaveBackend
+{
+public:
+    WaveBackend(const WaveBackend& rhs) = delete;
+    WaveBackend& operator=(const WaveBackend& rhs) = delete;
+    virtual ~WaveBackend() = default;
+
+    int RowCount() const { return mNumRows; }
+    int ColumnCount() const { return mNumCols; }
+    int VertexCount() const { return mNumRows * mNumCols; }
+    int TriangleCount() const { return (mNumRows - 1) * (mNumCols - 1) * 2; }
+    float Width() const { return mNumCols * mSpatialStep; }
+    float Depth() const { return mNumRows * mSpatialStep; }
+    float SpatialStep() const { return mSpatialStep; }
+    float TimeStep() const { return mTimeStep; }
+
+    // Advances the accumulated time by dt and steps if a step is due.
+    // Returns false when no step was taken.
+    bool Update(float dt);
+
+    // Raises the current solution around (i, j); boundaries are left alone.
+    virtual void Disturb(int i, int j, float magnitude) = 0;
+
+protected:
+    WaveBackend(int m, int n, float dx, float dt, float speed, float damping);
+
+    // Advances the solution by one time step: prev -> curr -> next.
+    virtual void Step() = 0;
+
+    int mNumRows = 0;
+    int mNumCols = 0;
+
+    // Simulation constants we can precompute.
+    float mK1 = 0.0f;
+    float mK2 = 0.0f;
+    float mK3 = 0.0f;
+
+    float mTimeStep = 0.0f;
+    float mSpatialStep = 0.0f;
+    float mAccumulated = 0.0f;
+};
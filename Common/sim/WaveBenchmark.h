@@ -0,0 +1,5 @@
+#pragma once
+
+// Headless measurement of per-frame heightfield production cost: the fused
+// step + shade kernel against a step followed by a separate vertex copy pass.
+void RunWaveBenchmark(int frameCount = 200);
@@ -0,0 +1,23 @@
+#pragma once
+
+// Precomputed constants of the damped wave equation finite-difference scheme,
+// shared by the CPU and D3D12 backends:
+//   next = K1 * prev + K2 * curr + K3 * (sum of the four neighbours of curr)
+struct WaveCoefficients
+{
+    float K1 = 0.0f;
+    float K2 = 0.0f;
+    float K3 = 0.0f;
+};
+
+inline WaveCoefficients ComputeWaveCoefficients(float dx, float dt, float speed, float damping)
+{
+    float d = damping * dt + 2.0f;
+    float e = (speed * speed) * (dt * dt) / (dx * dx);
+
+    WaveCoefficients k;
+    k.K1 = (damping * dt - 2.0f) / d;
+    k.K2 = (4.0f - 8.0f * e) / d;
+    k.K3 = (2.0f * e) / d;
+    return k;
+}
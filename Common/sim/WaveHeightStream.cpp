@@ -0,0 +1,31 @@
+#include "WaveHeightStream.h"
+
+WaveHeightStream::WaveHeightStream(ID3D12Device* device, CpuWaveSimulator* simulator, int bufferCount)
+{
+	mSimulator = simulator;
+
+	for (int i = 0; i < bufferCount; ++i)
+		mBuffers.push_back(std::make_unique<UploadBuffer<WaveSample>>(device, simulator->VertexCount(), false));
+
+	// Nothing has been written yet.
+	mBufferVersions.assign(bufferCount, ~0ull);
+}
+
+void WaveHeightStream::Update(float dt, int frameIndex)
+{
+	WaveSample* out = mBuffers[frameIndex]->MappedData();
+
+	if (!mSimulator->Update(dt, out) && mBufferVersions[frameIndex] != mSimulator->Version())
+		mSimulator->Shade(out);
+
+	mBufferVersions[frameIndex] = mSimulator->Version();
+}
+
+D3D12_VERTEX_BUFFER_VIEW WaveHeightStream::VertexBufferView(int frameIndex) const
+{
+	D3D12_VERTEX_BUFFER_VIEW vbv;
+	vbv.BufferLocation = mBuffers[frameIndex]->Resource()->GetGPUVirtualAddress();
+	vbv.StrideInBytes = sizeof(WaveSample);
+	vbv.SizeInBytes = sizeof(WaveSample) * mSimulator->VertexCount();
+	return vbv;
+}
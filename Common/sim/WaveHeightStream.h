@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Common/UploadBuffer.h"
+
+#include "CpuWaveSimulator.h"
+
+// Exposes the CPU wave solution as a second vertex stream. Every frame resource
+// owns one persistently mapped upload buffer and the simulator writes heights and
+// normals straight into it, so there is no staging copy and no extra pass.
+class WaveHeightStream
+{
+public:
+    WaveHeightStream(ID3D12Device* device, CpuWaveSimulator* simulator, int bufferCount);
+    WaveHeightStream(const WaveHeightStream& rhs) = delete;
+    WaveHeightStream& operator=(const WaveHeightStream& rhs) = delete;
+    ~WaveHeightStream() = default;
+
+    // The GPU must be done with frame resource frameIndex before calling this.
+    void Update(float dt, int frameIndex);
+
+    D3D12_VERTEX_BUFFER_VIEW VertexBufferView(int frameIndex) const;
+
+private:
+    CpuWaveSimulator* mSimulator = nullptr;
+
+    std::vector<std::unique_ptr<UploadBuffer<WaveSample>>> mBuffers;
+
+    // Solution version held by each buffer, so a frame without a simulation
+    // step only re-shades buffers that are actually stale.
+    std::vector<unsigned long long> mBufferVersions;
+};
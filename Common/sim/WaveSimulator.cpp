@@ -1,73 +1,65 @@
 #include "WaveSimulator.h"
 
 WaveSimulator::WaveSimulator(ID3D12Device* device, int m, int n, float dx, float dt, float speed, float damping)
+	: WaveBackend(m, n, dx, dt, speed, damping)
 {
-	mNumRows = m;
-	mNumCols = n;
-
-	mVertexCount = m * n;
-	mTriangleCount = (m - 1) * (n - 1) * 2;
-
-	mTimeStep = dt;
-	mSpatialStep = dx;
-
-	float d = damping * dt + 2.0f;
-	float e = (speed * speed) * (dt * dt) / (dx * dx);
-	mK1 = (damping * dt - 2.0f) / d;
-	mK2 = (4.0f - 8.0f * e) / d;
-	mK3 = (2.0f * e) / d;
-
 	md3dDevice = device;
 }
 
 void WaveSimulator::Update(const GameTimer& gt, ID3D12GraphicsCommandList* cmdList)
 {
-	static float t = 0.0f;
-
-	t += gt.DeltaTime();
+	mCmdList = cmdList;
+	Update(gt.DeltaTime());
+}
 
-	if (t >= mTimeStep)
-	{
-		t -= mTimeStep;
+void WaveSimulator::Step()
+{
+	ID3D12GraphicsCommandList* cmdList = mCmdList;
 
-		cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-			mCurrSln.Get(), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_UNORDERED_ACCESS
-		));
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
+		mCurrSln.Get(), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_UNORDERED_ACCESS
+	));
 
-		cmdList->SetComputeRootSignature(mRootSignature.Get());
+	cmdList->SetComputeRootSignature(mRootSignature.Get());
 
-		float constants[] = { mK1, mK2, mK3 };
-		cmdList->SetComputeRoot32BitConstants(0, 3, constants, 0);
-		cmdList->SetComputeRootDescriptorTable(1, mPrevSlnUavView);
-		cmdList->SetComputeRootDescriptorTable(2, mCurrSlnUavView);
-		cmdList->SetComputeRootDescriptorTable(3, mNextSlnUavView);
+	float constants[] = { mK1, mK2, mK3 };
+	cmdList->SetComputeRoot32BitConstants(0, 3, constants, 0);
+	cmdList->SetComputeRootDescriptorTable(1, mPrevSlnUavView);
+	cmdList->SetComputeRootDescriptorTable(2, mCurrSlnUavView);
+	cmdList->SetComputeRootDescriptorTable(3, mNextSlnUavView);
 
-		cmdList->SetPipelineState(mUpdatePSO.Get());
-		// TODO: ߽
-		cmdList->Dispatch(mNumRows / 16, mNumCols / 16, 1);
+	cmdList->SetPipelineState(mUpdatePSO.Get());
+	// TODO: ߽
+	cmdList->Dispatch(mNumRows / 16, mNumCols / 16, 1);
 
-		// prev -> curr -> next
-    mNextSln.Swap(mPrevSln);
-    mCurrSln.Swap(mPrevSln);
+	// prev -> curr -> next
+	mNextSln.Swap(mPrevSln);
+	mCurrSln.Swap(mPrevSln);
 
-		auto tempSrvView = mPrevSlnSrvView;
-		mPrevSlnSrvView = mCurrSlnSrvView;
-		mCurrSlnSrvView = mNextSlnSrvView;
-		mNextSlnSrvView = tempSrvView;
+	auto tempSrvView = mPrevSlnSrvView;
+	mPrevSlnSrvView = mCurrSlnSrvView;
+	mCurrSlnSrvView = mNextSlnSrvView;
+	mNextSlnSrvView = tempSrvView;
 
-		auto tempUavView = mPrevSlnUavView;
-		mPrevSlnUavView = mCurrSlnUavView;
-		mCurrSlnUavView = mNextSlnUavView;
-		mNextSlnUavView = tempUavView;
+	auto tempUavView = mPrevSlnUavView;
+	mPrevSlnUavView = mCurrSlnUavView;
+	mCurrSlnUavView = mNextSlnUavView;
+	mNextSlnUavView = tempUavView;
 
-		cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-			mCurrSln.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_GENERIC_READ
-		));
-	}
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
+		mCurrSln.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_GENERIC_READ
+	));
 }
 
 void WaveSimulator::Disturb(ID3D12GraphicsCommandList* cmdList, int i, int j, float magnitude)
 {
+	mCmdList = cmdList;
+	Disturb(i, j, magnitude);
+}
+
+void WaveSimulator::Disturb(int i, int j, float magnitude)
+{
+	ID3D12GraphicsCommandList* cmdList = mCmdList;
 	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
 		mCurrSln.Get(), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_UNORDERED_ACCESS
 	));
@@ -259,8 +251,8 @@ void WaveSimulator::BuildRootSignature()
 
 void WaveSimulator::BuildPSOs()
 {
-	mUpdateCS = d3dUtil::CompileShader(L"WaveSimulator.hlsl", nullptr, "UpdateCS", "cs_5_0");
-	mDisturbCS = d3dUtil::CompileShader(L"WaveSimulator.hlsl", nullptr, "DisturbCS", "cs_5_0");
+	mUpdateCS = d3dUtil::CompileShader(L"../Common/sim/WaveSimulator.hlsl", nullptr, "UpdateCS", "cs_5_0");
+	mDisturbCS = d3dUtil::CompileShader(L"../Common/sim/WaveSimulator.hlsl", nullptr, "DisturbCS", "cs_5_0");
 
 	D3D12_COMPUTE_PIPELINE_STATE_DESC updatePsoDesc = {};
 	updatePsoDesc.CS = {
@@ -3,26 +3,26 @@
 #include "Common/d3dUtil.h"
 #include "Common/GameTimer.h"
 
-class WaveSimulator
+#include "WaveBackend.h"
+
+// D3D12 backend: the solutions live in R32_FLOAT textures and every step or
+// disturbance is a compute dispatch recorded into the command list last given
+// to SetCommandList (or to the Update and Disturb overloads that take one).
+class WaveSimulator : public WaveBackend
 {
 public:
     WaveSimulator(ID3D12Device* device, int m, int n, float dx, float dt, float speed, float damping);
-    WaveSimulator(const WaveSimulator& rhs) = delete;
-    WaveSimulator& operator=(const WaveSimulator& rhs) = delete;
-    ~WaveSimulator() = default;
-
-    int RowCount() const { return mNumRows; }
-    int ColumnCount() const { return mNumCols; }
-    int VertexCount() const { return mVertexCount; }
-    int TriangleCount() const { return mTriangleCount; }
-    float Width() const { return mNumCols * mSpatialStep; }
-    float Depth() const { return mNumRows * mSpatialStep; }
-    float SpatialStep() const { return mSpatialStep; }
+    ~WaveSimulator() override = default;
 
     static const UINT DescriptorCount() { return 6; }
 
+    void SetCommandList(ID3D12GraphicsCommandList* cmdList) { mCmdList = cmdList; }
+
+    using WaveBackend::Update;
+
     void Update(const GameTimer& gt, ID3D12GraphicsCommandList* cmdList);
     void Disturb(ID3D12GraphicsCommandList* cmdList, int i, int j, float magnitude);
+    void Disturb(int i, int j, float magnitude) override;
     CD3DX12_GPU_DESCRIPTOR_HANDLE DispatchmentMap();
 
     void Initialze(ID3D12GraphicsCommandList* cmdList, CD3DX12_CPU_DESCRIPTOR_HANDLE& cpuHandle, CD3DX12_GPU_DESCRIPTOR_HANDLE& gpuHandle, UINT descriptorSize);
@@ -31,22 +31,11 @@ private:
     void BuildDescriptors(CD3DX12_CPU_DESCRIPTOR_HANDLE& cpuHandle, CD3DX12_GPU_DESCRIPTOR_HANDLE& gpuHandle, UINT descriptorSize);
     void BuildRootSignature();
     void BuildPSOs();
+protected:
+    void Step() override;
 private:
-    int mNumRows = 0;
-    int mNumCols = 0;
-
-    int mVertexCount = 0;
-    int mTriangleCount = 0;
-
-    // Simulation constants we can precompute.
-    float mK1 = 0.0f;
-    float mK2 = 0.0f;
-    float mK3 = 0.0f;
-
-    float mTimeStep = 0.0f;
-    float mSpatialStep = 0.0f;
-
     ID3D12Device* md3dDevice = nullptr;
+    ID3D12GraphicsCommandList* mCmdList = nullptr;
 
     Microsoft::WRL::ComPtr<ID3D12RootSignature> mRootSignature;
     Microsoft::WRL::ComPtr<ID3D12PipelineState> mUpdatePSO;
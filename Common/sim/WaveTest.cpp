@@ -0,0 +1,183 @@
+// Checks the CPU wave backend against reference values: the coefficients of
+// the sample's constants, the first step of the initial impulse worked out by
+// hand, and many steps of a plain double-precision stencil with disturbances.
+// Exits non-zero if any check fails.
+
+#include "CpuWaveSimulator.h"
+
+#include <cmath>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	// The sample's constants: dx = 1, dt = 0.03, speed = 4, damping = 0.2.
+	const float kDx = 1.0f, kDt = 0.03f, kSpeed = 4.0f, kDamping = 0.2f;
+
+	// ComputeWaveCoefficients of the constants above, worked out in double.
+	const double kK1 = -0.9940179461615155;
+	const double kK2 = 1.9365902293120638;
+	const double kK3 = 0.014356929212362913;
+
+	int gFailures = 0;
+
+	void Expect(bool ok, const char* what, double got, double want)
+	{
+		if (ok)
+			return;
+		printf("FAIL %s: got %.9g, want %.9g\n", what, got, want);
+		++gFailures;
+	}
+
+	void ExpectNear(const char* what, double got, double want, double tolerance)
+	{
+		Expect(std::fabs(got - want) <= tolerance, what, got, want);
+	}
+
+	// The damped wave step as written in WaveSimulator.hlsl, boundary fixed at
+	// zero, in double.
+	struct Reference
+	{
+		Reference(int m, int n) : Rows(m), Cols(n), Prev(m * n, 0.0), Curr(m * n, 0.0)
+		{
+			Prev[m * n / 2] = 1.0;
+			Curr[m * n / 2] = 1.0;
+		}
+
+		void Step()
+		{
+			std::vector<double> next(Rows * Cols, 0.0);
+			for (int i = 1; i < Rows - 1; ++i)
+			{
+				for (int j = 1; j < Cols - 1; ++j)
+				{
+					int idx = i * Cols + j;
+					next[idx] = kK1 * Prev[idx] + kK2 * Curr[idx] +
+						kK3 * (Curr[idx + Cols] + Curr[idx - Cols] + Curr[idx + 1] + Curr[idx - 1]);
+				}
+			}
+			Prev = std::move(Curr);
+			Curr = std::move(next);
+		}
+
+		void Disturb(int i, int j, double magnitude)
+		{
+			Curr[i * Cols + j] += magnitude;
+			Curr[i * Cols + j + 1] += 0.5 * magnitude;
+			Curr[i * Cols + j - 1] += 0.5 * magnitude;
+			Curr[(i + 1) * Cols + j] += 0.5 * magnitude;
+			Curr[(i - 1) * Cols + j] += 0.5 * magnitude;
+		}
+
+		int Rows;
+		int Cols;
+		std::vector<double> Prev;
+		std::vector<double> Curr;
+	};
+
+	void TestCoefficients()
+	{
+		WaveCoefficients k = ComputeWaveCoefficients(kDx, kDt, kSpeed, kDamping);
+		ExpectNear("K1", k.K1, kK1, 1e-6);
+		ExpectNear("K2", k.K2, kK2, 1e-6);
+		ExpectNear("K3", k.K3, kK3, 1e-6);
+	}
+
+	void TestFirstStep()
+	{
+		// Odd, so the initial impulse at m * n / 2 is not on the boundary.
+		const int n = 15;
+		CpuWaveSimulator waves(n, n, kDx, kDt, kSpeed, kDamping);
+		const int c = n * n / 2;
+
+		// Less than a time step does nothing.
+		Expect(!waves.Update(0.5f * kDt), "early step", 1.0, 0.0);
+		Expect(waves.Version() == 0, "version before the first step", (double)waves.Version(), 0.0);
+		Expect(waves.Update(0.5f * kDt), "first step", 0.0, 1.0);
+
+		const float* h = waves.CurrentSolution();
+		ExpectNear("centre", h[c], kK1 + kK2, 1e-6);
+		ExpectNear("left", h[c - 1], kK3, 1e-6);
+		ExpectNear("right", h[c + 1], kK3, 1e-6);
+		ExpectNear("up", h[c - n], kK3, 1e-6);
+		ExpectNear("down", h[c + n], kK3, 1e-6);
+		ExpectNear("diagonal", h[c - n - 1], 0.0, 0.0);
+		ExpectNear("corner", h[0], 0.0, 0.0);
+	}
+
+	void TestAgainstReference()
+	{
+		const int m = 33, n = 47, steps = 200;
+		CpuWaveSimulator waves(m, n, kDx, kDt, kSpeed, kDamping);
+		Reference reference(m, n);
+		std::vector<WaveSample> samples(m * n);
+
+		for (int s = 0; s < steps; ++s)
+		{
+			if (s % 25 == 0)
+			{
+				int i = 3 + s % (m - 6), j = 3 + (7 * s) % (n - 6);
+				waves.Disturb(i, j, 0.75f);
+				reference.Disturb(i, j, 0.75);
+			}
+			// Alternate the plain and the fused step; both must match.
+			bool stepped = s % 2 ? waves.Update(kDt, samples.data()) : waves.Update(kDt);
+			Expect(stepped, "step", 0.0, 1.0);
+			reference.Step();
+		}
+
+		const float* h = waves.CurrentSolution();
+		double worst = 0.0;
+		for (int i = 0; i < m * n; ++i)
+			worst = std::fmax(worst, std::fabs(h[i] - reference.Curr[i]));
+		ExpectNear("largest difference from the reference", worst, 0.0, 1e-4);
+
+		// The last step was fused, so the samples are of the current solution.
+		for (int i = 0; i < m * n; ++i)
+		{
+			if (samples[i].Height != h[i])
+			{
+				Expect(false, "fused height", samples[i].Height, h[i]);
+				break;
+			}
+		}
+
+		// Boundaries never move and disturbing them is ignored.
+		waves.Disturb(0, n / 2, 1.0f);
+		waves.Disturb(m / 2, n - 1, 1.0f);
+		for (int j = 0; j < n; ++j)
+			ExpectNear("top boundary", h[j], 0.0, 0.0);
+		for (int i = 0; i < m; ++i)
+			ExpectNear("right boundary", h[i * n + n - 1], 0.0, 0.0);
+	}
+
+	void TestFlatNormals()
+	{
+		const int n = 8;
+		std::vector<float> flat(n * n, 0.25f);
+		std::vector<WaveSample> samples(n * n);
+		WaveShade(flat.data(), samples.data(), n, n, kDx);
+		for (const WaveSample& s : samples)
+		{
+			ExpectNear("flat height", s.Height, 0.25, 0.0);
+			ExpectNear("flat normal y", s.Normal[1], 1.0, 1e-6);
+		}
+	}
+}
+
+int main()
+{
+	TestCoefficients();
+	TestFirstStep();
+	TestAgainstReference();
+	TestFlatNormals();
+
+	if (gFailures)
+	{
+		printf("%d failures\n", gFailures);
+		return 1;
+	}
+	printf("all wave tests passed\n");
+	return 0;
+}
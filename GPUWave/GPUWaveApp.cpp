@@ -4,8 +4,8 @@
 
 const int gNumFrameResources = 3;
 
-GPUWaveApp::GPUWaveApp(HINSTANCE hInstance)
-	:D3DApp(hInstance)
+GPUWaveApp::GPUWaveApp(HINSTANCE hInstance, bool useCpuWaves)
+	:D3DApp(hInstance), mUseCpuWaves(useCpuWaves)
 {
 }
 
@@ -24,7 +24,18 @@ bool GPUWaveApp::Initialize()
 	ThrowIfFailed(mCommandList->Reset(mDirectCmdListAlloc.Get(), nullptr));
 
 
-	mWaveSimulator = std::make_unique<WaveSimulator>(md3dDevice.Get(), 128, 128, 1.0f, 0.03f, 4.0f, 0.2f);
+	if (mUseCpuWaves)
+	{
+		mCpuWaveSimulator = std::make_unique<CpuWaveSimulator>(128, 128, 1.0f, 0.03f, 4.0f, 0.2f);
+		mWaveStream = std::make_unique<WaveHeightStream>(md3dDevice.Get(), mCpuWaveSimulator.get(), gNumFrameResources);
+		mWaves = mCpuWaveSimulator.get();
+	}
+	else
+	{
+		mWaveSimulator = std::make_unique<WaveSimulator>(md3dDevice.Get(), 128, 128, 1.0f, 0.03f, 4.0f, 0.2f);
+		mWaveSimulator->SetCommandList(mCommandList.Get());
+		mWaves = mWaveSimulator.get();
+	}
 
 	LoadTextures();
 	BulidDescriptorHeap();
@@ -33,11 +44,14 @@ bool GPUWaveApp::Initialize()
 	CD3DX12_GPU_DESCRIPTOR_HANDLE gpuHandle(mCbvSrvUavDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
 	BuildDescriptors(cpuHandle, gpuHandle, mCbvSrvUavDescriptorSize);
 
-	mWaveSimulator->Initialze(
-		mCommandList.Get(),
-		cpuHandle, gpuHandle,
-		mCbvSrvUavDescriptorSize
-	);
+	if (!mUseCpuWaves)
+	{
+		mWaveSimulator->Initialze(
+			mCommandList.Get(),
+			cpuHandle, gpuHandle,
+			mCbvSrvUavDescriptorSize
+		);
+	}
 
 	BuildRootSignature();
 	BuildShadersAndInputLayout();
@@ -121,7 +135,6 @@ void GPUWaveApp::Draw(const GameTimer& gt)
 	// ָҪȾĿ껺
 	mCommandList->OMSetRenderTargets(1, &CurrentBackBufferView(), true, &DepthStencilView());
 
-	auto waveView = mWaveSimulator->DispatchmentMap();
 	ID3D12DescriptorHeap* descriptorHeaps[] = { mCbvSrvUavDescriptorHeap.Get() };
 	mCommandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
 
@@ -141,8 +154,16 @@ void GPUWaveApp::Draw(const GameTimer& gt)
 	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Transparent]);
 
 	UpdateWaves(gt);
-	mCommandList->SetPipelineState(mPSOs["waves"].Get());
-	mCommandList->SetGraphicsRootDescriptorTable(4, waveView);
+	if (mUseCpuWaves)
+	{
+		mCommandList->SetPipelineState(mPSOs["wavesStream"].Get());
+		mCommandList->IASetVertexBuffers(1, 1, &mWaveStream->VertexBufferView(mCurrFrameResourceIndex));
+	}
+	else
+	{
+		mCommandList->SetPipelineState(mPSOs["waves"].Get());
+		mCommandList->SetGraphicsRootDescriptorTable(4, mWaveSimulator->DispatchmentMap());
+	}
 	DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Waves]);
 
 	// ȾĿ״̬ת״̬
@@ -317,15 +338,18 @@ void GPUWaveApp::UpdateWaves(const GameTimer& gt)
 	{
 		t_base += 0.5f;
 
-		int i = MathHelper::Rand(4, mWaveSimulator->RowCount() - 5);
-		int j = MathHelper::Rand(4, mWaveSimulator->ColumnCount() - 5);
+		int i = MathHelper::Rand(4, mWaves->RowCount() - 5);
+		int j = MathHelper::Rand(4, mWaves->ColumnCount() - 5);
 
 		float r = MathHelper::RandF(0.5f, 1.0f);
 
-		mWaveSimulator->Disturb(mCommandList.Get(), i, j, r);
+		mWaves->Disturb(i, j, r);
 	}
 	// Update the wave simulation.
-	mWaveSimulator->Update(gt, mCommandList.Get());
+	if (mUseCpuWaves)
+		mWaveStream->Update(gt.DeltaTime(), mCurrFrameResourceIndex);
+	else
+		mWaves->Update(gt.DeltaTime());
 }
 
 void GPUWaveApp::AnimateMaterials(const GameTimer& gt)
@@ -389,7 +413,9 @@ void GPUWaveApp::BulidDescriptorHeap()
 	// Create the descriptor heap.
 	//
 	D3D12_DESCRIPTOR_HEAP_DESC cbvsrvuavHeapDesc = {};
-	cbvsrvuavHeapDesc.NumDescriptors = 3 +  mWaveSimulator->DescriptorCount();
+	// The CPU backend streams heights in a vertex buffer and needs no
+	// descriptors of its own.
+	cbvsrvuavHeapDesc.NumDescriptors = 3 + (mUseCpuWaves ? 0 : WaveSimulator::DescriptorCount());
 	cbvsrvuavHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
 	cbvsrvuavHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 	ThrowIfFailed(md3dDevice->CreateDescriptorHeap(&cbvsrvuavHeapDesc, IID_PPV_ARGS(&mCbvSrvUavDescriptorHeap)));
@@ -443,17 +469,27 @@ void GPUWaveApp::BuildShadersAndInputLayout()
 		"DISPLACEMENT_MAP", "1",
 		NULL, NULL
 	};
+	D3D_SHADER_MACRO heightStreamDefines[] = {
+		"HEIGHT_STREAM", "1",
+		NULL, NULL
+	};
 
-	mShaders["LitVS"] = d3dUtil::CompileShader(L"Lit.hlsl", nullptr, "VS", "vs_5_0");
-	mShaders["DispMapLitVS"] = d3dUtil::CompileShader(L"Lit.hlsl", displacementMapDefines, "VS", "vs_5_0");
-	mShaders["LitPS"] = d3dUtil::CompileShader(L"Lit.hlsl", defines, "PS", "ps_5_0");
-	mShaders["AlphaLitPS"] = d3dUtil::CompileShader(L"Lit.hlsl", alphaTestDefines, "PS", "ps_5_0");
+	mShaders["LitVS"] = d3dUtil::CompileShader(L"../Common/sim/Lit.hlsl", nullptr, "VS", "vs_5_0");
+	mShaders["DispMapLitVS"] = d3dUtil::CompileShader(L"../Common/sim/Lit.hlsl", displacementMapDefines, "VS", "vs_5_0");
+	mShaders["StreamLitVS"] = d3dUtil::CompileShader(L"../Common/sim/Lit.hlsl", heightStreamDefines, "VS", "vs_5_0");
+	mShaders["LitPS"] = d3dUtil::CompileShader(L"../Common/sim/Lit.hlsl", defines, "PS", "ps_5_0");
+	mShaders["AlphaLitPS"] = d3dUtil::CompileShader(L"../Common/sim/Lit.hlsl", alphaTestDefines, "PS", "ps_5_0");
 
 	mInputLayout = {
 		{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
 		{"NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, Normal), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
 		{"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(Vertex, TexC), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0}
 	};
+
+	// The static grid in slot 0 plus the CPU-produced heights and normals in slot 1.
+	mStreamInputLayout = mInputLayout;
+	mStreamInputLayout.push_back({"HEIGHT", 0, DXGI_FORMAT_R32_FLOAT, 1, offsetof(WaveSample, Height), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0});
+	mStreamInputLayout.push_back({"NORMAL", 1, DXGI_FORMAT_R32G32B32_FLOAT, 1, offsetof(WaveSample, Normal), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0});
 }
 
 void GPUWaveApp::BuildRootSignature()
@@ -577,6 +613,14 @@ void GPUWaveApp::BuildPSOs()
 	};
 	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&wavePsoDesc, IID_PPV_ARGS(&mPSOs["waves"])));
 
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC waveStreamPsoDesc = wavePsoDesc;
+	waveStreamPsoDesc.InputLayout = { mStreamInputLayout.data(), (UINT)mStreamInputLayout.size() };
+	waveStreamPsoDesc.VS = {
+		reinterpret_cast<BYTE*>(mShaders["StreamLitVS"]->GetBufferPointer()),
+		mShaders["StreamLitVS"]->GetBufferSize()
+	};
+	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&waveStreamPsoDesc, IID_PPV_ARGS(&mPSOs["wavesStream"])));
+
 	//
 	// AlphaԵPSO
 	//
@@ -702,7 +746,7 @@ void GPUWaveApp::BuildLandGeometry()
 void GPUWaveApp::BuildWavesGeometry()
 {
 	GeometryGenerator geoGen;
-	GeometryGenerator::MeshData grid = geoGen.CreateGrid(160.0f, 160.0f, mWaveSimulator->RowCount(), mWaveSimulator->ColumnCount());
+	GeometryGenerator::MeshData grid = geoGen.CreateGrid(160.0f, 160.0f, mWaves->RowCount(), mWaves->ColumnCount());
 
 	std::vector<Vertex> vertices(grid.Vertices.size());
 	for (size_t i = 0; i < grid.Vertices.size(); ++i)
@@ -714,7 +758,7 @@ void GPUWaveApp::BuildWavesGeometry()
 
 	std::vector<std::uint32_t> indices = grid.Indices32;
 
-	UINT vbByteSize = mWaveSimulator->VertexCount() * sizeof(Vertex);
+	UINT vbByteSize = mWaves->VertexCount() * sizeof(Vertex);
 	UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint32_t);
 
 	auto geo = std::make_unique<MeshGeometry>();
@@ -801,9 +845,9 @@ void GPUWaveApp::BuildRenderItems()
 	wavesRitem->StartIndexLocation = wavesRitem->Geo->DrawArgs["grid"].StartIndexLocation;
 	wavesRitem->BaseVertexLocation = wavesRitem->Geo->DrawArgs["grid"].BaseVertexLocation;
 	wavesRitem->Mat = mMaterials["water"].get();
-	wavesRitem->DisplacementMapTexelSize.x = 1.0f / mWaveSimulator->ColumnCount();
-	wavesRitem->DisplacementMapTexelSize.y = 1.0f / mWaveSimulator->RowCount();
-	wavesRitem->GridSpatialStep = mWaveSimulator->SpatialStep();
+	wavesRitem->DisplacementMapTexelSize.x = 1.0f / mWaves->ColumnCount();
+	wavesRitem->DisplacementMapTexelSize.y = 1.0f / mWaves->RowCount();
+	wavesRitem->GridSpatialStep = mWaves->SpatialStep();
 	mRitemLayer[(int)RenderLayer::Waves].push_back(wavesRitem.get());
 
 	auto gridRitem = std::make_unique<RenderItem>();
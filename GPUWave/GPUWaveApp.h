@@ -2,9 +2,10 @@
 
 #include "Common/d3dApp.h"
 
-#include "FrameResource.h"
+#include "Common/sim/FrameResource.h"
 
-#include "WaveSimulator.h"
+#include "Common/sim/WaveSimulator.h"
+#include "Common/sim/WaveHeightStream.h"
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
@@ -29,7 +30,7 @@ enum class RenderLayer : int
 class GPUWaveApp : public D3DApp
 {
 public:
-	GPUWaveApp(HINSTANCE hInstance);
+	GPUWaveApp(HINSTANCE hInstance, bool useCpuWaves = false);
 	GPUWaveApp(const GPUWaveApp& rhs) = delete;
 	GPUWaveApp& operator=(const GPUWaveApp& rhs) = delete;
 	~GPUWaveApp();
@@ -90,12 +91,22 @@ private:
 	std::unordered_map<std::string, ComPtr<ID3D12PipelineState>> mPSOs;
 
 	std::vector<D3D12_INPUT_ELEMENT_DESC> mInputLayout;
+	std::vector<D3D12_INPUT_ELEMENT_DESC> mStreamInputLayout;
 
 	// List of all the render items.
 	std::vector<std::unique_ptr<RenderItem>> mAllRitems;
 
 	std::unique_ptr<WaveSimulator> mWaveSimulator;
 
+	// CPU simulation path: heights and normals are streamed as vertex data
+	// instead of being sampled from the displacement map.
+	bool mUseCpuWaves = false;
+	std::unique_ptr<CpuWaveSimulator> mCpuWaveSimulator;
+	std::unique_ptr<WaveHeightStream> mWaveStream;
+
+	// The backend that simulates the waves: mCpuWaveSimulator or mWaveSimulator.
+	WaveBackend* mWaves = nullptr;
+
 	// Render items divided by PSO.
 	std::vector<RenderItem*> mRitemLayer[(UINT)RenderLayer::Count];
 
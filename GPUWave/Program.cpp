@@ -3,6 +3,7 @@
 #include <windows.h>
 
 #include "GPUWaveApp.h"
+#include "Common/sim/WaveBenchmark.h"
 
 // Entry Point
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance, PSTR cmdLine, int showCmd)
@@ -12,9 +13,22 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance, PSTR cmdLine, in
     _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
 
+    // -bench: print the CPU heightfield production benchmark to a console and exit.
+    if (strstr(cmdLine, "-bench") != nullptr)
+    {
+        if (!AttachConsole(ATTACH_PARENT_PROCESS))
+            AllocConsole();
+        FILE* stream = nullptr;
+        freopen_s(&stream, "CONOUT$", "w", stdout);
+
+        RunWaveBenchmark();
+        return 0;
+    }
+
     try
     {
-        GPUWaveApp theApp(hInstance);
+        // -cpuwaves: simulate on the CPU and stream heights as vertex data.
+        GPUWaveApp theApp(hInstance, strstr(cmdLine, "-cpuwaves") != nullptr);
         if (!theApp.Initialize())
             return 0;
 
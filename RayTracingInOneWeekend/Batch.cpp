@@ -0,0 +1,144 @@
+#include "Batch.h"
+#include "ImageOutput.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+std::vector<CameraParams> TurntableCameras(const CameraParams &params,
+                                           uint32_t count) {
+  std::vector<CameraParams> cameras(count, params);
+  float dx = params.lookfrom.x - params.lookat.x;
+  float dz = params.lookfrom.z - params.lookat.z;
+  for (uint32_t i = 0; i < count; i++) {
+    float angle = 2.f * 3.14159265f * float(i) / float(count);
+    float c = std::cos(angle), s = std::sin(angle);
+    cameras[i].lookfrom.x = params.lookat.x + c * dx - s * dz;
+    cameras[i].lookfrom.z = params.lookat.z + s * dx + c * dz;
+  }
+  return cameras;
+}
+
+std::string NumberedPath(const std::string &path, uint32_t index) {
+  size_t dot = path.rfind('.');
+  size_t slash = path.find_last_of("/\\");
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    dot = path.size();
+  char number[16];
+  snprintf(number, sizeof(number), "_%04u", index);
+  return path.substr(0, dot) + number + path.substr(dot);
+}
+
+BatchStats RenderBatch(const CpuTracer &tracer,
+                       const std::vector<BatchView> &views, int threadCount,
+                       std::vector<std::vector<XMFLOAT3>> *images) {
+  if (threadCount <= 0)
+    threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+  const RenderSettings &settings = tracer.Settings();
+  int numViews = (int)std::max<size_t>(1, views.size());
+  int perView = std::max(1, threadCount / numViews);
+  int workers = std::min(numViews, threadCount / perView);
+  if (images)
+    images->resize(views.size());
+
+  std::atomic<size_t> next{0};
+  std::atomic<uint64_t> samples{0};
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  auto worker = [&]() {
+    try {
+      ImageOutput output(settings.tonemap);
+      std::vector<XMFLOAT3> pixels;
+      for (size_t v = next++; v < views.size(); v = next++) {
+        std::vector<XMFLOAT3> &image = images ? (*images)[v] : pixels;
+        samples += tracer.Render(perView, views[v].camera, image).samples;
+        if (!views[v].output_path.empty()) {
+          output.Write(views[v].output_path, image, settings.image_width,
+                       settings.image_height);
+        }
+      }
+      output.Wait();
+    } catch (...) {
+      // Stop the others at their next view and rethrow on this thread.
+      next = views.size();
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error)
+        error = std::current_exception();
+    }
+  };
+
+  auto start = std::chrono::high_resolution_clock::now();
+  std::vector<std::thread> threads;
+  for (int w = 1; w < workers; w++)
+    threads.emplace_back(worker);
+  worker();
+  for (auto &t : threads)
+    t.join();
+  auto stop = std::chrono::high_resolution_clock::now();
+  if (error)
+    std::rethrow_exception(error);
+
+  BatchStats stats;
+  stats.seconds = std::chrono::duration<double>(stop - start).count();
+  stats.samples = samples;
+  stats.workers = workers;
+  stats.threads_per_view = perView;
+  return stats;
+}
+
+void RunBatchBenchmark(const RenderSettings &settings, int threadCount) {
+  // Small views, as for a dataset; the scene is the full cover scene.
+  RenderSettings s = settings;
+  s.image_width = 128;
+  s.image_height = 96;
+  s.num_samples = 4;
+  s.adaptive_threshold = 0.f;
+  CameraParams params;
+  SceneObjects objects;
+  BuildCoverScene(s, params, objects);
+  CameraCB camera;
+  BuildCamera(s, params, camera);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  CpuTracer tracer(s, camera, objects);
+  auto stop = std::chrono::high_resolution_clock::now();
+  printf("%ux%u, %u spp, depth %u, %zu spheres, BVH built once in %.1f ms\n",
+         s.image_width, s.image_height, s.num_samples, s.max_depth,
+         objects.spheres.size(),
+         std::chrono::duration<double, std::milli>(stop - start).count());
+  printf("    views   one at a time   batched   workers x threads\n");
+
+  for (uint32_t count : {1u, 10u, 100u, 1000u}) {
+    std::vector<BatchView> views(count);
+    std::vector<CameraParams> cameras = TurntableCameras(params, count);
+    for (uint32_t i = 0; i < count; i++) {
+      BuildCamera(s, cameras[i], views[i].camera);
+      views[i].output_path = NumberedPath("batch_bench.png", i);
+    }
+
+    // Every view in turn over all threads, written out before the next.
+    start = std::chrono::high_resolution_clock::now();
+    {
+      ImageOutput output(s.tonemap);
+      std::vector<XMFLOAT3> pixels;
+      for (const BatchView &view : views) {
+        tracer.Render(threadCount, view.camera, pixels);
+        output.Write(view.output_path, pixels, s.image_width, s.image_height);
+        output.Wait();
+      }
+    }
+    stop = std::chrono::high_resolution_clock::now();
+    double serial = std::chrono::duration<double>(stop - start).count();
+
+    BatchStats batch = RenderBatch(tracer, views, threadCount);
+    for (const BatchView &view : views)
+      remove(view.output_path.c_str());
+    printf("  %7u %11.0f/min %9.0f/min %9d x %d\n", count,
+           60.0 * count / serial, 60.0 * count / batch.seconds, batch.workers,
+           batch.threads_per_view);
+  }
+}
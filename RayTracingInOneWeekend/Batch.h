@@ -0,0 +1,45 @@
+#pragma once
+#include "CpuTracer.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Many views of one scene: turntables and dataset generation.
+
+struct BatchView {
+  CameraCB camera;
+  // Written when the view is done; empty keeps the image in memory only.
+  std::string output_path;
+};
+
+struct BatchStats {
+  double seconds = 0.0;
+  uint64_t samples = 0;
+  // Views rendered at once, and the threads each of them gets.
+  int workers = 0;
+  int threads_per_view = 0;
+};
+
+// count cameras evenly spaced on a circle around params.lookat, at the
+// height and distance of params.lookfrom above and around the y axis.
+std::vector<CameraParams> TurntableCameras(const CameraParams &params,
+                                           uint32_t count);
+
+// path with the index before its extension: image.png, 7 -> image_0007.png.
+std::string NumberedPath(const std::string &path, uint32_t index);
+
+// Renders every view with the scene, BVH and settings of tracer, which are
+// built once and only read. With at least as many views as threads, each
+// worker takes whole views off a shared counter and renders them on its own,
+// so no tile is ever handed between cores. With fewer views the threads are
+// split evenly between them and each view runs the tile scheduler on its
+// share. Every worker writes through its own ImageOutput, so a PNG is encoded
+// while the worker goes on to the next view. images, if given, receives the
+// pixels of every view.
+BatchStats RenderBatch(const CpuTracer &tracer,
+                       const std::vector<BatchView> &views, int threadCount,
+                       std::vector<std::vector<XMFLOAT3>> *images = nullptr);
+
+// Images per minute for turntables of 1 to 1000 views, rendered one view at
+// a time over all threads and through RenderBatch, with PNG output.
+void RunBatchBenchmark(const RenderSettings &settings, int threadCount = 0);
@@ -0,0 +1,181 @@
+#include "Bvh.h"
+#include <algorithm>
+#include <cfloat>
+
+#define BVH_NUM_BINS 16
+
+namespace {
+
+struct Aabb {
+  float min[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+  float max[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+  void Grow(const float lo[3], const float hi[3]) {
+    for (int k = 0; k < 3; k++) {
+      min[k] = std::min(min[k], lo[k]);
+      max[k] = std::max(max[k], hi[k]);
+    }
+  }
+  void Grow(const Aabb &b) { Grow(b.min, b.max); }
+  float HalfArea() const {
+    if (min[0] > max[0])
+      return 0.f;
+    float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+    return dx * dy + dy * dz + dz * dx;
+  }
+};
+
+struct Prim {
+  Aabb box;
+  float centroid[3];
+};
+
+struct Bin {
+  Aabb box;
+  uint32_t count = 0;
+};
+
+struct BuildTask {
+  uint32_t node;
+  uint32_t first;
+  uint32_t count;
+  uint32_t depth;
+};
+
+} // namespace
+
+std::vector<BvhNode> BuildBvh(SceneObjects &objects, uint32_t max_leaf_size) {
+  const uint32_t num = (uint32_t)objects.spheres.size();
+  std::vector<Prim> prims(num);
+  std::vector<uint32_t> order(num);
+  for (uint32_t i = 0; i < num; i++) {
+    const Sphere &s = objects.spheres[i];
+    float c[3] = {s.center.x, s.center.y, s.center.z};
+    for (int k = 0; k < 3; k++) {
+      prims[i].box.min[k] = c[k] - s.radius;
+      prims[i].box.max[k] = c[k] + s.radius;
+      prims[i].centroid[k] = c[k];
+    }
+    order[i] = i;
+  }
+
+  std::vector<BvhNode> nodes;
+  nodes.reserve(num ? 2 * num - 1 : 1);
+  nodes.push_back(BvhNode());
+
+  std::vector<BuildTask> tasks;
+  tasks.push_back({0, 0, num, 1});
+  while (!tasks.empty()) {
+    BuildTask task = tasks.back();
+    tasks.pop_back();
+
+    Aabb box, centroids;
+    for (uint32_t i = task.first; i < task.first + task.count; i++) {
+      const Prim &p = prims[order[i]];
+      box.Grow(p.box);
+      centroids.Grow(p.centroid, p.centroid);
+    }
+
+    BvhNode &node = nodes[task.node];
+    node.bounds_min = XMFLOAT3(box.min[0], box.min[1], box.min[2]);
+    node.bounds_max = XMFLOAT3(box.max[0], box.max[1], box.max[2]);
+    node.left_first = task.first;
+    node.count = task.count;
+    if (task.count <= 1 || task.depth >= BVH_MAX_DEPTH)
+      continue;
+
+    // Binned SAH over the centroid bounds of every axis.
+    float best_cost = FLT_MAX;
+    int best_axis = -1;
+    int best_split = 0;
+    for (int axis = 0; axis < 3; axis++) {
+      float lo = centroids.min[axis], extent = centroids.max[axis] - lo;
+      if (extent <= 0.f)
+        continue;
+      float scale = BVH_NUM_BINS / extent;
+
+      Bin bins[BVH_NUM_BINS];
+      for (uint32_t i = task.first; i < task.first + task.count; i++) {
+        const Prim &p = prims[order[i]];
+        int b = std::min(BVH_NUM_BINS - 1, (int)((p.centroid[axis] - lo) * scale));
+        bins[b].box.Grow(p.box);
+        bins[b].count++;
+      }
+
+      // Sweep from the right to get the area and count right of each plane.
+      float right_area[BVH_NUM_BINS];
+      uint32_t right_count[BVH_NUM_BINS];
+      Aabb right;
+      uint32_t n = 0;
+      for (int b = BVH_NUM_BINS - 1; b > 0; b--) {
+        right.Grow(bins[b].box);
+        n += bins[b].count;
+        right_area[b] = right.HalfArea();
+        right_count[b] = n;
+      }
+
+      Aabb left;
+      n = 0;
+      for (int b = 1; b < BVH_NUM_BINS; b++) {
+        left.Grow(bins[b - 1].box);
+        n += bins[b - 1].count;
+        if (n == 0 || right_count[b] == 0)
+          continue;
+        float cost = left.HalfArea() * n + right_area[b] * right_count[b];
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_axis = axis;
+          best_split = b;
+        }
+      }
+    }
+
+    // Cost of a leaf versus one traversal step plus both children, both
+    // relative to this node's area.
+    float area = box.HalfArea();
+    bool must_split = task.count > max_leaf_size;
+    if (!must_split && (best_axis < 0 || area <= 0.f ||
+                        1.f + best_cost / area >= (float)task.count))
+      continue;
+
+    uint32_t *begin = order.data() + task.first;
+    uint32_t *end = begin + task.count;
+    uint32_t *mid = begin;
+    if (best_axis >= 0) {
+      float lo = centroids.min[best_axis];
+      float scale = BVH_NUM_BINS / (centroids.max[best_axis] - lo);
+      mid = std::partition(begin, end, [&](uint32_t i) {
+        int b = std::min(BVH_NUM_BINS - 1,
+                         (int)((prims[i].centroid[best_axis] - lo) * scale));
+        return b < best_split;
+      });
+    }
+    if (mid == begin || mid == end) {
+      // Every centroid in one bin (or the same place): split the range in half.
+      mid = begin + task.count / 2;
+    }
+
+    uint32_t left_count = (uint32_t)(mid - begin);
+    uint32_t left = (uint32_t)nodes.size();
+    nodes.push_back(BvhNode());
+    nodes.push_back(BvhNode());
+
+    BvhNode &parent = nodes[task.node];
+    parent.left_first = left;
+    parent.count = 0;
+    tasks.push_back({left, task.first, left_count, task.depth + 1});
+    tasks.push_back({left + 1, task.first + left_count, task.count - left_count,
+                     task.depth + 1});
+  }
+
+  // Put spheres in leaf order so leaves index them directly.
+  std::vector<Sphere> spheres(num);
+  std::vector<Material1> materials(num);
+  for (uint32_t i = 0; i < num; i++) {
+    spheres[i] = objects.spheres[order[i]];
+    materials[i] = objects.materials[order[i]];
+  }
+  objects.spheres.swap(spheres);
+  objects.materials.swap(materials);
+  return nodes;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "Scene.h"
+#include <cstdint>
+#include <vector>
+
+// Deepest path BuildBvh produces; both traversals size their stacks from it.
+#define BVH_MAX_DEPTH 64
+
+// Same layout as BvhNode in bvh.hlsli (32 bytes).
+struct BvhNode {
+  XMFLOAT3 bounds_min;
+  // Interior nodes: index of the left child, the right one follows it.
+  // Leaves: index of the first sphere.
+  uint32_t left_first;
+  XMFLOAT3 bounds_max;
+  // Number of spheres in a leaf, 0 for interior nodes.
+  uint32_t count;
+};
+
+// Builds a binned-SAH BVH over objects.spheres, root at index 0. The spheres
+// and their materials are reordered so that every leaf covers a contiguous
+// range. Leaves hold at most max_leaf_size spheres unless the depth limit is
+// reached.
+std::vector<BvhNode> BuildBvh(SceneObjects &objects,
+                              uint32_t max_leaf_size = 8);
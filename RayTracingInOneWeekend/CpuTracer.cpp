@@ -0,0 +1,1016 @@
+#include "CpuTracer.h"
+#include <Common/CpuFeatures.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#define TILE_SIZE 16
+// Most paths one tile keeps in flight in TRACE_WAVEFRONT; whole samples of the
+// tile are batched up to this.
+#define WAVEFRONT_BATCH 16384
+// Samples per pixel in one batch under adaptive sampling.
+#define WAVEFRONT_ADAPTIVE_BATCH 4u
+#define PI 3.1415926f
+
+namespace {
+
+struct Float3 {
+  float x, y, z;
+};
+
+inline Float3 operator+(Float3 a, Float3 b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+inline Float3 operator-(Float3 a, Float3 b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+inline Float3 operator-(Float3 a) { return {-a.x, -a.y, -a.z}; }
+inline Float3 operator*(Float3 a, Float3 b) { return {a.x * b.x, a.y * b.y, a.z * b.z}; }
+inline Float3 operator*(float s, Float3 a) { return {s * a.x, s * a.y, s * a.z}; }
+inline float dot(Float3 a, Float3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline Float3 cross(Float3 a, Float3 b) {
+  return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+inline Float3 normalize(Float3 a) { return (1.f / std::sqrt(dot(a, a))) * a; }
+inline Float3 load(const XMFLOAT3 &a) { return {a.x, a.y, a.z}; }
+
+// HLSL reflect/refract.
+inline Float3 reflect(Float3 i, Float3 n) { return i - (2.f * dot(i, n)) * n; }
+inline Float3 refract(Float3 i, Float3 n, float eta) {
+  float cosi = dot(n, i);
+  float k = 1.f - eta * eta * (1.f - cosi * cosi);
+  if (k < 0.f)
+    return {0.f, 0.f, 0.f};
+  return eta * i - (eta * cosi + std::sqrt(k)) * n;
+}
+
+// The generators below follow utils.hlsli and material.hlsli line by line;
+// the numbers themselves come from Random.h, which the shaders share.
+inline float randomFloat(Rng &rng) { return rngNext(rng); }
+
+inline void randomDisk(Rng &rng, float &x, float &y) {
+  float theta = 2 * PI * randomFloat(rng);
+  float r = std::sqrt(randomFloat(rng));
+  x = r * std::cos(theta);
+  y = r * std::sin(theta);
+}
+
+inline Float3 randomHemisphere(Rng &rng) {
+  float xi1 = randomFloat(rng);
+  float xi2 = randomFloat(rng);
+  float z = 1.f - 2.f * xi1;
+  float r = std::sqrt(std::max(0.f, 1.f - z * z));
+  float phi = 2 * PI * xi2;
+  return {r * std::cos(phi), r * std::sin(phi), std::fabs(z)};
+}
+
+inline Float3 toWorld(Float3 r, Float3 n) {
+  Float3 w = n;
+  Float3 v = normalize(std::fabs(w.x) > std::fabs(w.y) ? Float3{w.z, 0.f, -w.x}
+                                                       : Float3{0.f, w.z, -w.y});
+  Float3 u = cross(v, w);
+  return r.x * u + r.y * v + r.z * w;
+}
+
+inline float reflectance(float cosine, float ref_idx) {
+  // Use Schlick's approximation for reflectance.
+  float r0 = (1.f - ref_idx) / (1.f + ref_idx);
+  r0 = r0 * r0;
+  return r0 + (1.f - r0) * std::pow((1.f - cosine), 5.f);
+}
+
+// Same signature as the other scatter functions, for shade().
+inline Float3 scatterLambertian(const Material1 &, Float3, Float3 n,
+                                Rng &rng) {
+  return toWorld(randomHemisphere(rng), n);
+}
+
+inline Float3 scatterMetal(const Material1 &mat, Float3 r, Float3 n,
+                           Rng &rng) {
+  return normalize(reflect(r, n) +
+                   mat.fuzz * toWorld(randomHemisphere(rng), n));
+}
+
+inline Float3 scatterGlass(const Material1 &mat, Float3 r, Float3 n,
+                           Rng &rng) {
+  bool front_face = dot(r, n) < 0;
+  n = front_face ? n : -n;
+  float refraction_ratio = front_face ? (1.f / mat.ir) : mat.ir;
+  float cos_theta = std::min(dot(-r, n), 1.f);
+  float sin_theta = std::sqrt(1.f - cos_theta * cos_theta);
+  bool cannot_refract = refraction_ratio * sin_theta > 1.f;
+  if (cannot_refract ||
+      reflectance(cos_theta, refraction_ratio) > randomFloat(rng)) {
+    return reflect(r, n);
+  } else {
+    return refract(r, n, refraction_ratio);
+  }
+}
+
+Float3 scatter(const Material1 &mat, Float3 r, Float3 n, Rng &rng) {
+  switch (mat.type) {
+  case MATERIAL_METAL:
+    return scatterMetal(mat, r, n, rng);
+  case MATERIAL_GLASS:
+    return scatterGlass(mat, r, n, rng);
+  case MATERIAL_LAMBERTIAN:
+  default:
+    return scatterLambertian(mat, r, n, rng);
+  }
+}
+
+inline Float3 sky(Float3 dir) {
+  float t = 0.5f * (dir.y + 1.f);
+  return (1.f - t) * Float3{1.f, 1.f, 1.f} + t * Float3{0.5f, 0.7f, 1.f};
+}
+
+// Welford's update and the convergence test of stats.hlsli.
+inline float relativeError(const PixelStats &st) {
+  Float3 variance = (1.f / float(st.count - 1)) * load(st.m2);
+  float std_error = std::sqrt((variance.x + variance.y + variance.z) /
+                              (3.f * float(st.count)));
+  return std_error / ((st.mean.x + st.mean.y + st.mean.z) / 3.f + 0.01f);
+}
+
+inline void addSample(PixelStats &st, Float3 c, uint32_t min_samples,
+                      float threshold) {
+  st.count++;
+  Float3 delta = c - load(st.mean);
+  Float3 mean = load(st.mean) + (1.f / float(st.count)) * delta;
+  Float3 m2 = load(st.m2) + delta * (c - mean);
+  st.mean = XMFLOAT3(mean.x, mean.y, mean.z);
+  st.m2 = XMFLOAT3(m2.x, m2.y, m2.z);
+  if (threshold > 0.f && st.count >= std::max(min_samples, 2u) &&
+      relativeError(st) < threshold)
+    st.active = 0;
+}
+
+// One contiguous range of tiles per worker, packed as (begin << 32 | end) so
+// the owner popping at the front and thieves taking from the back can both
+// use a single compare-and-swap.
+class TileQueues {
+public:
+  TileQueues(uint32_t numTiles, int numWorkers)
+      : mRanges(new std::atomic<uint64_t>[numWorkers]), mNumWorkers(numWorkers) {
+    for (int w = 0; w < numWorkers; w++) {
+      uint64_t begin = (uint64_t)numTiles * w / numWorkers;
+      uint64_t end = (uint64_t)numTiles * (w + 1) / numWorkers;
+      mRanges[w].store(begin << 32 | end);
+    }
+  }
+
+  bool Pop(int worker, uint32_t &tile) {
+    std::atomic<uint64_t> &range = mRanges[worker];
+    uint64_t r = range.load();
+    for (;;) {
+      uint32_t begin = uint32_t(r >> 32), end = uint32_t(r);
+      if (begin >= end)
+        return false;
+      if (range.compare_exchange_weak(r, (uint64_t)(begin + 1) << 32 | end)) {
+        tile = begin;
+        return true;
+      }
+    }
+  }
+
+  bool Steal(int thief, uint32_t &tile) {
+    for (int i = 1; i < mNumWorkers; i++) {
+      std::atomic<uint64_t> &range = mRanges[(thief + i) % mNumWorkers];
+      uint64_t r = range.load();
+      for (;;) {
+        uint32_t begin = uint32_t(r >> 32), end = uint32_t(r);
+        if (begin >= end)
+          break;
+        if (range.compare_exchange_weak(r, (uint64_t)begin << 32 | (end - 1))) {
+          tile = end - 1;
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+private:
+  std::unique_ptr<std::atomic<uint64_t>[]> mRanges;
+  int mNumWorkers;
+};
+
+// Same as WavefrontPath and WavefrontHit in wavefront.hlsli, except that the
+// pixel is replaced by the slot of the path's sample in the batch.
+struct WavefrontPath {
+  CpuRay ray;
+  Float3 throughput;
+  uint32_t slot;
+  uint32_t depth;
+};
+
+struct WavefrontHit {
+  Float3 pos;
+  Float3 normal;
+  uint32_t obj_id;
+};
+
+// Means of pixels [begin, end) from the sums of acc.
+void resolveRows(const CpuAccumulation &acc, std::vector<XMFLOAT3> &pixels,
+                 size_t begin, size_t end) {
+  for (size_t i = begin; i < end; i++) {
+    float inv = 1.f / float(std::max(1u, acc.stats[i].count));
+    Float3 sum = load(acc.sums[0][i]) + load(acc.sums[1][i]);
+    pixels[i] = XMFLOAT3(inv * sum.x, inv * sum.y, inv * sum.z);
+  }
+}
+
+} // namespace
+
+int HitSphereLanes(const SphereLanes &lanes, const CpuRay &ray,
+                   float &t_closest) {
+  int hit_lane = -1;
+  float a = ray.dx * ray.dx + ray.dy * ray.dy + ray.dz * ray.dz;
+  for (uint32_t i = 0; i < lanes.count; i++) {
+    float ocx = ray.ox - lanes.cx[i];
+    float ocy = ray.oy - lanes.cy[i];
+    float ocz = ray.oz - lanes.cz[i];
+    float half_b = ocx * ray.dx + ocy * ray.dy + ocz * ray.dz;
+    float c = ocx * ocx + ocy * ocy + ocz * ocz -
+              lanes.radius[i] * lanes.radius[i];
+    float discriminant = half_b * half_b - a * c;
+    if (discriminant < 0)
+      continue;
+    float sqrtd = std::sqrt(discriminant);
+    float t = (-half_b - sqrtd) / a;
+    if (t < MIN_T || MAX_T < t) {
+      t = (-half_b + sqrtd) / a;
+      if (t < MIN_T || MAX_T < t)
+        continue;
+    }
+    if (t < t_closest) {
+      t_closest = t;
+      hit_lane = (int)i;
+    }
+  }
+  return hit_lane;
+}
+
+CpuTracer::CpuTracer(const RenderSettings &settings, const CameraCB &camera,
+                     const SceneObjects &objects)
+    : mSettings(settings), mCamera(camera) {
+  SceneObjects sorted = objects;
+  mNodes = BuildBvh(sorted, SPHERE_LANES);
+  mSpheres = std::move(sorted.spheres);
+  mMaterials = std::move(sorted.materials);
+
+  // Pack every leaf into groups of eight. Leaves are disjoint and cover all
+  // spheres, so walking mLanes in order is also the brute-force loop.
+  mLeafLanes.assign(mNodes.size(), 0);
+  for (size_t n = 0; n < mNodes.size(); n++) {
+    const BvhNode &node = mNodes[n];
+    if (node.count == 0)
+      continue;
+    mLeafLanes[n] = (uint32_t)mLanes.size();
+    for (uint32_t first = node.left_first;
+         first < node.left_first + node.count; first += SPHERE_LANES) {
+      SphereLanes lanes = {};
+      lanes.first = first;
+      lanes.count = std::min<uint32_t>(SPHERE_LANES,
+                                       node.left_first + node.count - first);
+      for (uint32_t i = 0; i < lanes.count; i++) {
+        const Sphere &s = mSpheres[first + i];
+        lanes.cx[i] = s.center.x;
+        lanes.cy[i] = s.center.y;
+        lanes.cz[i] = s.center.z;
+        lanes.radius[i] = s.radius;
+      }
+      mLanes.push_back(lanes);
+    }
+  }
+  mTilesX = (settings.image_width + TILE_SIZE - 1) / TILE_SIZE;
+  mTilesY = (settings.image_height + TILE_SIZE - 1) / TILE_SIZE;
+  mUseAvx = AvxSupported();
+}
+
+CpuRenderStats CpuTracer::Render(int threadCount,
+                                 std::vector<XMFLOAT3> &pixels) const {
+  return Render(threadCount, mCamera, pixels);
+}
+
+CpuRenderStats CpuTracer::Render(int threadCount, const CameraCB &camera,
+                                 std::vector<XMFLOAT3> &pixels) const {
+  CpuAccumulation acc;
+  Reset(acc);
+  CpuRenderStats stats =
+      Accumulate(threadCount, mSettings.num_samples, camera, acc);
+  Resolve(acc, pixels);
+  return stats;
+}
+
+CpuRenderStats CpuTracer::Render(int threadCount,
+                                 std::vector<XMFLOAT3> &pixels,
+                                 const RowsCallback &onRows) const {
+  CpuAccumulation acc;
+  Reset(acc);
+  pixels.resize(acc.sums[0].size());
+
+  // Tiles left in every row of tiles; rows of tiles are handed over in order
+  // from the bottom, by whichever worker finishes the last one in reach.
+  std::unique_ptr<std::atomic<uint32_t>[]> remaining(
+      new std::atomic<uint32_t>[mTilesY]);
+  for (uint32_t ty = 0; ty < mTilesY; ty++)
+    remaining[ty] = mTilesX;
+  std::vector<bool> done(mTilesY, false);
+  uint32_t next = 0;
+  std::mutex lock;
+  std::exception_ptr error;
+
+  auto onTile = [&](uint32_t tile) {
+    uint32_t ty = tile / mTilesX;
+    if (--remaining[ty] != 0)
+      return;
+    std::lock_guard<std::mutex> guard(lock);
+    done[ty] = true;
+    for (; next < mTilesY && done[next]; next++) {
+      uint32_t y0 = next * TILE_SIZE;
+      uint32_t y1 = std::min(y0 + TILE_SIZE, mSettings.image_height);
+      resolveRows(acc, pixels, size_t(y0) * mSettings.image_width,
+                  size_t(y1) * mSettings.image_width);
+      if (error)
+        continue;
+      try {
+        onRows(y0, y1 - y0);
+      } catch (...) {
+        error = std::current_exception();
+      }
+    }
+  };
+
+  CpuRenderStats stats = AccumulateTiles(threadCount, mSettings.num_samples,
+                                         mCamera, acc, onTile);
+  if (error)
+    std::rethrow_exception(error);
+  return stats;
+}
+
+void CpuTracer::Reset(CpuAccumulation &acc) const {
+  size_t num_pixels = (size_t)mSettings.image_width * mSettings.image_height;
+  for (auto &sums : acc.sums)
+    sums.assign(num_pixels, XMFLOAT3(0.f, 0.f, 0.f));
+  PixelStats empty = {};
+  empty.active = 1;
+  acc.stats.assign(num_pixels, empty);
+  acc.samples = 0;
+}
+
+CpuRenderStats CpuTracer::Accumulate(int threadCount, uint32_t numSamples,
+                                     CpuAccumulation &acc) const {
+  return Accumulate(threadCount, numSamples, mCamera, acc);
+}
+
+CpuRenderStats CpuTracer::Accumulate(int threadCount, uint32_t numSamples,
+                                     const CameraCB &camera,
+                                     CpuAccumulation &acc) const {
+  return AccumulateTiles(threadCount, numSamples, camera, acc, nullptr);
+}
+
+CpuRenderStats CpuTracer::AccumulateTiles(
+    int threadCount, uint32_t numSamples, const CameraCB &camera,
+    CpuAccumulation &acc,
+    const std::function<void(uint32_t tile)> &onTile) const {
+  if (threadCount <= 0)
+    threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+  uint32_t numTiles = mTilesX * mTilesY;
+  threadCount = std::min<int>(threadCount, (int)numTiles);
+
+  TileQueues queues(numTiles, threadCount);
+  std::atomic<uint64_t> steals{0};
+  std::vector<std::vector<uint64_t>> bounce_rays(
+      threadCount, std::vector<uint64_t>(mSettings.max_depth, 0));
+  auto worker = [&](int w) {
+    uint32_t tile;
+    uint64_t *rays = bounce_rays[w].data();
+    while (queues.Pop(w, tile)) {
+      RenderTile(tile, numSamples, camera, acc, rays);
+      if (onTile)
+        onTile(tile);
+    }
+    while (queues.Steal(w, tile)) {
+      steals++;
+      RenderTile(tile, numSamples, camera, acc, rays);
+      if (onTile)
+        onTile(tile);
+    }
+  };
+
+  auto start = std::chrono::high_resolution_clock::now();
+  std::vector<std::thread> threads;
+  for (int w = 1; w < threadCount; w++)
+    threads.emplace_back(worker, w);
+  worker(0);
+  for (auto &t : threads)
+    t.join();
+  auto stop = std::chrono::high_resolution_clock::now();
+
+  CpuRenderStats stats;
+  stats.seconds = std::chrono::duration<double>(stop - start).count();
+  stats.steals = steals;
+  stats.bounce_rays.assign(mSettings.max_depth, 0);
+  for (const auto &rays : bounce_rays) {
+    for (uint32_t d = 0; d < mSettings.max_depth; d++) {
+      stats.bounce_rays[d] += rays[d];
+      stats.rays += rays[d];
+    }
+  }
+  // Every sample starts with one camera ray.
+  stats.samples = stats.bounce_rays.empty() ? 0 : stats.bounce_rays[0];
+  acc.samples += numSamples;
+  return stats;
+}
+
+void CpuTracer::Resolve(const CpuAccumulation &acc,
+                        std::vector<XMFLOAT3> &pixels) {
+  pixels.resize(acc.sums[0].size());
+  resolveRows(acc, pixels, 0, pixels.size());
+}
+
+void CpuTracer::RenderTile(uint32_t tile, uint32_t numSamples,
+                           const CameraCB &camera, CpuAccumulation &acc,
+                           uint64_t *bounce_rays) const {
+  if (mSettings.trace_mode == TRACE_WAVEFRONT) {
+    RenderTileWavefront(tile, numSamples, camera, acc, bounce_rays);
+    return;
+  }
+
+  uint32_t x0 = (tile % mTilesX) * TILE_SIZE;
+  uint32_t y0 = (tile / mTilesX) * TILE_SIZE;
+  uint32_t x1 = std::min(x0 + TILE_SIZE, mSettings.image_width);
+  uint32_t y1 = std::min(y0 + TILE_SIZE, mSettings.image_height);
+
+  Float3 origin = load(camera.origin);
+  Float3 lower_left_corner = load(camera.lower_left_corner);
+  Float3 horizontal = load(camera.horizontal);
+  Float3 vertical = load(camera.vertical);
+  Float3 u = load(camera.u);
+  Float3 v = load(camera.v);
+  std::vector<XMFLOAT3> colors;
+
+  for (uint32_t y = y0; y < y1; y++) {
+    for (uint32_t x = x0; x < x1; x++) {
+      uint32_t idx = y * mSettings.image_width + x;
+      uint32_t key = pixelKey(mSettings.seed, idx);
+      float s = float(x) / float(mSettings.image_width);
+      float t = float(y) / float(mSettings.image_height);
+
+      Float3 sums[2] = {load(acc.sums[0][idx]), load(acc.sums[1][idx])};
+      // A pixel that is still active has taken every sample so far, so i is
+      // also its own sample count.
+      PixelStats st = acc.stats[idx];
+      for (uint32_t i = acc.samples; i < acc.samples + numSamples && st.active;
+           i++) {
+        // generateRay
+        Rng rng = makeRng(mSettings.sampler, key, i);
+        float rdx, rdy;
+        randomDisk(rng, rdx, rdy);
+        Float3 o = origin + (camera.lens_radius * rdx) * u +
+                   (camera.lens_radius * rdy) * v;
+        Float3 d = normalize(lower_left_corner + s * horizontal +
+                             t * vertical - o);
+        CpuRay ray = {o.x, o.y, o.z, d.x, d.y, d.z};
+        XMFLOAT3 c = mSettings.trace_mode == TRACE_PER_DEPTH
+                         ? TracePerDepth(ray, rng, bounce_rays, colors)
+                         : Trace(ray, rng, bounce_rays);
+        sums[i & 1] = sums[i & 1] + load(c);
+        addSample(st, load(c), mSettings.adaptive_min_samples,
+                  mSettings.adaptive_threshold);
+      }
+      acc.stats[idx] = st;
+      acc.sums[0][idx] = XMFLOAT3(sums[0].x, sums[0].y, sums[0].z);
+      acc.sums[1][idx] = XMFLOAT3(sums[1].x, sums[1].y, sums[1].z);
+    }
+  }
+}
+
+void CpuTracer::RenderTileWavefront(uint32_t tile, uint32_t numSamples,
+                                    const CameraCB &camera,
+                                    CpuAccumulation &acc,
+                                    uint64_t *bounce_rays) const {
+  uint32_t x0 = (tile % mTilesX) * TILE_SIZE;
+  uint32_t y0 = (tile / mTilesX) * TILE_SIZE;
+  uint32_t x1 = std::min(x0 + TILE_SIZE, mSettings.image_width);
+  uint32_t y1 = std::min(y0 + TILE_SIZE, mSettings.image_height);
+  uint32_t w = x1 - x0;
+  uint32_t num_pixels = w * (y1 - y0);
+
+  Float3 origin = load(camera.origin);
+  Float3 lower_left_corner = load(camera.lower_left_corner);
+  Float3 horizontal = load(camera.horizontal);
+  Float3 vertical = load(camera.vertical);
+  Float3 u = load(camera.u);
+  Float3 v = load(camera.v);
+
+  // Radiance of every sample of the batch, its pixel and its index there.
+  std::vector<Float3> radiance;
+  std::vector<uint32_t> sample_pixel, sample_index;
+  std::vector<WavefrontPath> paths_in, paths_out;
+  std::vector<WavefrontHit> hits;
+  std::vector<uint32_t> material_queues[NUM_MATERIALS];
+  uint32_t batch_samples = std::max(1u, WAVEFRONT_BATCH / num_pixels);
+  // Pixels only retire between batches, so keep them short when they can.
+  if (mSettings.adaptive_threshold > 0.f)
+    batch_samples = std::min(batch_samples, WAVEFRONT_ADAPTIVE_BATCH);
+
+  uint32_t end = acc.samples + numSamples;
+  for (uint32_t s0 = acc.samples; s0 < end; s0 += batch_samples) {
+    uint32_t s1 = std::min(s0 + batch_samples, end);
+
+    // generate: every sample of the batch is its own path, drawing the random
+    // numbers of its pixel and sample index. Retired pixels get none.
+    paths_in.clear();
+    radiance.clear();
+    sample_pixel.clear();
+    sample_index.clear();
+    for (uint32_t p = 0; p < num_pixels; p++) {
+      uint32_t x = x0 + p % w, y = y0 + p / w;
+      uint32_t idx = y * mSettings.image_width + x;
+      if (!acc.stats[idx].active)
+        continue;
+      uint32_t key = pixelKey(mSettings.seed, idx);
+      float s = float(x) / float(mSettings.image_width);
+      float t = float(y) / float(mSettings.image_height);
+      for (uint32_t i = s0; i < s1; i++) {
+        WavefrontPath path;
+        Rng rng = makeRng(mSettings.sampler, key, i);
+        float rdx, rdy;
+        randomDisk(rng, rdx, rdy);
+        Float3 o = origin + (camera.lens_radius * rdx) * u +
+                   (camera.lens_radius * rdy) * v;
+        Float3 d = normalize(lower_left_corner + s * horizontal +
+                             t * vertical - o);
+        path.ray = {o.x, o.y, o.z, d.x, d.y, d.z};
+        path.throughput = {1.f, 1.f, 1.f};
+        path.depth = 0;
+        path.slot = (uint32_t)radiance.size();
+        radiance.push_back(Float3{0.f, 0.f, 0.f});
+        sample_pixel.push_back(idx);
+        sample_index.push_back(i);
+        paths_in.push_back(path);
+      }
+    }
+
+    for (uint32_t depth = 0; depth < mSettings.max_depth && !paths_in.empty();
+         depth++) {
+      bounce_rays[depth] += paths_in.size();
+
+      // extend: escaped paths end here, the others are queued by material.
+      hits.resize(paths_in.size());
+      for (auto &queue : material_queues)
+        queue.clear();
+      for (uint32_t i = 0; i < (uint32_t)paths_in.size(); i++) {
+        const WavefrontPath &path = paths_in[i];
+        const CpuRay &ray = path.ray;
+        float t_closest = INFINITY;
+        int hit_obj_id = ClosestHit(ray, t_closest);
+        Float3 dir = {ray.dx, ray.dy, ray.dz};
+        if (hit_obj_id < 0) {
+          radiance[path.slot] = path.throughput * sky(dir);
+          continue;
+        }
+        const Sphere &sphere = mSpheres[hit_obj_id];
+        WavefrontHit &hit = hits[i];
+        hit.pos = Float3{ray.ox, ray.oy, ray.oz} + t_closest * dir;
+        hit.normal = (1.f / sphere.radius) * (hit.pos - load(sphere.center));
+        hit.obj_id = (uint32_t)hit_obj_id;
+        material_queues[mMaterials[hit_obj_id].type].push_back(i);
+      }
+
+      // shade: one loop per material, survivors are compacted into paths_out.
+      paths_out.clear();
+      auto shade = [&](int type, auto scatter_fn) {
+        for (uint32_t i : material_queues[type]) {
+          WavefrontPath path = paths_in[i];
+          const WavefrontHit &hit = hits[i];
+          const Material1 &mat = mMaterials[hit.obj_id];
+          Rng rng = makeRng(mSettings.sampler,
+                            pixelKey(mSettings.seed, sample_pixel[path.slot]),
+                            sample_index[path.slot]);
+          rngBounce(rng, path.depth);
+          Float3 dir = {path.ray.dx, path.ray.dy, path.ray.dz};
+          Float3 next = scatter_fn(mat, dir, hit.normal, rng);
+          path.ray = {hit.pos.x, hit.pos.y, hit.pos.z, next.x, next.y, next.z};
+          path.throughput = path.throughput * load(mat.color);
+          path.depth++;
+          paths_out.push_back(path);
+        }
+      };
+      shade(MATERIAL_LAMBERTIAN, scatterLambertian);
+      shade(MATERIAL_METAL, scatterMetal);
+      shade(MATERIAL_GLASS, scatterGlass);
+      paths_in.swap(paths_out);
+    }
+    // Paths still alive after max_depth bounces get no light.
+
+    // blend, in sample order per pixel. The samples of a pixel follow each
+    // other, so its count tells even from odd.
+    for (size_t j = 0; j < radiance.size(); j++) {
+      uint32_t idx = sample_pixel[j];
+      PixelStats &st = acc.stats[idx];
+      if (!st.active)
+        continue;
+      XMFLOAT3 &sum = acc.sums[st.count & 1][idx];
+      Float3 s = load(sum) + radiance[j];
+      sum = XMFLOAT3(s.x, s.y, s.z);
+      addSample(st, radiance[j], mSettings.adaptive_min_samples,
+                mSettings.adaptive_threshold);
+    }
+  }
+}
+
+int CpuTracer::Bounce(CpuRay &ray, Rng &rng, uint32_t depth,
+                      XMFLOAT3 &color) const {
+  // forward
+  float t_closest = INFINITY;
+  int hit_obj_id = ClosestHit(ray, t_closest);
+
+  Float3 dir = {ray.dx, ray.dy, ray.dz};
+  if (hit_obj_id < 0) {
+    Float3 c = sky(dir);
+    color = XMFLOAT3(c.x, c.y, c.z);
+    return -1;
+  }
+
+  const Sphere &sphere = mSpheres[hit_obj_id];
+  const Material1 &mat = mMaterials[hit_obj_id];
+  Float3 pos = Float3{ray.ox, ray.oy, ray.oz} + t_closest * dir;
+  Float3 normal = (1.f / sphere.radius) * (pos - load(sphere.center));
+  rngBounce(rng, depth);
+  Float3 next = scatter(mat, dir, normal, rng);
+  ray = {pos.x, pos.y, pos.z, next.x, next.y, next.z};
+  color = mat.color;
+  return hit_obj_id;
+}
+
+XMFLOAT3 CpuTracer::Trace(CpuRay ray, Rng &rng,
+                          uint64_t *bounce_rays) const {
+  // Same as path.hlsl: the product of the attenuations so far is carried
+  // along instead of being stored per depth.
+  Float3 throughput = {1.f, 1.f, 1.f};
+  for (uint32_t d = 0; d < mSettings.max_depth; d++) {
+    XMFLOAT3 c;
+    int hit_obj_id = Bounce(ray, rng, d, c);
+    bounce_rays[d]++;
+    throughput = throughput * load(c);
+    if (hit_obj_id < 0)
+      return XMFLOAT3(throughput.x, throughput.y, throughput.z);
+  }
+
+  // Paths still alive after max_depth bounces get no light.
+  return XMFLOAT3(0.f, 0.f, 0.f);
+}
+
+XMFLOAT3 CpuTracer::TracePerDepth(CpuRay ray, Rng &rng,
+                                  uint64_t *bounce_rays,
+                                  std::vector<XMFLOAT3> &colors) const {
+  const uint32_t max_depth = mSettings.max_depth;
+  colors.resize(max_depth + 1);
+
+  // forward: attenuation per depth, the sky where the path escapes, white
+  // once it is gone.
+  bool valid = true;
+  for (uint32_t d = 0; d < max_depth; d++) {
+    if (!valid) {
+      colors[d] = XMFLOAT3(1.f, 1.f, 1.f);
+      continue;
+    }
+    valid = Bounce(ray, rng, d, colors[d]) >= 0;
+    bounce_rays[d]++;
+  }
+
+  // background
+  colors[max_depth] = valid ? XMFLOAT3(0.f, 0.f, 0.f) : XMFLOAT3(1.f, 1.f, 1.f);
+
+  // backward
+  for (uint32_t d = max_depth; d > 0; d--) {
+    Float3 c = load(colors[d]) * load(colors[d - 1]);
+    colors[d - 1] = XMFLOAT3(c.x, c.y, c.z);
+  }
+  return colors[0];
+}
+
+int CpuTracer::HitLanes(uint32_t first, uint32_t count, const CpuRay &ray,
+                        float &t_closest) const {
+  int hit_obj_id = -1;
+  for (uint32_t i = first; i < first + count; i++) {
+    const SphereLanes &lanes = mLanes[i];
+    int lane = mUseAvx ? HitSphereLanesAvx(lanes, ray, t_closest)
+                       : HitSphereLanes(lanes, ray, t_closest);
+    if (lane >= 0)
+      hit_obj_id = (int)lanes.first + lane;
+  }
+  return hit_obj_id;
+}
+
+int CpuTracer::ClosestHit(const CpuRay &ray, float &t_closest) const {
+  if (!mUseBvh)
+    return HitLanes(0, (uint32_t)mLanes.size(), ray, t_closest);
+
+  float inv_dx = 1.f / ray.dx, inv_dy = 1.f / ray.dy, inv_dz = 1.f / ray.dz;
+  // Distance at which the ray enters node n, or INFINITY if it misses it
+  // within (MIN_T, t_closest).
+  auto enter = [&](uint32_t n) {
+    const BvhNode &node = mNodes[n];
+    float tx0 = (node.bounds_min.x - ray.ox) * inv_dx;
+    float tx1 = (node.bounds_max.x - ray.ox) * inv_dx;
+    float ty0 = (node.bounds_min.y - ray.oy) * inv_dy;
+    float ty1 = (node.bounds_max.y - ray.oy) * inv_dy;
+    float tz0 = (node.bounds_min.z - ray.oz) * inv_dz;
+    float tz1 = (node.bounds_max.z - ray.oz) * inv_dz;
+    float t_enter = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)),
+                             std::max(std::min(tz0, tz1), MIN_T));
+    float t_exit = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)),
+                            std::min(std::max(tz0, tz1), t_closest));
+    // Widen the exit a few ulps so rounding never culls a sphere that grazes
+    // its own box.
+    return t_enter <= t_exit * 1.0000004f ? t_enter : INFINITY;
+  };
+
+  int hit_obj_id = -1;
+  uint32_t stack[BVH_MAX_DEPTH];
+  uint32_t sp = 0;
+  uint32_t n = 0;
+  if (enter(0) == INFINITY)
+    return -1;
+  for (;;) {
+    const BvhNode &node = mNodes[n];
+    if (node.count > 0) {
+      uint32_t num_lanes = (node.count + SPHERE_LANES - 1) / SPHERE_LANES;
+      int hit = HitLanes(mLeafLanes[n], num_lanes, ray, t_closest);
+      if (hit >= 0)
+        hit_obj_id = hit;
+    } else {
+      // Visit the nearer child first so t_closest shrinks early.
+      uint32_t near = node.left_first, far = node.left_first + 1;
+      float t_near = enter(near), t_far = enter(far);
+      if (t_far < t_near) {
+        std::swap(near, far);
+        std::swap(t_near, t_far);
+      }
+      if (t_near != INFINITY) {
+        if (t_far != INFINITY)
+          stack[sp++] = far;
+        n = near;
+        continue;
+      }
+    }
+    if (sp == 0)
+      break;
+    n = stack[--sp];
+  }
+  return hit_obj_id;
+}
+
+bool CpuTracer::AvxSupported() {
+  if (!SphereLanesAvxCompiled())
+    return false;
+  return CpuSupportsAvx();
+}
+
+void RunCpuTracerBenchmark(const RenderSettings &settings, int maxThreads) {
+  CameraCB camera;
+  SceneObjects objects;
+  BuildScene(settings, camera, objects);
+  CpuTracer tracer(settings, camera, objects);
+
+  if (maxThreads <= 0)
+    maxThreads = (int)std::max(1u, std::thread::hardware_concurrency());
+  std::vector<int> threadCounts;
+  for (int n = 1; n < maxThreads; n *= 2)
+    threadCounts.push_back(n);
+  threadCounts.push_back(maxThreads);
+
+  printf("%ux%u, %u spp, depth %u, %u spheres\n", settings.image_width,
+         settings.image_height, settings.num_samples, settings.max_depth,
+         (uint32_t)objects.spheres.size());
+
+  std::vector<XMFLOAT3> pixels;
+  for (int avx = 0; avx < 2; avx++) {
+    if (avx && !CpuTracer::AvxSupported()) {
+      printf("8-wide AVX: not supported\n");
+      break;
+    }
+    tracer.SetUseAvx(avx != 0);
+    printf("%s\n", avx ? "AVX sphere test" : "scalar sphere test");
+
+    double base = 0.0;
+    for (int n : threadCounts) {
+      CpuRenderStats stats = tracer.Render(n, pixels);
+      double rate = stats.samples / stats.seconds;
+      if (base == 0.0)
+        base = rate;
+      printf("  %3d threads: %8.2f Msamples/s  x%5.2f  (%llu tiles stolen)\n",
+             n, rate * 1e-6, rate / base, (unsigned long long)stats.steals);
+    }
+  }
+}
+
+void RunWavefrontBenchmark(const RenderSettings &settings, int threadCount) {
+  CameraCB camera;
+  SceneObjects objects;
+  BuildScene(settings, camera, objects);
+
+  printf("%ux%u, %u spp, depth %u, %u spheres\n", settings.image_width,
+         settings.image_height, settings.num_samples, settings.max_depth,
+         (uint32_t)objects.spheres.size());
+
+  std::vector<XMFLOAT3> pixels;
+  CpuRenderStats stats[2];
+  const uint32_t modes[2] = {TRACE_PATH, TRACE_WAVEFRONT};
+  for (int i = 0; i < 2; i++) {
+    RenderSettings s = settings;
+    s.trace_mode = modes[i];
+    stats[i] = CpuTracer(s, camera, objects).Render(threadCount, pixels);
+  }
+
+  // Dispatch size per bounce: the whole screen for the per-pixel passes, the
+  // live queue for the wavefront.
+  printf("  depth   live paths   of camera rays\n");
+  const std::vector<uint64_t> &live = stats[1].bounce_rays;
+  for (size_t d = 0; d < live.size() && live[d] > 0; d++) {
+    printf("  %5zu %12llu %15.1f%%\n", d, (unsigned long long)live[d],
+           100.0 * live[d] / live[0]);
+  }
+  double full = (double)live[0] * settings.max_depth;
+  printf("  %llu of %.0f thread launches (%.1f%%)\n",
+         (unsigned long long)stats[1].rays, full, 100.0 * stats[1].rays / full);
+
+  for (int i = 0; i < 2; i++) {
+    printf("  %-10s %8.2f s %8.2f Msamples/s  x%5.2f\n",
+           i ? "wavefront" : "path", stats[i].seconds,
+           stats[i].samples / stats[i].seconds * 1e-6,
+           stats[0].seconds / stats[i].seconds);
+  }
+}
+
+void RunAdaptiveBenchmark(const RenderSettings &settings, int threadCount) {
+  CameraCB camera;
+  SceneObjects objects;
+  BuildScene(settings, camera, objects);
+
+  // The reference gets random streams of its own; sharing them with the
+  // renders it is compared to would hide part of their noise.
+  RenderSettings ref = settings;
+  ref.num_samples = 8 * settings.num_samples;
+  ref.adaptive_threshold = 0.f;
+  ref.seed = settings.seed + 1;
+  std::vector<XMFLOAT3> reference;
+  CpuRenderStats ref_stats =
+      CpuTracer(ref, camera, objects).Render(threadCount, reference);
+  printf("%ux%u, depth %u, reference %u spp in %.2f s\n",
+         settings.image_width, settings.image_height, settings.max_depth,
+         ref.num_samples, ref_stats.seconds);
+  printf("  %-18s %8s %8s %10s\n", "sampling", "avg spp", "seconds", "RMSE");
+
+  std::vector<XMFLOAT3> pixels;
+  auto run = [&](const char *name, const RenderSettings &s) {
+    CpuRenderStats stats = CpuTracer(s, camera, objects).Render(threadCount,
+                                                                 pixels);
+    double error = 0.0;
+    for (size_t i = 0; i < pixels.size(); i++) {
+      Float3 d = load(pixels[i]) - load(reference[i]);
+      error += dot(d, d);
+    }
+    printf("  %-18s %8.1f %8.2f %10.5f\n", name,
+           double(stats.samples) / pixels.size(), stats.seconds,
+           std::sqrt(error / (3.0 * pixels.size())));
+  };
+
+  char name[32];
+  for (uint32_t div : {8u, 4u, 2u, 1u}) {
+    RenderSettings s = settings;
+    s.num_samples = std::max(1u, settings.num_samples / div);
+    s.adaptive_threshold = 0.f;
+    snprintf(name, sizeof(name), "uniform %u", s.num_samples);
+    run(name, s);
+  }
+  for (float threshold : {0.2f, 0.1f, 0.05f, 0.02f}) {
+    RenderSettings s = settings;
+    s.adaptive_threshold = threshold;
+    snprintf(name, sizeof(name), "adaptive %.2f", threshold);
+    run(name, s);
+  }
+}
+
+void RunSamplerBenchmark(const RenderSettings &settings, int threadCount) {
+  CameraCB camera;
+  SceneObjects objects;
+  BuildScene(settings, camera, objects);
+
+  // Independent random numbers for the reference, so that its error is not
+  // correlated with that of either sampler.
+  RenderSettings ref = settings;
+  ref.num_samples = 8 * settings.num_samples;
+  ref.adaptive_threshold = 0.f;
+  ref.sampler = SAMPLER_RANDOM;
+  ref.seed = settings.seed + 1;
+  std::vector<XMFLOAT3> reference;
+  CpuRenderStats ref_stats =
+      CpuTracer(ref, camera, objects).Render(threadCount, reference);
+  printf("%ux%u, depth %u, reference %u spp in %.2f s\n",
+         settings.image_width, settings.image_height, settings.max_depth,
+         ref.num_samples, ref_stats.seconds);
+  printf("  %8s %12s %12s %8s\n", "spp", "random RMSE", "sobol RMSE",
+         "ratio");
+
+  std::vector<XMFLOAT3> pixels;
+  for (uint32_t div : {16u, 4u, 1u}) {
+    double rmse[2];
+    for (uint32_t sampler : {SAMPLER_RANDOM, SAMPLER_SOBOL}) {
+      RenderSettings s = settings;
+      s.num_samples = std::max(1u, settings.num_samples / div);
+      s.adaptive_threshold = 0.f;
+      s.sampler = sampler;
+      CpuTracer(s, camera, objects).Render(threadCount, pixels);
+      double error = 0.0;
+      for (size_t i = 0; i < pixels.size(); i++) {
+        Float3 d = load(pixels[i]) - load(reference[i]);
+        error += dot(d, d);
+      }
+      rmse[sampler] = std::sqrt(error / (3.0 * pixels.size()));
+    }
+    printf("  %8u %12.5f %12.5f %8.3f\n",
+           std::max(1u, settings.num_samples / div), rmse[SAMPLER_RANDOM],
+           rmse[SAMPLER_SOBOL], rmse[SAMPLER_SOBOL] / rmse[SAMPLER_RANDOM]);
+  }
+}
+
+void RunBvhBenchmark(const RenderSettings &settings, int threadCount) {
+  printf("%ux%u, %u spp, depth %u\n", settings.image_width,
+         settings.image_height, settings.num_samples, settings.max_depth);
+  printf("   spheres    nodes   build ms   BVH Mrays/s   brute Mrays/s\n");
+
+  std::vector<XMFLOAT3> pixels;
+  for (uint32_t grid : {5u, 16u, 50u, 160u, 350u}) {
+    RenderSettings s = settings;
+    s.sphere_grid = grid;
+    CameraCB camera;
+    SceneObjects objects;
+    BuildScene(s, camera, objects);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    CpuTracer tracer(s, camera, objects);
+    auto stop = std::chrono::high_resolution_clock::now();
+    double build_ms = std::chrono::duration<double, std::milli>(stop - start).count();
+
+    CpuRenderStats bvh = tracer.Render(threadCount, pixels);
+    printf("  %8zu %8zu %10.1f %13.2f", objects.spheres.size(),
+           tracer.NodeCount(), build_ms, bvh.rays / bvh.seconds * 1e-6);
+    if (objects.spheres.size() <= 1100) {
+      tracer.SetUseBvh(false);
+      CpuRenderStats brute = tracer.Render(threadCount, pixels);
+      printf(" %15.2f", brute.rays / brute.seconds * 1e-6);
+    }
+    printf("\n");
+  }
+}
+
+bool CompareTraceModes(const RenderSettings &settings, int threadCount,
+                       float tolerance) {
+  CameraCB camera;
+  SceneObjects objects;
+  BuildScene(settings, camera, objects);
+  printf("%ux%u, %u spp, depth %u, seed %u\n", settings.image_width,
+         settings.image_height, settings.num_samples, settings.max_depth,
+         settings.seed);
+
+  const char *names[] = {"single pass", "per depth", "wavefront"};
+  std::vector<XMFLOAT3> images[3];
+  for (uint32_t mode : {TRACE_PATH, TRACE_PER_DEPTH, TRACE_WAVEFRONT}) {
+    RenderSettings s = settings;
+    s.trace_mode = mode;
+    CpuRenderStats stats =
+        CpuTracer(s, camera, objects).Render(threadCount, images[mode]);
+    printf("  %-12s %.2f s\n", names[mode], stats.seconds);
+  }
+
+  bool same = true;
+  const std::vector<XMFLOAT3> &a = images[TRACE_PATH];
+  for (uint32_t mode : {TRACE_PER_DEPTH, TRACE_WAVEFRONT}) {
+    const std::vector<XMFLOAT3> &b = images[mode];
+    size_t worst = 0, mismatches = 0;
+    float worst_diff = 0.f;
+    for (size_t i = 0; i < a.size(); i++) {
+      float diff = std::max(std::max(std::fabs(a[i].x - b[i].x),
+                                     std::fabs(a[i].y - b[i].y)),
+                            std::fabs(a[i].z - b[i].z));
+      if (!(diff <= tolerance))
+        mismatches++;
+      if (!(diff <= worst_diff)) {
+        worst_diff = diff;
+        worst = i;
+      }
+    }
+    printf("  %-12s max difference %g at (%zu, %zu), %zu pixels over %g\n",
+           names[mode], worst_diff, worst % settings.image_width,
+           worst / settings.image_width, mismatches, tolerance);
+    same = same && mismatches == 0;
+  }
+  return same;
+}
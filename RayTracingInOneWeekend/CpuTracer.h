@@ -0,0 +1,186 @@
+#pragma once
+#include "Bvh.h"
+#include "Scene.h"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#define SPHERE_LANES 8
+
+// Same ray interval as geo.hlsli.
+#define MAX_T 1e3f
+#define MIN_T 1e-3f
+
+// Eight spheres in structure-of-arrays form, tested against one ray at a time.
+// Only the first count lanes are valid; first is the index of lane 0 in
+// SceneObjects::spheres.
+struct SphereLanes {
+  float cx[SPHERE_LANES];
+  float cy[SPHERE_LANES];
+  float cz[SPHERE_LANES];
+  float radius[SPHERE_LANES];
+  uint32_t first;
+  uint32_t count;
+};
+
+struct CpuRay {
+  float ox, oy, oz;
+  float dx, dy, dz;
+};
+
+// Closest intersection in [MIN_T, MAX_T] that is also nearer than t_closest.
+// Returns the lane and updates t_closest, or returns -1. Lanes are checked in
+// order, so ties go to the lower index exactly like the loop in forward.hlsl.
+int HitSphereLanes(const SphereLanes &lanes, const CpuRay &ray,
+                   float &t_closest);
+int HitSphereLanesAvx(const SphereLanes &lanes, const CpuRay &ray,
+                      float &t_closest);
+bool SphereLanesAvxCompiled();
+
+struct CpuRenderStats {
+  double seconds = 0.0;
+  // Samples actually traced, fewer than pixels x spp once adaptive sampling
+  // retires pixels.
+  uint64_t samples = 0;
+  uint64_t rays = 0;
+  uint64_t steals = 0;
+  // Rays traced at each depth, the first entry being the camera rays.
+  std::vector<uint64_t> bounce_rays;
+};
+
+// Running state of a render that is built up over several Accumulate calls.
+struct CpuAccumulation {
+  // Sums of the even and of the odd samples of every pixel. They are two
+  // independent estimates, which is what ConvergenceError compares.
+  std::vector<XMFLOAT3> sums[2];
+  // Running mean and variance of every pixel; count is the number of samples
+  // in its sums.
+  std::vector<PixelStats> stats;
+  // Samples asked of every pixel so far. Pixels retired by adaptive sampling
+  // have fewer.
+  uint32_t samples = 0;
+};
+
+// CPU version of the passes InOneWeekendApp runs for each trace_mode. The
+// image is cut into 16x16 tiles; every thread starts with a contiguous run of
+// tiles and steals from the others once its own run is empty, so uneven tiles
+// (glass, sky) do not leave cores idle. Rays are traced through the same BVH
+// that the shaders walk.
+class CpuTracer {
+public:
+  // The first row and the number of rows of a finished band.
+  using RowsCallback = std::function<void(uint32_t first, uint32_t rows)>;
+
+  CpuTracer(const RenderSettings &settings, const CameraCB &camera,
+            const SceneObjects &objects);
+
+  // threadCount <= 0 uses every hardware thread. pixels receives the mean of
+  // num_samples samples per pixel, bottom row first like the GPU buffer.
+  CpuRenderStats Render(int threadCount, std::vector<XMFLOAT3> &pixels) const;
+  // The same through another camera. The scene and the BVH are read only, so
+  // any number of views may render at once.
+  CpuRenderStats Render(int threadCount, const CameraCB &camera,
+                        std::vector<XMFLOAT3> &pixels) const;
+  // The same, handing rows to onRows bottom row first as soon as every tile
+  // up to them is done, so that they can be written out while the rest of
+  // the image renders; their means are in pixels by then. The calls come
+  // from the workers one at a time. An exception from onRows stops further
+  // calls and is rethrown once the render is done.
+  CpuRenderStats Render(int threadCount, std::vector<XMFLOAT3> &pixels,
+                        const RowsCallback &onRows) const;
+
+  // The same in steps: Reset seeds acc, Accumulate adds numSamples samples to
+  // every pixel that adaptive sampling has not retired, and Resolve turns the
+  // sums into the mean at any point.
+  void Reset(CpuAccumulation &acc) const;
+  CpuRenderStats Accumulate(int threadCount, uint32_t numSamples,
+                            CpuAccumulation &acc) const;
+  CpuRenderStats Accumulate(int threadCount, uint32_t numSamples,
+                            const CameraCB &camera, CpuAccumulation &acc) const;
+  static void Resolve(const CpuAccumulation &acc,
+                      std::vector<XMFLOAT3> &pixels);
+
+  void SetUseAvx(bool useAvx) { mUseAvx = useAvx && AvxSupported(); }
+  // Without the BVH every ray is tested against every sphere.
+  void SetUseBvh(bool useBvh) { mUseBvh = useBvh; }
+
+  size_t NodeCount() const { return mNodes.size(); }
+  const RenderSettings &Settings() const { return mSettings; }
+  const CameraCB &Camera() const { return mCamera; }
+
+  static bool AvxSupported();
+
+private:
+  // Accumulate, calling onTile (if set) after each tile from the worker
+  // that rendered it.
+  CpuRenderStats AccumulateTiles(
+      int threadCount, uint32_t numSamples, const CameraCB &camera,
+      CpuAccumulation &acc,
+      const std::function<void(uint32_t tile)> &onTile) const;
+  // Adds samples acc.samples to acc.samples + numSamples - 1 of the tile's
+  // pixels. bounce_rays has max_depth entries and counts the rays traced per
+  // depth.
+  void RenderTile(uint32_t tile, uint32_t numSamples, const CameraCB &camera,
+                  CpuAccumulation &acc, uint64_t *bounce_rays) const;
+  // TRACE_WAVEFRONT: the tile's paths advance one bounce at a time, see
+  // wavefront.hlsli. A pixel that converges partway through a batch drops the
+  // rest of its samples in it.
+  void RenderTileWavefront(uint32_t tile, uint32_t numSamples,
+                           const CameraCB &camera, CpuAccumulation &acc,
+                           uint64_t *bounce_rays) const;
+  XMFLOAT3 Trace(CpuRay ray, Rng &rng, uint64_t *bounce_rays) const;
+  // TRACE_PER_DEPTH: keeps max_depth + 1 colors and multiplies them back
+  // down like the background and backward shaders.
+  XMFLOAT3 TracePerDepth(CpuRay ray, Rng &rng, uint64_t *bounce_rays,
+                         std::vector<XMFLOAT3> &colors) const;
+  // Forward step number depth. On a hit color is the attenuation, ray
+  // becomes the scattered ray and the sphere index is returned; on a miss
+  // color is the sky and -1 is returned.
+  int Bounce(CpuRay &ray, Rng &rng, uint32_t depth, XMFLOAT3 &color) const;
+  int ClosestHit(const CpuRay &ray, float &t_closest) const;
+  int HitLanes(uint32_t first, uint32_t count, const CpuRay &ray,
+               float &t_closest) const;
+
+  RenderSettings mSettings;
+  CameraCB mCamera;
+  // In BVH leaf order; every leaf covers whole entries of mLanes starting at
+  // mLeafLanes[node].
+  std::vector<Sphere> mSpheres;
+  std::vector<Material1> mMaterials;
+  std::vector<BvhNode> mNodes;
+  std::vector<SphereLanes> mLanes;
+  std::vector<uint32_t> mLeafLanes;
+  uint32_t mTilesX = 0;
+  uint32_t mTilesY = 0;
+  bool mUseAvx = false;
+  bool mUseBvh = true;
+};
+
+// Samples per second of the CPU backend from 1 thread up to maxThreads
+// (0 = every hardware thread), with the scalar and the AVX sphere test.
+void RunCpuTracerBenchmark(const RenderSettings &settings, int maxThreads = 0);
+
+// Live paths per bounce and samples per second of TRACE_WAVEFRONT against
+// TRACE_PATH.
+void RunWavefrontBenchmark(const RenderSettings &settings, int threadCount = 0);
+
+// Average samples per pixel and RMSE against a reference of 8x num_samples,
+// for uniform sampling at a few sample counts and for adaptive sampling at a
+// few thresholds.
+void RunAdaptiveBenchmark(const RenderSettings &settings, int threadCount = 0);
+
+// RMSE against a reference of 8x num_samples for independent random numbers
+// and for scrambled Sobol points, at the same few sample counts.
+void RunSamplerBenchmark(const RenderSettings &settings, int threadCount = 0);
+
+// BVH build time and rays per second from a hundred to a few hundred thousand
+// spheres, with the brute-force loop alongside while it is still affordable.
+void RunBvhBenchmark(const RenderSettings &settings, int threadCount = 0);
+
+// Renders the scene with the single-pass, the per-depth and the wavefront
+// formulation and compares them pixel by pixel. All of them draw the same
+// random numbers for the same pixel, sample and bounce, so they differ only by
+// float rounding; returns false (after printing the worst pixel) if any
+// channel is off by more than tolerance.
+bool CompareTraceModes(const RenderSettings &settings, int threadCount = 0,
+                       float tolerance = 1e-5f);
@@ -0,0 +1,76 @@
+// Compiled with AVX enabled (see RayTracingInOneWeekend.vcxproj); only called
+// after CpuTracer::AvxSupported() has checked the CPU.
+#include "CpuTracer.h"
+
+#if defined(__AVX__)
+
+#include <cmath>
+#include <immintrin.h>
+
+bool SphereLanesAvxCompiled() { return true; }
+
+int HitSphereLanesAvx(const SphereLanes &lanes, const CpuRay &ray,
+                      float &t_closest) {
+  const __m256 dx = _mm256_set1_ps(ray.dx);
+  const __m256 dy = _mm256_set1_ps(ray.dy);
+  const __m256 dz = _mm256_set1_ps(ray.dz);
+  const __m256 min_t = _mm256_set1_ps(MIN_T);
+  const __m256 max_t = _mm256_set1_ps(MAX_T);
+
+  __m256 ocx = _mm256_sub_ps(_mm256_set1_ps(ray.ox), _mm256_loadu_ps(lanes.cx));
+  __m256 ocy = _mm256_sub_ps(_mm256_set1_ps(ray.oy), _mm256_loadu_ps(lanes.cy));
+  __m256 ocz = _mm256_sub_ps(_mm256_set1_ps(ray.oz), _mm256_loadu_ps(lanes.cz));
+  __m256 r = _mm256_loadu_ps(lanes.radius);
+
+  __m256 a = _mm256_set1_ps(ray.dx * ray.dx + ray.dy * ray.dy + ray.dz * ray.dz);
+  __m256 half_b = _mm256_add_ps(
+      _mm256_add_ps(_mm256_mul_ps(ocx, dx), _mm256_mul_ps(ocy, dy)),
+      _mm256_mul_ps(ocz, dz));
+  __m256 c = _mm256_sub_ps(
+      _mm256_add_ps(
+          _mm256_add_ps(_mm256_mul_ps(ocx, ocx), _mm256_mul_ps(ocy, ocy)),
+          _mm256_mul_ps(ocz, ocz)),
+      _mm256_mul_ps(r, r));
+  __m256 discriminant =
+      _mm256_sub_ps(_mm256_mul_ps(half_b, half_b), _mm256_mul_ps(a, c));
+
+  __m256 hit = _mm256_cmp_ps(discriminant, _mm256_setzero_ps(), _CMP_GE_OQ);
+  __m256 sqrtd = _mm256_sqrt_ps(_mm256_max_ps(discriminant, _mm256_setzero_ps()));
+  __m256 neg_half_b = _mm256_sub_ps(_mm256_setzero_ps(), half_b);
+  __m256 t0 = _mm256_div_ps(_mm256_sub_ps(neg_half_b, sqrtd), a);
+  __m256 t1 = _mm256_div_ps(_mm256_add_ps(neg_half_b, sqrtd), a);
+  __m256 t0_ok = _mm256_and_ps(_mm256_cmp_ps(t0, min_t, _CMP_GE_OQ),
+                               _mm256_cmp_ps(t0, max_t, _CMP_LE_OQ));
+  __m256 t1_ok = _mm256_and_ps(_mm256_cmp_ps(t1, min_t, _CMP_GE_OQ),
+                               _mm256_cmp_ps(t1, max_t, _CMP_LE_OQ));
+  __m256 t = _mm256_blendv_ps(t1, t0, t0_ok);
+  hit = _mm256_and_ps(hit, _mm256_or_ps(t0_ok, t1_ok));
+  hit = _mm256_and_ps(hit, _mm256_cmp_ps(t, _mm256_set1_ps(t_closest), _CMP_LT_OQ));
+
+  int mask = _mm256_movemask_ps(hit) & ((1 << lanes.count) - 1);
+  if (!mask)
+    return -1;
+
+  // Nearest lane, lowest index first on ties.
+  alignas(32) float ts[SPHERE_LANES];
+  _mm256_store_ps(ts, t);
+  int hit_lane = -1;
+  for (int i = 0; i < SPHERE_LANES; i++) {
+    if ((mask >> i & 1) && ts[i] < t_closest) {
+      t_closest = ts[i];
+      hit_lane = i;
+    }
+  }
+  return hit_lane;
+}
+
+#else
+
+bool SphereLanesAvxCompiled() { return false; }
+
+int HitSphereLanesAvx(const SphereLanes &lanes, const CpuRay &ray,
+                      float &t_closest) {
+  return HitSphereLanes(lanes, ray, t_closest);
+}
+
+#endif
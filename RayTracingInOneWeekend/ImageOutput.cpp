@@ -0,0 +1,552 @@
+#include "ImageOutput.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define IMAGE_OUTPUT_SSE 1
+#include <emmintrin.h>
+#endif
+
+// Rows converted per write for the streamed formats.
+#define IMAGE_BAND_ROWS 16
+
+namespace {
+
+inline void put16(std::vector<uint8_t> &out, uint32_t v) {
+  out.push_back(uint8_t(v));
+  out.push_back(uint8_t(v >> 8));
+}
+
+inline void put32(std::vector<uint8_t> &out, uint32_t v) {
+  put16(out, v & 0xffff);
+  put16(out, v >> 16);
+}
+
+inline void put64(std::vector<uint8_t> &out, uint64_t v) {
+  put32(out, uint32_t(v));
+  put32(out, uint32_t(v >> 32));
+}
+
+inline void putFloat(std::vector<uint8_t> &out, float f) {
+  uint32_t v;
+  memcpy(&v, &f, sizeof(v));
+  put32(out, v);
+}
+
+inline void putString(std::vector<uint8_t> &out, const char *s) {
+  out.insert(out.end(), s, s + strlen(s) + 1);
+}
+
+// The conversion the bmp output always did, one channel at a time. Also
+// takes the pixels left over after the last group of four.
+void ToneMapPixelsScalar(const XMFLOAT3 *pixels, size_t count,
+                         uint32_t tonemap, bool bgr, uint8_t *bytes) {
+  for (size_t i = 0; i < count; i++) {
+    float c[3] = {pixels[i].x, pixels[i].y, pixels[i].z};
+    for (int k = 0; k < 3; k++) {
+      float v = tonemap == TONEMAP_GAMMA ? std::sqrt(std::max(c[k], 0.f)) : c[k];
+      bytes[3 * i + (bgr ? 2 - k : k)] =
+          static_cast<uint8_t>(256 * std::max(std::min(v, 0.999f), 0.f));
+    }
+  }
+}
+
+// Bytes of one line of an 8-bit image, padded to 4 for BMP.
+inline size_t lineBytes(uint32_t format, uint32_t width) {
+  return format == IMAGE_FORMAT_BMP ? (3 * size_t(width) + 3) & ~size_t(3)
+                                    : 3 * size_t(width);
+}
+
+// Tone maps a whole image into bytes, top row first as PNG wants it.
+void ToneMapImage(const XMFLOAT3 *pixels, uint32_t width, uint32_t height,
+                  uint32_t tonemap, std::vector<uint8_t> &bytes) {
+  bytes.resize(3 * size_t(width) * height);
+  for (uint32_t y = 0; y < height; y++) {
+    ToneMapPixels(pixels + size_t(y) * width, width, tonemap, false,
+                  bytes.data() + 3 * size_t(height - 1 - y) * width);
+  }
+}
+
+void WritePng(const std::string &path, const std::vector<uint8_t> &bytes,
+              uint32_t width, uint32_t height) {
+  if (!stbi_write_png(path.c_str(), (int)width, (int)height, 3, bytes.data(),
+                      (int)(3 * width))) {
+    throw std::runtime_error("cannot write " + path);
+  }
+}
+
+} // namespace
+
+uint32_t ImageFormatFromPath(const std::string &path) {
+  size_t dot = path.rfind('.');
+  std::string ext = dot == std::string::npos ? "" : path.substr(dot + 1);
+  for (char &c : ext)
+    c = (char)tolower((unsigned char)c);
+  if (ext == "png")
+    return IMAGE_FORMAT_PNG;
+  if (ext == "pfm")
+    return IMAGE_FORMAT_PFM;
+  if (ext == "exr")
+    return IMAGE_FORMAT_EXR;
+  return IMAGE_FORMAT_BMP;
+}
+
+void ToneMapPixels(const XMFLOAT3 *pixels, size_t count, uint32_t tonemap,
+                   bool bgr, uint8_t *bytes) {
+  size_t i = 0;
+#ifdef IMAGE_OUTPUT_SSE
+  // Four pixels are twelve floats in three registers, converted together
+  // since the channels do not matter until the bytes are stored.
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(0.999f);
+  const __m128 scale = _mm_set1_ps(256.f);
+  const float *src = &pixels[0].x;
+  for (; i + 4 <= count; i += 4) {
+    __m128 a = _mm_loadu_ps(src + 3 * i);     // r0 g0 b0 r1
+    __m128 b = _mm_loadu_ps(src + 3 * i + 4); // g1 b1 r2 g2
+    __m128 c = _mm_loadu_ps(src + 3 * i + 8); // b2 r3 g3 b3
+    if (bgr) {
+      __m128 t = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 0, 0));
+      __m128 ab = _mm_shuffle_ps(b, a, _MM_SHUFFLE(3, 3, 0, 0));
+      __m128 cb = _mm_shuffle_ps(c, b, _MM_SHUFFLE(3, 3, 0, 0));
+      __m128 bc = _mm_shuffle_ps(b, c, _MM_SHUFFLE(3, 3, 2, 2));
+      a = _mm_shuffle_ps(a, t, _MM_SHUFFLE(2, 0, 1, 2));    // b0 g0 r0 b1
+      b = _mm_shuffle_ps(ab, cb, _MM_SHUFFLE(2, 0, 2, 0));  // g1 r1 b2 g2
+      c = _mm_shuffle_ps(bc, c, _MM_SHUFFLE(1, 2, 2, 0));   // r2 b3 g3 r3
+    }
+    if (tonemap == TONEMAP_GAMMA) {
+      a = _mm_sqrt_ps(_mm_max_ps(a, zero));
+      b = _mm_sqrt_ps(_mm_max_ps(b, zero));
+      c = _mm_sqrt_ps(_mm_max_ps(c, zero));
+    }
+    __m128i ia = _mm_cvttps_epi32(_mm_mul_ps(_mm_max_ps(_mm_min_ps(a, one), zero), scale));
+    __m128i ib = _mm_cvttps_epi32(_mm_mul_ps(_mm_max_ps(_mm_min_ps(b, one), zero), scale));
+    __m128i ic = _mm_cvttps_epi32(_mm_mul_ps(_mm_max_ps(_mm_min_ps(c, one), zero), scale));
+    __m128i packed = _mm_packus_epi16(_mm_packs_epi32(ia, ib),
+                                      _mm_packs_epi32(ic, ic));
+    alignas(16) uint8_t out[16];
+    _mm_store_si128(reinterpret_cast<__m128i *>(out), packed);
+    memcpy(bytes + 3 * i, out, 12);
+  }
+#endif
+  ToneMapPixelsScalar(pixels + i, count - i, tonemap, bgr, bytes + 3 * i);
+}
+
+ImageWriter::ImageWriter(const std::string &path, uint32_t width,
+                         uint32_t height, uint32_t tonemap)
+    : mPath(path), mFormat(ImageFormatFromPath(path)), mWidth(width),
+      mHeight(height), mTonemap(tonemap) {
+  if (mFormat == IMAGE_FORMAT_PNG) {
+    mBytes.resize(3 * size_t(width) * height);
+    return;
+  }
+  mFile = fopen(path.c_str(), "wb");
+  if (!mFile)
+    throw std::runtime_error("cannot open " + path);
+
+  std::vector<uint8_t> header;
+  if (mFormat == IMAGE_FORMAT_BMP) {
+    // BITMAPFILEHEADER and BITMAPINFOHEADER; a positive height means the
+    // rows are stored bottom-up.
+    uint32_t image_size = uint32_t(lineBytes(mFormat, width) * height);
+    header.push_back('B');
+    header.push_back('M');
+    put32(header, 54 + image_size);
+    put32(header, 0);
+    put32(header, 54);
+    put32(header, 40);
+    put32(header, width);
+    put32(header, height);
+    put16(header, 1);
+    put16(header, 24);
+    put32(header, 0);
+    put32(header, image_size);
+    put32(header, 2835);
+    put32(header, 2835);
+    put32(header, 0);
+    put32(header, 0);
+    mBytes.resize(lineBytes(mFormat, width) * IMAGE_BAND_ROWS);
+  } else if (mFormat == IMAGE_FORMAT_PFM) {
+    // Color PFM: rows bottom-up, a negative scale for little-endian floats.
+    char text[64];
+    int n = snprintf(text, sizeof(text), "PF\n%u %u\n-1.0\n", width, height);
+    header.assign(text, text + n);
+  } else {
+    // Single-part scanline OpenEXR with uncompressed 32-bit float B, G and R
+    // channels (sorted by name, as the format requires). DECREASING_Y lets
+    // the bottom row be written first without seeking.
+    put32(header, 20000630);
+    put32(header, 2);
+    putString(header, "channels");
+    putString(header, "chlist");
+    put32(header, 3 * 18 + 1);
+    for (const char *name : {"B", "G", "R"}) {
+      putString(header, name);
+      put32(header, 2); // FLOAT
+      put32(header, 0); // pLinear and reserved
+      put32(header, 1);
+      put32(header, 1);
+    }
+    header.push_back(0);
+    putString(header, "compression");
+    putString(header, "compression");
+    put32(header, 1);
+    header.push_back(0); // NO_COMPRESSION
+    for (const char *window : {"dataWindow", "displayWindow"}) {
+      putString(header, window);
+      putString(header, "box2i");
+      put32(header, 16);
+      put32(header, 0);
+      put32(header, 0);
+      put32(header, width - 1);
+      put32(header, height - 1);
+    }
+    putString(header, "lineOrder");
+    putString(header, "lineOrder");
+    put32(header, 1);
+    header.push_back(1); // DECREASING_Y
+    putString(header, "pixelAspectRatio");
+    putString(header, "float");
+    put32(header, 4);
+    putFloat(header, 1.f);
+    putString(header, "screenWindowCenter");
+    putString(header, "v2f");
+    put32(header, 8);
+    putFloat(header, 0.f);
+    putFloat(header, 0.f);
+    putString(header, "screenWindowWidth");
+    putString(header, "float");
+    put32(header, 4);
+    putFloat(header, 1.f);
+    header.push_back(0);
+
+    // Offsets of the scanlines by y, top row (y = 0) first. Every chunk is
+    // its y, its size and the line's three channel planes.
+    size_t line = 12 * size_t(width);
+    uint64_t first = header.size() + 8 * uint64_t(height);
+    for (uint32_t y = 0; y < height; y++)
+      put64(header, first + uint64_t(height - 1 - y) * (8 + line));
+    mBytes.resize(8 + line);
+  }
+  Write(header.data(), header.size());
+}
+
+ImageWriter::~ImageWriter() {
+  if (mFile)
+    fclose(mFile);
+}
+
+void ImageWriter::Write(const void *data, size_t size) {
+  if (fwrite(data, 1, size, mFile) != size)
+    throw std::runtime_error("cannot write " + mPath);
+}
+
+void ImageWriter::WriteRows(const XMFLOAT3 *pixels, uint32_t rows) {
+  rows = std::min(rows, mHeight - mRow);
+  switch (mFormat) {
+  case IMAGE_FORMAT_PNG:
+    for (uint32_t r = 0; r < rows; r++) {
+      ToneMapPixels(pixels + size_t(r) * mWidth, mWidth, mTonemap, false,
+                    mBytes.data() + 3 * size_t(mHeight - 1 - mRow - r) * mWidth);
+    }
+    break;
+  case IMAGE_FORMAT_PFM:
+    Write(pixels, sizeof(XMFLOAT3) * mWidth * size_t(rows));
+    break;
+  case IMAGE_FORMAT_EXR:
+    for (uint32_t r = 0; r < rows; r++) {
+      const XMFLOAT3 *row = pixels + size_t(r) * mWidth;
+      int32_t y = int32_t(mHeight - 1 - mRow - r);
+      int32_t size = int32_t(12 * mWidth);
+      memcpy(mBytes.data(), &y, 4);
+      memcpy(mBytes.data() + 4, &size, 4);
+      float *b = reinterpret_cast<float *>(mBytes.data() + 8);
+      float *g = b + mWidth;
+      float *red = g + mWidth;
+      for (uint32_t x = 0; x < mWidth; x++) {
+        b[x] = row[x].z;
+        g[x] = row[x].y;
+        red[x] = row[x].x;
+      }
+      Write(mBytes.data(), mBytes.size());
+    }
+    break;
+  case IMAGE_FORMAT_BMP:
+  default: {
+    size_t line = lineBytes(mFormat, mWidth);
+    for (uint32_t r0 = 0; r0 < rows; r0 += IMAGE_BAND_ROWS) {
+      uint32_t band = std::min(rows - r0, (uint32_t)IMAGE_BAND_ROWS);
+      for (uint32_t r = 0; r < band; r++) {
+        ToneMapPixels(pixels + size_t(r0 + r) * mWidth, mWidth, mTonemap, true,
+                      mBytes.data() + r * line);
+      }
+      Write(mBytes.data(), band * line);
+    }
+    break;
+  }
+  }
+  mRow += rows;
+}
+
+void ImageWriter::Close() {
+  if (mFormat == IMAGE_FORMAT_PNG) {
+    WritePng(mPath, mBytes, mWidth, mHeight);
+    mBytes = std::vector<uint8_t>();
+    return;
+  }
+  if (!mFile)
+    return;
+  // Rows never written stay black.
+  std::vector<XMFLOAT3> black(mWidth, XMFLOAT3(0.f, 0.f, 0.f));
+  while (mRow < mHeight)
+    WriteRows(black.data(), 1);
+  FILE *file = mFile;
+  mFile = nullptr;
+  if (fclose(file) != 0)
+    throw std::runtime_error("cannot write " + mPath);
+}
+
+ImageOutput::~ImageOutput() {
+  try {
+    Wait();
+  } catch (std::exception &e) {
+    fprintf(stderr, "%s\n", e.what());
+  }
+}
+
+void ImageOutput::Write(const std::string &path,
+                        const std::vector<XMFLOAT3> &pixels, uint32_t width,
+                        uint32_t height) {
+  Wait();
+  if (ImageFormatFromPath(path) != IMAGE_FORMAT_PNG) {
+    ImageWriter writer(path, width, height, mTonemap);
+    writer.WriteRows(pixels.data(), height);
+    writer.Close();
+    return;
+  }
+  ToneMapImage(pixels.data(), width, height, mTonemap, mBytes);
+  mPending = std::async(std::launch::async, [this, path, width, height] {
+    WritePng(path, mBytes, width, height);
+  });
+}
+
+void ImageOutput::Wait() {
+  if (mPending.valid())
+    mPending.get();
+}
+
+namespace {
+
+bool readFile(const std::string &path, std::vector<uint8_t> &data) {
+  FILE *f = fopen(path.c_str(), "rb");
+  if (!f)
+    return false;
+  uint8_t buffer[65536];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+    data.insert(data.end(), buffer, buffer + n);
+  fclose(f);
+  return true;
+}
+
+// Pixels of a PFM as ImageWriter writes it, bottom row first.
+bool readPfm(const std::string &path, uint32_t width, uint32_t height,
+             std::vector<XMFLOAT3> &pixels) {
+  std::vector<uint8_t> data;
+  if (!readFile(path, data))
+    return false;
+  char text[64];
+  int n = snprintf(text, sizeof(text), "PF\n%u %u\n-1.0\n", width, height);
+  size_t bytes = sizeof(XMFLOAT3) * size_t(width) * height;
+  if (data.size() != n + bytes || memcmp(data.data(), text, n) != 0)
+    return false;
+  pixels.resize(size_t(width) * height);
+  memcpy(pixels.data(), data.data() + n, bytes);
+  return true;
+}
+
+// Pixels of an uncompressed B, G, R float scanline EXR, bottom row first.
+// Follows the offset table rather than assuming the chunks are in order.
+bool readExr(const std::string &path, uint32_t width, uint32_t height,
+             std::vector<XMFLOAT3> &pixels) {
+  std::vector<uint8_t> data;
+  if (!readFile(path, data) || data.size() < 8)
+    return false;
+  auto get32 = [&](size_t at) {
+    uint32_t v;
+    memcpy(&v, data.data() + at, 4);
+    return v;
+  };
+  if (get32(0) != 20000630)
+    return false;
+  // Attributes: name, type, size and value, up to an empty name.
+  size_t at = 8;
+  while (at < data.size() && data[at] != 0) {
+    for (int z = 0; z < 2; z++)
+      at = size_t(std::find(data.begin() + at, data.end(), 0) - data.begin()) + 1;
+    if (at + 4 > data.size())
+      return false;
+    at += 4 + get32(at);
+  }
+  at++;
+
+  size_t line = 12 * size_t(width);
+  pixels.resize(size_t(width) * height);
+  for (uint32_t y = 0; y < height; y++) {
+    uint64_t offset;
+    if (at + 8 * (y + 1) > data.size())
+      return false;
+    memcpy(&offset, data.data() + at + 8 * size_t(y), 8);
+    if (offset + 8 + line > data.size() || get32(offset) != y ||
+        get32(offset + 4) != line)
+      return false;
+    const uint8_t *planes = data.data() + offset + 8;
+    XMFLOAT3 *row = pixels.data() + size_t(height - 1 - y) * width;
+    for (uint32_t x = 0; x < width; x++) {
+      memcpy(&row[x].z, planes + 4 * size_t(x), 4);
+      memcpy(&row[x].y, planes + 4 * size_t(width + x), 4);
+      memcpy(&row[x].x, planes + 4 * size_t(2 * width + x), 4);
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+bool ImageRoundTrip() {
+  bool ok = true;
+
+  // Values around both ends of the clamp and in between.
+  std::vector<XMFLOAT3> colors(67);
+  for (size_t i = 0; i < colors.size(); i++) {
+    float u = 1.6f * toUnitFloat(pcgHash(uint32_t(3 * i))) - 0.3f;
+    float v = 1.6f * toUnitFloat(pcgHash(uint32_t(3 * i + 1))) - 0.3f;
+    float w = 1.6f * toUnitFloat(pcgHash(uint32_t(3 * i + 2))) - 0.3f;
+    colors[i] = XMFLOAT3(u, v, w);
+  }
+  colors[0] = XMFLOAT3(0.f, 0.999f, 1.f);
+  colors[1] = XMFLOAT3(-0.f, 0.998f, 0.0039f);
+  for (uint32_t tonemap : {TONEMAP_CLAMP, TONEMAP_GAMMA}) {
+    for (bool bgr : {false, true}) {
+      for (size_t count : {1u, 3u, 4u, 7u, 13u, 66u, 67u}) {
+        // Offset by one pixel as well, so the loads are unaligned.
+        for (size_t first : {0u, 1u}) {
+          if (first + count > colors.size())
+            continue;
+          std::vector<uint8_t> simd(3 * count), scalar(3 * count);
+          ToneMapPixels(colors.data() + first, count, tonemap, bgr,
+                        simd.data());
+          ToneMapPixelsScalar(colors.data() + first, count, tonemap, bgr,
+                              scalar.data());
+          if (simd != scalar) {
+            size_t at = size_t(
+                std::mismatch(simd.begin(), simd.end(), scalar.begin()).first -
+                simd.begin());
+            printf("  tone map %s%s, %zu pixels from %zu: byte %zu is %u, "
+                   "scalar %u\n",
+                   tonemap == TONEMAP_GAMMA ? "gamma" : "clamp",
+                   bgr ? " bgr" : "", count, first, at, simd[at], scalar[at]);
+            ok = false;
+          }
+        }
+      }
+    }
+  }
+  printf("  tone map: %s\n", ok ? "ok" : "FAILED");
+
+  // Rows handed over in uneven bands, as a renderer finishing tiles would.
+  const uint32_t width = 37, height = 23;
+  std::vector<XMFLOAT3> pixels(size_t(width) * height);
+  for (size_t i = 0; i < pixels.size(); i++)
+    pixels[i] = colors[i % colors.size()];
+  pixels[5].x = 1e30f;
+  for (const char *ext : {"pfm", "exr"}) {
+    std::string path = std::string("image_roundtrip.") + ext;
+    {
+      ImageWriter writer(path, width, height);
+      uint32_t row = 0;
+      for (uint32_t band : {1u, 16u, 5u, 1u}) {
+        writer.WriteRows(pixels.data() + size_t(row) * width, band);
+        row += band;
+      }
+      writer.Close();
+    }
+    std::vector<XMFLOAT3> loaded;
+    bool read = ImageFormatFromPath(path) == IMAGE_FORMAT_PFM
+                    ? readPfm(path, width, height, loaded)
+                    : readExr(path, width, height, loaded);
+    remove(path.c_str());
+    bool same = read && loaded.size() == pixels.size() &&
+                memcmp(loaded.data(), pixels.data(),
+                       sizeof(XMFLOAT3) * pixels.size()) == 0;
+    printf("  %s: %s\n", ext,
+           same ? "ok" : read ? "FAILED, pixels differ" : "FAILED to read");
+    ok = ok && same;
+  }
+  return ok;
+}
+
+void RunOutputBenchmark() {
+  struct Frame {
+    const char *name;
+    uint32_t width, height;
+  };
+  printf("  frame   format     MB   write s   caller s\n");
+  for (Frame frame : {Frame{"4K", 3840, 2160}, Frame{"8K", 7680, 4320}}) {
+    // A smooth gradient with some per-pixel noise on top, which is about
+    // what a progressive render looks like to a PNG encoder.
+    size_t count = size_t(frame.width) * frame.height;
+    std::vector<XMFLOAT3> pixels(count);
+    for (uint32_t y = 0; y < frame.height; y++) {
+      for (uint32_t x = 0; x < frame.width; x++) {
+        uint32_t idx = y * frame.width + x;
+        float noise = 0.1f * toUnitFloat(pcgHash(idx));
+        pixels[idx] = XMFLOAT3(float(x) / frame.width + noise,
+                               float(y) / frame.height + noise, 0.5f + noise);
+      }
+    }
+
+    std::vector<uint8_t> bytes(3 * count);
+    auto time = [](auto fn) {
+      auto start = std::chrono::high_resolution_clock::now();
+      fn();
+      auto stop = std::chrono::high_resolution_clock::now();
+      return std::chrono::duration<double>(stop - start).count();
+    };
+    double scalar = time([&] {
+      ToneMapPixelsScalar(pixels.data(), count, TONEMAP_CLAMP, true,
+                          bytes.data());
+    });
+    double simd = time([&] {
+      ToneMapPixels(pixels.data(), count, TONEMAP_CLAMP, true, bytes.data());
+    });
+    printf("  %-5s   tone map: scalar %.1f ms, SSE %.1f ms (x%.1f)\n",
+           frame.name, 1e3 * scalar, 1e3 * simd, scalar / simd);
+
+    for (const char *ext : {"bmp", "png", "pfm", "exr"}) {
+      std::string path = std::string("output_bench.") + ext;
+      ImageOutput output;
+      double caller = 0.0;
+      double total = time([&] {
+        caller = time([&] {
+          output.Write(path, pixels, frame.width, frame.height);
+        });
+        output.Wait();
+      });
+      double mb = 0.0;
+      if (FILE *f = fopen(path.c_str(), "rb")) {
+        fseek(f, 0, SEEK_END);
+        mb = ftell(f) / 1e6;
+        fclose(f);
+      }
+      remove(path.c_str());
+      printf("  %-5s   %-6s %7.1f %9.3f %10.3f\n", frame.name, ext, mb, total,
+             caller);
+    }
+  }
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "Scene.h"
+#include <cstdint>
+#include <cstdio>
+#include <future>
+#include <string>
+#include <vector>
+
+// Writing rendered images. 8-bit formats go through ToneMapPixels, which
+// clamps (and with TONEMAP_GAMMA takes the square root of) four pixels at a
+// time in SSE registers; .pfm and .exr keep the linear floats as they are.
+
+#define IMAGE_FORMAT_BMP 0
+#define IMAGE_FORMAT_PNG 1
+#define IMAGE_FORMAT_PFM 2
+#define IMAGE_FORMAT_EXR 3
+
+// Format from the extension of path, IMAGE_FORMAT_BMP for anything unknown.
+uint32_t ImageFormatFromPath(const std::string &path);
+
+// Converts count linear colors to 3 bytes each: min(max(c, 0), 0.999) * 256,
+// truncated, after a square root with TONEMAP_GAMMA. bgr swaps red and blue.
+void ToneMapPixels(const XMFLOAT3 *pixels, size_t count, uint32_t tonemap,
+                   bool bgr, uint8_t *bytes);
+
+// Writes an image a band of rows at a time, bottom row first, the order
+// pixels are kept in. BMP, PFM and EXR rows go to the file as they come, so
+// only one band of converted pixels exists at any time and a renderer can
+// hand over rows as it finishes them. PNG needs the whole image for its
+// filter and deflate pass and is encoded by Close. Throws std::runtime_error
+// if the file cannot be written.
+class ImageWriter {
+public:
+  ImageWriter(const std::string &path, uint32_t width, uint32_t height,
+              uint32_t tonemap = TONEMAP_CLAMP);
+  ImageWriter(const ImageWriter &) = delete;
+  ImageWriter &operator=(const ImageWriter &) = delete;
+  ~ImageWriter();
+
+  // The next rows (width pixels each) above those written so far.
+  void WriteRows(const XMFLOAT3 *pixels, uint32_t rows);
+  void Close();
+
+private:
+  void Write(const void *data, size_t size);
+
+  std::string mPath;
+  uint32_t mFormat;
+  uint32_t mWidth;
+  uint32_t mHeight;
+  uint32_t mTonemap;
+  uint32_t mRow = 0;
+  FILE *mFile = nullptr;
+  // One converted band for BMP and EXR, the whole image top row first for PNG.
+  std::vector<uint8_t> mBytes;
+};
+
+// Writes whole images as ImageWriter does, but encodes PNGs on a background
+// thread so that rendering carries on meanwhile. The tone-mapped bytes are
+// made on the calling thread, so pixels may change as soon as Write returns.
+// One image is in flight at a time: Write first waits for the previous one,
+// which keeps a single 8-bit copy of the image alive.
+class ImageOutput {
+public:
+  explicit ImageOutput(uint32_t tonemap = TONEMAP_CLAMP) : mTonemap(tonemap) {}
+  ImageOutput(const ImageOutput &) = delete;
+  ImageOutput &operator=(const ImageOutput &) = delete;
+  ~ImageOutput();
+
+  void Write(const std::string &path, const std::vector<XMFLOAT3> &pixels,
+             uint32_t width, uint32_t height);
+  // Waits for the image in flight and rethrows its error, if any.
+  void Wait();
+
+private:
+  uint32_t mTonemap;
+  std::vector<uint8_t> mBytes;
+  std::future<void> mPending;
+};
+
+// Compares ToneMapPixels with the scalar conversion for both tone maps, both
+// channel orders and counts that leave a remainder after the groups of four,
+// then writes PFM and EXR images in uneven bands and reads them back; returns
+// false (after printing what differed) unless every byte and float matches.
+bool ImageRoundTrip();
+
+// Seconds spent converting and writing synthetic 4K and 8K frames in every
+// format, the scalar and SSE tone mapping on their own, and how long Write
+// blocks the caller for a PNG.
+void RunOutputBenchmark();
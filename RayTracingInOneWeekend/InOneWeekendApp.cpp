@@ -1,7 +1,8 @@
 #include "InOneWeekendApp.h"
-#include <random>
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include <stb_image_write.h>
+#include "ImageOutput.h"
+#include "Progressive.h"
+#include <chrono>
+#include <cstdio>
 
 void InOneWeekendApp::OnInit() {
   ComputeApp::OnInit();
@@ -14,20 +15,11 @@ void InOneWeekendApp::OnInit() {
 
 void InOneWeekendApp::OnCompute() {
   ComputeApp::OnCompute();
-  // init random
-  {
-    std::mt19937 rng{std::random_device{}()};
-    UINT *mappedData = nullptr;
-    ThrowIfFailed(mRandomUploadBuffer->Map(
-        0, nullptr, reinterpret_cast<void **>(&mappedData)));
-    for (UINT idx = 0; idx < mImageWidth * mImageHeight; idx++) {
-      mappedData[idx] = rng();
-    }
-    mRandomUploadBuffer->Unmap(0, nullptr);
-  }
 
-  // set constantbuffer
-  int *imageCBMapped = nullptr;
+  // set constantbuffer, one ImageCB per sample since they are all read when
+  // the command list runs
+  UINT imageCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ImageCB));
+  BYTE *imageCBMapped = nullptr;
   ThrowIfFailed(mImageCBUploadBuffer->Map(
       0, nullptr, reinterpret_cast<void **>(&imageCBMapped)));
   {
@@ -37,179 +29,448 @@ void InOneWeekendApp::OnCompute() {
     memcpy(mapped, &mCameraCB, sizeof(mCameraCB));
     mCameraCBUploadBuffer->Unmap(0, nullptr);
   }
-  {
-    int *mapped = nullptr;
-    ThrowIfFailed(mObjectCBUploadBuffer->Map(
-        0, nullptr, reinterpret_cast<void **>(&mapped)));
-    //mObjectCB.num_objs = 4;
-    memcpy(mapped, &mObjectCB, sizeof(mObjectCB));
-    mCameraCBUploadBuffer->Unmap(0, nullptr);
-  }
 
   // reset cmdList
   ThrowIfFailed(mCmdAlloc->Reset());
   ThrowIfFailed(mCmdList->Reset(mCmdAlloc.Get(), nullptr));
 
   // upload
-  mCmdList->ResourceBarrier(
-      1, &CD3DX12_RESOURCE_BARRIER::Transition(mRandomBuffer.Get(),
-                                               D3D12_RESOURCE_STATE_COMMON,
-                                               D3D12_RESOURCE_STATE_COPY_DEST));
-  mCmdList->CopyResource(mRandomBuffer.Get(), mRandomUploadBuffer.Get());
-  mCmdList->ResourceBarrier(
-      1, &CD3DX12_RESOURCE_BARRIER::Transition(mRandomBuffer.Get(),
-                                               D3D12_RESOURCE_STATE_COPY_DEST,
-                                               D3D12_RESOURCE_STATE_COMMON));
+  mSphereBuffer = d3dUtil::CreateDefaultBuffer(
+      mDevice.Get(), mCmdList.Get(), mObjects.spheres.data(),
+      mObjects.spheres.size() * sizeof(Sphere), mSphereUploadBuffer);
+  mMaterialBuffer = d3dUtil::CreateDefaultBuffer(
+      mDevice.Get(), mCmdList.Get(), mObjects.materials.data(),
+      mObjects.materials.size() * sizeof(Material1), mMaterialUploadBuffer);
+  mBvhNodeBuffer = d3dUtil::CreateDefaultBuffer(
+      mDevice.Get(), mCmdList.Get(), mBvhNodes.data(),
+      mBvhNodes.size() * sizeof(BvhNode), mBvhNodeUploadBuffer);
+
+  // Render in batches, each flushed and written out on its own, so there is
+  // an image to look at early and the render can stop once it is converged.
+  // Samples keep their ImageCB slot across batches, and the pixel buffer
+  // keeps the running blend.
+  std::vector<XMFLOAT3> pixels, previous;
+  std::vector<uint32_t> counts, previousCounts;
+  ImageOutput output(mSettings.tonemap);
+  UINT done = 0;
+  UINT batch = 1;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (UINT b = 0; done < mNumSamples; b++) {
+    auto batchStart = std::chrono::high_resolution_clock::now();
+    if (b > 0) {
+      ThrowIfFailed(mCmdAlloc->Reset());
+      ThrowIfFailed(mCmdList->Reset(mCmdAlloc.Get(), nullptr));
+    }
+
+    for (UINT i = done; i < done + batch; i++) {
+      // reset image constantbuffer
+      mImageCB.image_width = mImageWidth;
+      mImageCB.image_height = mImageHeight;
+      mImageCB.sample_idx = i;
+      mImageCB.num_samples = mNumSamples;
+      mImageCB.max_depth = mMaxDepth;
+      mImageCB.adaptive_min_samples = mSettings.adaptive_min_samples;
+      mImageCB.adaptive_threshold = mSettings.adaptive_threshold;
+      mImageCB.seed = mSettings.seed;
+      mImageCB.sampler = mSettings.sampler;
+      memcpy(imageCBMapped + i * imageCBByteSize, &mImageCB, sizeof(mImageCB));
+
+      D3D12_GPU_VIRTUAL_ADDRESS imageCB =
+          mImageCBUploadBuffer->GetGPUVirtualAddress() + i * imageCBByteSize;
+      if (mSettings.trace_mode == TRACE_PER_DEPTH) {
+        RecordPerDepthPasses(imageCB);
+      } else if (mSettings.trace_mode == TRACE_WAVEFRONT) {
+        RecordWavefrontPasses(imageCB, i);
+      } else {
+        RecordPathPass(imageCB);
+      }
+    }
+
+    // download
+    mCmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
+                                     mPixelBuffer.Get(),
+                                     D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+                                     D3D12_RESOURCE_STATE_COPY_SOURCE));
+    mCmdList->CopyResource(mPixelReadbackBuffer.Get(), mPixelBuffer.Get());
+    mCmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
+                                     mStatsBuffer.Get(),
+                                     D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+                                     D3D12_RESOURCE_STATE_COPY_SOURCE));
+    mCmdList->CopyResource(mStatsReadbackBuffer.Get(), mStatsBuffer.Get());
+    mCmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
+                                     mStatsBuffer.Get(),
+                                     D3D12_RESOURCE_STATE_COPY_SOURCE,
+                                     D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+    if (mSettings.trace_mode == TRACE_WAVEFRONT) {
+      mCmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
+                                       mLiveHistoryBuffer.Get(),
+                                       D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+                                       D3D12_RESOURCE_STATE_COPY_SOURCE));
+      mCmdList->CopyResource(mLiveHistoryReadbackBuffer.Get(),
+                             mLiveHistoryBuffer.Get());
+      mCmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
+                                       mLiveHistoryBuffer.Get(),
+                                       D3D12_RESOURCE_STATE_COPY_SOURCE,
+                                       D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+    }
+    mCmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
+                                     mPixelBuffer.Get(),
+                                     D3D12_RESOURCE_STATE_COPY_SOURCE,
+                                     D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+
+    // flush cmdList
+    ThrowIfFailed(mCmdList->Close());
+    ID3D12CommandList *cmdLists[] = {mCmdList.Get()};
+    mCmdQueue->ExecuteCommandLists(_countof(cmdLists), cmdLists);
+    FlushCommandQueue();
+
+    // readback color
+    {
+      XMFLOAT3 *mappedData = nullptr;
+      ThrowIfFailed(mPixelReadbackBuffer->Map(
+          0, nullptr, reinterpret_cast<void **>(&mappedData)));
+      pixels.assign(mappedData, mappedData + mImageWidth * mImageHeight);
+      mPixelReadbackBuffer->Unmap(0, nullptr);
+      output.Write(mSettings.output_path, pixels, mImageWidth, mImageHeight);
+    }
+
+    // readback per-pixel sample counts; with --adaptive, retired pixels took
+    // fewer than batch samples, or none
+    {
+      PixelStats *mappedData = nullptr;
+      ThrowIfFailed(mStatsReadbackBuffer->Map(
+          0, nullptr, reinterpret_cast<void **>(&mappedData)));
+      counts.resize(pixels.size());
+      for (size_t p = 0; p < counts.size(); p++)
+        counts[p] = mappedData[p].count;
+      mStatsReadbackBuffer->Unmap(0, nullptr);
+    }
+
+    // The batch on its own is independent of the samples before it, which
+    // is what ConvergenceError needs.
+    float error = INFINITY;
+    if (done > 0) {
+      // Every pixel divides by its own counts, as in Progressive.cpp; a
+      // pixel that took no samples this batch contributes no difference.
+      std::vector<XMFLOAT3> batchMean(pixels.size());
+      for (size_t p = 0; p < pixels.size(); p++) {
+        float total = float(counts[p]), before = float(previousCounts[p]);
+        if (counts[p] <= previousCounts[p]) {
+          batchMean[p] = previous[p];
+          continue;
+        }
+        float added = total - before;
+        batchMean[p] =
+            XMFLOAT3((total * pixels[p].x - before * previous[p].x) / added,
+                     (total * pixels[p].y - before * previous[p].y) / added,
+                     (total * pixels[p].z - before * previous[p].z) / added);
+      }
+      error = ConvergenceError(previous, done, batchMean, batch);
+    }
+    done += batch;
+    auto now = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(now - batchStart).count();
+    printf("batch %3u: +%4u = %4u spp, %6.2f s, error %.4f\n", b + 1, batch,
+           done, std::chrono::duration<double>(now - start).count(), error);
+    if (mSettings.error_threshold > 0.f && error < mSettings.error_threshold) {
+      break;
+    }
+    batch = NextBatchSamples(batch, seconds, mSettings.batch_budget_ms,
+                             mNumSamples - done);
+    previous.swap(pixels);
+    previousCounts.swap(counts);
+  }
+  output.Wait();
+  if (mSettings.adaptive_threshold > 0.f) {
+    PrintAdaptiveStats(done);
+  }
+  if (mSettings.trace_mode == TRACE_WAVEFRONT) {
+    PrintLivePaths(done);
+  }
+}
+
+void InOneWeekendApp::RecordPathPass(D3D12_GPU_VIRTUAL_ADDRESS imageCB) {
+  CD3DX12_RESOURCE_BARRIER barriers[] = {
+      CD3DX12_RESOURCE_BARRIER::UAV(mPixelBuffer.Get()),
+      CD3DX12_RESOURCE_BARRIER::UAV(mStatsBuffer.Get())};
+  mCmdList->ResourceBarrier(_countof(barriers), barriers);
+  mCmdList->SetPipelineState(mPathPipelineState.Get());
+  mCmdList->SetComputeRootSignature(mPathRootSignature.Get());
+  mCmdList->SetComputeRootConstantBufferView(0, imageCB);
+  mCmdList->SetComputeRootConstantBufferView(
+      1, mCameraCBUploadBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootShaderResourceView(
+      2, mSphereBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootShaderResourceView(
+      3, mMaterialBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootShaderResourceView(
+      4, mBvhNodeBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      5, mPixelBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      6, mStatsBuffer->GetGPUVirtualAddress());
+  mCmdList->Dispatch((mImageWidth + 15) / 16, (mImageHeight + 15) / 16, 1);
+}
 
+void InOneWeekendApp::RecordPerDepthPasses(
+    D3D12_GPU_VIRTUAL_ADDRESS imageCB) {
   std::vector<CD3DX12_RESOURCE_BARRIER> barriers;
-  for (UINT i = 0; i < mNumSamples; i++) {
-    // reset image constantbuffer
-    mImageCB.image_width = mImageWidth;
-    mImageCB.image_height = mImageHeight;
-    mImageCB.sample_idx = i;
-    mImageCB.num_samples = mNumSamples;
-    memcpy(imageCBMapped, &mImageCB, sizeof(mImageCB));
 
-    // generateRay
+  // generateRay
+  barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mRayBuffer.Get()));
+  barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mValidBuffer.Get()));
+  mCmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+  mCmdList->SetPipelineState(mGenerateRayPipelineState.Get());
+  mCmdList->SetComputeRootSignature(mGenerateRayRootSignature.Get());
+  mCmdList->SetComputeRootConstantBufferView(0, imageCB);
+  mCmdList->SetComputeRootConstantBufferView(
+      1, mCameraCBUploadBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      2, mRayBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      3, mValidBuffer->GetGPUVirtualAddress());
+  mCmdList->Dispatch((mImageWidth + 15) / 16, (mImageHeight + 15) / 16, 1);
+
+  // foward
+  for (UINT d = 0; d < mMaxDepth; d++) {
     barriers.clear();
+    barriers.push_back(
+        CD3DX12_RESOURCE_BARRIER::UAV(mAllColorBuffers[d].Get()));
     barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mRayBuffer.Get()));
     barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mValidBuffer.Get()));
-    barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mRandomBuffer.Get()));
     mCmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
-    mCmdList->SetPipelineState(mGenerateRayPipelineState.Get());
-    mCmdList->SetComputeRootSignature(mGenerateRayRootSignature.Get());
-    mCmdList->SetComputeRootConstantBufferView(
-        0, mImageCBUploadBuffer->GetGPUVirtualAddress());
-    mCmdList->SetComputeRootConstantBufferView(
-        1, mCameraCBUploadBuffer->GetGPUVirtualAddress());
+
+    mCmdList->SetPipelineState(mForwardPipelineState.Get());
+    mCmdList->SetComputeRootSignature(mForwardRootSignature.Get());
+    mCmdList->SetComputeRootConstantBufferView(0, imageCB);
+    mCmdList->SetComputeRootShaderResourceView(
+        1, mSphereBuffer->GetGPUVirtualAddress());
+    mCmdList->SetComputeRootShaderResourceView(
+        2, mMaterialBuffer->GetGPUVirtualAddress());
+    mCmdList->SetComputeRootShaderResourceView(
+        3, mBvhNodeBuffer->GetGPUVirtualAddress());
     mCmdList->SetComputeRootUnorderedAccessView(
-        2, mRayBuffer->GetGPUVirtualAddress());
+        4, mAllColorBuffers[d]->GetGPUVirtualAddress());
     mCmdList->SetComputeRootUnorderedAccessView(
-        3, mValidBuffer->GetGPUVirtualAddress());
+        5, mRayBuffer->GetGPUVirtualAddress());
     mCmdList->SetComputeRootUnorderedAccessView(
-        4, mRandomBuffer->GetGPUVirtualAddress());
+        6, mValidBuffer->GetGPUVirtualAddress());
+    mCmdList->SetComputeRoot32BitConstant(7, d, 0);
     mCmdList->Dispatch((mImageWidth + 15) / 16, (mImageHeight + 15) / 16, 1);
+  }
 
-    // foward
-    for (UINT d = 0; d < mMaxDepth; d++) {
-      barriers.clear();
-      barriers.push_back(
-          CD3DX12_RESOURCE_BARRIER::UAV(mAllColorBuffers[d].Get()));
-      barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mRayBuffer.Get()));
-      barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mValidBuffer.Get()));
-      barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mRandomBuffer.Get()));
-      mCmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
-
-      mCmdList->SetPipelineState(mForwardPipelineState.Get());
-      mCmdList->SetComputeRootSignature(mForwardRootSignature.Get());
-      mCmdList->SetComputeRootConstantBufferView(
-          0, mImageCBUploadBuffer->GetGPUVirtualAddress());
-      mCmdList->SetComputeRootConstantBufferView(
-          1, mObjectCBUploadBuffer->GetGPUVirtualAddress());
-      mCmdList->SetComputeRootUnorderedAccessView(
-          2, mAllColorBuffers[d]->GetGPUVirtualAddress());
-      mCmdList->SetComputeRootUnorderedAccessView(
-          3, mRayBuffer->GetGPUVirtualAddress());
-      mCmdList->SetComputeRootUnorderedAccessView(
-          4, mValidBuffer->GetGPUVirtualAddress());
-      mCmdList->SetComputeRootUnorderedAccessView(
-          5, mRandomBuffer->GetGPUVirtualAddress());
-      mCmdList->Dispatch((mImageWidth + 15) / 16, (mImageHeight + 15) / 16, 1);
-    }
+  // background
+  barriers.clear();
+  barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mValidBuffer.Get()));
+  barriers.push_back(
+      CD3DX12_RESOURCE_BARRIER::UAV(mAllColorBuffers[mMaxDepth].Get()));
+  mCmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+  mCmdList->SetPipelineState(mBackgroundPipelineState.Get());
+  mCmdList->SetComputeRootSignature(mBackgroundRootSignature.Get());
+  mCmdList->SetComputeRootConstantBufferView(0, imageCB);
+  mCmdList->SetComputeRootUnorderedAccessView(
+      1, mValidBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      2, mAllColorBuffers[mMaxDepth]->GetGPUVirtualAddress());
+  mCmdList->Dispatch((mImageWidth + 15) / 16, (mImageHeight + 15) / 16, 1);
 
-    // background
+  // backward
+  for (UINT d = mMaxDepth; d > 0; d--) {
     barriers.clear();
-    barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mValidBuffer.Get()));
     barriers.push_back(
-        CD3DX12_RESOURCE_BARRIER::UAV(mAllColorBuffers[mMaxDepth].Get()));
+        CD3DX12_RESOURCE_BARRIER::UAV(mAllColorBuffers[d].Get()));
+    barriers.push_back(
+        CD3DX12_RESOURCE_BARRIER::UAV(mAllColorBuffers[d - 1].Get()));
     mCmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
-    mCmdList->SetPipelineState(mBackgroundPipelineState.Get());
-    mCmdList->SetComputeRootSignature(mBackgroundRootSignature.Get());
-    mCmdList->SetComputeRootConstantBufferView(
-        0, mImageCBUploadBuffer->GetGPUVirtualAddress());
+    mCmdList->SetPipelineState(mBackwardPipelineState.Get());
+    mCmdList->SetComputeRootSignature(mBackwardRootSignature.Get());
+    mCmdList->SetComputeRootConstantBufferView(0, imageCB);
     mCmdList->SetComputeRootUnorderedAccessView(
-        1, mValidBuffer->GetGPUVirtualAddress());
+        1, mAllColorBuffers[d]->GetGPUVirtualAddress());
     mCmdList->SetComputeRootUnorderedAccessView(
-        2, mAllColorBuffers[mMaxDepth]->GetGPUVirtualAddress());
+        2, mAllColorBuffers[d - 1]->GetGPUVirtualAddress());
     mCmdList->Dispatch((mImageWidth + 15) / 16, (mImageHeight + 15) / 16, 1);
+  }
 
-    // backward
-    for (UINT d = mMaxDepth; d > 0; d--) {
-      barriers.clear();
-      barriers.push_back(
-          CD3DX12_RESOURCE_BARRIER::UAV(mAllColorBuffers[d].Get()));
-      barriers.push_back(
-          CD3DX12_RESOURCE_BARRIER::UAV(mAllColorBuffers[d - 1].Get()));
-      mCmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
-      mCmdList->SetPipelineState(mBackwardPipelineState.Get());
-      mCmdList->SetComputeRootSignature(mBackwardRootSignature.Get());
-      mCmdList->SetComputeRootConstantBufferView(
-          0, mImageCBUploadBuffer->GetGPUVirtualAddress());
-      mCmdList->SetComputeRootUnorderedAccessView(
-          1, mAllColorBuffers[d]->GetGPUVirtualAddress());
-      mCmdList->SetComputeRootUnorderedAccessView(
-          2, mAllColorBuffers[d - 1]->GetGPUVirtualAddress());
-      mCmdList->Dispatch((mImageWidth + 15) / 16, (mImageHeight + 15) / 16, 1);
-    }
+  // blend
+  barriers.clear();
+  barriers.push_back(
+      CD3DX12_RESOURCE_BARRIER::UAV(mAllColorBuffers[0].Get()));
+  barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mPixelBuffer.Get()));
+  barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mStatsBuffer.Get()));
+  mCmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+  mCmdList->SetPipelineState(mBlendPipelineState.Get());
+  mCmdList->SetComputeRootSignature(mBlendRootSignature.Get());
+  mCmdList->SetComputeRootConstantBufferView(0, imageCB);
+  mCmdList->SetComputeRootUnorderedAccessView(
+      1, mAllColorBuffers[0]->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      2, mPixelBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      3, mStatsBuffer->GetGPUVirtualAddress());
+  mCmdList->Dispatch((mImageWidth + 15) / 16, (mImageHeight + 15) / 16, 1);
+}
 
-    // blend
-    barriers.clear();
-    barriers.push_back(
-        CD3DX12_RESOURCE_BARRIER::UAV(mAllColorBuffers[0].Get()));
-    barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(mPixelBuffer.Get()));
-    mCmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
-    mCmdList->SetPipelineState(mBlendPipelineState.Get());
-    mCmdList->SetComputeRootSignature(mBlendRootSignature.Get());
-    mCmdList->SetComputeRootConstantBufferView(
-        0, mImageCBUploadBuffer->GetGPUVirtualAddress());
+void InOneWeekendApp::RecordWavefrontPasses(D3D12_GPU_VIRTUAL_ADDRESS imageCB,
+                                            UINT sample) {
+  // Every stage reads what the one before wrote, and most of them touch the
+  // counters, so a full UAV barrier goes between all of them.
+  CD3DX12_RESOURCE_BARRIER uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(nullptr);
+  CD3DX12_RESOURCE_BARRIER toIndirect = CD3DX12_RESOURCE_BARRIER::Transition(
+      mDispatchArgsBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+      D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+  CD3DX12_RESOURCE_BARRIER toUav = CD3DX12_RESOURCE_BARRIER::Transition(
+      mDispatchArgsBuffer.Get(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT,
+      D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+  auto args = [&](UINT stage, UINT historySlot) {
+    mCmdList->ResourceBarrier(1, &uavBarrier);
+    mCmdList->SetPipelineState(mWfArgsPipelineState.Get());
+    mCmdList->SetComputeRootSignature(mWfArgsRootSignature.Get());
+    mCmdList->SetComputeRoot32BitConstant(0, stage, 0);
+    mCmdList->SetComputeRoot32BitConstant(0, historySlot, 1);
     mCmdList->SetComputeRootUnorderedAccessView(
-        1, mAllColorBuffers[0]->GetGPUVirtualAddress());
+        1, mCounterBuffer->GetGPUVirtualAddress());
     mCmdList->SetComputeRootUnorderedAccessView(
-        2, mPixelBuffer->GetGPUVirtualAddress());
-    mCmdList->Dispatch((mImageWidth + 15) / 16, (mImageHeight + 15) / 16, 1);
+        2, mDispatchArgsBuffer->GetGPUVirtualAddress());
+    mCmdList->SetComputeRootUnorderedAccessView(
+        3, mLiveHistoryBuffer->GetGPUVirtualAddress());
+    mCmdList->Dispatch(1, 1, 1);
+    CD3DX12_RESOURCE_BARRIER barriers[] = {uavBarrier, toIndirect};
+    mCmdList->ResourceBarrier(_countof(barriers), barriers);
+  };
+
+  // generate
+  args(2, 0);
+  mCmdList->ResourceBarrier(1, &toUav);
+  mCmdList->SetPipelineState(mWfGeneratePipelineState.Get());
+  mCmdList->SetComputeRootSignature(mWfGenerateRootSignature.Get());
+  mCmdList->SetComputeRootConstantBufferView(0, imageCB);
+  mCmdList->SetComputeRootConstantBufferView(
+      1, mCameraCBUploadBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      2, mPathQueueBuffers[0]->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      3, mRadianceBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      4, mCounterBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      5, mStatsBuffer->GetGPUVirtualAddress());
+  mCmdList->Dispatch((mImageWidth + 15) / 16, (mImageHeight + 15) / 16, 1);
+
+  for (UINT d = 0; d < mMaxDepth; d++) {
+    ID3D12Resource *pathsIn = mPathQueueBuffers[d % 2].Get();
+    ID3D12Resource *pathsOut = mPathQueueBuffers[(d + 1) % 2].Get();
+
+    // extend, sized by the live paths the last bounce left
+    args(0, sample * mMaxDepth + d);
+    mCmdList->SetPipelineState(mWfExtendPipelineState.Get());
+    mCmdList->SetComputeRootSignature(mWfExtendRootSignature.Get());
+    mCmdList->SetComputeRootConstantBufferView(0, imageCB);
+    mCmdList->SetComputeRootShaderResourceView(
+        1, mSphereBuffer->GetGPUVirtualAddress());
+    mCmdList->SetComputeRootShaderResourceView(
+        2, mMaterialBuffer->GetGPUVirtualAddress());
+    mCmdList->SetComputeRootShaderResourceView(
+        3, mBvhNodeBuffer->GetGPUVirtualAddress());
+    mCmdList->SetComputeRootUnorderedAccessView(
+        4, mCounterBuffer->GetGPUVirtualAddress());
+    mCmdList->SetComputeRootUnorderedAccessView(
+        5, pathsIn->GetGPUVirtualAddress());
+    mCmdList->SetComputeRootUnorderedAccessView(
+        6, mHitBuffer->GetGPUVirtualAddress());
+    mCmdList->SetComputeRootUnorderedAccessView(
+        7, mMaterialQueueBuffer->GetGPUVirtualAddress());
+    mCmdList->SetComputeRootUnorderedAccessView(
+        8, mRadianceBuffer->GetGPUVirtualAddress());
+    mCmdList->ExecuteIndirect(
+        mDispatchCommandSignature.Get(), 1, mDispatchArgsBuffer.Get(),
+        WF_ARGS_EXTEND * sizeof(D3D12_DISPATCH_ARGUMENTS), nullptr, 0);
+    mCmdList->ResourceBarrier(1, &toUav);
+
+    // shade, one queue per material
+    args(1, 0);
+    mCmdList->SetComputeRootSignature(mWfShadeRootSignature.Get());
+    mCmdList->SetComputeRootConstantBufferView(0, imageCB);
+    mCmdList->SetComputeRootShaderResourceView(
+        1, mMaterialBuffer->GetGPUVirtualAddress());
+    mCmdList->SetComputeRootUnorderedAccessView(
+        2, mCounterBuffer->GetGPUVirtualAddress());
+    mCmdList->SetComputeRootUnorderedAccessView(
+        3, pathsIn->GetGPUVirtualAddress());
+    mCmdList->SetComputeRootUnorderedAccessView(
+        4, mHitBuffer->GetGPUVirtualAddress());
+    mCmdList->SetComputeRootUnorderedAccessView(
+        5, mMaterialQueueBuffer->GetGPUVirtualAddress());
+    mCmdList->SetComputeRootUnorderedAccessView(
+        6, pathsOut->GetGPUVirtualAddress());
+    for (UINT m = 0; m < NUM_MATERIALS; m++) {
+      mCmdList->SetPipelineState(mWfShadePipelineStates[m].Get());
+      mCmdList->ExecuteIndirect(
+          mDispatchCommandSignature.Get(), 1, mDispatchArgsBuffer.Get(),
+          WF_ARGS_SHADE(m) * sizeof(D3D12_DISPATCH_ARGUMENTS), nullptr, 0);
+    }
+    mCmdList->ResourceBarrier(1, &toUav);
   }
 
-  // download
-  mCmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-                                   mPixelBuffer.Get(),
-                                   D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
-                                   D3D12_RESOURCE_STATE_COPY_SOURCE));
-  mCmdList->CopyResource(mPixelReadbackBuffer.Get(), mPixelBuffer.Get());
+  // blend
+  mCmdList->ResourceBarrier(1, &uavBarrier);
+  mCmdList->SetPipelineState(mBlendPipelineState.Get());
+  mCmdList->SetComputeRootSignature(mBlendRootSignature.Get());
+  mCmdList->SetComputeRootConstantBufferView(0, imageCB);
+  mCmdList->SetComputeRootUnorderedAccessView(
+      1, mRadianceBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      2, mPixelBuffer->GetGPUVirtualAddress());
+  mCmdList->SetComputeRootUnorderedAccessView(
+      3, mStatsBuffer->GetGPUVirtualAddress());
+  mCmdList->Dispatch((mImageWidth + 15) / 16, (mImageHeight + 15) / 16, 1);
+}
 
-  // flush cmdList
-  ThrowIfFailed(mCmdList->Close());
-  ID3D12CommandList *cmdLists[] = {mCmdList.Get()};
-  mCmdQueue->ExecuteCommandLists(_countof(cmdLists), cmdLists);
-  FlushCommandQueue();
+void InOneWeekendApp::PrintAdaptiveStats(UINT numSamples) {
+  PixelStats *mappedData = nullptr;
+  ThrowIfFailed(mStatsReadbackBuffer->Map(
+      0, nullptr, reinterpret_cast<void **>(&mappedData)));
+  UINT numPixels = mImageWidth * mImageHeight;
+  UINT64 spent = 0;
+  UINT retired = 0;
+  for (UINT i = 0; i < numPixels; i++) {
+    spent += mappedData[i].count;
+    retired += mappedData[i].active == 0;
+  }
+  mStatsReadbackBuffer->Unmap(0, nullptr);
 
-  // readback color
-  {
-    XMFLOAT3 *mappedData = nullptr;
-    ThrowIfFailed(mPixelReadbackBuffer->Map(
-        0, nullptr, reinterpret_cast<void **>(&mappedData)));
-    std::vector<unsigned char> imageData(3 * mImageWidth * mImageHeight);
-    for (size_t y = 0; y < mImageHeight; y++) {
-      for (size_t x = 0; x < mImageWidth; x++) {
-        const auto &c = mappedData[y * mImageWidth + x];
-        auto r = static_cast<unsigned char>(256 * max(min(c.x, 0.999f), 0.f));
-        auto g = static_cast<unsigned char>(256 * max(min(c.y, 0.999f), 0.f));
-        auto b = static_cast<unsigned char>(256 * max(min(c.z, 0.999f), 0.f));
-        imageData[3 * (y * mImageWidth + x) + 0] = r;
-        imageData[3 * (y * mImageWidth + x) + 1] = g;
-        imageData[3 * (y * mImageWidth + x) + 2] = b;
-      }
+  printf("adaptive: %.1f spp on average of %u, %.1f%% of pixels converged\n",
+         double(spent) / numPixels, numSamples, 100.0 * retired / numPixels);
+}
+
+void InOneWeekendApp::PrintLivePaths(UINT numSamples) {
+  UINT *mappedData = nullptr;
+  ThrowIfFailed(mLiveHistoryReadbackBuffer->Map(
+      0, nullptr, reinterpret_cast<void **>(&mappedData)));
+  std::vector<UINT64> live(mMaxDepth, 0);
+  for (UINT i = 0; i < numSamples; i++) {
+    for (UINT d = 0; d < mMaxDepth; d++) {
+      live[d] += mappedData[i * mMaxDepth + d];
     }
-    mPixelReadbackBuffer->Unmap(0, nullptr);
-    stbi_flip_vertically_on_write(true);
-    stbi_write_bmp("image.bmp", mImageWidth, mImageHeight, 3, imageData.data());
   }
+  mLiveHistoryReadbackBuffer->Unmap(0, nullptr);
+
+  UINT64 launched = 0;
+  printf("depth   live paths per sample   of pixels\n");
+  for (UINT d = 0; d < mMaxDepth && live[d] > 0; d++) {
+    launched += live[d];
+    printf("%5u %23.1f %10.1f%%\n", d, double(live[d]) / numSamples,
+           100.0 * live[d] / live[0]);
+  }
+  printf("%.1f%% of the threads of full-screen bounces\n",
+         100.0 * launched / (double(live[0]) * mMaxDepth));
 }
 
 void InOneWeekendApp::InitConstant() {
-  mImageWidth = 256;
-  mImageHeight = 192;
-  mMaxDepth = 20;
-  mNumSamples = 100;
+  mImageWidth = mSettings.image_width;
+  mImageHeight = mSettings.image_height;
+  mMaxDepth = mSettings.max_depth;
+  mNumSamples = mSettings.num_samples;
 
   // Init ImageCB
   {
@@ -217,85 +478,16 @@ void InOneWeekendApp::InitConstant() {
     mImageCB.image_height = mImageHeight;
     mImageCB.num_samples = mNumSamples;
     mImageCB.sample_idx = 0;
+    mImageCB.max_depth = mMaxDepth;
+    mImageCB.adaptive_min_samples = mSettings.adaptive_min_samples;
+    mImageCB.adaptive_threshold = mSettings.adaptive_threshold;
+    mImageCB.seed = mSettings.seed;
+    mImageCB.sampler = mSettings.sampler;
   }
 
-  // Init CameraCB
-  {
-    XMFLOAT3 lookfrom(13, 2, 3);
-    XMFLOAT3 lookat(0, 0, 0);
-    XMFLOAT3 vup(0, 1, 0);
-    float dist_to_focus = 10.f;
-    float aperture = 0.1f;
-    float aspect_ratio =
-        static_cast<float>(mImageWidth) / static_cast<float>(mImageHeight);
-
-    float theta = XMConvertToRadians(20.f);
-    float h = std::tan(theta / 2.0f);
-    float viewport_height = 2.0f * h;
-    float viewport_width = aspect_ratio * viewport_height;
-
-    XMVECTOR lookfrom_v = XMLoadFloat3(&lookfrom);
-    XMVECTOR lookat_v = XMLoadFloat3(&lookat);
-    XMVECTOR vup_v = XMLoadFloat3(&vup);
-    XMVECTOR w_v = XMVector3Normalize(lookfrom_v - lookat_v);
-    XMVECTOR u_v = XMVector3Normalize(XMVector3Cross(vup_v, w_v));
-    XMVECTOR v_v = XMVector3Cross(w_v, u_v);
-    XMVECTOR horizontal_v = dist_to_focus * viewport_width * u_v;
-    XMVECTOR vertical_v = dist_to_focus * viewport_height * v_v;
-    XMVECTOR lower_left_corner_v = lookfrom_v - 0.5f * horizontal_v -
-                                   0.5f * vertical_v - dist_to_focus * w_v;
-
-    XMStoreFloat3(&mCameraCB.origin, lookfrom_v);
-    XMStoreFloat3(&mCameraCB.lower_left_corner, lower_left_corner_v);
-    XMStoreFloat3(&mCameraCB.horizontal, horizontal_v);
-    XMStoreFloat3(&mCameraCB.vertical, vertical_v);
-    XMStoreFloat3(&mCameraCB.u, u_v);
-    XMStoreFloat3(&mCameraCB.v, v_v);
-    XMStoreFloat3(&mCameraCB.w, w_v);
-    mCameraCB.lens_radius = aperture * 0.5f;
-  }
-
-  // Init ObjectCB
-  {
-    UINT obj_idx = 0;
-    std::mt19937 rng{std::random_device{}()};
-    std::uniform_real_distribution<float> unf(0.f, 1.f);
-    mObjectCB.spheres[obj_idx] = Sphere(XMFLOAT3(0.f, -1000.f, 0.f), 1000.f);
-    mObjectCB.materials[obj_idx] = Material1(XMFLOAT3(0.5f, 0.5f, 0.5f));
-    obj_idx++;
-
-    mObjectCB.spheres[obj_idx] = Sphere(XMFLOAT3(0.f, 1.f, 0.f), 1.f);
-    mObjectCB.materials[obj_idx] = Material1(1.5f);
-    obj_idx++;
-    mObjectCB.spheres[obj_idx] = Sphere(XMFLOAT3(-4.f, 1.f, 0.f), 1.f);
-    mObjectCB.materials[obj_idx] = Material1(XMFLOAT3(0.4f, 0.2f, 0.1f));
-    obj_idx++;
-    mObjectCB.spheres[obj_idx] = Sphere(XMFLOAT3(4.f, 1.f, 0.f), 1.f);
-    mObjectCB.materials[obj_idx] = Material1(XMFLOAT3(0.7f, 0.6f, 0.5f), 0.f);
-    obj_idx++;
-
-    for (int a = -5; a < 5; a++) {
-      for (int b = -5; b < 5; b++) {
-        XMFLOAT3 center(a + 0.9f + unf(rng), 0.2, b + 0.9f + unf(rng));
-        float choose_mat = unf(rng);
-        mObjectCB.spheres[obj_idx] = Sphere(center, 0.2f);
-        if (choose_mat < 0.8f) {
-          mObjectCB.materials[obj_idx] =
-              Material1(XMFLOAT3(unf(rng), unf(rng), unf(rng)));
-        } else if (choose_mat < 0.95f) {
-          mObjectCB.materials[obj_idx] =
-              Material1(XMFLOAT3(0.5f * unf(rng) + 0.5f, 0.5f * unf(rng) + 0.5f,
-                                 0.5f * unf(rng) + 0.5f),
-                        0.5f * unf(rng));
-        } else {
-          mObjectCB.materials[obj_idx] = Material1(1.5f);
-        }
-        obj_idx++;
-      }
-    }
-
-    mObjectCB.num_objs = obj_idx;
-  }
+  // Init CameraCB, scene and its BVH
+  BuildScene(mSettings, mCameraCB, mObjects);
+  mBvhNodes = BuildBvh(mObjects);
 }
 
 void InOneWeekendApp::CreateResource() {
@@ -303,7 +495,8 @@ void InOneWeekendApp::CreateResource() {
   ThrowIfFailed(mDevice->CreateCommittedResource(
       &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE,
       &CD3DX12_RESOURCE_DESC::Buffer(
-          d3dUtil::CalcConstantBufferByteSize(sizeof(ImageCB))),
+          d3dUtil::CalcConstantBufferByteSize(sizeof(ImageCB)) *
+          mNumSamples),
       D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
       IID_PPV_ARGS(&mImageCBUploadBuffer)));
   ThrowIfFailed(mDevice->CreateCommittedResource(
@@ -312,13 +505,43 @@ void InOneWeekendApp::CreateResource() {
           d3dUtil::CalcConstantBufferByteSize(sizeof(CameraCB))),
       D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
       IID_PPV_ARGS(&mCameraCBUploadBuffer)));
+
+  if (mSettings.trace_mode == TRACE_PER_DEPTH) {
+    CreatePerDepthResource();
+  } else if (mSettings.trace_mode == TRACE_WAVEFRONT) {
+    CreateWavefrontResource();
+  }
+
+  // create pixel buffer
   ThrowIfFailed(mDevice->CreateCommittedResource(
-      &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE,
+      &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
       &CD3DX12_RESOURCE_DESC::Buffer(
-          d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectCB))),
-      D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
-      IID_PPV_ARGS(&mObjectCBUploadBuffer)));
+          mImageWidth * mImageHeight * sizeof(XMFLOAT3),
+          D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+      D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&mPixelBuffer)));
+  ThrowIfFailed(mDevice->CreateCommittedResource(
+      &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
+      &CD3DX12_RESOURCE_DESC::Buffer(
+          mImageWidth * mImageHeight * sizeof(PixelStats),
+          D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+      D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&mStatsBuffer)));
+
+  // create corresponding readback buffer
+  ThrowIfFailed(mDevice->CreateCommittedResource(
+      &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK), D3D12_HEAP_FLAG_NONE,
+      &CD3DX12_RESOURCE_DESC::Buffer(
+          GetRequiredIntermediateSize(mPixelBuffer.Get(), 0, 1)),
+      D3D12_RESOURCE_STATE_COPY_DEST, nullptr,
+      IID_PPV_ARGS(&mPixelReadbackBuffer)));
+  ThrowIfFailed(mDevice->CreateCommittedResource(
+      &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK), D3D12_HEAP_FLAG_NONE,
+      &CD3DX12_RESOURCE_DESC::Buffer(
+          GetRequiredIntermediateSize(mStatsBuffer.Get(), 0, 1)),
+      D3D12_RESOURCE_STATE_COPY_DEST, nullptr,
+      IID_PPV_ARGS(&mStatsReadbackBuffer)));
+}
 
+void InOneWeekendApp::CreatePerDepthResource() {
   // create colorbuffers
   mAllColorBuffers.resize(mMaxDepth + 1);
   for (UINT i = 0; i < mMaxDepth + 1; i++) {
@@ -342,32 +565,8 @@ void InOneWeekendApp::CreateResource() {
           mImageWidth * mImageHeight * sizeof(Ray),
           D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
       D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&mRayBuffer)));
-  ThrowIfFailed(mDevice->CreateCommittedResource(
-      &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
-      &CD3DX12_RESOURCE_DESC::Buffer(
-          mImageWidth * mImageHeight * sizeof(UINT),
-          D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
-      D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&mRandomBuffer)));
-  ThrowIfFailed(mDevice->CreateCommittedResource(
-      &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
-      &CD3DX12_RESOURCE_DESC::Buffer(
-          mImageWidth * mImageHeight * sizeof(XMFLOAT3),
-          D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
-      D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&mPixelBuffer)));
 
-  // create corresponding readback, upload buffer
-  ThrowIfFailed(mDevice->CreateCommittedResource(
-      &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK), D3D12_HEAP_FLAG_NONE,
-      &CD3DX12_RESOURCE_DESC::Buffer(
-          GetRequiredIntermediateSize(mPixelBuffer.Get(), 0, 1)),
-      D3D12_RESOURCE_STATE_COPY_DEST, nullptr,
-      IID_PPV_ARGS(&mPixelReadbackBuffer)));
-  ThrowIfFailed(mDevice->CreateCommittedResource(
-      &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE,
-      &CD3DX12_RESOURCE_DESC::Buffer(
-          GetRequiredIntermediateSize(mRandomBuffer.Get(), 0, 1)),
-      D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
-      IID_PPV_ARGS(&mRandomUploadBuffer)));
+  // create corresponding readback buffer
   ThrowIfFailed(mDevice->CreateCommittedResource(
       &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK), D3D12_HEAP_FLAG_NONE,
       &CD3DX12_RESOURCE_DESC::Buffer(
@@ -382,27 +581,123 @@ void InOneWeekendApp::CreateResource() {
       IID_PPV_ARGS(&mValidReadbackBuffer)));
 }
 
+void InOneWeekendApp::CreateWavefrontResource() {
+  UINT numPixels = mImageWidth * mImageHeight;
+  auto createUav = [&](UINT64 byteSize, ComPtr<ID3D12Resource> &buffer) {
+    ThrowIfFailed(mDevice->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(
+            byteSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+        D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&buffer)));
+  };
+  createUav(numPixels * sizeof(WavefrontPath), mPathQueueBuffers[0]);
+  createUav(numPixels * sizeof(WavefrontPath), mPathQueueBuffers[1]);
+  createUav(numPixels * sizeof(WavefrontHit), mHitBuffer);
+  createUav(NUM_MATERIALS * numPixels * sizeof(UINT), mMaterialQueueBuffer);
+  createUav(numPixels * sizeof(XMFLOAT3), mRadianceBuffer);
+  createUav(WF_NUM_COUNTERS * sizeof(UINT), mCounterBuffer);
+  createUav(WF_NUM_ARGS * sizeof(D3D12_DISPATCH_ARGUMENTS),
+            mDispatchArgsBuffer);
+  createUav(mNumSamples * mMaxDepth * sizeof(UINT), mLiveHistoryBuffer);
+
+  // create corresponding readback buffer
+  ThrowIfFailed(mDevice->CreateCommittedResource(
+      &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK), D3D12_HEAP_FLAG_NONE,
+      &CD3DX12_RESOURCE_DESC::Buffer(mNumSamples * mMaxDepth * sizeof(UINT)),
+      D3D12_RESOURCE_STATE_COPY_DEST, nullptr,
+      IID_PPV_ARGS(&mLiveHistoryReadbackBuffer)));
+
+  // create command signature for the indirect dispatches
+  D3D12_INDIRECT_ARGUMENT_DESC argDesc = {};
+  argDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH;
+  D3D12_COMMAND_SIGNATURE_DESC sigDesc = {};
+  sigDesc.ByteStride = sizeof(D3D12_DISPATCH_ARGUMENTS);
+  sigDesc.NumArgumentDescs = 1;
+  sigDesc.pArgumentDescs = &argDesc;
+  ThrowIfFailed(mDevice->CreateCommandSignature(
+      &sigDesc, nullptr, IID_PPV_ARGS(&mDispatchCommandSignature)));
+}
+
 void InOneWeekendApp::CreateRootSignature() {
   std::vector<CD3DX12_ROOT_PARAMETER> params;
 
-  // create rootsignature for generate ray
-  params.resize(5);
+  // create rootsignature for path
+  params.resize(7);
+  params[0].InitAsConstantBufferView(0);
+  params[1].InitAsConstantBufferView(1);
+  params[2].InitAsShaderResourceView(0);
+  params[3].InitAsShaderResourceView(1);
+  params[4].InitAsShaderResourceView(2);
+  params[5].InitAsUnorderedAccessView(0);
+  params[6].InitAsUnorderedAccessView(1);
+  mPathRootSignature = d3dUtil::CreateRootSignature(
+      mDevice.Get(), (UINT)params.size(), params.data());
+
+  // create rootsignature for wavefront generate
+  params.resize(6);
   params[0].InitAsConstantBufferView(0);
   params[1].InitAsConstantBufferView(1);
   params[2].InitAsUnorderedAccessView(0);
   params[3].InitAsUnorderedAccessView(1);
   params[4].InitAsUnorderedAccessView(2);
-  mGenerateRayRootSignature = d3dUtil::CreateRootSignature(
+  params[5].InitAsUnorderedAccessView(3);
+  mWfGenerateRootSignature = d3dUtil::CreateRootSignature(
       mDevice.Get(), (UINT)params.size(), params.data());
 
-  // create rootsignature for forward
-  params.resize(6);
+  // create rootsignature for wavefront args
+  params.resize(4);
+  params[0].InitAsConstants(2, 0);
+  params[1].InitAsUnorderedAccessView(0);
+  params[2].InitAsUnorderedAccessView(1);
+  params[3].InitAsUnorderedAccessView(2);
+  mWfArgsRootSignature = d3dUtil::CreateRootSignature(
+      mDevice.Get(), (UINT)params.size(), params.data());
+
+  // create rootsignature for wavefront extend
+  params.resize(9);
   params[0].InitAsConstantBufferView(0);
-  params[1].InitAsConstantBufferView(1);
+  params[1].InitAsShaderResourceView(0);
+  params[2].InitAsShaderResourceView(1);
+  params[3].InitAsShaderResourceView(2);
+  params[4].InitAsUnorderedAccessView(0);
+  params[5].InitAsUnorderedAccessView(1);
+  params[6].InitAsUnorderedAccessView(2);
+  params[7].InitAsUnorderedAccessView(3);
+  params[8].InitAsUnorderedAccessView(4);
+  mWfExtendRootSignature = d3dUtil::CreateRootSignature(
+      mDevice.Get(), (UINT)params.size(), params.data());
+
+  // create rootsignature for wavefront shade, shared by every material
+  params.resize(7);
+  params[0].InitAsConstantBufferView(0);
+  params[1].InitAsShaderResourceView(0);
   params[2].InitAsUnorderedAccessView(0);
   params[3].InitAsUnorderedAccessView(1);
   params[4].InitAsUnorderedAccessView(2);
   params[5].InitAsUnorderedAccessView(3);
+  params[6].InitAsUnorderedAccessView(4);
+  mWfShadeRootSignature = d3dUtil::CreateRootSignature(
+      mDevice.Get(), (UINT)params.size(), params.data());
+
+  // create rootsignature for generate ray
+  params.resize(4);
+  params[0].InitAsConstantBufferView(0);
+  params[1].InitAsConstantBufferView(1);
+  params[2].InitAsUnorderedAccessView(0);
+  params[3].InitAsUnorderedAccessView(1);
+  mGenerateRayRootSignature = d3dUtil::CreateRootSignature(
+      mDevice.Get(), (UINT)params.size(), params.data());
+
+  // create rootsignature for forward
+  params.resize(8);
+  params[0].InitAsConstantBufferView(0);
+  params[1].InitAsShaderResourceView(0);
+  params[2].InitAsShaderResourceView(1);
+  params[3].InitAsShaderResourceView(2);
+  params[4].InitAsUnorderedAccessView(0);
+  params[5].InitAsUnorderedAccessView(1);
+  params[6].InitAsUnorderedAccessView(2);
+  params[7].InitAsConstants(1, 1);
   mForwardRootSignature = d3dUtil::CreateRootSignature(
       mDevice.Get(), (UINT)params.size(), params.data());
 
@@ -423,15 +718,26 @@ void InOneWeekendApp::CreateRootSignature() {
       mDevice.Get(), (UINT)params.size(), params.data());
 
   // create rootsignature for blend
-  params.resize(3);
+  params.resize(4);
   params[0].InitAsConstantBufferView(0);
   params[1].InitAsUnorderedAccessView(0);
   params[2].InitAsUnorderedAccessView(1);
+  params[3].InitAsUnorderedAccessView(2);
   mBlendRootSignature = d3dUtil::CreateRootSignature(
       mDevice.Get(), (UINT)params.size(), params.data());
 }
 
 void InOneWeekendApp::CreateComputeShader() {
+  mPathComputeShader = d3dUtil::LoadBinary(L"path.cso");
+  mWfGenerateComputeShader = d3dUtil::LoadBinary(L"wfGenerate.cso");
+  mWfArgsComputeShader = d3dUtil::LoadBinary(L"wfArgs.cso");
+  mWfExtendComputeShader = d3dUtil::LoadBinary(L"wfExtend.cso");
+  mWfShadeComputeShaders[MATERIAL_LAMBERTIAN] =
+      d3dUtil::LoadBinary(L"wfShadeLambertian.cso");
+  mWfShadeComputeShaders[MATERIAL_METAL] =
+      d3dUtil::LoadBinary(L"wfShadeMetal.cso");
+  mWfShadeComputeShaders[MATERIAL_GLASS] =
+      d3dUtil::LoadBinary(L"wfShadeGlass.cso");
   mGenerateRayComputeShader = d3dUtil::LoadBinary(L"generateRay.cso");
   mForwardComputeShader = d3dUtil::LoadBinary(L"forward.cso");
   mBackgroundComputeShader = d3dUtil::LoadBinary(L"background.cso");
@@ -442,6 +748,43 @@ void InOneWeekendApp::CreateComputeShader() {
 void InOneWeekendApp::CreatePipelineState() {
   D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
 
+  // path
+  psoDesc.pRootSignature = mPathRootSignature.Get();
+  psoDesc.CS.BytecodeLength = mPathComputeShader->GetBufferSize();
+  psoDesc.CS.pShaderBytecode = mPathComputeShader->GetBufferPointer();
+  ThrowIfFailed(mDevice->CreateComputePipelineState(
+      &psoDesc, IID_PPV_ARGS(&mPathPipelineState)));
+
+  // wavefront generate
+  psoDesc.pRootSignature = mWfGenerateRootSignature.Get();
+  psoDesc.CS.BytecodeLength = mWfGenerateComputeShader->GetBufferSize();
+  psoDesc.CS.pShaderBytecode = mWfGenerateComputeShader->GetBufferPointer();
+  ThrowIfFailed(mDevice->CreateComputePipelineState(
+      &psoDesc, IID_PPV_ARGS(&mWfGeneratePipelineState)));
+
+  // wavefront args
+  psoDesc.pRootSignature = mWfArgsRootSignature.Get();
+  psoDesc.CS.BytecodeLength = mWfArgsComputeShader->GetBufferSize();
+  psoDesc.CS.pShaderBytecode = mWfArgsComputeShader->GetBufferPointer();
+  ThrowIfFailed(mDevice->CreateComputePipelineState(
+      &psoDesc, IID_PPV_ARGS(&mWfArgsPipelineState)));
+
+  // wavefront extend
+  psoDesc.pRootSignature = mWfExtendRootSignature.Get();
+  psoDesc.CS.BytecodeLength = mWfExtendComputeShader->GetBufferSize();
+  psoDesc.CS.pShaderBytecode = mWfExtendComputeShader->GetBufferPointer();
+  ThrowIfFailed(mDevice->CreateComputePipelineState(
+      &psoDesc, IID_PPV_ARGS(&mWfExtendPipelineState)));
+
+  // wavefront shade
+  psoDesc.pRootSignature = mWfShadeRootSignature.Get();
+  for (UINT m = 0; m < NUM_MATERIALS; m++) {
+    psoDesc.CS.BytecodeLength = mWfShadeComputeShaders[m]->GetBufferSize();
+    psoDesc.CS.pShaderBytecode = mWfShadeComputeShaders[m]->GetBufferPointer();
+    ThrowIfFailed(mDevice->CreateComputePipelineState(
+        &psoDesc, IID_PPV_ARGS(&mWfShadePipelineStates[m])));
+  }
+
   // generateRay
   psoDesc.pRootSignature = mGenerateRayRootSignature.Get();
   psoDesc.CS.BytecodeLength = mGenerateRayComputeShader->GetBufferSize();
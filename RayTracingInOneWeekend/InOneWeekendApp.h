@@ -1,34 +1,7 @@
 #pragma once
 #include <Common/ComputeApp.h>
-#include <DirectXMath.h>
-
-#define MAX_NUM_OBJS 128
-#define MATERIAL_LAMBERTIAN 0
-#define MATERIAL_METAL 1
-#define MATERIAL_GLASS 2
-
-using namespace DirectX;
-
-struct Material1 {
-  int type;
-  float ir;
-  float fuzz;
-  UINT pad0;
-  XMFLOAT3 color;
-  UINT pad1;
-  Material1() = default;
-  Material1(const XMFLOAT3 &color) : type(MATERIAL_LAMBERTIAN), color(color) {}
-  Material1(const XMFLOAT3 &color, float fuzz)
-      : type(MATERIAL_METAL), color(color), fuzz(fuzz) {}
-  Material1(float ir) : type(MATERIAL_GLASS), color(1.f, 1.f, 1.f), ir(ir) {}
-};
-
-struct Sphere {
-  XMFLOAT3 center;
-  float radius;
-  Sphere() = default;
-  Sphere(const XMFLOAT3 &c, float r) : center(c), radius(r) {}
-};
+#include "Bvh.h"
+#include "Scene.h"
 
 struct Ray {
   XMFLOAT3 origin;
@@ -39,73 +12,117 @@ struct Ray {
   Ray(const XMFLOAT3 &o, const XMFLOAT3 &d) : origin(o), direction(d) {}
 };
 
-struct ImageCB {
-  UINT image_width;
-  UINT image_height;
-  UINT sample_idx;
-  UINT num_samples;
-};
+// Same as wavefront.hlsli.
+#define WF_GROUP_SIZE 64
+#define WF_NUM_COUNTERS 5
+#define WF_ARGS_EXTEND 0
+#define WF_ARGS_SHADE(m) (1 + (m))
+#define WF_NUM_ARGS 4
 
-struct CameraCB {
+struct WavefrontPath {
   XMFLOAT3 origin;
+  UINT pixel;
+  XMFLOAT3 direction;
+  UINT depth;
+  XMFLOAT3 throughput;
   UINT pad0;
-  XMFLOAT3 lower_left_corner;
-  UINT pad1;
-  XMFLOAT3 horizontal;
-  UINT pad2;
-  XMFLOAT3 vertical;
-  UINT pad3;
-  XMFLOAT3 u;
-  UINT pad4;
-  XMFLOAT3 v;
-  UINT pad5;
-  XMFLOAT3 w;
-  float lens_radius;
 };
 
-struct ObjectCB {
-  UINT num_objs;
-  UINT pad0[3];
-  Sphere spheres[MAX_NUM_OBJS];
-  Material1 materials[MAX_NUM_OBJS];
+struct WavefrontHit {
+  XMFLOAT3 pos;
+  UINT obj_id;
+  XMFLOAT3 normal;
+  UINT pad0;
 };
 
 class InOneWeekendApp : public ComputeApp {
 public:
+  explicit InOneWeekendApp(const RenderSettings &settings = RenderSettings())
+      : mSettings(settings) {}
+
   void OnInit() override;
   void OnCompute() override;
 
 private:
   void InitConstant();
   void CreateResource();
+  void CreatePerDepthResource();
+  void CreateWavefrontResource();
   void CreateRootSignature();
   void CreateComputeShader();
   void CreatePipelineState();
+  // Record one sample that reads imageCB.
+  void RecordPathPass(D3D12_GPU_VIRTUAL_ADDRESS imageCB);
+  void RecordPerDepthPasses(D3D12_GPU_VIRTUAL_ADDRESS imageCB);
+  void RecordWavefrontPasses(D3D12_GPU_VIRTUAL_ADDRESS imageCB, UINT sample);
+  // Samples actually taken per pixel and the share of converged pixels.
+  void PrintAdaptiveStats(UINT numSamples);
+  // Live paths per bounce over the first numSamples samples.
+  void PrintLivePaths(UINT numSamples);
 
+  RenderSettings mSettings;
   UINT mMaxDepth;
   UINT mImageWidth;
   UINT mImageHeight;
   UINT mNumSamples;
   ImageCB mImageCB;
   CameraCB mCameraCB;
-  ObjectCB mObjectCB;
+  SceneObjects mObjects;
+  std::vector<BvhNode> mBvhNodes;
 
-  // Buffers
+  // Buffers, the color, valid and ray buffers only with TRACE_PER_DEPTH
   std::vector<ComPtr<ID3D12Resource>> mAllColorBuffers;
   ComPtr<ID3D12Resource> mValidBuffer;
   ComPtr<ID3D12Resource> mRayBuffer;
-  ComPtr<ID3D12Resource> mRandomBuffer;
   ComPtr<ID3D12Resource> mPixelBuffer;
-  ComPtr<ID3D12Resource> mRandomUploadBuffer;
+  // PixelStats of every pixel, updated by the blend step of each trace_mode
+  ComPtr<ID3D12Resource> mStatsBuffer;
   ComPtr<ID3D12Resource> mPixelReadbackBuffer;
+  ComPtr<ID3D12Resource> mStatsReadbackBuffer;
   ComPtr<ID3D12Resource> mRayReadbackBuffer;
   ComPtr<ID3D12Resource> mValidReadbackBuffer;
 
+  // Wavefront queues, only with TRACE_WAVEFRONT. Bounces alternate between
+  // the two path queues; mLiveHistoryBuffer logs the live paths per bounce.
+  ComPtr<ID3D12Resource> mPathQueueBuffers[2];
+  ComPtr<ID3D12Resource> mHitBuffer;
+  ComPtr<ID3D12Resource> mMaterialQueueBuffer;
+  ComPtr<ID3D12Resource> mRadianceBuffer;
+  ComPtr<ID3D12Resource> mCounterBuffer;
+  ComPtr<ID3D12Resource> mDispatchArgsBuffer;
+  ComPtr<ID3D12Resource> mLiveHistoryBuffer;
+  ComPtr<ID3D12Resource> mLiveHistoryReadbackBuffer;
+  ComPtr<ID3D12CommandSignature> mDispatchCommandSignature;
+
+  // Scene, in BVH leaf order
+  ComPtr<ID3D12Resource> mSphereBuffer;
+  ComPtr<ID3D12Resource> mMaterialBuffer;
+  ComPtr<ID3D12Resource> mBvhNodeBuffer;
+  ComPtr<ID3D12Resource> mSphereUploadBuffer;
+  ComPtr<ID3D12Resource> mMaterialUploadBuffer;
+  ComPtr<ID3D12Resource> mBvhNodeUploadBuffer;
+
   // ConstantBuffers
   ComPtr<ID3D12Resource> mImageCBUploadBuffer;
   ComPtr<ID3D12Resource> mCameraCBUploadBuffer;
-  ComPtr<ID3D12Resource> mObjectCBUploadBuffer;
 
+  // path
+  ComPtr<ID3D12RootSignature> mPathRootSignature;
+  ComPtr<ID3DBlob> mPathComputeShader;
+  ComPtr<ID3D12PipelineState> mPathPipelineState;
+  // wavefront: generate, args, extend and one shade kernel per material
+  ComPtr<ID3D12RootSignature> mWfGenerateRootSignature;
+  ComPtr<ID3DBlob> mWfGenerateComputeShader;
+  ComPtr<ID3D12PipelineState> mWfGeneratePipelineState;
+  ComPtr<ID3D12RootSignature> mWfArgsRootSignature;
+  ComPtr<ID3DBlob> mWfArgsComputeShader;
+  ComPtr<ID3D12PipelineState> mWfArgsPipelineState;
+  ComPtr<ID3D12RootSignature> mWfExtendRootSignature;
+  ComPtr<ID3DBlob> mWfExtendComputeShader;
+  ComPtr<ID3D12PipelineState> mWfExtendPipelineState;
+  ComPtr<ID3D12RootSignature> mWfShadeRootSignature;
+  ComPtr<ID3DBlob> mWfShadeComputeShaders[NUM_MATERIALS];
+  ComPtr<ID3D12PipelineState> mWfShadePipelineStates[NUM_MATERIALS];
   // generateRay
   ComPtr<ID3D12RootSignature> mGenerateRayRootSignature;
   ComPtr<ID3DBlob> mGenerateRayComputeShader;
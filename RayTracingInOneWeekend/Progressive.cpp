@@ -0,0 +1,80 @@
+#include "Progressive.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+float ConvergenceError(const std::vector<XMFLOAT3> &a, uint32_t na,
+                       const std::vector<XMFLOAT3> &b, uint32_t nb) {
+  if (na == 0 || nb == 0 || a.empty())
+    return INFINITY;
+  // Var(a - b) = var * (1 / na + 1 / nb) while the combined mean has
+  // var / (na + nb), so scale |a - b| by sqrt(na * nb) / (na + nb).
+  float scale = std::sqrt(float(na) * float(nb)) / float(na + nb);
+  float wa = float(na) / float(na + nb), wb = float(nb) / float(na + nb);
+  double error = 0.0;
+  for (size_t i = 0; i < a.size(); i++) {
+    float diff = std::fabs(a[i].x - b[i].x) + std::fabs(a[i].y - b[i].y) +
+                 std::fabs(a[i].z - b[i].z);
+    float mean =
+        wa * (a[i].x + a[i].y + a[i].z) + wb * (b[i].x + b[i].y + b[i].z);
+    error += scale * diff / (mean + 0.01f);
+  }
+  return float(error / a.size());
+}
+
+uint32_t NextBatchSamples(uint32_t lastSamples, double lastSeconds,
+                          float budgetMs, uint32_t remaining) {
+  double next = 4.0 * lastSamples;
+  if (lastSeconds > 0.0)
+    next = std::min(next, lastSamples * budgetMs * 1e-3 / lastSeconds);
+  return (uint32_t)std::min<double>(remaining, std::max(1.0, std::floor(next)));
+}
+
+ProgressiveUpdate ProgressiveRenderer::Run(int threadCount,
+                                           const Callback &onBatch) {
+  const RenderSettings &settings = mTracer.Settings();
+  mCancel = false;
+  mTracer.Reset(mAcc);
+
+  ProgressiveUpdate update;
+  update.pixels = &mPixels;
+  std::vector<XMFLOAT3> even, odd;
+  // Two samples first, so the even and odd halves can be compared at once.
+  uint32_t n = std::min(2u, settings.num_samples);
+  auto start = std::chrono::high_resolution_clock::now();
+  while (mAcc.samples < settings.num_samples && !mCancel) {
+    CpuRenderStats stats = mTracer.Accumulate(threadCount, n, mAcc);
+    CpuTracer::Resolve(mAcc, mPixels);
+
+    // Retired pixels have fewer samples than the rest, so every pixel
+    // divides by its own counts.
+    uint32_t n_even = (mAcc.samples + 1) / 2, n_odd = mAcc.samples / 2;
+    even.resize(mPixels.size());
+    odd.resize(mPixels.size());
+    for (size_t i = 0; i < mPixels.size(); i++) {
+      uint32_t count = mAcc.stats[i].count;
+      float ie = 1.f / float(std::max(1u, (count + 1) / 2));
+      float io = 1.f / float(std::max(1u, count / 2));
+      const XMFLOAT3 &se = mAcc.sums[0][i], &so = mAcc.sums[1][i];
+      even[i] = XMFLOAT3(ie * se.x, ie * se.y, ie * se.z);
+      odd[i] = XMFLOAT3(io * so.x, io * so.y, io * so.z);
+    }
+
+    update.batch++;
+    update.batch_samples = n;
+    update.samples = mAcc.samples;
+    update.seconds = std::chrono::duration<double>(
+                         std::chrono::high_resolution_clock::now() - start)
+                         .count();
+    update.error = ConvergenceError(even, n_even, odd, n_odd);
+    update.converged = settings.error_threshold > 0.f &&
+                       update.error < settings.error_threshold;
+    if (onBatch)
+      onBatch(update);
+    if (update.converged)
+      break;
+    n = NextBatchSamples(n, stats.seconds, settings.batch_budget_ms,
+                         settings.num_samples - mAcc.samples);
+  }
+  return update;
+}
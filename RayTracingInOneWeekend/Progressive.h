@@ -0,0 +1,58 @@
+#pragma once
+#include "CpuTracer.h"
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Relative standard error of an image estimated from two independent renders
+// of it: a, the mean of na samples per pixel, and b, the mean of nb others.
+// The difference between them gives the noise of the combined mean of
+// na + nb samples, which is divided by that mean (plus a small floor for dark
+// pixels) and averaged over the image. Returns INFINITY while either is empty.
+float ConvergenceError(const std::vector<XMFLOAT3> &a, uint32_t na,
+                       const std::vector<XMFLOAT3> &b, uint32_t nb);
+
+// Samples for the next batch so that it takes about budgetMs, given that the
+// last one took lastSeconds for lastSamples. Grows at most 4x per batch and
+// never goes past remaining.
+uint32_t NextBatchSamples(uint32_t lastSamples, double lastSeconds,
+                          float budgetMs, uint32_t remaining);
+
+struct ProgressiveUpdate {
+  uint32_t batch = 0;
+  uint32_t batch_samples = 0;
+  // Samples per pixel so far.
+  uint32_t samples = 0;
+  double seconds = 0.0;
+  float error = INFINITY;
+  bool converged = false;
+  // Running mean after the batch, bottom row first.
+  const std::vector<XMFLOAT3> *pixels = nullptr;
+};
+
+// Renders on the CPU backend in batches of samples over the tile scheduler
+// of CpuTracer. Each batch is sized to take about batch_budget_ms and is
+// published through the callback as soon as it is done. Rendering stops after
+// num_samples, once ConvergenceError drops below error_threshold, or at the
+// first batch boundary after Cancel.
+class ProgressiveRenderer {
+public:
+  using Callback = std::function<void(const ProgressiveUpdate &)>;
+
+  explicit ProgressiveRenderer(const CpuTracer &tracer) : mTracer(tracer) {}
+
+  // Returns the last update; its pixels point to storage that lives until
+  // the next Run.
+  ProgressiveUpdate Run(int threadCount, const Callback &onBatch = nullptr);
+
+  // Safe to call from another thread or from the callback.
+  void Cancel() { mCancel = true; }
+
+private:
+  const CpuTracer &mTracer;
+  CpuAccumulation mAcc;
+  std::vector<XMFLOAT3> mPixels;
+  std::atomic<bool> mCancel{false};
+};
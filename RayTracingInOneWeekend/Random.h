@@ -0,0 +1,129 @@
+#ifndef __RANDOM_H__
+#define __RANDOM_H__
+
+// Stateless random numbers, included by the shaders and by the CPU backend
+// alike, so both draw exactly the same numbers. Every value is a hash of the
+// pixel, the sample and a dimension, so nothing has to be uploaded or stored
+// between passes and any pass can pick up a path where another left it.
+//
+// Dimensions: the lens takes RNG_DIM_LENS and the one after it; bounce d
+// starts at RNG_DIM_BOUNCE(d), its scattered direction takes the first two
+// and the glass reflect-or-refract choice the next one. Pairs of dimensions
+// (2k, 2k + 1) form one 2D sample.
+
+#ifdef __cplusplus
+#include <cstdint>
+typedef uint32_t uint;
+#define RNG_INOUT(T) T &
+#else
+#define RNG_INOUT(T) inout T
+#endif
+
+// Independent uniform numbers from a PCG hash.
+#define SAMPLER_RANDOM 0
+// Owen-scrambled Sobol points, better stratified over the pixel's samples.
+#define SAMPLER_SOBOL 1
+
+#define RNG_DIM_LENS 0
+#define RNG_DIM_BOUNCE(d) (2 + 4 * (d))
+
+struct Rng {
+  uint sequence;
+  uint key;
+  uint sample_idx;
+  uint dim;
+};
+
+#ifdef __cplusplus
+inline uint reversebits(uint x) {
+  x = (x << 16) | (x >> 16);
+  x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+  x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+  x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+  x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+  return x;
+}
+#endif
+
+// PCG-RXS-M-XS hash (Jarzynski and Olano, "Hash Functions for GPU
+// Rendering").
+inline uint pcgHash(uint v) {
+  uint state = v * 747796405u + 2891336453u;
+  uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+  return (word >> 22u) ^ word;
+}
+
+inline uint hashCombine(uint seed, uint v) { return pcgHash(seed ^ pcgHash(v)); }
+
+// Top 24 bits as a float in [0, 1).
+inline float toUnitFloat(uint x) { return float(x >> 8) * (1.f / 16777216.f); }
+
+// Burley, "Practical Hash-based Owen Scrambling": a hash that only lets
+// higher bits affect lower ones, applied to the reversed bits so it acts as a
+// nested uniform scramble of the binary digits.
+inline uint laineKarrasPermutation(uint x, uint seed) {
+  x += seed;
+  x ^= x * 0x6c50b47cu;
+  x ^= x * 0xb82f1e52u;
+  x ^= x * 0xc7afe638u;
+  x ^= x * 0x8d22f6e6u;
+  return x;
+}
+
+inline uint nestedUniformScramble(uint x, uint seed) {
+  return reversebits(laineKarrasPermutation(reversebits(x), seed));
+}
+
+// First two Sobol dimensions of point index, as 0.32 fixed point.
+inline uint sobol2(uint index, uint axis) {
+  if (axis == 0u)
+    return reversebits(index);
+  uint result = 0u;
+  uint v = 1u << 31;
+  for (uint i = index; i != 0u; i >>= 1) {
+    if ((i & 1u) != 0u)
+      result ^= v;
+    v ^= v >> 1;
+  }
+  return result;
+}
+
+// Every 2D pair gets its own shuffle of the points and its own scramble, so
+// the pairs are not correlated with each other or across pixels.
+inline float sobolSample(uint key, uint sample_idx, uint dim) {
+  uint seed = hashCombine(key, dim >> 1);
+  uint index = nestedUniformScramble(sample_idx, seed);
+  uint axis = dim & 1u;
+  return toUnitFloat(nestedUniformScramble(sobol2(index, axis),
+                                           hashCombine(seed, axis + 1u)));
+}
+
+// Key of one pixel's sequences under seed.
+inline uint pixelKey(uint seed, uint pixel) {
+  return hashCombine(pcgHash(seed), pixel);
+}
+
+inline Rng makeRng(uint sequence, uint key, uint sample_idx) {
+  Rng rng;
+  rng.sequence = sequence;
+  rng.key = key;
+  rng.sample_idx = sample_idx;
+  rng.dim = RNG_DIM_LENS;
+  return rng;
+}
+
+// Moves to the first dimension of bounce depth.
+inline void rngBounce(RNG_INOUT(Rng) rng, uint depth) {
+  rng.dim = RNG_DIM_BOUNCE(depth);
+}
+
+// Next dimension, in [0, 1).
+inline float rngNext(RNG_INOUT(Rng) rng) {
+  uint dim = rng.dim;
+  rng.dim = dim + 1u;
+  if (rng.sequence == SAMPLER_SOBOL)
+    return sobolSample(rng.key, rng.sample_idx, dim);
+  return toUnitFloat(hashCombine(hashCombine(rng.key, rng.sample_idx), dim));
+}
+
+#endif
@@ -0,0 +1,91 @@
+#include "Scene.h"
+#include "SceneFile.h"
+#include <cmath>
+#include <random>
+
+void BuildCamera(const RenderSettings &settings, const CameraParams &params,
+                 CameraCB &camera) {
+  float aspect_ratio = static_cast<float>(settings.image_width) /
+                       static_cast<float>(settings.image_height);
+
+  float theta = XMConvertToRadians(params.vfov);
+  float h = std::tan(theta / 2.0f);
+  float viewport_height = 2.0f * h;
+  float viewport_width = aspect_ratio * viewport_height;
+  float dist_to_focus = params.focus_dist;
+
+  XMVECTOR lookfrom_v = XMLoadFloat3(&params.lookfrom);
+  XMVECTOR lookat_v = XMLoadFloat3(&params.lookat);
+  XMVECTOR vup_v = XMLoadFloat3(&params.vup);
+  XMVECTOR w_v = XMVector3Normalize(lookfrom_v - lookat_v);
+  XMVECTOR u_v = XMVector3Normalize(XMVector3Cross(vup_v, w_v));
+  XMVECTOR v_v = XMVector3Cross(w_v, u_v);
+  XMVECTOR horizontal_v = dist_to_focus * viewport_width * u_v;
+  XMVECTOR vertical_v = dist_to_focus * viewport_height * v_v;
+  XMVECTOR lower_left_corner_v = lookfrom_v - 0.5f * horizontal_v -
+                                 0.5f * vertical_v - dist_to_focus * w_v;
+
+  XMStoreFloat3(&camera.origin, lookfrom_v);
+  XMStoreFloat3(&camera.lower_left_corner, lower_left_corner_v);
+  XMStoreFloat3(&camera.horizontal, horizontal_v);
+  XMStoreFloat3(&camera.vertical, vertical_v);
+  XMStoreFloat3(&camera.u, u_v);
+  XMStoreFloat3(&camera.v, v_v);
+  XMStoreFloat3(&camera.w, w_v);
+  camera.lens_radius = params.aperture * 0.5f;
+}
+
+void BuildCoverScene(const RenderSettings &settings, CameraParams &params,
+                     SceneObjects &objects) {
+  params = CameraParams();
+
+  int grid = (int)settings.sphere_grid;
+  std::mt19937 rng{settings.seed};
+  std::uniform_real_distribution<float> unf(0.f, 1.f);
+  objects.spheres.clear();
+  objects.materials.clear();
+  objects.spheres.reserve(4 + 4 * grid * grid);
+  objects.materials.reserve(4 + 4 * grid * grid);
+  auto add = [&](const Sphere &sphere, const Material1 &material) {
+    objects.spheres.push_back(sphere);
+    objects.materials.push_back(material);
+  };
+
+  add(Sphere(XMFLOAT3(0.f, -1000.f, 0.f), 1000.f),
+      Material1(XMFLOAT3(0.5f, 0.5f, 0.5f)));
+
+  add(Sphere(XMFLOAT3(0.f, 1.f, 0.f), 1.f), Material1(1.5f));
+  add(Sphere(XMFLOAT3(-4.f, 1.f, 0.f), 1.f),
+      Material1(XMFLOAT3(0.4f, 0.2f, 0.1f)));
+  add(Sphere(XMFLOAT3(4.f, 1.f, 0.f), 1.f),
+      Material1(XMFLOAT3(0.7f, 0.6f, 0.5f), 0.f));
+
+  for (int a = -grid; a < grid; a++) {
+    for (int b = -grid; b < grid; b++) {
+      XMFLOAT3 center(a + 0.9f + unf(rng), 0.2f, b + 0.9f + unf(rng));
+      float choose_mat = unf(rng);
+      Sphere sphere(center, 0.2f);
+      if (choose_mat < 0.8f) {
+        add(sphere, Material1(XMFLOAT3(unf(rng), unf(rng), unf(rng))));
+      } else if (choose_mat < 0.95f) {
+        add(sphere, Material1(XMFLOAT3(0.5f * unf(rng) + 0.5f,
+                                       0.5f * unf(rng) + 0.5f,
+                                       0.5f * unf(rng) + 0.5f),
+                              0.5f * unf(rng)));
+      } else {
+        add(sphere, Material1(1.5f));
+      }
+    }
+  }
+}
+
+void BuildScene(const RenderSettings &settings, CameraCB &camera,
+                SceneObjects &objects) {
+  CameraParams params;
+  if (settings.scene_path.empty()) {
+    BuildCoverScene(settings, params, objects);
+  } else {
+    LoadScene(settings.scene_path, params, objects);
+  }
+  BuildCamera(settings, params, camera);
+}
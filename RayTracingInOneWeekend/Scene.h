@@ -0,0 +1,160 @@
+#pragma once
+#include "Random.h"
+#include <DirectXMath.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scene description shared by the D3D12 passes and the CPU backend. Nothing in
+// here may depend on d3d12, so the CPU renderer builds without a GPU.
+
+#define MATERIAL_LAMBERTIAN 0
+#define MATERIAL_METAL 1
+#define MATERIAL_GLASS 2
+#define NUM_MATERIALS 3
+
+// Whole path per thread, carrying the throughput in a single pass.
+#define TRACE_PATH 0
+// Legacy: one color buffer per depth, multiplied back down by the background
+// and backward passes. Gives the same image as TRACE_PATH.
+#define TRACE_PER_DEPTH 1
+// Live path queue compacted after every bounce, hits sorted into one queue
+// per material and shaded by one kernel each.
+#define TRACE_WAVEFRONT 2
+
+// Linear colors clamped to [0, 1) for 8-bit output, as the image always was.
+#define TONEMAP_CLAMP 0
+// Square root first (gamma 2), as the book does.
+#define TONEMAP_GAMMA 1
+
+using namespace DirectX;
+
+struct Material1 {
+  int type;
+  float ir;
+  float fuzz;
+  uint32_t pad0;
+  XMFLOAT3 color;
+  uint32_t pad1;
+  Material1() = default;
+  Material1(const XMFLOAT3 &color) : type(MATERIAL_LAMBERTIAN), color(color) {}
+  Material1(const XMFLOAT3 &color, float fuzz)
+      : type(MATERIAL_METAL), color(color), fuzz(fuzz) {}
+  Material1(float ir) : type(MATERIAL_GLASS), color(1.f, 1.f, 1.f), ir(ir) {}
+};
+
+struct Sphere {
+  XMFLOAT3 center;
+  float radius;
+  Sphere() = default;
+  Sphere(const XMFLOAT3 &c, float r) : center(c), radius(r) {}
+};
+
+struct ImageCB {
+  uint32_t image_width;
+  uint32_t image_height;
+  uint32_t sample_idx;
+  uint32_t num_samples;
+  uint32_t max_depth;
+  uint32_t adaptive_min_samples;
+  float adaptive_threshold;
+  uint32_t seed;
+  // SAMPLER_RANDOM or SAMPLER_SOBOL.
+  uint32_t sampler;
+  uint32_t pad0;
+  uint32_t pad1;
+  uint32_t pad2;
+};
+
+// Same layout as PixelStats in stats.hlsli: Welford's running mean and sum of
+// squared deviations of one pixel's samples. A pixel stops taking samples
+// once active drops to 0.
+struct PixelStats {
+  XMFLOAT3 mean;
+  uint32_t count;
+  XMFLOAT3 m2;
+  uint32_t active;
+};
+
+struct CameraCB {
+  XMFLOAT3 origin;
+  uint32_t pad0;
+  XMFLOAT3 lower_left_corner;
+  uint32_t pad1;
+  XMFLOAT3 horizontal;
+  uint32_t pad2;
+  XMFLOAT3 vertical;
+  uint32_t pad3;
+  XMFLOAT3 u;
+  uint32_t pad4;
+  XMFLOAT3 v;
+  uint32_t pad5;
+  XMFLOAT3 w;
+  float lens_radius;
+};
+
+// Where the camera is and how it sees. BuildCamera turns it into a CameraCB
+// for the aspect ratio of the image.
+struct CameraParams {
+  XMFLOAT3 lookfrom{13.f, 2.f, 3.f};
+  XMFLOAT3 lookat{0.f, 0.f, 0.f};
+  XMFLOAT3 vup{0.f, 1.f, 0.f};
+  // Vertical field of view in degrees.
+  float vfov = 20.f;
+  float aperture = 0.1f;
+  float focus_dist = 10.f;
+};
+
+// Uploaded as structured buffers, so there is no limit on the sphere count.
+struct SceneObjects {
+  std::vector<Sphere> spheres;
+  std::vector<Material1> materials;
+};
+
+struct RenderSettings {
+  uint32_t image_width = 256;
+  uint32_t image_height = 192;
+  uint32_t max_depth = 20;
+  // A scene file to render, see SceneFile.h; empty renders the random cover
+  // scene below.
+  std::string scene_path;
+  uint32_t num_samples = 100;
+  // Places the small spheres and keys every pixel's random numbers.
+  uint32_t seed = 0;
+  // SAMPLER_RANDOM or SAMPLER_SOBOL, see Random.h.
+  uint32_t sampler = SAMPLER_SOBOL;
+  // Small spheres are scattered over a (2 * sphere_grid)^2 grid around the
+  // three big ones; 5 gives the 104 spheres of the book cover.
+  uint32_t sphere_grid = 5;
+  // One of TRACE_PATH, TRACE_PER_DEPTH or TRACE_WAVEFRONT.
+  uint32_t trace_mode = TRACE_PATH;
+  // Progressive rendering: every batch of samples is sized to take about
+  // batch_budget_ms and is written out when done. Once the estimated relative
+  // error drops below error_threshold the render stops early; 0 always takes
+  // num_samples.
+  float batch_budget_ms = 250.f;
+  float error_threshold = 0.f;
+  // Adaptive sampling: after adaptive_min_samples, a pixel stops as soon as
+  // the standard error of its mean relative to the mean is below
+  // adaptive_threshold, so num_samples becomes the most any pixel takes.
+  // 0 samples every pixel num_samples times.
+  uint32_t adaptive_min_samples = 16;
+  float adaptive_threshold = 0.f;
+  // Rewritten after every batch; .bmp, .png, .pfm or .exr, see ImageOutput.h.
+  // tonemap applies to the 8-bit formats only.
+  std::string output_path = "image.bmp";
+  uint32_t tonemap = TONEMAP_CLAMP;
+};
+
+void BuildCamera(const RenderSettings &settings, const CameraParams &params,
+                 CameraCB &camera);
+
+// The random "In One Weekend" cover scene of settings.sphere_grid and
+// settings.seed.
+void BuildCoverScene(const RenderSettings &settings, CameraParams &params,
+                     SceneObjects &objects);
+
+// Fills the camera and objects from settings.scene_path, or with the cover
+// scene if it is empty.
+void BuildScene(const RenderSettings &settings, CameraCB &camera,
+                SceneObjects &objects);
@@ -0,0 +1,330 @@
+#include "SceneFile.h"
+#include <Common/MappedFile.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+static_assert(sizeof(Sphere) == 16, "Sphere is stored as is");
+static_assert(sizeof(Material1) == 32, "Material1 is stored as is");
+
+namespace {
+
+// The fields a material of its type uses; constructors leave the others,
+// and the padding, uninitialized.
+Material1 canonical(const Material1 &mat) {
+  Material1 out;
+  memset(&out, 0, sizeof(out));
+  out.type = mat.type;
+  out.color = mat.color;
+  if (mat.type == MATERIAL_METAL)
+    out.fuzz = mat.fuzz;
+  if (mat.type == MATERIAL_GLASS)
+    out.ir = mat.ir;
+  return out;
+}
+
+inline uint64_t alignUp(uint64_t v, uint64_t a) { return (v + a - 1) / a * a; }
+
+struct FileCloser {
+  void operator()(FILE *f) const { fclose(f); }
+};
+
+void write(FILE *f, const void *data, size_t size, const std::string &path) {
+  if (fwrite(data, 1, size, f) != size)
+    throw std::runtime_error("cannot write " + path);
+}
+
+// Reads count floats from s, moving s past them; false if any is missing.
+bool parseFloats(const char *&s, float *out, int count) {
+  for (int i = 0; i < count; i++) {
+    char *end;
+    out[i] = strtof(s, &end);
+    if (end == s)
+      return false;
+    s = end;
+  }
+  return true;
+}
+
+bool sameFloat3(const XMFLOAT3 &a, const XMFLOAT3 &b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+bool sameCamera(const CameraParams &a, const CameraParams &b) {
+  return sameFloat3(a.lookfrom, b.lookfrom) && sameFloat3(a.lookat, b.lookat) &&
+         sameFloat3(a.vup, b.vup) && a.vfov == b.vfov &&
+         a.aperture == b.aperture && a.focus_dist == b.focus_dist;
+}
+
+// Index of the first object that differs, or -1 if none.
+int64_t firstDifference(const SceneObjects &a, const SceneObjects &b) {
+  size_t n = std::min(a.spheres.size(), b.spheres.size());
+  for (size_t i = 0; i < n; i++) {
+    Material1 ma = canonical(a.materials[i]), mb = canonical(b.materials[i]);
+    if (!sameFloat3(a.spheres[i].center, b.spheres[i].center) ||
+        a.spheres[i].radius != b.spheres[i].radius ||
+        memcmp(&ma, &mb, sizeof(ma)) != 0)
+      return (int64_t)i;
+  }
+  return a.spheres.size() == b.spheres.size() ? -1 : (int64_t)n;
+}
+
+double fileMB(const std::string &path) {
+  FILE *f = fopen(path.c_str(), "rb");
+  if (!f)
+    return 0.0;
+  fseek(f, 0, SEEK_END);
+  double mb = ftell(f) / 1e6;
+  fclose(f);
+  return mb;
+}
+
+} // namespace
+
+void LoadScene(const std::string &path, CameraParams &camera,
+               SceneObjects &objects) {
+  char magic[8] = {};
+  if (FILE *f = fopen(path.c_str(), "rb")) {
+    size_t n = fread(magic, 1, sizeof(magic), f);
+    fclose(f);
+    if (n == sizeof(magic) && !memcmp(magic, SCENE_FILE_MAGIC, sizeof(magic))) {
+      LoadSceneBinary(path, camera, objects);
+      return;
+    }
+  }
+  ImportSceneText(path, camera, objects);
+}
+
+void LoadSceneBinary(const std::string &path, CameraParams &camera,
+                     SceneObjects &objects) {
+  MappedFile file(path);
+  SceneFileHeader header;
+  memcpy(&header, file.Map(0, sizeof(header)), sizeof(header));
+  if (memcmp(header.magic, SCENE_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != SCENE_FILE_VERSION ||
+      header.header_size != sizeof(SceneFileHeader))
+    throw std::runtime_error(path + " is not a version " +
+                             std::to_string(SCENE_FILE_VERSION) + " scene");
+  uint64_t count = header.object_count;
+  if (count > file.Size() / sizeof(Material1) ||
+      header.spheres_offset + count * sizeof(Sphere) > file.Size() ||
+      header.materials_offset + count * sizeof(Material1) > file.Size())
+    throw std::runtime_error(path + " is truncated");
+
+  camera = header.camera;
+  objects.spheres.resize((size_t)count);
+  objects.materials.resize((size_t)count);
+  CopySection(file, header.spheres_offset, count, objects.spheres.data(),
+              SCENE_CHUNK_BYTES);
+  CopySection(file, header.materials_offset, count, objects.materials.data(),
+              SCENE_CHUNK_BYTES);
+  for (const Material1 &mat : objects.materials) {
+    if (mat.type < 0 || mat.type >= NUM_MATERIALS)
+      throw std::runtime_error(path + " has a material of unknown type " +
+                               std::to_string(mat.type));
+  }
+}
+
+void ImportSceneText(const std::string &path, CameraParams &camera,
+                     SceneObjects &objects) {
+  std::unique_ptr<FILE, FileCloser> f(fopen(path.c_str(), "rb"));
+  if (!f)
+    throw std::runtime_error("cannot open " + path);
+  camera = CameraParams();
+  objects.spheres.clear();
+  objects.materials.clear();
+
+  char line[1024];
+  for (int number = 1; fgets(line, sizeof(line), f.get()); number++) {
+    const char *s = line;
+    while (*s == ' ' || *s == '\t')
+      s++;
+    if (*s == '#' || *s == '\n' || *s == '\r' || *s == '\0')
+      continue;
+    const char *word = s;
+    while (*s && *s != ' ' && *s != '\t' && *s != '\n' && *s != '\r')
+      s++;
+    std::string kind(word, s);
+
+    // Every sphere line starts with center and radius, v[0] to v[3].
+    float v[12];
+    int count = kind == "camera"       ? 12
+                : kind == "lambertian" ? 7
+                : kind == "metal"      ? 8
+                : kind == "glass"      ? 5
+                                       : 0;
+    if (count == 0 || !parseFloats(s, v, count)) {
+      throw std::runtime_error(path + ":" + std::to_string(number) +
+                               ": cannot parse " + kind);
+    }
+    if (kind == "camera") {
+      camera.lookfrom = XMFLOAT3(v[0], v[1], v[2]);
+      camera.lookat = XMFLOAT3(v[3], v[4], v[5]);
+      camera.vup = XMFLOAT3(v[6], v[7], v[8]);
+      camera.vfov = v[9];
+      camera.aperture = v[10];
+      camera.focus_dist = v[11];
+      continue;
+    }
+    if (kind == "lambertian")
+      objects.materials.push_back(Material1(XMFLOAT3(v[4], v[5], v[6])));
+    else if (kind == "metal")
+      objects.materials.push_back(Material1(XMFLOAT3(v[4], v[5], v[6]), v[7]));
+    else
+      objects.materials.push_back(Material1(v[4]));
+    objects.spheres.push_back(Sphere(XMFLOAT3(v[0], v[1], v[2]), v[3]));
+  }
+}
+
+void SaveScene(const std::string &path, const CameraParams &camera,
+               const SceneObjects &objects) {
+  if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".txt") == 0)
+    ExportSceneText(path, camera, objects);
+  else
+    SaveSceneBinary(path, camera, objects);
+}
+
+void SaveSceneBinary(const std::string &path, const CameraParams &camera,
+                     const SceneObjects &objects) {
+  std::unique_ptr<FILE, FileCloser> f(fopen(path.c_str(), "wb"));
+  if (!f)
+    throw std::runtime_error("cannot open " + path);
+
+  SceneFileHeader header = {};
+  memcpy(header.magic, SCENE_FILE_MAGIC, sizeof(header.magic));
+  header.version = SCENE_FILE_VERSION;
+  header.header_size = sizeof(SceneFileHeader);
+  header.object_count = objects.spheres.size();
+  header.spheres_offset = alignUp(sizeof(SceneFileHeader), 256);
+  header.materials_offset =
+      alignUp(header.spheres_offset + header.object_count * sizeof(Sphere), 256);
+  header.camera = camera;
+
+  std::vector<uint8_t> zeros(256, 0);
+  write(f.get(), &header, sizeof(header), path);
+  write(f.get(), zeros.data(), header.spheres_offset - sizeof(header), path);
+  write(f.get(), objects.spheres.data(),
+        objects.spheres.size() * sizeof(Sphere), path);
+  write(f.get(), zeros.data(),
+        header.materials_offset - header.spheres_offset -
+            objects.spheres.size() * sizeof(Sphere),
+        path);
+
+  // Materials go through canonical so the file has no uninitialized bytes.
+  std::vector<Material1> chunk;
+  const size_t per_chunk = SCENE_CHUNK_BYTES / sizeof(Material1);
+  for (size_t first = 0; first < objects.materials.size(); first += per_chunk) {
+    size_t n = std::min(per_chunk, objects.materials.size() - first);
+    chunk.resize(n);
+    for (size_t i = 0; i < n; i++)
+      chunk[i] = canonical(objects.materials[first + i]);
+    write(f.get(), chunk.data(), n * sizeof(Material1), path);
+  }
+  if (fclose(f.release()) != 0)
+    throw std::runtime_error("cannot write " + path);
+}
+
+void ExportSceneText(const std::string &path, const CameraParams &camera,
+                     const SceneObjects &objects) {
+  std::unique_ptr<FILE, FileCloser> f(fopen(path.c_str(), "wb"));
+  if (!f)
+    throw std::runtime_error("cannot open " + path);
+
+  // %.9g prints every float so that it reads back to the same bits.
+  fprintf(f.get(), "# %zu spheres\n", objects.spheres.size());
+  fprintf(f.get(), "camera %.9g %.9g %.9g  %.9g %.9g %.9g  %.9g %.9g %.9g  "
+                   "%.9g %.9g %.9g\n",
+          camera.lookfrom.x, camera.lookfrom.y, camera.lookfrom.z,
+          camera.lookat.x, camera.lookat.y, camera.lookat.z, camera.vup.x,
+          camera.vup.y, camera.vup.z, camera.vfov, camera.aperture,
+          camera.focus_dist);
+  for (size_t i = 0; i < objects.spheres.size(); i++) {
+    const Sphere &s = objects.spheres[i];
+    const Material1 &m = objects.materials[i];
+    const char *names[] = {"lambertian", "metal", "glass"};
+    fprintf(f.get(), "%s %.9g %.9g %.9g %.9g",
+            names[std::min(m.type, MATERIAL_GLASS)], s.center.x, s.center.y,
+            s.center.z, s.radius);
+    if (m.type == MATERIAL_GLASS)
+      fprintf(f.get(), " %.9g\n", m.ir);
+    else if (m.type == MATERIAL_METAL)
+      fprintf(f.get(), " %.9g %.9g %.9g %.9g\n", m.color.x, m.color.y,
+              m.color.z, m.fuzz);
+    else
+      fprintf(f.get(), " %.9g %.9g %.9g\n", m.color.x, m.color.y, m.color.z);
+  }
+  if (ferror(f.get()) || fclose(f.release()) != 0)
+    throw std::runtime_error("cannot write " + path);
+}
+
+bool SceneRoundTrip(const RenderSettings &settings) {
+  const std::string text = "scene_roundtrip.txt";
+  const std::string binary = "scene_roundtrip.rtscene";
+  bool same = true;
+  for (uint32_t grid : {settings.sphere_grid, 100u}) {
+    RenderSettings s = settings;
+    s.sphere_grid = grid;
+    CameraParams camera, from_text, from_binary;
+    SceneObjects objects, text_objects, binary_objects;
+    BuildCoverScene(s, camera, objects);
+    camera.vfov = 33.3f; // not the default, so a missing camera line shows
+
+    ExportSceneText(text, camera, objects);
+    LoadScene(text, from_text, text_objects);
+    SaveSceneBinary(binary, from_text, text_objects);
+    LoadScene(binary, from_binary, binary_objects);
+    remove(text.c_str());
+    remove(binary.c_str());
+
+    int64_t text_diff = firstDifference(objects, text_objects);
+    int64_t binary_diff = firstDifference(objects, binary_objects);
+    bool ok = sameCamera(camera, from_text) &&
+              sameCamera(camera, from_binary) && text_diff < 0 &&
+              binary_diff < 0;
+    printf("  %8zu spheres: %s", objects.spheres.size(), ok ? "ok" : "FAILED");
+    if (!sameCamera(camera, from_text) || !sameCamera(camera, from_binary))
+      printf(", camera differs");
+    if (text_diff >= 0)
+      printf(", text differs at object %lld", (long long)text_diff);
+    if (binary_diff >= 0)
+      printf(", binary differs at object %lld", (long long)binary_diff);
+    printf("\n");
+    same = same && ok;
+  }
+  return same;
+}
+
+void RunSceneLoadBenchmark(const RenderSettings &settings) {
+  const std::string text = "scene_bench.txt";
+  const std::string binary = "scene_bench.rtscene";
+  printf("   spheres  format      MB   save s   load s     MB/s   Mobj/s\n");
+  for (uint32_t grid : {50u, 500u, 1000u}) {
+    RenderSettings s = settings;
+    s.sphere_grid = grid;
+    CameraParams camera;
+    SceneObjects objects;
+    BuildCoverScene(s, camera, objects);
+
+    for (bool is_text : {true, false}) {
+      const std::string &path = is_text ? text : binary;
+      auto time = [](auto fn) {
+        auto start = std::chrono::high_resolution_clock::now();
+        fn();
+        auto stop = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double>(stop - start).count();
+      };
+      double save = time([&] { SaveScene(path, camera, objects); });
+      CameraParams loaded_camera;
+      SceneObjects loaded;
+      double load = time([&] { LoadScene(path, loaded_camera, loaded); });
+      double mb = fileMB(path);
+      remove(path.c_str());
+      printf("  %8zu  %-8s %7.1f %8.3f %8.3f %8.0f %8.2f\n",
+             objects.spheres.size(), is_text ? "text" : "binary", mb,
+             save, load, mb / load, loaded.spheres.size() / load * 1e-6);
+    }
+  }
+}
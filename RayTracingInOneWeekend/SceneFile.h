@@ -0,0 +1,58 @@
+#pragma once
+#include "Scene.h"
+#include <cstdint>
+#include <string>
+
+// Scene files. The binary format is a SceneFileHeader followed by the sphere
+// and the material arrays in exactly the layout of the structured buffers,
+// little-endian, so loading is a copy out of the mapped file with nothing to
+// parse. Large files are mapped SCENE_CHUNK_BYTES at a time rather than
+// whole, which keeps millions of spheres from needing the whole file in the
+// address space and resident at once.
+//
+// The text format is one object per line, '#' starts a comment:
+//   camera <lookfrom x y z> <lookat x y z> <vup x y z> vfov aperture focus
+//   lambertian <center x y z> radius <color r g b>
+//   metal <center x y z> radius <color r g b> fuzz
+//   glass <center x y z> radius ir
+
+#define SCENE_FILE_MAGIC "RTSCENE"
+#define SCENE_FILE_VERSION 1
+#define SCENE_CHUNK_BYTES (64u << 20)
+
+struct SceneFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  uint64_t object_count;
+  // Byte offsets of object_count Spheres and object_count Material1s.
+  uint64_t spheres_offset;
+  uint64_t materials_offset;
+  CameraParams camera;
+};
+
+// Binary if path starts with SCENE_FILE_MAGIC, text otherwise. Throws
+// std::runtime_error on a malformed or unreadable file.
+void LoadScene(const std::string &path, CameraParams &camera,
+               SceneObjects &objects);
+void LoadSceneBinary(const std::string &path, CameraParams &camera,
+                     SceneObjects &objects);
+void ImportSceneText(const std::string &path, CameraParams &camera,
+                     SceneObjects &objects);
+
+// Text if path ends in .txt, binary otherwise.
+void SaveScene(const std::string &path, const CameraParams &camera,
+               const SceneObjects &objects);
+void SaveSceneBinary(const std::string &path, const CameraParams &camera,
+                     const SceneObjects &objects);
+void ExportSceneText(const std::string &path, const CameraParams &camera,
+                     const SceneObjects &objects);
+
+// Writes the cover scene of settings as text, imports it, saves that as
+// binary and loads it back; returns false (after printing the first
+// difference) unless every stage gives the same camera and objects.
+bool SceneRoundTrip(const RenderSettings &settings);
+
+// MB/s and objects/s of text import and binary load from ten thousand to a
+// few million spheres.
+void RunSceneLoadBenchmark(const RenderSettings &settings);
@@ -1,17 +1,35 @@
+#include "stats.hlsli"
+
 cbuffer ImageCB : register(b0) {
   uint g_image_width;
   uint g_image_height;
   uint g_sample_idx;
   uint g_num_samples;
+  uint g_max_depth;
+  uint g_adaptive_min_samples;
+  float g_adaptive_threshold;
 };
 
 RWStructuredBuffer<float3> g_colors : register(u0);
 RWStructuredBuffer<float3> g_pixels : register(u1);
+RWStructuredBuffer<PixelStats> g_stats : register(u2);
 
+// Welford's update of the running mean and variance. Retired pixels ignore
+// g_colors; the passes before still trace them.
 [numthreads(16, 16, 1)]
 void main(uint3 dtid : SV_DispatchThreadID) {
+  if (dtid.x >= g_image_width || dtid.y >= g_image_height) {
+    return;
+  }
   uint idx = dtid.y * g_image_width + dtid.x;
-  float alpha = 1.f / float(1 + g_sample_idx);
-  float beta = 1.f - alpha;
-  g_pixels[idx] = alpha * g_colors[idx] + beta * g_pixels[idx];
+  PixelStats st = emptyPixelStats();
+  if (g_sample_idx > 0) {
+    st = g_stats[idx];
+  }
+  if (st.active == 0) {
+    return;
+  }
+  addSample(st, g_colors[idx], g_adaptive_min_samples, g_adaptive_threshold);
+  g_stats[idx] = st;
+  g_pixels[idx] = st.mean;
 }
\ No newline at end of file
@@ -0,0 +1,92 @@
+#ifndef __BVH_HLSLI__
+#define __BVH_HLSLI__
+
+#include "geo.hlsli"
+
+// Deepest path the CPU builder produces (BVH_MAX_DEPTH in Bvh.h).
+#define BVH_MAX_DEPTH 64
+
+struct BvhNode {
+  float3 bounds_min;
+  // Interior nodes: index of the left child, the right one follows it.
+  // Leaves: index of the first sphere.
+  uint left_first;
+  float3 bounds_max;
+  // Number of spheres in a leaf, 0 for interior nodes.
+  uint count;
+};
+
+// Distance at which the ray enters the box, or MAX_T + 1 if it misses it
+// before t_max.
+float enterBox(float3 origin, float3 inv_dir, BvhNode node, float t_max) {
+  float3 t0 = (node.bounds_min - origin) * inv_dir;
+  float3 t1 = (node.bounds_max - origin) * inv_dir;
+  float3 tmin = min(t0, t1);
+  float3 tmax = max(t0, t1);
+  float t_enter = max(max(tmin.x, tmin.y), max(tmin.z, MIN_T));
+  float t_exit = min(min(tmax.x, tmax.y), min(tmax.z, t_max));
+  // Widen the exit a few ulps so rounding never culls a sphere that grazes
+  // its own box.
+  return t_enter <= t_exit * 1.0000004f ? t_enter : MAX_T + 1.f;
+}
+
+// Closest hit over the spheres in nodes, nearer child first. hit_obj_id is
+// left untouched when nothing is hit.
+HitRecord hitBvh(Ray ray, StructuredBuffer<BvhNode> nodes,
+                 StructuredBuffer<Sphere> spheres, inout uint hit_obj_id) {
+  HitRecord rec;
+  rec.pos = float3(0.f, 0.f, 0.f);
+  rec.is_hit = false;
+  rec.normal = float3(0.f, 0.f, 1.f);
+  rec.t = MAX_T;
+
+  float3 inv_dir = 1.f / ray.direction;
+  uint stack[BVH_MAX_DEPTH];
+  uint sp = 0;
+  uint n = 0;
+  if (enterBox(ray.origin, inv_dir, nodes[0], MAX_T) > MAX_T) {
+    return rec;
+  }
+
+  [loop]
+  while (true) {
+    BvhNode node = nodes[n];
+    if (node.count > 0) {
+      for (uint i = node.left_first; i < node.left_first + node.count; i++) {
+        HitRecord rec1 = hit(ray, spheres[i]);
+        if ((rec1.is_hit && !rec.is_hit) ||
+            (rec1.is_hit && rec.is_hit && rec1.t < rec.t)) {
+          rec = rec1;
+          hit_obj_id = i;
+        }
+      }
+    } else {
+      uint near_id = node.left_first;
+      uint far_id = node.left_first + 1;
+      float t_near = enterBox(ray.origin, inv_dir, nodes[near_id], rec.t);
+      float t_far = enterBox(ray.origin, inv_dir, nodes[far_id], rec.t);
+      if (t_far < t_near) {
+        uint tmp_id = near_id;
+        near_id = far_id;
+        far_id = tmp_id;
+        float tmp_t = t_near;
+        t_near = t_far;
+        t_far = tmp_t;
+      }
+      if (t_near <= MAX_T) {
+        if (t_far <= MAX_T) {
+          stack[sp++] = far_id;
+        }
+        n = near_id;
+        continue;
+      }
+    }
+    if (sp == 0) {
+      break;
+    }
+    n = stack[--sp];
+  }
+  return rec;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef __CAMERA_HLSLI__
+#define __CAMERA_HLSLI__
+
+#include "geo.hlsli"
+#include "utils.hlsli"
+
+cbuffer CameraCB : register(b1) {
+  float3 g_camera_origin;
+  uint g_camear_pad0;
+  float3 g_camera_lower_left_corner;
+  uint g_camear_pad1;
+  float3 g_camera_horizontal;
+  uint g_camear_pad2;
+  float3 g_camera_vertical;
+  uint g_camear_pad3;
+  float3 g_camera_u;
+  uint g_camear_pad4;
+  float3 g_camera_v;
+  uint g_camear_pad5;
+  float3 g_camera_w;
+  float g_camera_lens_radius;
+};
+
+// Thin-lens ray through (s, t) of the viewport, both in [0, 1).
+Ray cameraRay(float s, float t, inout Rng rng) {
+  Ray ray;
+  float2 rd = g_camera_lens_radius * randomDisk(rng);
+  float3 offset = g_camera_u * rd.x + g_camera_v * rd.y;
+  ray.pad0 = ray.pad1 = 0;
+  ray.origin = g_camera_origin + offset;
+  ray.direction = normalize(g_camera_lower_left_corner + 
+                            s * g_camera_horizontal +
+                            t * g_camera_vertical - 
+                            ray.origin);
+  return ray;
+}
+
+#endif
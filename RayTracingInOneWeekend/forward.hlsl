@@ -1,25 +1,31 @@
-#include "geo.hlsli"
+#include "bvh.hlsli"
 #include "material.hlsli"
 
-#define MAX_NUM_OBJS 128
-
 cbuffer ImageCB : register(b0) {
   uint g_image_width;
   uint g_image_height;
   uint g_sample_idx;
   uint g_num_samples;
+  uint g_max_depth;
+  uint g_adaptive_min_samples;
+  float g_adaptive_threshold;
+  uint g_seed;
+  uint g_sampler;
 };
 
-cbuffer ObjectCB : register(b1) {
-  uint g_num_objs;
-  Sphere g_spheres[MAX_NUM_OBJS];
-  Material g_materials[MAX_NUM_OBJS];
+// Bounce this pass traces, for the random dimensions.
+cbuffer DepthCB : register(b1) {
+  uint g_depth;
 };
 
+// Spheres and materials in BVH leaf order.
+StructuredBuffer<Sphere> g_spheres : register(t0);
+StructuredBuffer<Material> g_materials : register(t1);
+StructuredBuffer<BvhNode> g_nodes : register(t2);
+
 RWStructuredBuffer<float3> g_colors : register(u0);
 RWStructuredBuffer<Ray> g_rays : register(u1);
 RWStructuredBuffer<bool> g_valids : register(u2);
-RWStructuredBuffer<uint> g_randoms : register(u3);
 
 [numthreads(16, 16, 1)]
 void main(uint3 dtid : SV_DispatchThreadID) {
@@ -29,29 +35,21 @@ void main(uint3 dtid : SV_DispatchThreadID) {
     return;
   }
   
-  HitRecord rec;
-  uint hit_obj_id = g_num_objs;
   Ray ray = g_rays[idx];
-  for (uint obj_id = 0; obj_id < g_num_objs; obj_id++) {
-    HitRecord rec1 = hit(ray, g_spheres[obj_id]);
-    if ((rec1.is_hit && !rec.is_hit) ||
-          (rec1.is_hit && rec.is_hit && rec1.t < rec.t)) {
-      rec = rec1;
-      hit_obj_id = obj_id;
-    }
-  }
-  
-  if (hit_obj_id < g_num_objs) {
+  uint hit_obj_id = 0;
+  HitRecord rec = hitBvh(ray, g_nodes, g_spheres, hit_obj_id);
+
+  if (rec.is_hit) {
     Material mat = g_materials[hit_obj_id];
-    uint random = g_randoms[idx];
+    Rng rng = makeRng(g_sampler, pixelKey(g_seed, idx), g_sample_idx);
+    rngBounce(rng, g_depth);
     Ray new_ray;
     new_ray.pad0 = new_ray.pad1 = 0;
     new_ray.origin = rec.pos;
-    new_ray.direction = scatter(mat, ray.direction, rec.normal, random);
+    new_ray.direction = scatter(mat, ray.direction, rec.normal, rng);
     g_colors[idx] = attenuation(mat);
     g_rays[idx] = new_ray;
     g_valids[idx] = true;
-    g_randoms[idx] = random;
   } else {
     float t = 0.5f * (ray.direction.y + 1.f);
     g_colors[idx] =
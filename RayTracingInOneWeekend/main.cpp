@@ -1,20 +1,248 @@
+#include "Batch.h"
+#include "CpuTracer.h"
+#include "ImageOutput.h"
+#include "Progressive.h"
+#include "SceneFile.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <random>
+#ifdef _WIN32
 #include "InOneWeekendApp.h"
-#include <stb_image.h>
+#endif
 
-int main(void) {
+// Usage: RayTracingInOneWeekend [--cpu] [--threads N] [--samples N] [--grid N]
+//                               [--seed N] [--per-depth | --wavefront]
+//                               [--progressive] [--budget MS] [--threshold E]
+//                               [--adaptive E] [--min-samples N]
+//                               [--sampler random|sobol] [--output PATH]
+//                               [--gamma] [--scene PATH] [--save-scene PATH]
+//                               [--views N]
+//                               [--bench | --compare | --scene-test |
+//                                --image-test]
+//   --cpu        render with the CPU backend instead of D3D12 (always the case
+//                on builds without D3D12)
+//   --threads N  CPU worker threads (the most --bench tries), 0 = every
+//                hardware thread
+//   --samples N  samples per pixel
+//   --grid N     scatter small spheres over a 2N x 2N grid (default 5)
+//   --scene PATH  render a binary or text scene file instead, see SceneFile.h
+//   --save-scene PATH  write the scene (as text if PATH ends in .txt) and
+//                exit; with --scene this converts between the formats
+//   --views N    render N views turning around the scene on the CPU, sharing
+//                one BVH, to the output path numbered as image_0000.bmp, ...
+//   --seed N     scene and per-pixel random seed (default: random, 1 with
+//                --compare)
+//   --per-depth  use the legacy per-depth color buffers and backward passes
+//   --wavefront  trace one bounce at a time over queues of live paths
+//   --progressive  render on the CPU in batches and rewrite the image after
+//                each one (the D3D12 path always does)
+//   --budget MS  target time per batch (default 250)
+//   --threshold E  stop once the estimated relative error is below E
+//   --adaptive E  stop sampling a pixel once the standard error of its mean
+//                is below E times the mean; --samples is then the maximum
+//   --min-samples N  samples every pixel takes before it may stop (default 16)
+//   --sampler S  random: independent hashed numbers; sobol: scrambled Sobol
+//                points for the lens and every bounce (default)
+//   --output PATH  image to write (default image.bmp); .png is encoded on a
+//                background thread, .pfm and .exr keep linear float colors
+//   --gamma      take the square root of colors before writing 8-bit images
+//   --bench      print CPU samples per second from 1 to N threads, live paths
+//                per bounce of the wavefront, error against samples spent
+//                with uniform and adaptive sampling and with either sampler,
+//                rays per second against sphere count, image output times
+//                for 4K and 8K frames, scene load speed, then images per
+//                minute of batches of views, and exit
+//   --compare    render on the CPU in every trace mode and exit with 1 if
+//                the images differ
+//   --scene-test  write the scene as text and binary, read both back and
+//                exit with 1 if anything changed
+//   --image-test  check the SSE tone mapping against the scalar one, write
+//                PFM and EXR images, read them back and exit with 1 if
+//                anything changed
+int main(int argc, char *argv[]) {
   // Enable run-time memory check for debug builds.
-#if defined(DEBUG) | defined(_DEBUG)
+#if defined(_WIN32) && (defined(DEBUG) | defined(_DEBUG))
   _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
 
+  RenderSettings settings;
+  settings.seed = std::random_device{}();
+#ifdef _WIN32
+  bool cpu = false;
+#else
+  bool cpu = true;
+#endif
+  bool bench = false;
+  bool compare = false;
+  bool progressive = false;
+  bool scene_test = false;
+  bool image_test = false;
+  uint32_t views = 0;
+  std::string save_scene;
+  bool seeded = false;
+  int threads = 0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--cpu")) {
+      cpu = true;
+    } else if (!strcmp(argv[i], "--bench")) {
+      bench = true;
+    } else if (!strcmp(argv[i], "--compare")) {
+      compare = true;
+    } else if (!strcmp(argv[i], "--per-depth")) {
+      settings.trace_mode = TRACE_PER_DEPTH;
+    } else if (!strcmp(argv[i], "--progressive")) {
+      cpu = true;
+      progressive = true;
+    } else if (!strcmp(argv[i], "--budget") && i + 1 < argc) {
+      settings.batch_budget_ms = (float)atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--threshold") && i + 1 < argc) {
+      settings.error_threshold = (float)atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--adaptive") && i + 1 < argc) {
+      settings.adaptive_threshold = (float)atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--min-samples") && i + 1 < argc) {
+      settings.adaptive_min_samples = (uint32_t)atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--sampler") && i + 1 < argc) {
+      i++;
+      if (!strcmp(argv[i], "random")) {
+        settings.sampler = SAMPLER_RANDOM;
+      } else if (!strcmp(argv[i], "sobol")) {
+        settings.sampler = SAMPLER_SOBOL;
+      } else {
+        fprintf(stderr, "unknown sampler %s\n", argv[i]);
+        return 1;
+      }
+    } else if (!strcmp(argv[i], "--output") && i + 1 < argc) {
+      settings.output_path = argv[++i];
+    } else if (!strcmp(argv[i], "--gamma")) {
+      settings.tonemap = TONEMAP_GAMMA;
+    } else if (!strcmp(argv[i], "--scene") && i + 1 < argc) {
+      settings.scene_path = argv[++i];
+    } else if (!strcmp(argv[i], "--save-scene") && i + 1 < argc) {
+      save_scene = argv[++i];
+    } else if (!strcmp(argv[i], "--views") && i + 1 < argc) {
+      views = (uint32_t)atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--scene-test")) {
+      scene_test = true;
+    } else if (!strcmp(argv[i], "--image-test")) {
+      image_test = true;
+    } else if (!strcmp(argv[i], "--wavefront")) {
+      settings.trace_mode = TRACE_WAVEFRONT;
+    } else if (!strcmp(argv[i], "--seed") && i + 1 < argc) {
+      settings.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+      seeded = true;
+    } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--samples") && i + 1 < argc) {
+      settings.num_samples = (uint32_t)atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--grid") && i + 1 < argc) {
+      settings.sphere_grid = (uint32_t)atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "unknown argument %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  if (compare && !seeded) {
+    settings.seed = 1;
+  }
+
   try {
-    InOneWeekendApp{}.Run();
+    if (compare) {
+      return CompareTraceModes(settings, threads) ? 0 : 1;
+    } else if (scene_test) {
+      return SceneRoundTrip(settings) ? 0 : 1;
+    } else if (image_test) {
+      return ImageRoundTrip() ? 0 : 1;
+    } else if (!save_scene.empty()) {
+      CameraParams camera;
+      SceneObjects objects;
+      if (settings.scene_path.empty()) {
+        BuildCoverScene(settings, camera, objects);
+      } else {
+        LoadScene(settings.scene_path, camera, objects);
+      }
+      SaveScene(save_scene, camera, objects);
+      printf("%zu spheres written to %s\n", objects.spheres.size(),
+             save_scene.c_str());
+    } else if (bench) {
+      RunCpuTracerBenchmark(settings, threads);
+      RunWavefrontBenchmark(settings, threads);
+      RunAdaptiveBenchmark(settings, threads);
+      RunSamplerBenchmark(settings, threads);
+      RunBvhBenchmark(settings, threads);
+      RunOutputBenchmark();
+      RunSceneLoadBenchmark(settings);
+      RunBatchBenchmark(settings, threads);
+    } else if (views > 0) {
+      CameraParams params;
+      SceneObjects objects;
+      if (settings.scene_path.empty()) {
+        BuildCoverScene(settings, params, objects);
+      } else {
+        LoadScene(settings.scene_path, params, objects);
+      }
+      std::vector<CameraParams> cameras = TurntableCameras(params, views);
+      std::vector<BatchView> batch(views);
+      for (uint32_t i = 0; i < views; i++) {
+        BuildCamera(settings, cameras[i], batch[i].camera);
+        batch[i].output_path = NumberedPath(settings.output_path, i);
+      }
+      CpuTracer tracer(settings, batch[0].camera, objects);
+      BatchStats stats = RenderBatch(tracer, batch, threads);
+      printf("%u views in %.2f s, %.1f images/min, %d x %d threads\n", views,
+             stats.seconds, 60.0 * views / stats.seconds, stats.workers,
+             stats.threads_per_view);
+    } else if (progressive) {
+      CameraCB camera;
+      SceneObjects objects;
+      BuildScene(settings, camera, objects);
+      CpuTracer tracer(settings, camera, objects);
+      ProgressiveRenderer renderer(tracer);
+      ImageOutput output(settings.tonemap);
+      renderer.Run(threads, [&](const ProgressiveUpdate &update) {
+        printf("batch %3u: +%4u = %4u spp, %6.2f s, error %.4f\n",
+               update.batch, update.batch_samples, update.samples,
+               update.seconds, update.error);
+        output.Write(settings.output_path, *update.pixels,
+                     settings.image_width, settings.image_height);
+      });
+      output.Wait();
+    } else if (cpu) {
+      CameraCB camera;
+      SceneObjects objects;
+      BuildScene(settings, camera, objects);
+      // Bands go to the file as soon as they are done, while the tiles
+      // above them are still rendering.
+      std::vector<XMFLOAT3> pixels;
+      ImageWriter writer(settings.output_path, settings.image_width,
+                         settings.image_height, settings.tonemap);
+      CpuRenderStats stats = CpuTracer(settings, camera, objects)
+                                 .Render(threads, pixels,
+                                         [&](uint32_t first, uint32_t rows) {
+                                           writer.WriteRows(
+                                               &pixels[size_t(first) *
+                                                       settings.image_width],
+                                               rows);
+                                         });
+      writer.Close();
+      printf("%.2f s, %.2f Msamples/s, %.1f spp on average\n", stats.seconds,
+             stats.samples / stats.seconds * 1e-6,
+             double(stats.samples) / pixels.size());
+    } else {
+#ifdef _WIN32
+      InOneWeekendApp{settings}.Run();
+#endif
+    }
+#ifdef _WIN32
   } catch (DxException &e) {
     setlocale(LC_ALL, "");
     fwprintf(stderr, L"HR Failed: %ls", e.ToString().c_str());
     return 0;
+#endif
   } catch (std::exception &e) {
-    fprintf(stderr, "%d", e.what());
-    return 0;
+    fprintf(stderr, "%s\n", e.what());
+    return 1;
   }
-}
\ No newline at end of file
+}
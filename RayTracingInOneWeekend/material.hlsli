@@ -27,31 +27,39 @@ inline float reflectance(float cosine, float ref_idx) {
   return r0 + (1.f - r0) * pow((1.f - cosine), 5.f);
 }
 
-float3 scatter(Material mat, float3 r, float3 n, inout uint random) {
+float3 scatterLambertian(Material mat, float3 r, float3 n, inout Rng rng) {
+  return toWorld(randomHemisphere(rng), n);
+}
+
+float3 scatterMetal(Material mat, float3 r, float3 n, inout Rng rng) {
+  return normalize(reflect(r, n) +
+                   mat.fuzz * toWorld(randomHemisphere(rng), n));
+}
+
+float3 scatterGlass(Material mat, float3 r, float3 n, inout Rng rng) {
+  bool front_face = dot(r, n) < 0;
+  n = front_face ? n : -n;
+  float refraction_ratio = front_face ? (1.f / mat.ir) : mat.ir;
+  float cos_theta = min(dot(-r, n), 1.f);
+  float sin_theta = sqrt(1.f - cos_theta * cos_theta);
+  bool cannot_refract = refraction_ratio * sin_theta > 1.f;
+  if (cannot_refract ||
+      reflectance(cos_theta, refraction_ratio) > randomFloat(rng)) {
+    return reflect(r, n);
+  } else {
+    return refract(r, n, refraction_ratio);
+  }
+}
+
+float3 scatter(Material mat, float3 r, float3 n, inout Rng rng) {
   switch (mat.type) {
     case MATERIAL_METAL:
-      return normalize(reflect(r, n) +
-                       mat.fuzz * toWorld(randomHemisphere(random), n));
-      break;
-    case MATERIAL_GLASS:{
-        bool front_face = dot(r, n) < 0;
-        n = front_face ? n : -n;
-        float refraction_ratio = front_face ? (1.f / mat.ir) : mat.ir;
-        float cos_theta = min(dot(-r, n), 1.f);
-        float sin_theta = sqrt(1.f - cos_theta * cos_theta);
-        bool cannot_refract = refraction_ratio * sin_theta > 1.f;
-        if (cannot_refract ||
-            reflectance(cos_theta, refraction_ratio) > randomFloat(random)) {
-          return reflect(r, n);
-        } else {
-          return refract(r, n, refraction_ratio);
-        }
-      }
-      break;
+      return scatterMetal(mat, r, n, rng);
+    case MATERIAL_GLASS:
+      return scatterGlass(mat, r, n, rng);
     case MATERIAL_LAMBERTIAN:
     default:
-      return toWorld(randomHemisphere(random), n);
-      break;
+      return scatterLambertian(mat, r, n, rng);
   }
 }
 
@@ -0,0 +1,73 @@
+#include "bvh.hlsli"
+#include "camera.hlsli"
+#include "material.hlsli"
+#include "stats.hlsli"
+
+cbuffer ImageCB : register(b0) {
+  uint g_image_width;
+  uint g_image_height;
+  uint g_sample_idx;
+  uint g_num_samples;
+  uint g_max_depth;
+  uint g_adaptive_min_samples;
+  float g_adaptive_threshold;
+  uint g_seed;
+  uint g_sampler;
+};
+
+// Spheres and materials in BVH leaf order.
+StructuredBuffer<Sphere> g_spheres : register(t0);
+StructuredBuffer<Material> g_materials : register(t1);
+StructuredBuffer<BvhNode> g_nodes : register(t2);
+
+RWStructuredBuffer<float3> g_pixels : register(u0);
+RWStructuredBuffer<PixelStats> g_stats : register(u1);
+
+// One whole sample per thread: generateRay, every forward bounce, background,
+// backward and blend in a single dispatch. The product of the attenuations is
+// carried as throughput instead of being stored per depth.
+[numthreads(16, 16, 1)]
+void main(uint3 dtid : SV_DispatchThreadID) {
+  if (dtid.x >= g_image_width || dtid.y >= g_image_height) {
+    return;
+  }
+  uint idx = dtid.y * g_image_width + dtid.x;
+  PixelStats st = emptyPixelStats();
+  if (g_sample_idx > 0) {
+    st = g_stats[idx];
+  }
+  // Converged pixels keep their mean and trace nothing.
+  if (st.active == 0) {
+    return;
+  }
+  float s = float(dtid.x) / float(g_image_width);
+  float t = float(dtid.y) / float(g_image_height);
+  Rng rng = makeRng(g_sampler, pixelKey(g_seed, idx), g_sample_idx);
+  Ray ray = cameraRay(s, t, rng);
+
+  float3 throughput = float3(1.f, 1.f, 1.f);
+  // Paths still bouncing after g_max_depth get no light.
+  float3 radiance = float3(0.f, 0.f, 0.f);
+  [loop]
+  for (uint d = 0; d < g_max_depth; d++) {
+    uint hit_obj_id = 0;
+    HitRecord rec = hitBvh(ray, g_nodes, g_spheres, hit_obj_id);
+    if (!rec.is_hit) {
+      float sky_t = 0.5f * (ray.direction.y + 1.f);
+      radiance = throughput * ((1.f - sky_t) * float3(1.f, 1.f, 1.f) +
+                               sky_t * float3(0.5f, 0.7f, 1.f));
+      break;
+    }
+    Material mat = g_materials[hit_obj_id];
+    throughput *= attenuation(mat);
+    ray.origin = rec.pos;
+    rngBounce(rng, d);
+    ray.direction = scatter(mat, ray.direction, rec.normal, rng);
+  }
+
+  // blend: the running mean replaces 1 / (1 + g_sample_idx), since retired
+  // pixels no longer count every sample.
+  addSample(st, radiance, g_adaptive_min_samples, g_adaptive_threshold);
+  g_stats[idx] = st;
+  g_pixels[idx] = st.mean;
+}
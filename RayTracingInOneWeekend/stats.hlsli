@@ -0,0 +1,44 @@
+#ifndef __STATS_HLSLI__
+#define __STATS_HLSLI__
+
+// Welford's running mean and sum of squared deviations of one pixel.
+struct PixelStats {
+  float3 mean;
+  uint count;
+  float3 m2;
+  uint active;
+};
+
+PixelStats emptyPixelStats() {
+  PixelStats st;
+  st.mean = float3(0.f, 0.f, 0.f);
+  st.count = 0;
+  st.m2 = float3(0.f, 0.f, 0.f);
+  st.active = 1;
+  return st;
+}
+
+// Standard error of the mean over the mean, channels averaged. Dark pixels
+// get the same 0.01 floor as ConvergenceError.
+float relativeError(PixelStats st) {
+  float3 variance = st.m2 / float(st.count - 1);
+  float std_error = sqrt((variance.x + variance.y + variance.z) /
+                         (3.f * float(st.count)));
+  return std_error / ((st.mean.x + st.mean.y + st.mean.z) / 3.f + 0.01f);
+}
+
+// Adds sample c, then retires the pixel once it has min_samples and its
+// relative error is below threshold. A threshold of 0 never retires it.
+void addSample(inout PixelStats st, float3 c, uint min_samples,
+               float threshold) {
+  st.count++;
+  float3 delta = c - st.mean;
+  st.mean += delta / float(st.count);
+  st.m2 += delta * (c - st.mean);
+  if (threshold > 0.f && st.count >= max(min_samples, 2) &&
+      relativeError(st) < threshold) {
+    st.active = 0;
+  }
+}
+
+#endif
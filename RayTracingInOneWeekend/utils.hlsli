@@ -1,29 +1,23 @@
 #ifndef __UTILS_HLSLI__
 #define __UTILS_HLSLI__
 
-#define PI 3.1415926f
+#include "Random.h"
 
-void xorShift(inout uint x) {
-  x ^= (x << 13);
-  x ^= (x >> 17);
-  x ^= (x << 5);
-}
+#define PI 3.1415926f
 
-float randomFloat(inout uint random) {
-  float x = float(random) / float(uint(-1));
-  xorShift(random);
-  return x;
+float randomFloat(inout Rng rng) {
+  return rngNext(rng);
 }
 
-float2 randomDisk(inout uint random) {
-  float theta = 2 * PI * randomFloat(random);
-  float r = sqrt(randomFloat(random));
+float2 randomDisk(inout Rng rng) {
+  float theta = 2 * PI * randomFloat(rng);
+  float r = sqrt(randomFloat(rng));
   return r * float2(cos(theta), sin(theta));
 }
 
-float3 randomSphere(inout uint random) {
-  float xi1 = randomFloat(random);
-  float xi2 = randomFloat(random);
+float3 randomSphere(inout Rng rng) {
+  float xi1 = randomFloat(rng);
+  float xi2 = randomFloat(rng);
   float z = 1.f - 2.f * xi1;
   float r = sqrt(1.f - z * z);
   float phi = 2 * PI * xi2;
@@ -32,8 +26,8 @@ float3 randomSphere(inout uint random) {
   return float3(x, y, z);
 }
 
-float3 randomHemisphere(inout uint random) {
-  float3 d = randomSphere(random);
+float3 randomHemisphere(inout Rng rng) {
+  float3 d = randomSphere(rng);
   return float3(d.x, d.y, abs(d.z));
 }
 
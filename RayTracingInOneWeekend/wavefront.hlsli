@@ -0,0 +1,41 @@
+#ifndef __WAVEFRONT_HLSLI__
+#define __WAVEFRONT_HLSLI__
+
+// Queues of the wavefront pipeline (TRACE_WAVEFRONT). Each bounce extends the
+// live paths of g_paths_in, sorts the hits into one queue per material and
+// shades every queue with its own kernel, which appends the survivors to
+// g_paths_out. Dead paths never take a thread again.
+
+#define WF_GROUP_SIZE 64
+
+// Slots of the counter buffer.
+#define WF_LIVE_IN 0
+#define WF_LIVE_OUT 1
+#define WF_MATERIAL_QUEUE(m) (2 + (m))
+#define WF_NUM_COUNTERS 5
+
+// Entries of the indirect dispatch argument buffer.
+#define WF_ARGS_EXTEND 0
+#define WF_ARGS_SHADE(m) (1 + (m))
+#define WF_NUM_ARGS 4
+
+struct WavefrontPath {
+  float3 origin;
+  uint pixel;
+  float3 direction;
+  // Bounces so far, which with the pixel and the sample keys its random
+  // numbers.
+  uint depth;
+  float3 throughput;
+  uint pad0;
+};
+
+// Written by extend at the index of its path in g_paths_in.
+struct WavefrontHit {
+  float3 pos;
+  uint obj_id;
+  float3 normal;
+  uint pad0;
+};
+
+#endif
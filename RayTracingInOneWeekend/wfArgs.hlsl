@@ -0,0 +1,39 @@
+#include "wavefront.hlsli"
+
+cbuffer ArgsCB : register(b0) {
+  // 0: start of a bounce, 1: after extend, 2: before generate.
+  uint g_stage;
+  // Where to log the live path count in stage 0.
+  uint g_history_slot;
+};
+
+RWStructuredBuffer<uint> g_counters : register(u0);
+RWStructuredBuffer<uint3> g_args : register(u1);
+RWStructuredBuffer<uint> g_history : register(u2);
+
+// Turns the queue counters into indirect dispatch sizes. Runs on one thread
+// between the stages so the sizes never have to leave the GPU.
+[numthreads(1, 1, 1)]
+void main() {
+  if (g_stage == 0) {
+    // The output queue of the last bounce is the input of this one.
+    uint live = g_counters[WF_LIVE_OUT];
+    g_counters[WF_LIVE_IN] = live;
+    g_counters[WF_LIVE_OUT] = 0;
+    for (uint m = 0; m < 3; m++) {
+      g_counters[WF_MATERIAL_QUEUE(m)] = 0;
+    }
+    g_args[WF_ARGS_EXTEND] =
+        uint3((live + WF_GROUP_SIZE - 1) / WF_GROUP_SIZE, 1, 1);
+    g_history[g_history_slot] = live;
+  } else if (g_stage == 2) {
+    // generate appends the camera rays of the pixels still sampling.
+    g_counters[WF_LIVE_OUT] = 0;
+  } else {
+    for (uint m = 0; m < 3; m++) {
+      uint count = g_counters[WF_MATERIAL_QUEUE(m)];
+      g_args[WF_ARGS_SHADE(m)] =
+          uint3((count + WF_GROUP_SIZE - 1) / WF_GROUP_SIZE, 1, 1);
+    }
+  }
+}
@@ -0,0 +1,60 @@
+#include "bvh.hlsli"
+#include "material.hlsli"
+#include "wavefront.hlsli"
+
+cbuffer ImageCB : register(b0) {
+  uint g_image_width;
+  uint g_image_height;
+  uint g_sample_idx;
+  uint g_num_samples;
+  uint g_max_depth;
+};
+
+// Spheres and materials in BVH leaf order.
+StructuredBuffer<Sphere> g_spheres : register(t0);
+StructuredBuffer<Material> g_materials : register(t1);
+StructuredBuffer<BvhNode> g_nodes : register(t2);
+
+RWStructuredBuffer<uint> g_counters : register(u0);
+RWStructuredBuffer<WavefrontPath> g_paths_in : register(u1);
+RWStructuredBuffer<WavefrontHit> g_hits : register(u2);
+// Three queues of g_image_width * g_image_height path indices.
+RWStructuredBuffer<uint> g_material_queues : register(u3);
+RWStructuredBuffer<float3> g_radiance : register(u4);
+
+// Closest hit of every live path. Escaped paths add the sky to their pixel
+// and end here; the others queue up for the kernel of their material.
+[numthreads(WF_GROUP_SIZE, 1, 1)]
+void main(uint3 dtid : SV_DispatchThreadID) {
+  uint i = dtid.x;
+  if (i >= g_counters[WF_LIVE_IN]) {
+    return;
+  }
+  WavefrontPath path = g_paths_in[i];
+  Ray ray;
+  ray.origin = path.origin;
+  ray.pad0 = 0;
+  ray.direction = path.direction;
+  ray.pad1 = 0;
+  uint hit_obj_id = 0;
+  HitRecord rec = hitBvh(ray, g_nodes, g_spheres, hit_obj_id);
+  if (!rec.is_hit) {
+    float t = 0.5f * (ray.direction.y + 1.f);
+    g_radiance[path.pixel] =
+        path.throughput *
+        ((1.f - t) * float3(1.f, 1.f, 1.f) + t * float3(0.5f, 0.7f, 1.f));
+    return;
+  }
+
+  WavefrontHit hit;
+  hit.pos = rec.pos;
+  hit.obj_id = hit_obj_id;
+  hit.normal = rec.normal;
+  hit.pad0 = 0;
+  g_hits[i] = hit;
+
+  uint m = g_materials[hit_obj_id].type;
+  uint slot;
+  InterlockedAdd(g_counters[WF_MATERIAL_QUEUE(m)], 1, slot);
+  g_material_queues[m * g_image_width * g_image_height + slot] = i;
+}
@@ -0,0 +1,50 @@
+#include "camera.hlsli"
+#include "stats.hlsli"
+#include "wavefront.hlsli"
+
+cbuffer ImageCB : register(b0) {
+  uint g_image_width;
+  uint g_image_height;
+  uint g_sample_idx;
+  uint g_num_samples;
+  uint g_max_depth;
+  uint g_adaptive_min_samples;
+  float g_adaptive_threshold;
+  uint g_seed;
+  uint g_sampler;
+};
+
+RWStructuredBuffer<WavefrontPath> g_paths_out : register(u0);
+RWStructuredBuffer<float3> g_radiance : register(u1);
+RWStructuredBuffer<uint> g_counters : register(u2);
+RWStructuredBuffer<PixelStats> g_stats : register(u3);
+
+// Camera rays for every pixel that blend has not retired, appended to
+// g_paths_out in any order.
+[numthreads(16, 16, 1)]
+void main(uint3 dtid : SV_DispatchThreadID) {
+  if (dtid.x >= g_image_width || dtid.y >= g_image_height) {
+    return;
+  }
+  uint idx = dtid.y * g_image_width + dtid.x;
+  // Paths still bouncing after g_max_depth get no light.
+  g_radiance[idx] = float3(0.f, 0.f, 0.f);
+  if (g_sample_idx > 0 && g_stats[idx].active == 0) {
+    return;
+  }
+  float s = float(dtid.x) / float(g_image_width);
+  float t = float(dtid.y) / float(g_image_height);
+  Rng rng = makeRng(g_sampler, pixelKey(g_seed, idx), g_sample_idx);
+  Ray ray = cameraRay(s, t, rng);
+
+  WavefrontPath path;
+  path.origin = ray.origin;
+  path.pixel = idx;
+  path.direction = ray.direction;
+  path.depth = 0;
+  path.throughput = float3(1.f, 1.f, 1.f);
+  path.pad0 = 0;
+  uint slot;
+  InterlockedAdd(g_counters[WF_LIVE_OUT], 1, slot);
+  g_paths_out[slot] = path;
+}
@@ -0,0 +1,59 @@
+#ifndef __WF_SHADE_HLSLI__
+#define __WF_SHADE_HLSLI__
+
+// Shading kernel for the material WF_MATERIAL, defined by the including
+// file, so every thread of a dispatch runs the same scatter.
+
+#include "material.hlsli"
+#include "wavefront.hlsli"
+
+cbuffer ImageCB : register(b0) {
+  uint g_image_width;
+  uint g_image_height;
+  uint g_sample_idx;
+  uint g_num_samples;
+  uint g_max_depth;
+  uint g_adaptive_min_samples;
+  float g_adaptive_threshold;
+  uint g_seed;
+  uint g_sampler;
+};
+
+StructuredBuffer<Material> g_materials : register(t0);
+
+RWStructuredBuffer<uint> g_counters : register(u0);
+RWStructuredBuffer<WavefrontPath> g_paths_in : register(u1);
+RWStructuredBuffer<WavefrontHit> g_hits : register(u2);
+RWStructuredBuffer<uint> g_material_queues : register(u3);
+RWStructuredBuffer<WavefrontPath> g_paths_out : register(u4);
+
+[numthreads(WF_GROUP_SIZE, 1, 1)]
+void main(uint3 dtid : SV_DispatchThreadID) {
+  if (dtid.x >= g_counters[WF_MATERIAL_QUEUE(WF_MATERIAL)]) {
+    return;
+  }
+  uint i = g_material_queues[WF_MATERIAL * g_image_width * g_image_height +
+                             dtid.x];
+  WavefrontPath path = g_paths_in[i];
+  WavefrontHit hit = g_hits[i];
+  Material mat = g_materials[hit.obj_id];
+
+  Rng rng = makeRng(g_sampler, pixelKey(g_seed, path.pixel), g_sample_idx);
+  rngBounce(rng, path.depth);
+#if WF_MATERIAL == MATERIAL_METAL
+  path.direction = scatterMetal(mat, path.direction, hit.normal, rng);
+#elif WF_MATERIAL == MATERIAL_GLASS
+  path.direction = scatterGlass(mat, path.direction, hit.normal, rng);
+#else
+  path.direction = scatterLambertian(mat, path.direction, hit.normal, rng);
+#endif
+  path.origin = hit.pos;
+  path.throughput *= attenuation(mat);
+  path.depth++;
+
+  uint slot;
+  InterlockedAdd(g_counters[WF_LIVE_OUT], 1, slot);
+  g_paths_out[slot] = path;
+}
+
+#endif
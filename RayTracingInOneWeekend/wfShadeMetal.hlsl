@@ -0,0 +1,4 @@
+#include "material.hlsli"
+
+#define WF_MATERIAL MATERIAL_METAL
+#include "wfShade.hlsli"
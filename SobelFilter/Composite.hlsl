@@ -11,6 +11,16 @@ SamplerState gsamPointClamp       : register(s1);
 Texture2D gBaseMap : register(t0);
 Texture2D gEdgeMap : register(t1);
 
+// Both maps are pooled render targets that may be larger than the screen;
+// these scale [0,1] texcoords onto the valid region of each.
+cbuffer cbComposite : register(b0)
+{
+	float2 gBaseTexScale;
+	float2 gEdgeTexScale;
+	// Valid region of the base map in texels, for SobelCompositePS.
+	float2 gBaseSize;
+};
+
 static const float2 gTexCoords[6] = {
 	float2(0.0f, 0.0f),
 	float2(0.0f, 1.0f),
@@ -40,8 +50,46 @@ VertexOut VS(uint vid : SV_VertexID)
 
 float4 PS(VertexOut pin) : SV_Target
 {
-	float4 c = gBaseMap.SampleLevel(gsamPointClamp, pin.TexC, 0.0f);
-	float4 e = gEdgeMap.SampleLevel(gsamPointClamp, pin.TexC, 0.0f);
+	float4 c = gBaseMap.SampleLevel(gsamPointClamp, pin.TexC * gBaseTexScale, 0.0f);
+	float4 e = gEdgeMap.SampleLevel(gsamPointClamp, pin.TexC * gEdgeTexScale, 0.0f);
 
 	return c * e;
 }
+
+// Same weights as CalcLuminance in SobelFilter.hlsl.
+float CalcLuminance(float3 color)
+{
+	return dot(color, float3(0.299f, 0.578f, 0.114f));
+}
+
+// Texels outside the valid region read as zero, like the out-of-bounds loads
+// of SobelCS.
+float LoadLuminance(int2 p)
+{
+	if (any(p < 0) || any(p >= int2(gBaseSize)))
+		return 0.0f;
+	return CalcLuminance(gBaseMap.Load(int3(p, 0)).rgb);
+}
+
+// SobelCS fused with PS: the edge value of each pixel is computed from its 3x3
+// neighbourhood of the base map and multiplied in straight away, so the edge
+// map is never written and the result goes straight to the render target.
+float4 SobelCompositePS(VertexOut pin) : SV_Target
+{
+	int2 p = int2(pin.PosH.xy);
+
+	float c[3][3];
+	[unroll]
+	for (int i = 0; i < 3; ++i)
+	{
+		[unroll]
+		for (int j = 0; j < 3; ++j)
+			c[i][j] = LoadLuminance(p + int2(j - 1, i - 1));
+	}
+
+	float Gx = (c[0][2] + 2.0f * c[1][2] + c[2][2]) - (c[0][0] + 2.0f * c[1][0] + c[2][0]);
+	float Gy = (c[0][0] + 2.0f * c[0][1] + c[0][2]) - (c[2][0] + 2.0f * c[2][1] + c[2][2]);
+	float mag = 1.0f - saturate(sqrt(Gx * Gx + Gy * Gy));
+
+	return gBaseMap.Load(int3(p, 0)) * mag;
+}
@@ -1,102 +0,0 @@
-#pragma once
-#include <Common/d3dUtil.h>
-#include <Common/UploadBuffer.h>
-
-using namespace DirectX;
-using namespace DirectX::PackedVector;
-
-struct PassConstants
-{
-	XMFLOAT4X4 View = MathHelper::Identity4x4();
-	XMFLOAT4X4 Proj = MathHelper::Identity4x4();
-	XMFLOAT4X4 ViewProj = MathHelper::Identity4x4();
-	XMFLOAT3 EyePosW = { 0.0f, 0.0f, 0.0f };
-	float cbPerObjectPad1 = 0.0f;
-
-	XMFLOAT4 AmbientLight = { 0.0f, 0.0f, 0.0f, 1.0f };
-
-	XMFLOAT4 FogColor = { 0.7f, 0.7f, 0.7f, 1.0f };
-	float FogStart = 10.0f;
-	float FogRange = 200.0f;
-	XMFLOAT2 cbPerPassPad2;
-
-	// Indices [0, NUM_DIR_LIGHTS) are directional lights;
-	// indices [NUM_DIR_LIGHTS, NUM_DIR_LIGHTS+NUM_POINT_LIGHTS) are point lights;
-	// indices [NUM_DIR_LIGHTS+NUM_POINT_LIGHTS, NUM_DIR_LIGHTS+NUM_POINT_LIGHT+NUM_SPOT_LIGHTS)
-	// are spot lights for a maximum of MaxLights per object.
-	Light Lights[MaxLights];
-};
-
-struct ObjectConstants
-{
-	XMFLOAT4X4 World = MathHelper::Identity4x4();
-	XMFLOAT4X4 WorldInvTranspose = MathHelper::Identity4x4();
-	XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
-
-	XMFLOAT2 DisplacementMapTexelSize;
-	float GridSpatialStep;
-	float cbPerObjectPad1;
-};
-
-// CPUΪÿ֡бԴ
-// е죬ȡʵʻԴ
-struct FrameResource
-{
-public:
-	FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount);
-	FrameResource(const FrameResource& rhs) = delete;
-	FrameResource& operator=(const FrameResource& rhs) = delete;
-	~FrameResource();
-
-	// GPUص֮ǰǲܶ
-	// ÿһ֡ҪԼ
-	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CmdListAlloc;
-
-	// GPUִô˳֮ǰǲܶи
-	// ÿһ֡ҪԼĳ
-	std::unique_ptr<UploadBuffer<PassConstants>> PassCB = nullptr;
-	std::unique_ptr<UploadBuffer<ObjectConstants>> ObjectCB = nullptr;
-	std::unique_ptr<UploadBuffer<MaterialConstants>> MaterialCB = nullptr;
-
-	// ͨΧֵǵΧ㣬ʹǿԼ⵽GPUǷʹЩԴ
-	UINT64 Fence = 0;
-};
-
-// 洢ͼṹ
-struct RenderItem
-{
-	RenderItem() = default;
-
-	// Model/World
-	XMFLOAT4X4 World = MathHelper::Identity4x4();
-	XMFLOAT4X4 WorldInvTranspose = MathHelper::Identity4x4();
-	// Tex
-	XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
-
-	XMFLOAT2 DisplacementMapTexelSize;
-	float GridSpatialStep;
-
-	// ʾѾı䣬ζŴʱҪ³
-	// ÿFrameResourceжһObjectǱÿ
-	// FrameResourceи¡޸ݵʱӦ
-	// NumFramesDirty = gNumFrameResources
-	// Ӷʹÿ֡Դõ
-	int NumFramesDirty = gNumFrameResources;
-
-	// ָGPUӦڵǰȾе峣
-	UINT ObjCBIndex = -1;
-
-	// ȾƵļ塣һܻõȾ
-	MeshGeometry* Geo = nullptr;
-
-	// ĲʣһʿΪʹ
-	Material* Mat = nullptr;
-
-	// ͼԪ
-	D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-
-	// DrawInstancedInstancedĲ
-	UINT IndexCount = 0;
-	UINT StartIndexLocation = 0;
-	UINT BaseVertexLocation = 0;
-};
@@ -1,158 +0,0 @@
-#define NUM_DIR_LIGHTS 3
-
-// Defaults for number of lights.
-#ifndef NUM_DIR_LIGHTS
-#define NUM_DIR_LIGHTS 1
-#endif
-
-#ifndef NUM_POINT_LIGHTS
-#define NUM_POINT_LIGHTS 0
-#endif
-
-#ifndef NUM_SPOT_LIGHTS
-#define NUM_SPOT_LIGHTS 0
-#endif
-
-// Include structures and functions for lighting.
-#include "../Shaders/LightingUtil.hlsl"
-
-// Samplers
-SamplerState gsamLinearWrap        : register(s0);
-SamplerState gsamPointClamp        : register(s1);
-
-// Textures
-Texture2D gDiffuseMap             : register(t0);
-Texture2D gDisplacementMap        : register(t1);
-
-// Constant data that varies per frame.
-
-cbuffer cbPerObject : register(b0)
-{
-	float4x4 gWorld;
-	float4x4 gWorldInvTranspose;
-	float4x4 gTexTransform;
-
-	float2 gDisplacementMapTexelSize;
-	float gGridSpatialStep;
-	float cbPerObjectPad1;
-};
-
-cbuffer cbMaterial : register(b1)
-{
-	float4 gDiffuseAlbedo;
-	float3 gFresnelR0;
-	float  gRoughness;
-	float4x4 gMatTransform;
-};
-
-// Constant data that varies per material.
-cbuffer cbPass : register(b2)
-{
-	float4x4 gView;
-	float4x4 gProj;
-	float4x4 gViewProj;
-	float3 gEyePosW;
-	float cbPerPassPad1;
-	float4 gAmbientLight;
-
-	// Fog
-	float4 gFogColor;
-	float gFogStart;
-	float gFogRange;
-	float2 cbPerPassPad2;
-
-	// Indices [0, NUM_DIR_LIGHTS) are directional lights;
-	// indices [NUM_DIR_LIGHTS, NUM_DIR_LIGHTS+NUM_POINT_LIGHTS) are point lights;
-	// indices [NUM_DIR_LIGHTS+NUM_POINT_LIGHTS, NUM_DIR_LIGHTS+NUM_POINT_LIGHT+NUM_SPOT_LIGHTS)
-	// are spot lights for a maximum of MaxLights per object.
-	Light gLights[MaxLights];
-};
-
-struct VertexIn
-{
-	float3 PosL    : POSITION;
-	float3 NormalL : NORMAL;
-	float2 TexC    : TEXCOORD;
-};
-
-struct VertexOut
-{
-	float4 PosH    : SV_POSITION;
-	float3 PosW    : POSITION;
-	float3 NormalW : NORMAL;
-	float2 TexC    : TEXCOORD;
-};
-
-VertexOut VS(VertexIn vin)
-{
-	VertexOut vout;
-
-#ifdef DISPLACEMENT_MAP
-	// Sample the displacement map using non-transformed [0,1]^2 tex-coords.
-	vin.PosL.y += gDisplacementMap.SampleLevel(gsamLinearWrap, vin.TexC, 1.0f).r;
-
-	// Estimate normal using finite difference.
-	float du = gDisplacementMapTexelSize.x;
-	float dv = gDisplacementMapTexelSize.y;
-	float l = gDisplacementMap.SampleLevel(gsamPointClamp, vin.TexC - float2(du, 0.0f), 0.0f).r;
-	float r = gDisplacementMap.SampleLevel(gsamPointClamp, vin.TexC + float2(du, 0.0f), 0.0f).r;
-	float t = gDisplacementMap.SampleLevel(gsamPointClamp, vin.TexC - float2(0.0f, dv), 0.0f).r;
-	float b = gDisplacementMap.SampleLevel(gsamPointClamp, vin.TexC + float2(0.0f, dv), 0.0f).r;
-	vin.NormalL = normalize(float3(-r + l, 2.0f * gGridSpatialStep, b - t));
-#endif
-
-	// Transform to world space.
-	float4 posW = mul(float4(vin.PosL, 1.0f), gWorld);
-	vout.PosW = posW.xyz;
-
-	// Assumes nonuniform scaling; otherwise, need to use inverse-transpose of world matrix.
-	vout.NormalW = mul(vin.NormalL, (float3x3)gWorld);
-
-	// Transform to homogeneous clip space.
-	vout.PosH = mul(posW, gViewProj);
-
-	float4 texC = mul(float4(vin.TexC, 0.0f, 1.0f), gTexTransform);
-	vout.TexC = mul(texC, gMatTransform).xy;
-
-	return vout;
-}
-
-float4 PS(VertexOut pin) : SV_Target
-{
-	float4 diffuseAlbedo = gDiffuseMap.Sample(gsamLinearWrap, pin.TexC) * gDiffuseAlbedo;
-
-#ifdef ALPHA_TEST
-	// if alpha < 0.1 then discard this pixel
-	clip(diffuseAlbedo.a - 0.1f);
-#endif
-
-	// Interpolating normal can unnormalize it, so renormalize it.
-	pin.NormalW = normalize(pin.NormalW);
-
-	// Vector from point being lit to eye. 
-	float3 toEyeW = normalize(gEyePosW - pin.PosW);
-
-	// Indirect lighting.
-	float4 ambient = gAmbientLight * diffuseAlbedo;
-
-	const float shininess = 1.0f - gRoughness;
-	Material mat = { diffuseAlbedo, gFresnelR0, shininess };
-	float3 shadowFactor = 1.0f;
-	float4 directLight = ComputeLighting(gLights, mat, pin.PosW,
-		pin.NormalW, toEyeW, shadowFactor);
-
-	float4 litColor = ambient + directLight;
-
-#ifdef FOG
-	float distToEye = distance(gEyePosW, pin.PosW);
-	float fogAmount = saturate((distToEye - gFogStart) / gFogRange);
-	litColor = lerp(litColor, gFogColor, fogAmount);
-#endif
-
-	// Common convention to take alpha from diffuse material.
-	litColor.a = diffuseAlbedo.a;
-
-	return litColor;
-}
-
-
@@ -0,0 +1,136 @@
+#include "PostProcessCpu.h"
+
+#include <Common/ParallelFor.h>
+
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+	struct Texel
+	{
+		float v[4];
+	};
+
+	// Out-of-image texels read as zero, like out-of-bounds loads on the GPU.
+	inline Texel Load(const PostProcessImage& img, int x, int y)
+	{
+		Texel t = {};
+		if (x < 0 || y < 0 || x >= img.Width || y >= img.Height)
+			return t;
+		const float* p = &img.Texels[((size_t)y * img.Width + x) * 4];
+		for (int c = 0; c < 4; ++c)
+			t.v[c] = p[c];
+		return t;
+	}
+
+	Texel Blur(const PostProcessImage& src, int x, int y)
+	{
+		static const float w[3] = { 1.0f, 2.0f, 1.0f };
+
+		Texel t = {};
+		for (int i = 0; i < 3; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				Texel s = Load(src, x - 1 + j, y - 1 + i);
+				float k = w[i] * w[j] / 16.0f;
+				for (int c = 0; c < 4; ++c)
+					t.v[c] += k * s.v[c];
+			}
+		}
+		return t;
+	}
+}
+
+void PostProcessCpu::Execute(const PostProcessPlan& plan, const PostProcessImage& input, PostProcessImage& output, int threadCount)
+{
+	const int width = input.Width;
+	const int height = input.Height;
+
+	if ((int)mTextures.size() < plan.TextureCount)
+		mTextures.resize(plan.TextureCount);
+	for (int i = 0; i < plan.TextureCount; ++i)
+	{
+		if (mTextures[i].Width != width || mTextures[i].Height != height)
+		{
+			mTextures[i].Resize(width, height);
+			++mAllocationCount;
+		}
+	}
+
+	auto texture = [&](int index) -> const PostProcessImage&
+	{
+		return index < 0 ? input : mTextures[index];
+	};
+
+	if (threadCount <= 0)
+		threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+
+	for (const PostProcessPass& pass : plan.Passes)
+	{
+		const PostProcessImage& src = texture(pass.Source);
+		PostProcessImage& dst = mTextures[pass.Target];
+
+		// edges is the row of Sobel edges when the pass starts with Sobel.
+		auto shadeRow = [&](int y, const float* edges)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				Texel t;
+				switch (pass.Head)
+				{
+				case PostProcessOp::Sobel:
+					for (int c = 0; c < 4; ++c)
+						t.v[c] = edges[x];
+					break;
+				case PostProcessOp::Blur: t = Blur(src, x, y); break;
+				default: t = Load(src, x, y); break;
+				}
+
+				for (const PostProcessFusedOp& op : pass.Fused)
+				{
+					if (op.Op == PostProcessOp::Threshold)
+					{
+						for (int c = 0; c < 4; ++c)
+							t.v[c] = t.v[c] >= op.Param ? 1.0f : 0.0f;
+					}
+					else if (op.Op == PostProcessOp::Composite)
+					{
+						Texel o = Load(texture(op.OtherTexture), x, y);
+						for (int c = 0; c < 4; ++c)
+							t.v[c] *= o.v[c];
+					}
+				}
+
+				float* p = &dst.Texels[((size_t)y * width + x) * 4];
+				for (int c = 0; c < 4; ++c)
+					p[c] = t.v[c];
+			}
+		};
+
+		if (pass.Head != PostProcessOp::Sobel)
+		{
+			ParallelFor(0, height, threadCount, [&](int y) { shadeRow(y, nullptr); });
+			continue;
+		}
+
+		// One band of rows per thread, each sliding its own luminance window
+		// down the band, so the edge map never exists as a whole.
+		const int bands = std::max(1, std::min(threadCount, height));
+		const int chunk = (height + bands - 1) / bands;
+		const size_t scratchSize = SobelCpu::ScratchSize(width);
+		if (mSobelScratch.size() < scratchSize * bands)
+			mSobelScratch.resize(scratchSize * bands);
+
+		ParallelFor(0, bands, bands, [&](int band)
+		{
+			int first = band * chunk;
+			int last = std::min(first + chunk, height);
+			SobelCpu::ExecuteRows(src.Texels.data(), (size_t)width * 4, width, height, first, last,
+				mSobelScratch.data() + scratchSize * band, SobelCpuPath::Avx2, shadeRow);
+		});
+	}
+
+	output = mTextures[plan.OutputTexture];
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "PostProcessGraph.h"
+#include "SobelCpu.h"
+
+#include <cstddef>
+#include <vector>
+
+// RGBA float image, row-major, no padding.
+struct PostProcessImage
+{
+	int Width = 0;
+	int Height = 0;
+	std::vector<float> Texels;
+
+	void Resize(int width, int height)
+	{
+		Width = width;
+		Height = height;
+		Texels.resize((std::size_t)width * height * 4);
+	}
+};
+
+///<summary>
+/// Executes a compiled PostProcessPlan on the CPU. Intermediate textures are
+/// pooled in the executor and reused across frames of the same size. Sobel
+/// passes compute their edges a row at a time inside the pass, with
+/// SobelCpu::ExecuteRows, rather than reading a full-frame edge map.
+///</summary>
+class PostProcessCpu
+{
+public:
+	PostProcessCpu() = default;
+	PostProcessCpu(const PostProcessCpu& rhs) = delete;
+	PostProcessCpu& operator=(const PostProcessCpu& rhs) = delete;
+	~PostProcessCpu() = default;
+
+	void Execute(const PostProcessPlan& plan, const PostProcessImage& input, PostProcessImage& output, int threadCount = 0);
+
+	// Number of times a pooled texture had to be (re)allocated.
+	int AllocationCount() const { return mAllocationCount; }
+
+private:
+	std::vector<PostProcessImage> mTextures;
+	int mAllocationCount = 0;
+
+	// SobelCpu::ScratchSize floats per thread.
+	std::vector<float> mSobelScratch;
+};
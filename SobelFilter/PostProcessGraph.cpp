@@ -0,0 +1,207 @@
+#include "PostProcessGraph.h"
+
+#include <algorithm>
+#include <cassert>
+
+PostProcessGraph::PostProcessGraph()
+{
+	mNodes.push_back(PostProcessNode());
+}
+
+int PostProcessGraph::AddNode(PostProcessOp op, int src, int src2, float param)
+{
+	int id = (int)mNodes.size();
+	assert(src >= 0 && src < id);
+	assert(src2 < id);
+
+	PostProcessNode node;
+	node.Op = op;
+	node.Src = src;
+	node.Src2 = src2;
+	node.Param = param;
+	mNodes.push_back(node);
+	return id;
+}
+
+int PostProcessGraph::AddSobel(int src)
+{
+	return AddNode(PostProcessOp::Sobel, src, -1, 0.0f);
+}
+
+int PostProcessGraph::AddBlur(int src)
+{
+	return AddNode(PostProcessOp::Blur, src, -1, 0.0f);
+}
+
+int PostProcessGraph::AddThreshold(int src, float threshold)
+{
+	return AddNode(PostProcessOp::Threshold, src, -1, threshold);
+}
+
+int PostProcessGraph::AddComposite(int color, int mask)
+{
+	assert(mask >= 0);
+	return AddNode(PostProcessOp::Composite, color, mask, 0.0f);
+}
+
+void PostProcessGraph::SetOutput(int node)
+{
+	assert(node >= 0 && node < (int)mNodes.size());
+	mOutput = node;
+}
+
+PostProcessPlan PostProcessGraph::Compile(bool enableFusion) const
+{
+	const int nodeCount = (int)mNodes.size();
+
+	// Only nodes reachable from the output are scheduled.
+	std::vector<bool> live(nodeCount, false);
+	live[mOutput] = true;
+	for (int i = nodeCount - 1; i > 0; --i)
+	{
+		if (!live[i])
+			continue;
+		live[mNodes[i].Src] = true;
+		if (mNodes[i].Src2 >= 0)
+			live[mNodes[i].Src2] = true;
+	}
+
+	// The output counts as one more consumer so it is always materialized.
+	std::vector<int> consumers(nodeCount, 0);
+	consumers[mOutput]++;
+	for (int i = 1; i < nodeCount; ++i)
+	{
+		if (!live[i])
+			continue;
+		consumers[mNodes[i].Src]++;
+		if (mNodes[i].Src2 >= 0)
+			consumers[mNodes[i].Src2]++;
+	}
+
+	// Pass that produces each node; -1 for the graph input.
+	std::vector<int> passOf(nodeCount, -1);
+	// Last node of each pass, i.e. the value its target ends up holding.
+	std::vector<int> tailOf;
+
+	PostProcessPlan plan;
+
+	// Texture references are recorded as pass indices first and turned into
+	// pooled textures once lifetimes are known.
+	auto canFuseInto = [&](int producer, int other) -> bool
+	{
+		if (!enableFusion || producer == 0 || consumers[producer] != 1)
+			return false;
+		int pass = passOf[producer];
+		if (tailOf[pass] != producer)
+			return false;
+		// The other operand must already be in memory when the pass runs.
+		return other < 0 || passOf[other] < pass;
+	};
+
+	for (int i = 1; i < nodeCount; ++i)
+	{
+		if (!live[i])
+			continue;
+
+		const PostProcessNode& node = mNodes[i];
+		if (IsPerPixel(node.Op))
+		{
+			// Composite is a product, so either operand can carry the chain.
+			int chain = node.Src;
+			int other = node.Src2;
+			if (node.Op == PostProcessOp::Composite && canFuseInto(node.Src2, node.Src))
+				std::swap(chain, other);
+
+			PostProcessFusedOp op;
+			op.Op = node.Op;
+			op.Param = node.Param;
+			op.OtherTexture = other < 0 ? -1 : passOf[other];
+
+			if (canFuseInto(chain, other))
+			{
+				int pass = passOf[chain];
+				plan.Passes[pass].Fused.push_back(op);
+				tailOf[pass] = i;
+				passOf[i] = pass;
+				continue;
+			}
+
+			PostProcessPass copy;
+			copy.Head = PostProcessOp::Input;
+			copy.Source = passOf[chain];
+			copy.Fused.push_back(op);
+			passOf[i] = (int)plan.Passes.size();
+			plan.Passes.push_back(copy);
+			tailOf.push_back(i);
+		}
+		else
+		{
+			PostProcessPass pass;
+			pass.Head = node.Op;
+			pass.Source = passOf[node.Src];
+			passOf[i] = (int)plan.Passes.size();
+			plan.Passes.push_back(pass);
+			tailOf.push_back(i);
+		}
+	}
+
+	// The output is the input itself: a single copy pass.
+	if (mOutput == 0)
+	{
+		plan.Passes.push_back(PostProcessPass());
+		tailOf.push_back(0);
+	}
+
+	const int passCount = (int)plan.Passes.size();
+	const int outputPass = mOutput == 0 ? passCount - 1 : passOf[mOutput];
+	plan.VirtualTextureCount = passCount;
+
+	// Last pass reading each pass's result.
+	std::vector<int> lastUse(passCount, -1);
+	for (int p = 0; p < passCount; ++p)
+	{
+		if (plan.Passes[p].Source >= 0)
+			lastUse[plan.Passes[p].Source] = p;
+		for (auto& op : plan.Passes[p].Fused)
+			if (op.OtherTexture >= 0)
+				lastUse[op.OtherTexture] = p;
+	}
+	lastUse[outputPass] = passCount;
+
+	// Greedy interval allocation in pass order. A texture is only released after
+	// the pass that last reads it, so no pass ever reads and writes the same one.
+	std::vector<int> textureOf(passCount, -1);
+	std::vector<int> freeTextures;
+	for (int p = 0; p < passCount; ++p)
+	{
+		for (int q = 0; q < p; ++q)
+		{
+			if (lastUse[q] == p - 1 && textureOf[q] >= 0)
+				freeTextures.push_back(textureOf[q]);
+		}
+
+		if (freeTextures.empty())
+		{
+			textureOf[p] = plan.TextureCount++;
+		}
+		else
+		{
+			textureOf[p] = freeTextures.back();
+			freeTextures.pop_back();
+		}
+	}
+
+	for (auto& pass : plan.Passes)
+	{
+		if (pass.Source >= 0)
+			pass.Source = textureOf[pass.Source];
+		for (auto& op : pass.Fused)
+			if (op.OtherTexture >= 0)
+				op.OtherTexture = textureOf[op.OtherTexture];
+	}
+	for (int p = 0; p < passCount; ++p)
+		plan.Passes[p].Target = textureOf[p];
+
+	plan.OutputTexture = textureOf[outputPass];
+	return plan;
+}
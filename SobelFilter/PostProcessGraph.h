@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+
+enum class PostProcessOp
+{
+	Input,      // The image handed to the graph.
+	Sobel,      // Luminance edge map, 1 = flat, 0 = steep (see SobelFilter.hlsl).
+	Blur,       // 3x3 binomial blur.
+	Threshold,  // Per channel: value >= Param ? 1 : 0.
+	Composite   // Per channel product of two images.
+};
+
+struct PostProcessNode
+{
+	PostProcessOp Op = PostProcessOp::Input;
+	int Src = -1;
+	int Src2 = -1;
+	float Param = 0.0f;
+};
+
+// A per-pixel op fused into a pass. It is applied to the value in registers;
+// Composite additionally reads OtherTexture (-1 is the graph input).
+struct PostProcessFusedOp
+{
+	PostProcessOp Op = PostProcessOp::Threshold;
+	float Param = 0.0f;
+	int OtherTexture = -1;
+};
+
+// One dispatch on the GPU / one sweep over the image on the CPU: a head op that
+// may read a neighbourhood, followed by per-pixel ops that never leave registers.
+struct PostProcessPass
+{
+	PostProcessOp Head = PostProcessOp::Input;  // Input means a plain copy of Source.
+	int Source = -1;                            // -1 is the graph input.
+	std::vector<PostProcessFusedOp> Fused;
+	int Target = 0;                             // Pooled texture written by this pass.
+};
+
+struct PostProcessPlan
+{
+	std::vector<PostProcessPass> Passes;
+
+	// Intermediate textures the plan needs once lifetimes are aliased, against
+	// one texture per pass without aliasing.
+	int TextureCount = 0;
+	int VirtualTextureCount = 0;
+
+	// Texture holding the graph output after the last pass.
+	int OutputTexture = -1;
+};
+
+///<summary>
+/// Describes a post-processing chain as a DAG and compiles it into passes.
+/// Nodes must be added after their sources, so ids are already in topological order.
+///</summary>
+class PostProcessGraph
+{
+public:
+	PostProcessGraph();
+
+	static int Input() { return 0; }
+
+	int AddSobel(int src);
+	int AddBlur(int src);
+	int AddThreshold(int src, float threshold);
+	int AddComposite(int color, int mask);
+
+	void SetOutput(int node);
+
+	const std::vector<PostProcessNode>& Nodes() const { return mNodes; }
+
+	PostProcessPlan Compile(bool enableFusion = true) const;
+
+	static bool IsPerPixel(PostProcessOp op) { return op == PostProcessOp::Threshold || op == PostProcessOp::Composite; }
+
+private:
+	int AddNode(PostProcessOp op, int src, int src2, float param);
+
+private:
+	std::vector<PostProcessNode> mNodes;
+	int mOutput = 0;
+};
@@ -3,6 +3,7 @@
 #include <windows.h>
 
 #include "SobelFilterApp.h"
+#include "SobelBenchmark.h"
 
 // Entry Point
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance, PSTR cmdLine, int showCmd)
@@ -12,6 +13,17 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance, PSTR cmdLine, in
     _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
 
+    // -bench: print the CPU edge detection benchmark to a console and exit.
+    if (strstr(cmdLine, "-bench") != nullptr)
+    {
+        if (!AttachConsole(ATTACH_PARENT_PROCESS))
+            AllocConsole();
+        FILE* stream = nullptr;
+        freopen_s(&stream, "CONOUT$", "w", stdout);
+
+        return RunSobelBenchmark();
+    }
+
     try
     {
         SobelFilterApp theApp(hInstance);
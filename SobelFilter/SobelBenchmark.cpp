@@ -0,0 +1,316 @@
+#include "SobelBenchmark.h"
+
+#include "SobelCpu.h"
+#include "PostProcessCpu.h"
+
+#include <Common/RenderTargetPool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	// Direct, non-separable 3x3 Sobel on luminance, written the way the
+	// original per-pixel shader indexed its neighbourhood.
+	void ReferenceSobel(const std::vector<std::uint8_t>& rgba, std::vector<float>& edges, int width, int height)
+	{
+		auto lum = [&](int x, int y) -> float
+		{
+			if (x < 0 || y < 0 || x >= width || y >= height)
+				return 0.0f;
+			const std::uint8_t* p = &rgba[4 * ((size_t)y * width + x)];
+			return (0.299f * p[0] + 0.578f * p[1] + 0.114f * p[2]) / 255.0f;
+		};
+
+		for (int y = 0; y < height; ++y)
+		{
+			for (int x = 0; x < width; ++x)
+			{
+				float c[3][3];
+				for (int i = 0; i < 3; ++i)
+					for (int j = 0; j < 3; ++j)
+						c[i][j] = lum(x - 1 + j, y - 1 + i);
+
+				float Gx = -c[0][0] - 2.0f * c[1][0] - c[2][0] + c[0][2] + 2.0f * c[1][2] + c[2][2];
+				float Gy = -c[2][0] - 2.0f * c[2][1] - c[2][2] + c[0][0] + 2.0f * c[0][1] + c[0][2];
+				float mag = std::sqrt(Gx * Gx + Gy * Gy);
+				edges[(size_t)y * width + x] = 1.0f - std::min(std::max(mag, 0.0f), 1.0f);
+			}
+		}
+	}
+
+	float MaxError(const std::vector<float>& a, const std::vector<float>& b)
+	{
+		float err = 0.0f;
+		for (size_t i = 0; i < a.size(); ++i)
+			err = std::max(err, std::fabs(a[i] - b[i]));
+		return err;
+	}
+
+	double TimeGraph(PostProcessCpu& executor, const PostProcessPlan& plan,
+		const PostProcessImage& input, PostProcessImage& output, int iterations)
+	{
+		executor.Execute(plan, input, output);
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < iterations; ++i)
+			executor.Execute(plan, input, output);
+		auto stop = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<double, std::milli>(stop - start).count() / iterations;
+	}
+
+	// Stands in for D3D12RenderTargetAllocator and only counts.
+	struct MockAllocator
+	{
+		struct Desc
+		{
+			int Format = 0;
+			bool operator==(const Desc& rhs) const { return Format == rhs.Format; }
+		};
+
+		struct Resource
+		{
+			std::uint64_t Bytes = 0;
+		};
+
+		Resource Allocate(const Desc&, unsigned int width, unsigned int height)
+		{
+			Resource r;
+			r.Bytes = (std::uint64_t)width * height * 4;
+			LiveBytes += r.Bytes;
+			PeakBytes = std::max(PeakBytes, LiveBytes);
+			return r;
+		}
+
+		void Release(Resource& resource)
+		{
+			LiveBytes -= resource.Bytes;
+			resource.Bytes = 0;
+		}
+
+		std::uint64_t LiveBytes = 0;
+		std::uint64_t PeakBytes = 0;
+	};
+
+	// A window dragged from 800x600 out to 1920x1080 and back, one size per frame,
+	// with the two size-dependent targets of SobelFilterApp. Returns false if the
+	// pool's counts differ from the known ones for this storm, or it does not
+	// beat recreating the targets by a wide margin.
+	bool RunResizeStormBenchmark()
+	{
+		const int frames = 600;
+		const unsigned int releaseDelay = 3;
+
+		// Two targets through the buckets on the way out, plus one shrink
+		// reallocation each on the way back; all but the last pair retired.
+		const int expectedAllocations = 18;
+		const int expectedReleases = 16;
+
+		RenderTargetPool<MockAllocator> pool(MockAllocator(), releaseDelay);
+		int naiveAllocations = 0;
+		std::uint64_t naivePeak = 0;
+		std::vector<std::pair<int, std::uint64_t>> naiveRetired;
+
+		unsigned int lastWidth = 0, lastHeight = 0;
+		for (int f = 0; f < frames; ++f)
+		{
+			float s = 0.5f - 0.5f * std::cos(6.2831853f * f / frames);
+			unsigned int width = 800 + (unsigned int)(1120 * s);
+			unsigned int height = 600 + (unsigned int)(480 * s);
+
+			pool.Acquire("EdgeMap", MockAllocator::Desc(), width, height);
+			pool.Acquire("TempBuffer", MockAllocator::Desc(), width, height);
+			pool.EndFrame();
+
+			// Recreating both textures on every size change; the old pair still
+			// has to outlive the frames in flight.
+			std::uint64_t bytes = (std::uint64_t)width * height * 4 * 2;
+			if (width != lastWidth || height != lastHeight)
+			{
+				naiveAllocations += 2;
+				if (lastWidth != 0)
+					naiveRetired.push_back({ f, (std::uint64_t)lastWidth * lastHeight * 4 * 2 });
+			}
+			while (!naiveRetired.empty() && f - naiveRetired.front().first >= (int)releaseDelay)
+				naiveRetired.erase(naiveRetired.begin());
+
+			std::uint64_t live = bytes;
+			for (auto& r : naiveRetired)
+				live += r.second;
+			naivePeak = std::max(naivePeak, live);
+			lastWidth = width;
+			lastHeight = height;
+		}
+
+		printf("\nresize storm, %d frames: %d allocations recreating per size, %d pooled (%d released, %zu pending)\n",
+			frames, naiveAllocations, pool.AllocationCount(), pool.ReleaseCount(), pool.PendingReleaseCount());
+		printf("peak texture memory: %.1f MB recreating, %.1f MB pooled\n",
+			naivePeak / 1048576.0, pool.GetAllocator().PeakBytes / 1048576.0);
+
+		bool ok = true;
+		if (pool.AllocationCount() != expectedAllocations || pool.ReleaseCount() != expectedReleases ||
+			pool.PendingReleaseCount() != 0)
+		{
+			printf("FAIL: want %d allocations, %d released, 0 pending\n", expectedAllocations, expectedReleases);
+			ok = false;
+		}
+		// Recreating makes 1134 allocations and peaks at 63 MB; the pool has to
+		// stay well clear of both.
+		if (pool.AllocationCount() * 50 > naiveAllocations)
+		{
+			printf("FAIL: pooling saves less than 50x the allocations of recreating\n");
+			ok = false;
+		}
+		if (pool.GetAllocator().PeakBytes * 3 > naivePeak * 2)
+		{
+			printf("FAIL: pooled peak is more than two thirds of recreating\n");
+			ok = false;
+		}
+		return ok;
+	}
+
+	// Returns false if a fused plan differs from the unfused one, or the
+	// row-at-a-time Sobel of the executor differs from SobelCpu::Execute.
+	bool RunPostProcessGraphBenchmark(int iterations)
+	{
+		PostProcessImage input;
+		input.Resize(1280, 720);
+		unsigned int state = 54321u;
+		for (auto& c : input.Texels)
+		{
+			state = state * 1664525u + 1013904223u;
+			c = (state >> 8) / 16777216.0f;
+		}
+
+		struct Case { const char* Name; PostProcessGraph Graph; };
+		std::vector<Case> cases(3);
+
+		// What SobelFilterApp draws: the scene multiplied by its edge map.
+		cases[0].Name = "sobel*scene";
+		{
+			auto& g = cases[0].Graph;
+			g.SetOutput(g.AddComposite(g.Input(), g.AddSobel(g.Input())));
+		}
+
+		cases[1].Name = "blur>sobel>thr*scene";
+		{
+			auto& g = cases[1].Graph;
+			int edges = g.AddThreshold(g.AddSobel(g.AddBlur(g.Input())), 0.5f);
+			g.SetOutput(g.AddComposite(g.Input(), edges));
+		}
+
+		cases[2].Name = "blur*sobel*scene";
+		{
+			auto& g = cases[2].Graph;
+			int blurred = g.AddBlur(g.Input());
+			int edges = g.AddSobel(g.Input());
+			g.SetOutput(g.AddComposite(g.Input(), g.AddComposite(blurred, edges)));
+		}
+
+		bool ok = true;
+
+		// Several bands, so rows at band edges see their neighbours' rows.
+		{
+			PostProcessGraph g;
+			g.SetOutput(g.AddSobel(g.Input()));
+			PostProcessCpu executor;
+			PostProcessImage rows;
+			executor.Execute(g.Compile(true), input, rows, 3);
+
+			SobelCpu sobel(input.Width, input.Height);
+			std::vector<float> frame((size_t)input.Width * input.Height), banded(frame.size());
+			sobel.Execute(input.Texels.data(), (size_t)input.Width * 4, frame.data());
+			for (size_t i = 0; i < banded.size(); ++i)
+				banded[i] = rows.Texels[4 * i];
+
+			float err = MaxError(banded, frame);
+			printf("\nsobel by rows vs whole frame: max err %.2e%s\n", err, err > 1.0e-5f ? "  MISMATCH" : "");
+			ok = ok && err <= 1.0e-5f;
+		}
+
+		printf("\n%22s %12s %12s %10s %10s %10s\n", "graph", "passes", "textures", "fused(ms)", "plain(ms)", "max err");
+		for (auto& c : cases)
+		{
+			PostProcessPlan fused = c.Graph.Compile(true);
+			PostProcessPlan plain = c.Graph.Compile(false);
+
+			PostProcessCpu fusedExec, plainExec;
+			PostProcessImage a, b;
+			double fusedMs = TimeGraph(fusedExec, fused, input, a, iterations);
+			double plainMs = TimeGraph(plainExec, plain, input, b, iterations);
+			float err = MaxError(a.Texels, b.Texels);
+
+			printf("%22s %5zu vs %-4zu %5d vs %-4d %10.2f %10.2f %10.2e%s\n", c.Name,
+				fused.Passes.size(), plain.Passes.size(), fused.TextureCount, plain.VirtualTextureCount,
+				fusedMs, plainMs, err, err > 1.0e-5f ? "  MISMATCH" : "");
+			ok = ok && err <= 1.0e-5f;
+		}
+		return ok;
+	}
+}
+
+int RunSobelBenchmark(int iterations)
+{
+	struct Resolution { int Width; int Height; };
+	const Resolution resolutions[] = { { 640, 480 }, { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 } };
+
+	struct Config { const char* Name; SobelCpuPath Path; int Threads; };
+	const int hwThreads = (int)std::max(1u, std::thread::hardware_concurrency());
+	const Config configs[] = {
+		{ "scalar x1", SobelCpuPath::Scalar, 1 },
+		{ "avx2 x1", SobelCpuPath::Avx2, 1 },
+		{ "scalar xN", SobelCpuPath::Scalar, hwThreads },
+		{ "avx2 xN", SobelCpuPath::Avx2, hwThreads },
+	};
+
+	printf("AVX2 %s, %d hardware threads\n", SobelCpu::Avx2Supported() ? "enabled" : "unavailable", hwThreads);
+	printf("%11s %10s %10s %10s\n", "resolution", "path", "MP/s", "max err");
+
+	bool ok = true;
+
+	for (const Resolution& res : resolutions)
+	{
+		// Deterministic noisy image so every path sees the same edges.
+		std::vector<std::uint8_t> image((size_t)res.Width * res.Height * 4);
+		unsigned int state = 12345u;
+		for (auto& c : image)
+		{
+			state = state * 1664525u + 1013904223u;
+			c = (std::uint8_t)(state >> 24);
+		}
+
+		std::vector<float> reference((size_t)res.Width * res.Height);
+		ReferenceSobel(image, reference, res.Width, res.Height);
+
+		SobelCpu sobel(res.Width, res.Height);
+		std::vector<float> edges(reference.size());
+
+		for (const Config& config : configs)
+		{
+			std::fill(edges.begin(), edges.end(), -1.0f);
+			sobel.Execute(image.data(), (size_t)res.Width * 4, edges.data(), config.Path, config.Threads);
+			float err = MaxError(edges, reference);
+
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < iterations; ++i)
+				sobel.Execute(image.data(), (size_t)res.Width * 4, edges.data(), config.Path, config.Threads);
+			auto stop = std::chrono::high_resolution_clock::now();
+
+			double seconds = std::chrono::duration<double>(stop - start).count();
+			double mps = (double)res.Width * res.Height * iterations / seconds / 1.0e6;
+
+			printf("%5dx%-5d %10s %10.1f %10.2e%s\n", res.Width, res.Height, config.Name, mps, err,
+				err > 1.0e-4f ? "  MISMATCH" : "");
+			ok = ok && err <= 1.0e-4f;
+		}
+	}
+
+	// Run every part even after a failure, so the output shows all of them.
+	ok = RunPostProcessGraphBenchmark(std::max(1, iterations / 4)) && ok;
+	ok = RunResizeStormBenchmark() && ok;
+	return ok ? 0 : 1;
+}
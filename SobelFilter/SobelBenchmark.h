@@ -0,0 +1,10 @@
+#pragma once
+
+// Headless edge detection throughput (megapixels per second) of the CPU
+// implementation across resolutions, paths and thread counts. Every path is
+// validated against a direct 3x3 convolution before it is timed. Also compiles
+// a few post-process graphs with and without fusion and compares the results,
+// then counts render target allocations during a simulated resize storm.
+// Returns non-zero if any path or graph disagrees with its reference
+// (printed as MISMATCH) or the pool fails its resize storm checks.
+int RunSobelBenchmark(int iterations = 20);
@@ -0,0 +1,124 @@
+#include "SobelCpu.h"
+
+#include <Common/CpuFeatures.h>
+#include <Common/ParallelFor.h>
+
+#include <algorithm>
+#include <cmath>
+
+// Same weights as CalcLuminance in SobelFilter.hlsl.
+static const float kWeightR = 0.299f;
+static const float kWeightG = 0.578f;
+static const float kWeightB = 0.114f;
+
+// The weights folded with the UNORM scale, for RGBA8 input.
+static const float kLumR = kWeightR / 255.0f;
+static const float kLumG = kWeightG / 255.0f;
+static const float kLumB = kWeightB / 255.0f;
+
+void SobelLuminanceRow(const std::uint8_t* rgba, float* lum, int begin, int width)
+{
+	for (int x = begin; x < width; ++x)
+	{
+		const std::uint8_t* p = rgba + 4 * x;
+		lum[x + 1] = kLumR * p[0] + kLumG * p[1] + kLumB * p[2];
+	}
+}
+
+void SobelLuminanceRow(const float* rgba, float* lum, int begin, int width)
+{
+	for (int x = begin; x < width; ++x)
+	{
+		const float* p = rgba + 4 * x;
+		lum[x + 1] = kWeightR * p[0] + kWeightG * p[1] + kWeightB * p[2];
+	}
+}
+
+void SobelEdgeRow(const float* top, const float* mid, const float* bottom, float* edges, int begin, int width)
+{
+	// Column x of the image is column x + 1 of the padded rows.
+	for (int x = begin; x < width; ++x)
+	{
+		float l = top[x] + 2.0f * mid[x] + bottom[x];
+		float r = top[x + 2] + 2.0f * mid[x + 2] + bottom[x + 2];
+		float t = top[x] + 2.0f * top[x + 1] + top[x + 2];
+		float b = bottom[x] + 2.0f * bottom[x + 1] + bottom[x + 2];
+
+		float Gx = r - l;
+		float Gy = t - b;
+		float mag = std::sqrt(Gx * Gx + Gy * Gy);
+		edges[x] = 1.0f - std::min(std::max(mag, 0.0f), 1.0f);
+	}
+}
+
+SobelCpu::SobelCpu(int width, int height)
+{
+	OnResize(width, height);
+}
+
+void SobelCpu::OnResize(int newWidth, int newHeight)
+{
+	mWidth = newWidth;
+	mHeight = newHeight;
+
+	// The border is never written, so it stays zero across frames.
+	mLum.assign((size_t)(mWidth + 2) * (mHeight + 2), 0.0f);
+}
+
+void SobelCpu::Execute(const std::uint8_t* rgba, std::size_t rowPitch, float* edges, SobelCpuPath path, int threadCount)
+{
+	const bool avx2 = path == SobelCpuPath::Avx2 && Avx2Supported();
+	const int paddedWidth = mWidth + 2;
+	float* lum = mLum.data();
+
+	ParallelFor(0, mHeight, threadCount, [&](int y)
+	{
+		const std::uint8_t* src = rgba + y * rowPitch;
+		float* dst = lum + (size_t)(y + 1) * paddedWidth;
+		if (avx2)
+			SobelLuminanceRowAvx2(src, dst, mWidth);
+		else
+			SobelLuminanceRow(src, dst, 0, mWidth);
+	});
+
+	EdgePass(edges, avx2, threadCount);
+}
+
+void SobelCpu::Execute(const float* rgba, std::size_t rowPitch, float* edges, SobelCpuPath path, int threadCount)
+{
+	const bool avx2 = path == SobelCpuPath::Avx2 && Avx2Supported();
+	const int paddedWidth = mWidth + 2;
+	float* lum = mLum.data();
+
+	ParallelFor(0, mHeight, threadCount, [&](int y)
+	{
+		SobelLuminanceRow(rgba + y * rowPitch, lum + (size_t)(y + 1) * paddedWidth, 0, mWidth);
+	});
+
+	EdgePass(edges, avx2, threadCount);
+}
+
+void SobelCpu::EdgePass(float* edges, bool avx2, int threadCount)
+{
+	const int paddedWidth = mWidth + 2;
+	const float* lum = mLum.data();
+
+	ParallelFor(0, mHeight, threadCount, [&](int y)
+	{
+		const float* top = lum + (size_t)y * paddedWidth;
+		const float* mid = top + paddedWidth;
+		const float* bottom = mid + paddedWidth;
+		float* dst = edges + (size_t)y * mWidth;
+		if (avx2)
+			SobelEdgeRowAvx2(top, mid, bottom, dst, mWidth);
+		else
+			SobelEdgeRow(top, mid, bottom, dst, 0, mWidth);
+	});
+}
+
+bool SobelCpu::Avx2Supported()
+{
+	if (!SobelAvx2Compiled())
+		return false;
+	return CpuSupportsAvx2();
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class SobelCpuPath
+{
+	Scalar,
+	Avx2
+};
+
+///<summary>
+/// CPU version of SobelFilter.hlsl, for computing and validating edge maps
+/// without a device. Input is RGBA8 (the back buffer format); texels outside
+/// the image read as zero, like out-of-bounds loads on the GPU. Output is the
+/// single edge value per pixel that the shader replicates into all channels.
+///</summary>
+class SobelCpu
+{
+public:
+	SobelCpu(int width, int height);
+
+	SobelCpu(const SobelCpu& rhs) = delete;
+	SobelCpu& operator=(const SobelCpu& rhs) = delete;
+	~SobelCpu() = default;
+
+	void OnResize(int newWidth, int newHeight);
+
+	///<summary>
+	/// Rows are split across threadCount threads (0 = all hardware threads).
+	/// The AVX2 path falls back to scalar when the CPU or build lacks support.
+	///</summary>
+	void Execute(const std::uint8_t* rgba, std::size_t rowPitch, float* edges,
+		SobelCpuPath path = SobelCpuPath::Avx2, int threadCount = 0);
+
+	///<summary>
+	/// As above for RGBA float input, rowPitch floats per row, such as the
+	/// images PostProcessCpu works on.
+	///</summary>
+	void Execute(const float* rgba, std::size_t rowPitch, float* edges,
+		SobelCpuPath path = SobelCpuPath::Avx2, int threadCount = 0);
+
+	///<summary>
+	/// Edge rows [first, last) of an RGBA float image without the full-frame
+	/// luminance buffer or edge map. Three padded luminance rows slide down
+	/// the image in scratch (ScratchSize(width) floats, one per thread) and
+	/// each row of edges is handed to row(y, edges) before the next is
+	/// computed, so a fused pass can consume it while it is still in cache.
+	///</summary>
+	template<typename RowFn>
+	static void ExecuteRows(const float* rgba, std::size_t rowPitch, int width, int height,
+		int first, int last, float* scratch, SobelCpuPath path, RowFn&& row);
+
+	static std::size_t ScratchSize(int width) { return (std::size_t)(width + 2) * 4; }
+
+	int Width() const { return mWidth; }
+	int Height() const { return mHeight; }
+
+	static bool Avx2Supported();
+
+private:
+	// Edges of mLum, which the Execute overloads have filled in.
+	void EdgePass(float* edges, bool avx2, int threadCount);
+
+	int mWidth = 0;
+	int mHeight = 0;
+
+	// Luminance with a one texel zero border: (mWidth + 2) x (mHeight + 2).
+	std::vector<float> mLum;
+};
+
+// Row kernels shared by the scalar and AVX2 translation units.
+// lum points at padded column 0 of the padded row; edges at image column 0.
+void SobelLuminanceRow(const std::uint8_t* rgba, float* lum, int begin, int width);
+void SobelLuminanceRow(const float* rgba, float* lum, int begin, int width);
+void SobelEdgeRow(const float* top, const float* mid, const float* bottom, float* edges, int begin, int width);
+
+void SobelLuminanceRowAvx2(const std::uint8_t* rgba, float* lum, int width);
+void SobelEdgeRowAvx2(const float* top, const float* mid, const float* bottom, float* edges, int width);
+bool SobelAvx2Compiled();
+
+template<typename RowFn>
+void SobelCpu::ExecuteRows(const float* rgba, std::size_t rowPitch, int width, int height,
+	int first, int last, float* scratch, SobelCpuPath path, RowFn&& row)
+{
+	const bool avx2 = path == SobelCpuPath::Avx2 && Avx2Supported();
+	const int paddedWidth = width + 2;
+	float* window[3] = { scratch, scratch + paddedWidth, scratch + 2 * paddedWidth };
+	float* edges = scratch + 3 * paddedWidth;
+
+	// Rows outside the image and the padding columns read as zero.
+	auto load = [&](float* lum, int y)
+	{
+		if (y < 0 || y >= height)
+		{
+			std::fill(lum, lum + paddedWidth, 0.0f);
+			return;
+		}
+		lum[0] = 0.0f;
+		lum[width + 1] = 0.0f;
+		SobelLuminanceRow(rgba + (std::size_t)y * rowPitch, lum, 0, width);
+	};
+
+	load(window[0], first - 1);
+	load(window[1], first);
+	for (int y = first; y < last; ++y)
+	{
+		load(window[2], y + 1);
+		if (avx2)
+			SobelEdgeRowAvx2(window[0], window[1], window[2], edges, width);
+		else
+			SobelEdgeRow(window[0], window[1], window[2], edges, 0, width);
+		row(y, static_cast<const float*>(edges));
+		std::rotate(window, window + 1, window + 3);
+	}
+}
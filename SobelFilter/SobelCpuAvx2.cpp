@@ -0,0 +1,87 @@
+// Compiled with AVX2 enabled (see SobelFilter.vcxproj); only called after
+// SobelCpu::Avx2Supported() has checked the CPU.
+#include "SobelCpu.h"
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+bool SobelAvx2Compiled()
+{
+	return true;
+}
+
+void SobelLuminanceRowAvx2(const std::uint8_t* rgba, float* lum, int width)
+{
+	const __m256i mask = _mm256_set1_epi32(0xFF);
+	const __m256 wr = _mm256_set1_ps(0.299f / 255.0f);
+	const __m256 wg = _mm256_set1_ps(0.578f / 255.0f);
+	const __m256 wb = _mm256_set1_ps(0.114f / 255.0f);
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8)
+	{
+		// Eight RGBA8 texels, one per 32-bit lane.
+		__m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rgba + 4 * x));
+		__m256 r = _mm256_cvtepi32_ps(_mm256_and_si256(px, mask));
+		__m256 g = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 8), mask));
+		__m256 b = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(px, 16), mask));
+
+		__m256 l = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r, wr), _mm256_mul_ps(g, wg)), _mm256_mul_ps(b, wb));
+		_mm256_storeu_ps(lum + x + 1, l);
+	}
+	SobelLuminanceRow(rgba, lum, x, width);
+}
+
+void SobelEdgeRowAvx2(const float* top, const float* mid, const float* bottom, float* edges, int width)
+{
+	const __m256 two = _mm256_set1_ps(2.0f);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8)
+	{
+		__m256 t0 = _mm256_loadu_ps(top + x);
+		__m256 t1 = _mm256_loadu_ps(top + x + 1);
+		__m256 t2 = _mm256_loadu_ps(top + x + 2);
+		__m256 m0 = _mm256_loadu_ps(mid + x);
+		__m256 m2 = _mm256_loadu_ps(mid + x + 2);
+		__m256 b0 = _mm256_loadu_ps(bottom + x);
+		__m256 b1 = _mm256_loadu_ps(bottom + x + 1);
+		__m256 b2 = _mm256_loadu_ps(bottom + x + 2);
+
+		// Vertical [1 2 1] on the outer columns, then horizontal [-1 0 1].
+		__m256 l = _mm256_add_ps(_mm256_add_ps(t0, _mm256_mul_ps(two, m0)), b0);
+		__m256 r = _mm256_add_ps(_mm256_add_ps(t2, _mm256_mul_ps(two, m2)), b2);
+		// Horizontal [1 2 1] on the outer rows, then vertical [1 0 -1].
+		__m256 t = _mm256_add_ps(_mm256_add_ps(t0, _mm256_mul_ps(two, t1)), t2);
+		__m256 b = _mm256_add_ps(_mm256_add_ps(b0, _mm256_mul_ps(two, b1)), b2);
+
+		__m256 gx = _mm256_sub_ps(r, l);
+		__m256 gy = _mm256_sub_ps(t, b);
+		__m256 mag = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(gx, gx), _mm256_mul_ps(gy, gy)));
+		mag = _mm256_min_ps(_mm256_max_ps(mag, zero), one);
+		_mm256_storeu_ps(edges + x, _mm256_sub_ps(one, mag));
+	}
+	SobelEdgeRow(top, mid, bottom, edges, x, width);
+}
+
+#else
+
+bool SobelAvx2Compiled()
+{
+	return false;
+}
+
+void SobelLuminanceRowAvx2(const std::uint8_t* rgba, float* lum, int width)
+{
+	SobelLuminanceRow(rgba, lum, 0, width);
+}
+
+void SobelEdgeRowAvx2(const float* top, const float* mid, const float* bottom, float* edges, int width)
+{
+	SobelEdgeRow(top, mid, bottom, edges, 0, width);
+}
+
+#endif
@@ -1,8 +1,9 @@
 #include "SobelFilter.h"
 
-SobelFilter::SobelFilter(ID3D12Device* device, UINT width, UINT height, DXGI_FORMAT format)
+SobelFilter::SobelFilter(ID3D12Device* device, RenderTargetPool<D3D12RenderTargetAllocator>* renderTargets, UINT width, UINT height, DXGI_FORMAT format)
 {
 	md3dDevice = device;
+	mRenderTargets = renderTargets;
 	mWidth = width;
 	mHeight = height;
 	mFormat = format;
@@ -14,11 +15,17 @@ void SobelFilter::Output(ID3D12GraphicsCommandList* cmdList, ID3D12Resource* out
 		output, outputState, D3D12_RESOURCE_STATE_COPY_DEST
 	));
 	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-		mEdgeMap.Get(), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_SOURCE
+		mEdgeMap, D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_SOURCE
 	));
-	cmdList->CopyResource(output, mEdgeMap.Get());
+
+	// Only the top-left mWidth x mHeight of the edge map is valid.
+	CD3DX12_TEXTURE_COPY_LOCATION dst(output, 0);
+	CD3DX12_TEXTURE_COPY_LOCATION src(mEdgeMap, 0);
+	CD3DX12_BOX srcBox(0, 0, mWidth, mHeight);
+	cmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, &srcBox);
+
 	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-		mEdgeMap.Get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_GENERIC_READ
+		mEdgeMap, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_GENERIC_READ
 	));
 	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
 		output, D3D12_RESOURCE_STATE_COPY_DEST, outputState
@@ -30,6 +37,11 @@ CD3DX12_GPU_DESCRIPTOR_HANDLE SobelFilter::EdgeMap()
 	return mEdgeMapSrvView;
 }
 
+DirectX::XMFLOAT2 SobelFilter::EdgeMapTexScale() const
+{
+	return DirectX::XMFLOAT2((float)mWidth / mEdgeMapWidth, (float)mHeight / mEdgeMapHeight);
+}
+
 void SobelFilter::Initialize(ID3D12GraphicsCommandList* cmdList, CD3DX12_CPU_DESCRIPTOR_HANDLE& cpuHandle, CD3DX12_GPU_DESCRIPTOR_HANDLE& gpuHandle, UINT descriptorSize)
 {
 	BuildResources();
@@ -45,10 +57,12 @@ void SobelFilter::OnResize(UINT newWidth, UINT newHeight)
 		mWidth = newWidth;
 		mHeight = newHeight;
 
+		UINT generation = mEdgeMapGeneration;
 		BuildResources();
 
 		// New resource, so we need new descriptors to that resource.
-		BuildDescriptors();
+		if (mEdgeMapGeneration != generation)
+			BuildDescriptors();
 	}
 }
 
@@ -56,44 +70,38 @@ void SobelFilter::Execute(ID3D12GraphicsCommandList* cmdList, CD3DX12_GPU_DESCRI
 {
 	cmdList->SetComputeRootSignature(mRootSignature.Get());
 
-	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mEdgeMap.Get(),
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mEdgeMap,
 		D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
 
+	// The input is pooled as well, so texels past mWidth x mHeight are stale
+	// and the shader has to treat them as out of bounds.
+	UINT inputSize[2] = { mWidth, mHeight };
+
 	cmdList->SetPipelineState(mSobelPSO.Get());
 	cmdList->SetComputeRootDescriptorTable(0, input);
 	cmdList->SetComputeRootDescriptorTable(1, mEdgeMapUavView);
+	cmdList->SetComputeRoot32BitConstants(2, 2, inputSize, 0);
 
 	UINT numGroupX = (INT)ceilf(mWidth / 16.0f);
 	UINT numGroupY = (INT)ceilf(mHeight / 16.0f);
 	cmdList->Dispatch(numGroupX, numGroupY, 1);
 
-	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mEdgeMap.Get(),
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mEdgeMap,
 		D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_GENERIC_READ));
 }
 
 void SobelFilter::BuildResources()
 {
-	D3D12_RESOURCE_DESC texDesc;
-	ZeroMemory(&texDesc, sizeof(D3D12_RESOURCE_DESC));
-	texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-	texDesc.Alignment = 0;
-	texDesc.Width = mWidth;
-	texDesc.Height = mHeight;
-	texDesc.DepthOrArraySize = 1;
-	texDesc.MipLevels = 1;
-	texDesc.Format = mFormat;
-	texDesc.SampleDesc.Count = 1;
-	texDesc.SampleDesc.Quality = 0;
-	texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-	texDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
-
-	ThrowIfFailed(md3dDevice->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&texDesc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&mEdgeMap)));
+	D3D12RenderTargetAllocator::Desc desc;
+	desc.Format = mFormat;
+	desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+	desc.InitialState = D3D12_RESOURCE_STATE_GENERIC_READ;
+
+	auto& target = mRenderTargets->Acquire("SobelFilter.EdgeMap", desc, mWidth, mHeight);
+	mEdgeMap = target.Res.Get();
+	mEdgeMapWidth = target.Width;
+	mEdgeMapHeight = target.Height;
+	mEdgeMapGeneration = target.Generation;
 }
 
 void SobelFilter::BuildDescriptors(CD3DX12_CPU_DESCRIPTOR_HANDLE& cpuHandle, CD3DX12_GPU_DESCRIPTOR_HANDLE& gpuHandle, UINT descriptorSize)
@@ -126,8 +134,8 @@ void SobelFilter::BuildDescriptors()
 	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
 	uavDesc.Texture2D.MipSlice = 0;
 
-	md3dDevice->CreateShaderResourceView(mEdgeMap.Get(), &srvDesc, mEdgeMapSrvView_CPU);
-	md3dDevice->CreateUnorderedAccessView(mEdgeMap.Get(), nullptr, &uavDesc, mEdgeMapUavView_CPU);
+	md3dDevice->CreateShaderResourceView(mEdgeMap, &srvDesc, mEdgeMapSrvView_CPU);
+	md3dDevice->CreateUnorderedAccessView(mEdgeMap, nullptr, &uavDesc, mEdgeMapUavView_CPU);
 }
 
 void SobelFilter::BuildRootSignature()
@@ -138,13 +146,14 @@ void SobelFilter::BuildRootSignature()
 	CD3DX12_DESCRIPTOR_RANGE uavTable;
 	uavTable.Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0);
 
-	CD3DX12_ROOT_PARAMETER slotRootParameter[2];
+	CD3DX12_ROOT_PARAMETER slotRootParameter[3];
 	slotRootParameter[0].InitAsDescriptorTable(1, &srvTable);
 	slotRootParameter[1].InitAsDescriptorTable(1, &uavTable);
+	slotRootParameter[2].InitAsConstants(2, 0);
 
 	// A root signature is an array of root parameters.
 	CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(
-		2, slotRootParameter,
+		3, slotRootParameter,
 		0, nullptr,
 		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
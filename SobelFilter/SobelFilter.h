@@ -1,15 +1,19 @@
 #pragma once
 
 #include <Common/d3dUtil.h>
+#include <Common/RenderTargetPool.h>
+#include <Common/D3D12RenderTargetAllocator.h>
 
 class SobelFilter
 {
 public:
 	///<summary>
 	/// The width and height should match the dimensions of the input texture to blur.
-	/// Recreate when the screen is resized. 
+	/// The edge map comes from renderTargets, so OnResize only reallocates when
+	/// the size crosses one of the pool's buckets.
 	///</summary>
 	SobelFilter(ID3D12Device* device,
+		RenderTargetPool<D3D12RenderTargetAllocator>* renderTargets,
 		UINT width, UINT height,
 		DXGI_FORMAT format);
 
@@ -24,6 +28,9 @@ public:
 
 	CD3DX12_GPU_DESCRIPTOR_HANDLE EdgeMap();
 
+	// The edge map may be bigger than the input; scales [0,1] texcoords onto the valid region.
+	DirectX::XMFLOAT2 EdgeMapTexScale() const;
+
 	static const UINT DescriptorCount() { return 2; }
 
 	void Initialize(ID3D12GraphicsCommandList* cmdList, CD3DX12_CPU_DESCRIPTOR_HANDLE& cpuHandle, CD3DX12_GPU_DESCRIPTOR_HANDLE& gpuHandle, UINT descriptorSize);
@@ -44,6 +51,7 @@ private:
 	void BuildPSOs();
 private:
 	ID3D12Device* md3dDevice = nullptr;
+	RenderTargetPool<D3D12RenderTargetAllocator>* mRenderTargets = nullptr;
 
 	UINT mWidth = 0;
 	UINT mHeight = 0;
@@ -59,5 +67,9 @@ private:
 	CD3DX12_GPU_DESCRIPTOR_HANDLE mEdgeMapSrvView;
 	CD3DX12_GPU_DESCRIPTOR_HANDLE mEdgeMapUavView;
 
-	Microsoft::WRL::ComPtr<ID3D12Resource> mEdgeMap = nullptr;
+	// Owned by mRenderTargets; mEdgeMapGeneration tells when the views are stale.
+	ID3D12Resource* mEdgeMap = nullptr;
+	UINT mEdgeMapWidth = 0;
+	UINT mEdgeMapHeight = 0;
+	UINT mEdgeMapGeneration = 0;
 };
@@ -1,35 +1,70 @@
 Texture2D gInput            : register(t0);
 RWTexture2D<float4> gOutput : register(u0);
 
+// ԳߴͰأܴЧ򣬳gInputSizeǾ
+cbuffer cbSobel : register(b0)
+{
+	uint2 gInputSize;
+};
+
+// ߳ĳߴ磬Լ1ر߿Ĺڴͼߴ
+#define N 16
+#define TILE_SIZE (N + 2)
+
 // RGB
 float CalcLuminance(float3 color)
 {
 	return dot(color, float3(0.299f, 0.578f, 0.114f));
 }
 
-[numthreads(16, 16, 1)]
-void SobelCS(uint3 dtid : SV_DispatchThreadID)
+// ÿֻȫڴȡһΣתΪ
+groupshared float gLum[TILE_SIZE * TILE_SIZE];
+
+// ˮƽм[-1 0 1][1 2 1]ƽ
+groupshared float gDiffX[TILE_SIZE * N];
+groupshared float gSmoothX[TILE_SIZE * N];
+
+// ߳ڵǰصıԵֵݶȶʹΪ0ƽ̹Ϊ1
+float SobelEdge(uint3 gid, uint3 gtid, uint gi)
 {
-	// ɼ뵱ǰڵ
-	float4 c[3][3];
-	for (int i = 0; i < 3; ++i)
+	// 18x18ͼ빲ڴ档Ч֮ⰴ0زĽһ
+	// תΪuintúܴͬΪԽ磩
+	int2 tileOrigin = int2(gid.xy * N) - 1;
+	for (uint i = gi; i < TILE_SIZE * TILE_SIZE; i += N * N)
 	{
-		for (int j = 0; j < 3; ++j)
-		{
-			int2 xy = dtid.xy + int2(-1 + j, -1 + i);
-			c[i][j] = gInput[xy];
-		}
+		int2 xy = tileOrigin + int2(i % TILE_SIZE, i / TILE_SIZE);
+		gLum[i] = all(uint2(xy) < gInputSize) ? CalcLuminance(gInput[xy].rgb) : 0.0f;
 	}
+	GroupMemoryBarrierWithGroupSync();
 
-	// ÿɫͨʽƫĽֵ
-	float4 Gx = -1.0f * c[0][0] - 2.0f * c[1][0] - 1.0f * c[2][0] + 1.0f * c[0][2] + 2.0f * c[1][2] + 1.0f * c[2][2];
-	float4 Gy = -1.0f * c[2][0] - 2.0f * c[2][1] - 1.0f * c[2][2] + 1.0f * c[0][0] + 2.0f * c[0][1] + 1.0f * c[0][2];
+	// ˮƽһά˲ͼȫ18
+	for (uint k = gi; k < TILE_SIZE * N; k += N * N)
+	{
+		uint row = k / N;
+		uint col = k % N + 1;
+		float l = gLum[row * TILE_SIZE + col - 1];
+		float c = gLum[row * TILE_SIZE + col];
+		float r = gLum[row * TILE_SIZE + col + 1];
+		gDiffX[k] = r - l;
+		gSmoothX[k] = l + 2.0f * c + r;
+	}
+	GroupMemoryBarrierWithGroupSync();
 
-	// ÿݶȵĳ
-	float4 mag = sqrt(Gx * Gx + Gy * Gy);
+	// ֱһά˲ϳ
+	uint top = gtid.y * N + gtid.x;
+	uint mid = top + N;
+	uint bottom = mid + N;
+	float Gx = gDiffX[top] + 2.0f * gDiffX[mid] + gDiffX[bottom];
+	float Gy = gSmoothX[top] - gSmoothX[bottom];
 
+	return 1.0f - saturate(sqrt(Gx * Gx + Gy * Gy));
+}
+
+[numthreads(N, N, 1)]
+void SobelCS(uint3 gid : SV_GroupID, uint3 gtid : SV_GroupThreadID, uint3 dtid : SV_DispatchThreadID, uint gi : SV_GroupIndex)
+{
 	// ݶȶ͵ĵطΪɫݶƽ̹ĵطΪɫ
-	mag = 1.0f - saturate(CalcLuminance(mag.rgb));
+	float mag = SobelEdge(gid, gtid, gi);
 
-	gOutput[dtid.xy] = mag;
+	gOutput[dtid.xy] = float4(mag, mag, mag, mag);
 }
\ No newline at end of file
@@ -25,7 +25,19 @@ bool SobelFilterApp::Initialize()
 
 
 	mWaveSimulator = std::make_unique<WaveSimulator>(md3dDevice.Get(), 128, 128, 1.0f, 0.03f, 4.0f, 0.2f);
-	mSobelFilter = std::make_unique<SobelFilter>(md3dDevice.Get(), mClientWidth, mClientHeight, DXGI_FORMAT_R8G8B8A8_UNORM);
+	// 滻Ҫȵ֡Դ֮ͷ
+	mRenderTargets = std::make_unique<RenderTargetPool<D3D12RenderTargetAllocator>>(
+		D3D12RenderTargetAllocator(md3dDevice.Get()), gNumFrameResources);
+	PostProcessGraph postProcess;
+	postProcess.SetOutput(postProcess.AddComposite(postProcess.Input(), postProcess.AddSobel(postProcess.Input())));
+	mPostProcessPlan = postProcess.Compile();
+	mFusedSobelComposite = mPostProcessPlan.Passes.size() == 1 &&
+		mPostProcessPlan.Passes[0].Head == PostProcessOp::Sobel &&
+		mPostProcessPlan.Passes[0].Fused.size() == 1 &&
+		mPostProcessPlan.Passes[0].Fused[0].Op == PostProcessOp::Composite;
+	// Only the unfused plan stores the edge map.
+	if (!mFusedSobelComposite)
+		mSobelFilter = std::make_unique<SobelFilter>(md3dDevice.Get(), mRenderTargets.get(), mClientWidth, mClientHeight, DXGI_FORMAT_R8G8B8A8_UNORM);
 
 	LoadTextures();
 	BuildDescriptorHeap();
@@ -40,11 +52,14 @@ bool SobelFilterApp::Initialize()
 		cpuHandle, gpuHandle,
 		mCbvSrvUavDescriptorSize
 	);
-	mSobelFilter->Initialize(
-		mCommandList.Get(),
-		cpuHandle, gpuHandle,
-		mCbvSrvUavDescriptorSize
-	);
+	if (mSobelFilter != nullptr)
+	{
+		mSobelFilter->Initialize(
+			mCommandList.Get(),
+			cpuHandle, gpuHandle,
+			mCbvSrvUavDescriptorSize
+		);
+	}
 
 	BuildRootSignature();
 	BuildCompositeRootSignature();
@@ -78,6 +93,15 @@ void SobelFilterApp::OnResize()
 	XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f * MathHelper::Pi, AspectRatio(), 1.0f, 1000.0f);
 	XMStoreFloat4x4(&mProj, proj);
 
+	if (mRenderTargets != nullptr)
+	{
+		// ֻгߴصķͰʱŻõµʱҪؽ
+		UINT generation = mTempBufferGeneration;
+		BuildResources();
+		if (mTempBufferGeneration != generation)
+			BuildTempBufferDescriptor();
+	}
+
 	if(mSobelFilter != nullptr)
 		mSobelFilter->OnResize(mClientWidth, mClientHeight);
 }
@@ -160,20 +184,37 @@ void SobelFilterApp::Draw(const GameTimer& gt)
 		CurrentBackBuffer(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE
 	));
 	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-		mTempBuffer.Get(), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_DEST
+		mTempBuffer, D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_COPY_DEST
 	));
-	mCommandList->CopyResource(mTempBuffer.Get(), CurrentBackBuffer());
+	// ʱܱȺֻ̨ƵϽ
+	CD3DX12_TEXTURE_COPY_LOCATION tempDst(mTempBuffer, 0);
+	CD3DX12_TEXTURE_COPY_LOCATION backBufferSrc(CurrentBackBuffer(), 0);
+	mCommandList->CopyTextureRegion(&tempDst, 0, 0, 0, &backBufferSrc, nullptr);
 	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-		mTempBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ
+		mTempBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ
 	));
 	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
 		CurrentBackBuffer(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_RENDER_TARGET
 	));
-	mSobelFilter->Execute(mCommandList.Get(), mTempSrvView);
+	// The fused pass computes the edges in the pixel shader that draws the
+	// composite, so it needs neither the edge map nor the Sobel dispatch;
+	// SobelCompositePS never reads t1, so that table stays unbound.
 	mCommandList->SetGraphicsRootSignature(mCompositeRootSignature.Get());
 	mCommandList->SetGraphicsRootDescriptorTable(0, mTempSrvView);
-	mCommandList->SetGraphicsRootDescriptorTable(1, mSobelFilter->EdgeMap());
-	mCommandList->SetPipelineState(mPSOs["composite"].Get());
+	XMFLOAT2 edgeTexScale(1.0f, 1.0f);
+	if (!mFusedSobelComposite)
+	{
+		mSobelFilter->Execute(mCommandList.Get(), mTempSrvView);
+		mCommandList->SetGraphicsRootDescriptorTable(1, mSobelFilter->EdgeMap());
+		edgeTexScale = mSobelFilter->EdgeMapTexScale();
+	}
+	float compositeConstants[6] = {
+		(float)mClientWidth / mTempBufferWidth, (float)mClientHeight / mTempBufferHeight,
+		edgeTexScale.x, edgeTexScale.y,
+		(float)mClientWidth, (float)mClientHeight
+	};
+	mCommandList->SetGraphicsRoot32BitConstants(2, 6, compositeConstants, 0);
+	mCommandList->SetPipelineState(mPSOs[mFusedSobelComposite ? "sobelComposite" : "composite"].Get());
 	mCommandList->DrawInstanced(6, 1, 0, 0);
 
 	// ȾĿ״̬ת״̬
@@ -200,6 +241,9 @@ void SobelFilterApp::Draw(const GameTimer& gt)
 	// һָµΧ
 	// GPUִ֮ǰGPUµΧ㣬ҪȵSignal()֮ǰ
 	mCommandQueue->Signal(mFence.Get(), mCurrentFence);
+
+	// ͷѾٱGPUʵľ
+	mRenderTargets->EndFrame();
 }
 
 void SobelFilterApp::OnMouseDown(WPARAM btnState, int x, int y)
@@ -420,7 +464,7 @@ void SobelFilterApp::BuildDescriptorHeap()
 	// Create the descriptor heap.
 	//
 	D3D12_DESCRIPTOR_HEAP_DESC cbvsrvuavHeapDesc = {};
-	cbvsrvuavHeapDesc.NumDescriptors = 4 +  mWaveSimulator->DescriptorCount() + mSobelFilter->DescriptorCount();
+	cbvsrvuavHeapDesc.NumDescriptors = 4 +  mWaveSimulator->DescriptorCount() + (mSobelFilter != nullptr ? SobelFilter::DescriptorCount() : 0);
 	cbvsrvuavHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
 	cbvsrvuavHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 	ThrowIfFailed(md3dDevice->CreateDescriptorHeap(&cbvsrvuavHeapDesc, IID_PPV_ARGS(&mCbvSrvUavDescriptorHeap)));
@@ -428,27 +472,16 @@ void SobelFilterApp::BuildDescriptorHeap()
 
 void SobelFilterApp::BuildResources()
 {
-	D3D12_RESOURCE_DESC texDesc;
-	ZeroMemory(&texDesc, sizeof(D3D12_RESOURCE_DESC));
-	texDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-	texDesc.Alignment = 0;
-	texDesc.Width = mClientWidth;
-	texDesc.Height = mClientHeight;
-	texDesc.DepthOrArraySize = 1;
-	texDesc.MipLevels = 1;
-	texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	texDesc.SampleDesc.Count = 1;
-	texDesc.SampleDesc.Quality = 0;
-	texDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-	texDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-
-	ThrowIfFailed(md3dDevice->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&texDesc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&mTempBuffer)));
+	D3D12RenderTargetAllocator::Desc desc;
+	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+	desc.InitialState = D3D12_RESOURCE_STATE_GENERIC_READ;
+
+	auto& target = mRenderTargets->Acquire("TempBuffer", desc, mClientWidth, mClientHeight);
+	mTempBuffer = target.Res.Get();
+	mTempBufferWidth = target.Width;
+	mTempBufferHeight = target.Height;
+	mTempBufferGeneration = target.Generation;
 }
 
 void SobelFilterApp::BuildDescriptors(CD3DX12_CPU_DESCRIPTOR_HANDLE& cpuHandle, CD3DX12_GPU_DESCRIPTOR_HANDLE& gpuHandle, UINT descriptorSize)
@@ -483,14 +516,25 @@ void SobelFilterApp::BuildDescriptors(CD3DX12_CPU_DESCRIPTOR_HANDLE& cpuHandle,
 	gpuHandle.Offset(1, descriptorSize);
 	cpuHandle.Offset(1, descriptorSize);
 
-	srvDesc.Format = mTempBuffer->GetDesc().Format;
-	md3dDevice->CreateShaderResourceView(mTempBuffer.Get(), &srvDesc, cpuHandle);
+	mTempSrvView_CPU = cpuHandle;
 	mTempSrvView = gpuHandle;
+	BuildTempBufferDescriptor();
 	// Next Descriptor
 	cpuHandle.Offset(1, descriptorSize);
 	gpuHandle.Offset(1, descriptorSize);
 }
 
+void SobelFilterApp::BuildTempBufferDescriptor()
+{
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Format = mTempBuffer->GetDesc().Format;
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MostDetailedMip = 0;
+	srvDesc.Texture2D.MipLevels = 1;
+	md3dDevice->CreateShaderResourceView(mTempBuffer, &srvDesc, mTempSrvView_CPU);
+}
+
 void SobelFilterApp::BuildShadersAndInputLayout()
 {
 	D3D_SHADER_MACRO defines[] = {
@@ -507,12 +551,13 @@ void SobelFilterApp::BuildShadersAndInputLayout()
 		NULL, NULL
 	};
 
-	mShaders["LitVS"] = d3dUtil::CompileShader(L"Lit.hlsl", nullptr, "VS", "vs_5_0");
-	mShaders["DispMapLitVS"] = d3dUtil::CompileShader(L"Lit.hlsl", displacementMapDefines, "VS", "vs_5_0");
-	mShaders["LitPS"] = d3dUtil::CompileShader(L"Lit.hlsl", defines, "PS", "ps_5_0");
-	mShaders["AlphaLitPS"] = d3dUtil::CompileShader(L"Lit.hlsl", alphaTestDefines, "PS", "ps_5_0");
+	mShaders["LitVS"] = d3dUtil::CompileShader(L"../Common/sim/Lit.hlsl", nullptr, "VS", "vs_5_0");
+	mShaders["DispMapLitVS"] = d3dUtil::CompileShader(L"../Common/sim/Lit.hlsl", displacementMapDefines, "VS", "vs_5_0");
+	mShaders["LitPS"] = d3dUtil::CompileShader(L"../Common/sim/Lit.hlsl", defines, "PS", "ps_5_0");
+	mShaders["AlphaLitPS"] = d3dUtil::CompileShader(L"../Common/sim/Lit.hlsl", alphaTestDefines, "PS", "ps_5_0");
 	mShaders["CompositeVS"] = d3dUtil::CompileShader(L"Composite.hlsl", nullptr, "VS", "vs_5_0");
 	mShaders["CompositePS"] = d3dUtil::CompileShader(L"Composite.hlsl", nullptr, "PS", "ps_5_0");
+	mShaders["SobelCompositePS"] = d3dUtil::CompileShader(L"Composite.hlsl", nullptr, "SobelCompositePS", "ps_5_0");
 
 	mInputLayout = {
 		{"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
@@ -574,16 +619,17 @@ void SobelFilterApp::BuildCompositeRootSignature()
 	srvTable1.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 1);
 
 	// 
-	CD3DX12_ROOT_PARAMETER slotRootParameter[2];
+	CD3DX12_ROOT_PARAMETER slotRootParameter[3];
 
 	slotRootParameter[0].InitAsDescriptorTable(1, &srvTable0, D3D12_SHADER_VISIBILITY_PIXEL);
 	slotRootParameter[1].InitAsDescriptorTable(1, &srvTable1, D3D12_SHADER_VISIBILITY_PIXEL);
+	slotRootParameter[2].InitAsConstants(6, 0, 0, D3D12_SHADER_VISIBILITY_PIXEL); // 
 
 	auto samplers = GetSamplers();
 
 	// ǩһ
 	CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(
-		2, slotRootParameter,
+		3, slotRootParameter,
 		(UINT)samplers.size(), samplers.data(),
 		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
@@ -694,6 +740,13 @@ void SobelFilterApp::BuildPSOs()
 		mShaders["CompositePS"]->GetBufferSize()
 	};
 	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&compositePsoDesc, IID_PPV_ARGS(&mPSOs["composite"])));
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC sobelCompositePsoDesc = compositePsoDesc;
+	sobelCompositePsoDesc.PS = {
+		reinterpret_cast<BYTE*>(mShaders["SobelCompositePS"]->GetBufferPointer()),
+		mShaders["SobelCompositePS"]->GetBufferSize()
+	};
+	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&sobelCompositePsoDesc, IID_PPV_ARGS(&mPSOs["sobelComposite"])));
 }
 
 void SobelFilterApp::BuildBoxGeometry()
@@ -2,10 +2,13 @@
 
 #include <Common/d3dApp.h>
 
-#include "FrameResource.h"
+#include <Common/sim/FrameResource.h>
 
-#include "WaveSimulator.h"
+#include <Common/sim/WaveSimulator.h>
+#include <Common/RenderTargetPool.h>
+#include <Common/D3D12RenderTargetAllocator.h>
 #include "SobelFilter.h"
+#include "PostProcessGraph.h"
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
@@ -59,6 +62,7 @@ private:
 	void BuildResources();
 
 	void BuildDescriptors(CD3DX12_CPU_DESCRIPTOR_HANDLE& cpuHandle, CD3DX12_GPU_DESCRIPTOR_HANDLE& gpuHandle, UINT descriptorSize);
+	void BuildTempBufferDescriptor();
 	
 	void BuildShadersAndInputLayout();
 	void BuildRootSignature();
@@ -100,10 +104,26 @@ private:
 	std::vector<std::unique_ptr<RenderItem>> mAllRitems;
 
 	std::unique_ptr<WaveSimulator> mWaveSimulator;
+	// Every size-dependent texture is taken from this pool, so dragging the
+	// window edge doesn't recreate them on every WM_SIZE.
+	std::unique_ptr<RenderTargetPool<D3D12RenderTargetAllocator>> mRenderTargets;
 	std::unique_ptr<SobelFilter> mSobelFilter;
 
+	// Post-processing chain (scene * edges) compiled once at startup. When the
+	// composite is fused into the Sobel pass, one pixel shader computes the
+	// edges and draws the composite; the edge map is never stored and
+	// mSobelFilter is not created. The D3D12 path records only these two
+	// shapes of the chain: Blur and Threshold passes, and the executor's
+	// pooled intermediate textures, exist on the CPU (PostProcessCpu) only.
+	PostProcessPlan mPostProcessPlan;
+	bool mFusedSobelComposite = false;
+
+	CD3DX12_CPU_DESCRIPTOR_HANDLE mTempSrvView_CPU;
 	CD3DX12_GPU_DESCRIPTOR_HANDLE mTempSrvView;
-	ComPtr<ID3D12Resource> mTempBuffer;
+	ID3D12Resource* mTempBuffer = nullptr;
+	UINT mTempBufferWidth = 0;
+	UINT mTempBufferHeight = 0;
+	UINT mTempBufferGeneration = 0;
 
 	// Render items divided by PSO.
 	std::vector<RenderItem*> mRitemLayer[(UINT)RenderLayer::Count];
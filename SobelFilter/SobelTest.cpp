@@ -0,0 +1,11 @@
+// Runs the CPU edge detection benchmark once, without a window, as a test:
+// every Sobel path against the direct convolution, fused post-process graphs
+// against unfused ones, and the render target pool through a resize storm.
+// Exits non-zero if any check fails.
+
+#include "SobelBenchmark.h"
+
+int main()
+{
+	return RunSobelBenchmark(1);
+}